@@ -2,4 +2,5 @@
 #include "meta/analyzers/multi_analyzer.h"
 
 #include "meta/analyzers/ngram/ngram_analyzer.h"
+#include "meta/analyzers/ngram/ngram_char_analyzer.h"
 #include "meta/analyzers/ngram/ngram_word_analyzer.h"
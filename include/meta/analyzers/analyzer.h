@@ -66,11 +66,67 @@ class analyzer
     feature_map<T> analyze(const corpus::document& doc)
     {
         feature_map<T> counts;
+        analyze(doc, counts);
+        return counts;
+    }
+
+    /**
+     * Tokenizes a document into an existing feature_map, adding to the
+     * counts already in it. Reusing one map for many documents (emptying
+     * it with reset() in between) avoids allocating a table for each.
+     *
+     * @param doc The document to be tokenized
+     * @param counts The feature_map to add the document's feature counts
+     * to
+     */
+    template <class T>
+    void analyze(const corpus::document& doc, feature_map<T>& counts)
+    {
         featurizer feats{counts};
         tokenize(doc, feats);
+    }
+
+    /**
+     * Tokenizes a document into hashed features. Analyzers that build
+     * features out of several tokens (like ngram_word_analyzer) compute
+     * their ids directly from the tokens' hashes, without building the
+     * features' strings.
+     *
+     * @param doc The document to be tokenized
+     * @param dict A dictionary to record the feature for each id in, for
+     * debugging (this makes every analyzer build its features' strings
+     * again)
+     * @return a hashed_feature_map that maps the ids of the observed
+     * features to their counts in the document
+     */
+    template <class T>
+    hashed_feature_map<T> analyze_hashed(const corpus::document& doc,
+                                         feature_dictionary* dict = nullptr)
+    {
+        hashed_feature_map<T> counts;
+        analyze_hashed(doc, counts, dict);
         return counts;
     }
 
+    /**
+     * Tokenizes a document into hashed features in an existing
+     * hashed_feature_map, adding to the counts already in it (see
+     * analyze()).
+     *
+     * @param doc The document to be tokenized
+     * @param counts The hashed_feature_map to add the document's feature
+     * counts to
+     * @param dict A dictionary to record the feature for each id in
+     */
+    template <class T>
+    void analyze_hashed(const corpus::document& doc,
+                        hashed_feature_map<T>& counts,
+                        feature_dictionary* dict = nullptr)
+    {
+        featurizer feats{counts, dict};
+        tokenize(doc, feats);
+    }
+
     /**
      * Clones this analyzer.
      */
@@ -107,7 +163,7 @@ std::unique_ptr<analyzer> load(const cpptoml::table& config);
 /**
  * @param config The config group used to create the analyzer from
  * @return the default filter chain for this version of MeTA,
- * based on a config object
+ * based on a config object (as a fused_chain)
  */
 std::unique_ptr<token_stream>
 default_filter_chain(const cpptoml::table& config);
@@ -115,7 +171,7 @@ default_filter_chain(const cpptoml::table& config);
 /**
  * @param config The config group used to create the analyzer from
  * @return the default filter chain for unigram words for this version
- * of MeTA, based on a config object
+ * of MeTA, based on a config object (as a fused_chain)
  */
 std::unique_ptr<token_stream>
 default_unigram_chain(const cpptoml::table& config);
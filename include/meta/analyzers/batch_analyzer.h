@@ -0,0 +1,280 @@
+/**
+ * @file batch_analyzer.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_ANALYZERS_BATCH_ANALYZER_H_
+#define META_ANALYZERS_BATCH_ANALYZER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "meta/analyzers/analyzer.h"
+#include "meta/analyzers/token_arena.h"
+#include "meta/config.h"
+#include "meta/corpus/document.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/array_view.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+template <class T>
+class batch_analyzer;
+
+/**
+ * The features of a batch of documents, as produced by
+ * batch_analyzer::analyze_batch(). The features of each document are
+ * stored contiguously, and the features themselves are views into arenas
+ * owned by the batch, so a batch holds no per-feature allocations.
+ *
+ * A batch can be reused: analyzing a new batch of documents into it
+ * overwrites its contents but keeps its memory, so a batch that is reused
+ * stops allocating once it has grown to the size of the largest batch.
+ *
+ * @tparam T The type of the feature values
+ */
+template <class T>
+class feature_batch
+{
+  public:
+    /// A feature and its value
+    using value_type = std::pair<util::string_view, T>;
+
+    /// The features of one document, in no particular order
+    using document_features = util::array_view<const value_type>;
+
+    using const_iterator =
+        typename std::vector<document_features>::const_iterator;
+
+    /**
+     * @return the number of documents in the batch
+     */
+    uint64_t size() const
+    {
+        return docs_.size();
+    }
+
+    /**
+     * @param idx The position of a document in the batch
+     * @return the features of that document, which are valid until the
+     * batch is reused
+     */
+    document_features operator[](uint64_t idx) const
+    {
+        return docs_[idx];
+    }
+
+    /**
+     * @return an iterator to the features of the first document
+     */
+    const_iterator begin() const
+    {
+        return docs_.begin();
+    }
+
+    /**
+     * @return an iterator past the features of the last document
+     */
+    const_iterator end() const
+    {
+        return docs_.end();
+    }
+
+  private:
+    friend batch_analyzer<T>;
+
+    /**
+     * The features of a contiguous range of the batch's documents, which
+     * are all written by one thread.
+     */
+    struct segment
+    {
+        /// Storage for the features' strings
+        token_arena strings;
+        /// The features of the documents, one after the other
+        std::vector<value_type> features;
+        /// The end of each document's features in the features vector
+        std::vector<uint64_t> ends;
+    };
+
+    /// The segments used by the last batch (and any left over from
+    /// larger batches, for reuse)
+    std::vector<segment> segments_;
+
+    /// The features of each document
+    std::vector<document_features> docs_;
+};
+
+/**
+ * Analyzes batches of documents in parallel. Each thread of the pool gets
+ * its own clone of the analyzer and its own feature_map, which is reset
+ * and reused for every document the thread analyzes; the features of each
+ * document are then copied into a feature_batch. Analyzing many short
+ * documents this way allocates almost nothing per document.
+ *
+ * @tparam T The type of the feature values (uint64_t or double)
+ */
+template <class T>
+class batch_analyzer
+{
+  public:
+    /**
+     * @param ana The analyzer to clone for each thread
+     * @param pool The thread pool to analyze documents with
+     */
+    batch_analyzer(const analyzer& ana, parallel::thread_pool& pool)
+        : pool_(pool)
+    {
+        if (pool_.size() == 0)
+            throw analyzer_exception{"batch_analyzer needs at least one "
+                                     "thread"};
+        workers_.reserve(pool_.size());
+        for (std::size_t i = 0; i < pool_.size(); ++i)
+            workers_.push_back(worker{ana.clone(), feature_map<T>{}});
+    }
+
+    /**
+     * Analyzes a batch of documents into an existing feature_batch,
+     * replacing its contents. This waits for tasks on the thread pool, so
+     * it must not be called from one.
+     *
+     * @param docs The documents to analyze
+     * @param batch The batch to write the documents' features to
+     */
+    void analyze_batch(util::array_view<const corpus::document> docs,
+                       feature_batch<T>& batch)
+    {
+        batch.docs_.clear();
+        if (docs.size() == 0)
+            return;
+
+        // documents are handed out in several chunks per thread, so that
+        // a thread that gets long documents doesn't hold up the others
+        const std::size_t chunks_per_worker = 4;
+        auto num_chunks
+            = std::min<std::size_t>(docs.size(),
+                                    workers_.size() * chunks_per_worker);
+        auto chunk_size = (docs.size() + num_chunks - 1) / num_chunks;
+        num_chunks = (docs.size() + chunk_size - 1) / chunk_size;
+
+        if (batch.segments_.size() < num_chunks)
+            batch.segments_.resize(num_chunks);
+
+        std::atomic<std::size_t> next_chunk{0};
+        auto task = [&](worker& wkr)
+        {
+            for (auto chunk = next_chunk++; chunk < num_chunks;
+                 chunk = next_chunk++)
+            {
+                auto first = chunk * chunk_size;
+                auto last = std::min(first + chunk_size, docs.size());
+                analyze_chunk(wkr, docs, first, last, batch.segments_[chunk]);
+            }
+        };
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(workers_.size());
+        for (auto& wkr : workers_)
+        {
+            auto wkr_ptr = &wkr;
+            futures.emplace_back(pool_.submit_task([&task, wkr_ptr]()
+                                                   {
+                                                       task(*wkr_ptr);
+                                                   }));
+        }
+
+        // every task must finish before an exception from any of them is
+        // rethrown, since they all refer to this stack frame
+        for (auto& fut : futures)
+            fut.wait();
+        for (auto& fut : futures)
+            fut.get();
+
+        batch.docs_.reserve(docs.size());
+        for (std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            const auto& seg = batch.segments_[chunk];
+            uint64_t begin = 0;
+            for (const auto& end : seg.ends)
+            {
+                batch.docs_.emplace_back(seg.features.data() + begin,
+                                         seg.features.data() + end);
+                begin = end;
+            }
+        }
+    }
+
+    /**
+     * Analyzes a batch of documents.
+     *
+     * @param docs The documents to analyze
+     * @return the features of the documents
+     */
+    feature_batch<T>
+    analyze_batch(util::array_view<const corpus::document> docs)
+    {
+        feature_batch<T> batch;
+        analyze_batch(docs, batch);
+        return batch;
+    }
+
+  private:
+    /**
+     * The state of one thread.
+     */
+    struct worker
+    {
+        /// The thread's analyzer
+        std::unique_ptr<analyzer> ana;
+        /// The map that the thread's documents are analyzed into
+        feature_map<T> counts;
+    };
+
+    /**
+     * Analyzes a range of documents into a segment of a batch.
+     *
+     * @param wkr The state of the thread analyzing the documents
+     * @param docs The documents of the batch
+     * @param first The position of the first document to analyze
+     * @param last The position after the last document to analyze
+     * @param seg The segment to write the documents' features to
+     */
+    static void analyze_chunk(worker& wkr,
+                              util::array_view<const corpus::document> docs,
+                              std::size_t first, std::size_t last,
+                              typename feature_batch<T>::segment& seg)
+    {
+        seg.strings.clear();
+        seg.features.clear();
+        seg.ends.clear();
+        for (auto i = first; i < last; ++i)
+        {
+            wkr.counts.reset();
+            wkr.ana->analyze(docs[i], wkr.counts);
+            for (const auto& count : wkr.counts)
+                seg.features.emplace_back(seg.strings.append(count.key()),
+                                          count.value());
+            seg.ends.push_back(seg.features.size());
+        }
+    }
+
+    /// The thread pool to analyze documents with
+    parallel::thread_pool& pool_;
+
+    /// The state of each thread
+    std::vector<worker> workers_;
+};
+}
+}
+#endif
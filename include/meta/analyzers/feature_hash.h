@@ -0,0 +1,160 @@
+/**
+ * @file feature_hash.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_ANALYZERS_FEATURE_HASH_H_
+#define META_ANALYZERS_FEATURE_HASH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/hashing/hashes/farm_hash.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+/**
+ * Computes the id of a feature for a hashed_feature_map. The hash is not
+ * seeded, so a feature has the same id in every process.
+ *
+ * @param feature The feature (or token) to hash
+ * @return the feature's id
+ */
+inline uint64_t hash_feature(util::string_view feature)
+{
+    hashing::farm_hash hasher;
+    hasher(feature.data(), feature.size());
+    return static_cast<uint64_t>(hasher);
+}
+
+/**
+ * Computes the ids of the n-grams of a sequence of tokens from the tokens'
+ * hashes, without building the n-grams themselves. The id of an n-gram is
+ * a polynomial in the hashes of its tokens, so sliding the window forward
+ * by one token takes constant time regardless of n.
+ */
+class rolling_hash
+{
+  public:
+    /**
+     * @param n The number of tokens in each n-gram
+     */
+    rolling_hash(uint64_t n)
+        : window_(std::max<uint64_t>(n, 1)), power_{1}, state_{0}, count_{0}
+    {
+        for (uint64_t i = 1; i < window_.size(); ++i)
+            power_ *= base;
+    }
+
+    /**
+     * Adds the next token to the window, dropping the oldest one if the
+     * window is full.
+     * @param token_hash The hash of the token
+     */
+    void push(uint64_t token_hash)
+    {
+        auto& slot = window_[count_ % window_.size()];
+        if (full())
+            state_ -= slot * power_;
+        state_ = state_ * base + token_hash;
+        slot = token_hash;
+        ++count_;
+    }
+
+    /**
+     * @return whether the window holds n tokens
+     */
+    bool full() const
+    {
+        return count_ >= window_.size();
+    }
+
+    /**
+     * @return the id of the n-gram in the window
+     */
+    uint64_t value() const
+    {
+        // the state is mixed with n so that an n-gram and an (n+1)-gram
+        // starting with a token whose hash is zero differ, and so that
+        // the low bits (which are kept when ids are masked) are well
+        // distributed
+        auto x = state_ ^ (window_.size() * 0x9e3779b97f4a7c15ull);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * Empties the window.
+     */
+    void clear()
+    {
+        state_ = 0;
+        count_ = 0;
+    }
+
+  private:
+    /// The base of the polynomial
+    const static constexpr uint64_t base = 0x100000001b3ull;
+
+    /// The hashes of the tokens in the window, as a ring buffer
+    std::vector<uint64_t> window_;
+    /// base^(n - 1), the weight of the oldest token in the window
+    uint64_t power_;
+    /// The value of the polynomial over the window
+    uint64_t state_;
+    /// The number of tokens pushed since the window was last cleared
+    uint64_t count_;
+};
+
+/**
+ * Maps the ids of hashed features back to the features they came from,
+ * for debugging. Every distinct feature seen for an id is kept, so
+ * collisions can be found.
+ */
+class feature_dictionary
+{
+  public:
+    /**
+     * Records that a feature was given an id.
+     * @param id The feature's id
+     * @param feature The feature
+     */
+    void insert(uint64_t id, util::string_view feature);
+
+    /**
+     * @param id The id to look up
+     * @return the features that were given the id, in the order they were
+     * first seen (empty if there were none)
+     */
+    const std::vector<std::string>& features(uint64_t id) const;
+
+    /**
+     * @return the ids that were given to more than one feature, in
+     * increasing order
+     */
+    std::vector<uint64_t> collisions() const;
+
+    /**
+     * @return the number of ids in the dictionary
+     */
+    uint64_t size() const;
+
+  private:
+    /// The features seen for each id
+    std::unordered_map<uint64_t, std::vector<std::string>> features_;
+};
+}
+}
+#endif
@@ -12,6 +12,7 @@
 
 #include <stdexcept>
 
+#include "meta/analyzers/feature_hash.h"
 #include "meta/config.h"
 #include "meta/hashing/probe_map.h"
 #include "meta/util/likely.h"
@@ -34,10 +35,22 @@ class featurizer_exception : public std::runtime_error
 template <class T>
 using feature_map = hashing::probe_map<std::string, T>;
 
+/**
+ * A map from the ids of hashed features (see hash_feature) to their
+ * values.
+ */
+template <class T>
+using hashed_feature_map = hashing::probe_map<uint64_t, T>;
+
 /**
  * Used by analyzers to increment feature values in feature_maps
  * generically. This class type-erases a specific map class so that the
  * interface remains the same to enable virtual functions in analyzers.
+ *
+ * A featurizer over a hashed_feature_map accepts either features, which
+ * it hashes, or feature ids that an analyzer has computed itself (for
+ * example, with a rolling_hash), so the analyzer never has to build the
+ * features' strings.
  */
 class featurizer
 {
@@ -53,6 +66,50 @@ class featurizer
                       "feature map must map to uint64_t or double");
     }
 
+    /**
+     * Constructs a featurizer that writes to a specific
+     * hashed_feature_map.
+     * @param map The map to write to
+     * @param dict A dictionary to record the feature for each id in (if
+     * any)
+     */
+    template <class T>
+    featurizer(hashed_feature_map<T>& map, feature_dictionary* dict = nullptr)
+        : map_{make_unique<concrete_hashed_map<T>>(map, dict)}
+    {
+        static_assert(std::is_same<T, uint64_t>::value
+                          || std::is_same<T, double>::value,
+                      "feature map must map to uint64_t or double");
+    }
+
+    /**
+     * @return whether this featurizer writes to a hashed_feature_map
+     */
+    bool hashed() const
+    {
+        return map_->hashed();
+    }
+
+    /**
+     * @return whether the features of hashed ids should be recorded with
+     * name(), because this featurizer has a feature_dictionary
+     */
+    bool naming() const
+    {
+        return map_->naming();
+    }
+
+    /**
+     * Records the feature that a hashed id was computed from. Does
+     * nothing unless naming().
+     * @param id The feature id
+     * @param feat The feature
+     */
+    void name(uint64_t id, util::string_view feat)
+    {
+        map_->name(id, feat);
+    }
+
     /**
      * Observes the given feature occurring val times.
      * @param feat The feature identifier
@@ -71,12 +128,36 @@ class featurizer
             map_->increment(feat, static_cast<uint64_t>(val));
     }
 
+    /**
+     * Observes the feature with the given hashed id occurring val times.
+     * Only valid if hashed().
+     * @param id The feature id
+     * @param val The feature value
+     */
+    template <class T>
+    void operator()(uint64_t id, T val)
+    {
+        static_assert(std::is_integral<T>::value
+                          || std::is_floating_point<T>::value,
+                      "feature map must map to uint64_t or double");
+
+        if (std::is_floating_point<T>::value)
+            map_->increment(id, static_cast<double>(val));
+        else
+            map_->increment(id, static_cast<uint64_t>(val));
+    }
+
   private:
     class map_concept
     {
       public:
         virtual void increment(const std::string& feat, double val) = 0;
         virtual void increment(const std::string& feat, uint64_t val) = 0;
+        virtual void increment(uint64_t id, double val) = 0;
+        virtual void increment(uint64_t id, uint64_t val) = 0;
+        virtual bool hashed() const = 0;
+        virtual bool naming() const = 0;
+        virtual void name(uint64_t id, util::string_view feat) = 0;
         virtual ~map_concept() = default;
     };
 
@@ -102,10 +183,96 @@ class featurizer
             map_[feat] += val;
         }
 
+        void increment(uint64_t, double) override
+        {
+            throw featurizer_exception{
+                "cannot increment hashed feature on string featurizer"};
+        }
+
+        void increment(uint64_t, uint64_t) override
+        {
+            throw featurizer_exception{
+                "cannot increment hashed feature on string featurizer"};
+        }
+
+        bool hashed() const override
+        {
+            return false;
+        }
+
+        bool naming() const override
+        {
+            return false;
+        }
+
+        void name(uint64_t, util::string_view) override
+        {
+            // nothing
+        }
+
       private:
         feature_map<T>& map_;
     };
 
+    template <class T>
+    class concrete_hashed_map : public map_concept
+    {
+      public:
+        concrete_hashed_map(hashed_feature_map<T>& map,
+                            feature_dictionary* dict)
+            : map_(map), dict_{dict}
+        {
+            // nothing
+        }
+
+        void increment(const std::string& feat, double val) override
+        {
+            auto id = hash_feature(feat);
+            name(id, feat);
+            increment(id, val);
+        }
+
+        void increment(const std::string& feat, uint64_t val) override
+        {
+            auto id = hash_feature(feat);
+            name(id, feat);
+            increment(id, val);
+        }
+
+        void increment(uint64_t id, double val) override
+        {
+            if (META_UNLIKELY((!std::is_same<T, double>::value)))
+                throw featurizer_exception{
+                    "cannot increment double value on integer featurizer"};
+            map_[id] += val;
+        }
+
+        void increment(uint64_t id, uint64_t val) override
+        {
+            map_[id] += val;
+        }
+
+        bool hashed() const override
+        {
+            return true;
+        }
+
+        bool naming() const override
+        {
+            return dict_ != nullptr;
+        }
+
+        void name(uint64_t id, util::string_view feat) override
+        {
+            if (dict_)
+                dict_->insert(id, feat);
+        }
+
+      private:
+        hashed_feature_map<T>& map_;
+        feature_dictionary* dict_;
+    };
+
     std::unique_ptr<map_concept> map_;
 };
 }
@@ -51,11 +51,24 @@ class empty_sentence_filter
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * Obtains the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -73,11 +86,17 @@ class empty_sentence_filter
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
 
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
+
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
     /// Keeps track of the left hand side of a potentially empty sentence
-    util::optional<std::string> first_;
+    util::optional<util::string_view> first_;
 
     /// Keeps track of the right hand side of a potentially empty sentence
-    util::optional<std::string> second_;
+    util::optional<util::string_view> second_;
 };
 }
 }
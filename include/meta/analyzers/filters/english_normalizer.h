@@ -55,11 +55,24 @@ class english_normalizer
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * Obtains the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -73,14 +86,14 @@ class english_normalizer
      * Determines if the given token is a whitespace token.
      * @param token The given token
      */
-    bool is_whitespace(const std::string& token) const;
+    bool is_whitespace(util::string_view token) const;
 
     /**
      * Converts the given non-whitespace token into a series of tokens and
      * places them on the buffer.
      * @param token The given token
      */
-    void parse_token(const std::string& token);
+    void parse_token(util::string_view token);
 
     /**
      * Checks for starting quotes in the token, adding a normalized begin
@@ -88,7 +101,7 @@ class english_normalizer
      * @param start The index to start searching at
      * @param token The given token
      */
-    uint64_t starting_quotes(uint64_t start, const std::string& token);
+    uint64_t starting_quotes(uint64_t start, util::string_view token);
 
     /**
      * Checks if the given character is a passable quote symbol.
@@ -101,7 +114,7 @@ class english_normalizer
      * @param start The index to start searching at
      * @param token The given token
      */
-    uint64_t strip_dashes(uint64_t start, const std::string& token);
+    uint64_t strip_dashes(uint64_t start, util::string_view token);
 
     /**
      * Reads "word" characters (alpha numeric and dashes) starting at start
@@ -110,18 +123,21 @@ class english_normalizer
      * @param start The index to start searching at
      * @param token The given token
      */
-    uint64_t word(uint64_t start, const std::string& token);
+    uint64_t word(uint64_t start, util::string_view token);
 
     /**
      * @return the next buffered token.
      */
-    std::string current_token();
+    util::string_view current_token();
 
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
 
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
+
     /// Buffered tokens to return
-    std::deque<std::string> tokens_;
+    std::deque<util::string_view> tokens_;
 };
 }
 }
@@ -62,11 +62,24 @@ class icu_filter : public util::clonable<token_stream, icu_filter>
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * @return the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -84,11 +97,17 @@ class icu_filter : public util::clonable<token_stream, icu_filter>
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
 
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
+
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
     /// The transformer to use
     utf::transformer trans_;
 
     /// Current token (if available)
-    util::optional<std::string> token_;
+    util::optional<util::string_view> token_;
 };
 
 /**
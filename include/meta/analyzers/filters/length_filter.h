@@ -12,6 +12,7 @@
 #include <memory>
 
 #include "meta/analyzers/filter_factory.h"
+#include "meta/analyzers/filters/stages.h"
 #include "meta/util/clonable.h"
 #include "meta/util/optional.h"
 
@@ -65,11 +66,24 @@ class length_filter : public util::clonable<token_stream, length_filter>
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * @return the next token in the sequence
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -87,14 +101,17 @@ class length_filter : public util::clonable<token_stream, length_filter>
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
 
-    /// The next buffered token
-    util::optional<std::string> token_;
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
 
-    /// The minimum length of a token that can be emitted by this filter
-    uint64_t min_length_;
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
+    /// The next buffered token
+    util::optional<util::string_view> token_;
 
-    /// The maximum length of a token that can be emitted by this filter
-    uint64_t max_length_;
+    /// The range of lengths of tokens that can be emitted by this filter
+    stages::length length_;
 };
 
 /**
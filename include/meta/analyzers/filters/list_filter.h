@@ -10,9 +10,9 @@
 #define META_LIST_FILTER_H_
 
 #include <memory>
-#include <unordered_set>
 
 #include "meta/analyzers/filter_factory.h"
+#include "meta/analyzers/filters/stages.h"
 #include "meta/util/clonable.h"
 #include "meta/util/optional.h"
 
@@ -48,11 +48,7 @@ class list_filter : public util::clonable<token_stream, list_filter>
      * Strongly typed flag to indicate whether the list_filter rejects
      * tokens in the list or only accepts tokens in the list.
      */
-    enum class type
-    {
-        ACCEPT,
-        REJECT
-    };
+    using type = stages::list::type;
 
     /**
      * Creates a list_filter reading tokens from the given source and
@@ -80,11 +76,24 @@ class list_filter : public util::clonable<token_stream, list_filter>
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * @return the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -102,14 +111,17 @@ class list_filter : public util::clonable<token_stream, list_filter>
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
 
-    /// The next buffered token
-    util::optional<std::string> token_;
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
 
-    /// The set of tokens used for filtering
-    std::unordered_set<std::string> list_;
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
+    /// The next buffered token
+    util::optional<util::string_view> token_;
 
-    /// Whether or not this filter accepts or rejects tokens in the list
-    type method_;
+    /// The list of tokens and whether they are accepted or rejected
+    stages::list list_;
 };
 
 /**
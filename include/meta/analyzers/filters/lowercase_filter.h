@@ -49,11 +49,24 @@ class lowercase_filter : public util::clonable<token_stream, lowercase_filter>
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * Obtains the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines whether there are more tokens available in the stream.
      */
@@ -65,6 +78,9 @@ class lowercase_filter : public util::clonable<token_stream, lowercase_filter>
   private:
     /// The stream to read tokens from.
     std::unique_ptr<token_stream> source_;
+
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
 };
 }
 }
@@ -10,6 +10,8 @@
 #define META_FILTER_PORTER2_FILTER_H_
 
 #include <memory>
+#include "meta/analyzers/filter_factory.h"
+#include "meta/analyzers/filters/stages.h"
 #include "meta/analyzers/token_stream.h"
 #include "meta/util/clonable.h"
 #include "meta/util/optional.h"
@@ -27,7 +29,11 @@ namespace filters
  * Requires that the porter2 stemmer project submodule be downloaded.
  *
  * Required config parameters: none.
- * Optional config parameters: none.
+ * Optional config parameters:
+ * ~~~toml
+ * cache-size = 65536 # the maximum number of cached stems; 0 disables
+ *                    # the cache
+ * ~~~
  */
 class porter2_filter : public util::clonable<token_stream, porter2_filter>
 {
@@ -36,8 +42,11 @@ class porter2_filter : public util::clonable<token_stream, porter2_filter>
      * Constructs a new porter2 stemmer filter, reading tokens from
      * the given source.
      * @param source The source to construct the filter from
+     * @param cache_size The maximum number of stems to cache
      */
-    porter2_filter(std::unique_ptr<token_stream> source);
+    porter2_filter(std::unique_ptr<token_stream> source,
+                   uint64_t cache_size
+                   = stages::porter2_stem::default_cache_size);
 
     /**
      * Copy constructor.
@@ -51,11 +60,24 @@ class porter2_filter : public util::clonable<token_stream, porter2_filter>
      */
     void set_content(std::string&& content) override;
 
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override;
+
     /**
      * Obtains the next token in the sequence.
      */
     std::string next() override;
 
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines if there are more tokens available in the stream.
      */
@@ -73,9 +95,26 @@ class porter2_filter : public util::clonable<token_stream, porter2_filter>
     /// The stream to read tokens from
     std::unique_ptr<token_stream> source_;
 
+    /// The arena used when this filter is read with next()
+    token_arena own_arena_;
+
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
     /// The buffered next token.
-    util::optional<std::string> token_;
+    util::optional<util::string_view> token_;
+
+    /// The stemmer
+    stages::porter2_stem stem_;
 };
+
+/**
+ * Specialization of the factory method for creating porter2_filters.
+ */
+template <>
+std::unique_ptr<token_stream>
+    make_filter<porter2_filter>(std::unique_ptr<token_stream>,
+                                const cpptoml::table&);
 }
 }
 }
@@ -11,9 +11,9 @@
 
 #include <deque>
 #include <memory>
-#include <unordered_set>
 
 #include "meta/analyzers/filter_factory.h"
+#include "meta/analyzers/filters/word_set.h"
 #include "meta/util/clonable.h"
 #include "meta/util/optional.h"
 
@@ -95,19 +95,19 @@ class sentence_boundary : public util::clonable<token_stream, sentence_boundary>
      * punctuation marker.
      * @param token The token to check
      */
-    static bool possible_punc(const std::string& token);
+    static bool possible_punc(util::string_view token);
 
     /**
      * Determines if the given token can be the last word in a sentence.
      * @param token The token to check
      */
-    static bool possible_end(const std::string& token);
+    static bool possible_end(util::string_view token);
 
     /**
      * Determines if the given token can be the beginning of a sentence.
      * @param token The token to check
      */
-    static bool possible_start(const std::string& token);
+    static bool possible_start(util::string_view token);
 
     /// The source to read tokens from
     std::unique_ptr<token_stream> source_;
@@ -119,19 +119,19 @@ class sentence_boundary : public util::clonable<token_stream, sentence_boundary>
     util::optional<std::string> prev_;
 
     /// The set of possible punctuation marks, shared among all instances
-    static std::unordered_set<std::string> punc_set;
+    static word_set punc_set;
 
     /**
      * The set of words that may not start sentences, shared among all
      * instances.
      */
-    static std::unordered_set<std::string> start_exception_set;
+    static word_set start_exception_set;
 
     /**
      * The set of words that may not end sentences, shared among all
      * instances.
      */
-    static std::unordered_set<std::string> end_exception_set;
+    static word_set end_exception_set;
 
     /**
      * Whether or not the heuristics above have been loaded. Must be set by
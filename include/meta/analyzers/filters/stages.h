@@ -0,0 +1,339 @@
+/**
+ * @file stages.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_FILTERS_STAGES_H_
+#define META_FILTERS_STAGES_H_
+
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <string>
+
+#include "meta/analyzers/filters/porter2_stemmer.h"
+#include "meta/analyzers/filters/word_set.h"
+#include "meta/analyzers/token_arena.h"
+#include "meta/analyzers/token_stream.h"
+#include "meta/config.h"
+#include "meta/hashing/probe_map.h"
+#include "meta/utf/ascii.h"
+#include "meta/utf/utf.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+namespace filters
+{
+
+/**
+ * The per-token work of the filters that look at one token at a time,
+ * separated from the plumbing that links filters into a chain. Each stage
+ * is a function object that takes a token and the arena to write a
+ * changed token to, replaces the token if it changes it, and returns
+ * whether the token should be kept.
+ *
+ * The filters of the same names run these stages on the tokens they read
+ * from their source; a fused_chain runs several of them in one loop. They
+ * are defined here so that they can be inlined into either.
+ */
+namespace stages
+{
+
+/**
+ * @param tok The token to check
+ * @return whether the token is a sentence boundary tag ("<s>" or "</s>")
+ */
+inline bool is_sentence_tag(util::string_view tok)
+{
+    return tok.size() <= 4 && tok.size() >= 3
+           && (tok == "<s>" || tok == "</s>");
+}
+
+/**
+ * @param feature The feature to check
+ * @return whether the feature contains a sentence boundary tag, either as
+ * the whole feature or as a word of an ngram that spans the boundary
+ */
+inline bool has_sentence_tag(util::string_view feature)
+{
+    return feature.find("<s>") != util::string_view::npos
+           || feature.find("</s>") != util::string_view::npos;
+}
+
+/**
+ * The stage of lowercase_filter.
+ */
+class lowercase
+{
+  public:
+    /**
+     * @param tok The token, which is replaced by its lowercase version
+     * @param arena The arena to write a changed token to
+     * @return true (every token is kept)
+     */
+    bool operator()(util::string_view& tok, token_arena& arena) const
+    {
+        // ASCII tokens are lowercased without decoding them, and are only
+        // copied if they contain an uppercase letter; tokens that aren't
+        // valid utf8 can't be decoded, so only their ASCII letters are
+        // lowercased
+        if (!utf::is_ascii(tok) && utf::is_valid_utf8(tok))
+        {
+            tok = arena.append(utf::foldcase(tok));
+            return true;
+        }
+
+        if (!utf::has_ascii_upper(tok))
+            return true;
+
+        auto data = arena.allocate(tok.size());
+        utf::ascii_tolower(tok, data);
+        tok = {data, tok.size()};
+        return true;
+    }
+};
+
+/**
+ * The stage of alpha_filter.
+ */
+class alpha
+{
+  public:
+    /**
+     * @param tok The token, which is replaced by its letters
+     * @param arena The arena to write a changed token to
+     * @return whether the token has any letters left (sentence boundary
+     * tags are always kept)
+     */
+    bool operator()(util::string_view& tok, token_arena& arena) const
+    {
+        if (is_sentence_tag(tok))
+            return true;
+
+        // most tokens are a plain word, which is kept as it is
+        if (utf::is_ascii_alpha(tok))
+            return !tok.empty();
+
+        // tokens that aren't valid utf8 can't be decoded, so they keep only
+        // their ASCII letters, like ASCII tokens
+        if (!utf::is_ascii(tok) && utf::is_valid_utf8(tok))
+        {
+            auto remove = [](uint32_t codepoint)
+            {
+                return !utf::isalpha(codepoint) && codepoint != '\'';
+            };
+            tok = arena.append(utf::remove_if(tok, remove));
+            return !tok.empty();
+        }
+
+        // other tokens are filtered without decoding them, and are only
+        // copied when a character has to be removed
+        auto keep = [](char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                   || c == '\'';
+        };
+        auto kept = static_cast<uint64_t>(
+            std::count_if(tok.begin(), tok.end(), keep));
+        if (kept == tok.size())
+            return true;
+        if (kept == 0)
+            return false;
+
+        auto data = arena.allocate(kept);
+        std::copy_if(tok.begin(), tok.end(), data, keep);
+        tok = {data, kept};
+        return true;
+    }
+};
+
+/**
+ * The stage of length_filter.
+ */
+class length
+{
+  public:
+    /**
+     * @param min The minimum length of a kept token, in codepoints
+     * @param max The maximum length of a kept token, in codepoints
+     */
+    length(uint64_t min, uint64_t max) : min_{min}, max_{max}
+    {
+        if (min_ > max_)
+            throw token_stream_exception{
+                "min filter length is greater than max filter length"};
+    }
+
+    /**
+     * @param tok The token
+     * @return whether the token is within the length range (sentence
+     * boundary tags are always kept)
+     */
+    bool operator()(util::string_view& tok, token_arena&) const
+    {
+        if (is_sentence_tag(tok))
+            return true;
+
+        // utf::length() doesn't decode ASCII tokens
+        auto len = utf::length(tok);
+        return len >= min_ && len <= max_;
+    }
+
+    /**
+     * @return the minimum length of a kept token
+     */
+    uint64_t min() const
+    {
+        return min_;
+    }
+
+    /**
+     * @return the maximum length of a kept token
+     */
+    uint64_t max() const
+    {
+        return max_;
+    }
+
+  private:
+    /// The minimum length of a kept token
+    uint64_t min_;
+    /// The maximum length of a kept token
+    uint64_t max_;
+};
+
+/**
+ * The stage of list_filter.
+ */
+class list
+{
+  public:
+    /**
+     * Strongly typed flag to indicate whether the stage rejects tokens in
+     * the list or only accepts tokens in the list.
+     */
+    enum class type
+    {
+        ACCEPT,
+        REJECT
+    };
+
+    /**
+     * @param filename A file that lists tokens (one per line) that should
+     * either be accepted or rejected
+     * @param method Whether to accept or reject tokens from the list
+     */
+    list(const std::string& filename, type method);
+
+    /**
+     * @param tok The token
+     * @return whether the token should be kept
+     */
+    bool operator()(util::string_view& tok, token_arena&) const
+    {
+        auto found = list_->contains(tok);
+        switch (method_)
+        {
+            case type::ACCEPT:
+                return found;
+            case type::REJECT:
+                return !found;
+            default:
+                throw token_stream_exception{"invalid method"};
+        }
+    }
+
+  private:
+    /// The set of tokens used for filtering, shared by all copies
+    std::shared_ptr<const word_set> list_;
+    /// Whether this stage accepts or rejects tokens in the list
+    type method_;
+};
+
+/**
+ * The stage of porter2_filter. Since a few thousand words make up most of
+ * the tokens of any text, the stems of the words seen so far are cached,
+ * so that most tokens are stemmed with a single lookup. The cache holds a
+ * bounded number of stems and is emptied when it fills up. Copies of a
+ * stage start with an empty cache, so every thread (which analyzes with
+ * its own copy of a filter chain) has a cache of its own.
+ */
+class porter2_stem
+{
+  public:
+    /// The default maximum number of cached stems
+    const static constexpr uint64_t default_cache_size = 1 << 16;
+
+    /**
+     * @param cache_size The maximum number of stems to cache (0 disables
+     * caching)
+     */
+    porter2_stem(uint64_t cache_size = default_cache_size);
+
+    /**
+     * Copy constructor. The copy's cache starts out empty.
+     * @param other The stage to copy
+     */
+    porter2_stem(const porter2_stem& other);
+
+    /**
+     * Move constructor.
+     */
+    porter2_stem(porter2_stem&&) = default;
+
+    /**
+     * @param tok The token, which is replaced by its stem
+     * @param arena The arena to write a changed token to
+     * @return whether the stem is nonempty
+     */
+    bool operator()(util::string_view& tok, token_arena& arena)
+    {
+        auto it = stems_.find(tok);
+        auto stem = it != stems_.end() ? it->value() : stem_uncached(tok);
+        if (stem.empty())
+            return false;
+
+        // most stems are the token itself, which needn't be copied; other
+        // stems are copied out of the cache, which may be emptied before
+        // the token is used
+        if (stem != tok)
+            tok = arena.append(stem);
+        return true;
+    }
+
+    /**
+     * @return the maximum number of stems to cache
+     */
+    uint64_t cache_size() const
+    {
+        return cache_size_;
+    }
+
+  private:
+    /**
+     * Stems a token that isn't cached, and caches its stem.
+     * @param tok The token
+     * @return the stem, which is valid until the next call
+     */
+    util::string_view stem_uncached(util::string_view tok);
+
+    /// The maximum number of stems to cache
+    uint64_t cache_size_;
+    /// Storage for the cached tokens and stems
+    token_arena strings_;
+    /// The cached stems of tokens
+    hashing::probe_map<util::string_view, util::string_view> stems_;
+    /// Storage for stemming the current token
+    std::string scratch_;
+};
+}
+}
+}
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file word_set.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_FILTERS_WORD_SET_H_
+#define META_FILTERS_WORD_SET_H_
+
+#include <istream>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/hashing/hash.h"
+#include "meta/hashing/hashes/farm_hash.h"
+#include "meta/hashing/probe_set.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+namespace filters
+{
+
+/**
+ * An immutable set of words (like a list of stopwords), for filters that
+ * look up every token in a word list. The words are stored one after the
+ * other in a single buffer, and a probe_set of views into that buffer
+ * finds them: a lookup hashes the token once, compares it only against
+ * words with the same hash, and never allocates. Tokens longer than the
+ * longest word are rejected without hashing them at all.
+ *
+ * A word_set can be moved but not copied; filters that are cloned for
+ * each thread share one through a std::shared_ptr<const word_set>.
+ */
+class word_set
+{
+  public:
+    /**
+     * Constructs an empty set.
+     */
+    word_set() = default;
+
+    /**
+     * Reads a set of words, one per line.
+     * @param in The stream to read the words from
+     */
+    explicit word_set(std::istream& in);
+
+    word_set(word_set&&) = default;
+    word_set& operator=(word_set&&) = default;
+
+    /**
+     * @param word The word to look for
+     * @return whether the word is in the set
+     */
+    bool contains(util::string_view word) const
+    {
+        return word.size() <= max_size_ && words_.find(word) != words_.end();
+    }
+
+    /**
+     * @return the number of words in the set
+     */
+    uint64_t size() const
+    {
+        return words_.size();
+    }
+
+  private:
+    /**
+     * Hashes words with the one-shot form of farm_hash for the short
+     * strings that almost all words are, which is much cheaper than
+     * hashing them incrementally.
+     */
+    struct word_hash
+    {
+        std::size_t operator()(util::string_view word) const
+        {
+            if (word.size() > 16)
+                return hashing::hash<>{}(word);
+            return hashing::farm::hash_len_0_to_16(
+                reinterpret_cast<const uint8_t*>(word.data()), word.size());
+        }
+    };
+
+    /// The characters of the words, one after the other
+    std::vector<char> buffer_;
+    /// Views of the words in the buffer
+    hashing::probe_set<util::string_view, hashing::probing::binary,
+                       word_hash> words_;
+    /// The size of the longest word
+    uint64_t max_size_ = 0;
+};
+}
+}
+}
+#endif
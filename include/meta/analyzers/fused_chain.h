@@ -0,0 +1,228 @@
+/**
+ * @file fused_chain.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_ANALYZERS_FUSED_CHAIN_H_
+#define META_ANALYZERS_FUSED_CHAIN_H_
+
+#include <tuple>
+#include <type_traits>
+
+#include "meta/analyzers/filters/stages.h"
+#include "meta/analyzers/token_arena.h"
+#include "meta/analyzers/token_stream.h"
+#include "meta/config.h"
+#include "meta/util/clonable.h"
+#include "meta/util/optional.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+/**
+ * A filter chain whose tokenizer and filters are fixed at compile time.
+ * Instead of one heap-allocated token_stream per filter, a fused_chain
+ * holds its tokenizer and the stages of its filters (see filters::stages)
+ * by value, and moves each token through all of the stages in a single
+ * loop: there are no virtual calls between the stages, and the stages
+ * can be inlined into the loop.
+ *
+ * A fused_chain produces the same tokens as the dynamic chain of the
+ * tokenizer followed by the filter of each stage, in order, and then an
+ * empty_sentence_filter if skip_empty_sentences is set.
+ * default_filter_chain() and default_unigram_chain() return fused chains;
+ * chains read from a filter list in the configuration stay dynamic.
+ *
+ * @tparam Tokenizer The type of the tokenizer
+ * @tparam Stages The types of the stages, in the order they are run
+ */
+template <class Tokenizer, class... Stages>
+class fused_chain
+    : public util::clonable<token_stream, fused_chain<Tokenizer, Stages...>>
+{
+  public:
+    /**
+     * @param tokenizer The tokenizer to read tokens from
+     * @param stages The stages to run on each token
+     * @param skip_empty_sentences Whether to remove "<s>" immediately
+     * followed by "</s>" from the output, as empty_sentence_filter does
+     */
+    fused_chain(Tokenizer tokenizer, Stages... stages,
+                bool skip_empty_sentences)
+        : tokenizer_(std::move(tokenizer)),
+          stages_{std::move(stages)...},
+          skip_empty_sentences_{skip_empty_sentences},
+          arena_{&own_arena_}
+    {
+        next_token();
+    }
+
+    /**
+     * Copy constructor.
+     * @param other The fused_chain to copy into this one
+     */
+    fused_chain(const fused_chain& other)
+        : tokenizer_(other.tokenizer_),
+          stages_{other.stages_},
+          skip_empty_sentences_{other.skip_empty_sentences_},
+          arena_{&own_arena_}
+    {
+        if (other.token_)
+            token_ = own_arena_.append(*other.token_);
+        if (other.pending_)
+            pending_ = own_arena_.append(*other.pending_);
+    }
+
+    /**
+     * Sets the content for the beginning of the filter chain.
+     * @param content The string content to set
+     */
+    void set_content(std::string&& content) override
+    {
+        own_arena_.clear();
+        set_view_content(std::move(content), own_arena_);
+    }
+
+    /**
+     * Sets the content for the beginning of the filter chain, to be read
+     * with next_view().
+     * @param content The string content to set
+     * @param arena The arena to write changed tokens to
+     */
+    void set_view_content(std::string&& content, token_arena& arena) override
+    {
+        arena_ = &arena;
+        token_ = pending_ = util::nullopt;
+        tokenizer_.Tokenizer::set_view_content(std::move(content), arena);
+        next_token();
+    }
+
+    /**
+     * Obtains the next token in the sequence.
+     */
+    std::string next() override
+    {
+        return next_view(own_arena_).to_string();
+    }
+
+    /**
+     * Obtains the next token in the sequence as a view.
+     */
+    util::string_view next_view(token_arena&) override
+    {
+        auto tok = *token_;
+        next_token();
+        return tok;
+    }
+
+    /**
+     * Determines whether there are more tokens available in the stream.
+     */
+    operator bool() const override
+    {
+        return static_cast<bool>(token_);
+    }
+
+  private:
+    /// The index of the stage to run next, for run()
+    template <std::size_t I>
+    using stage_index = std::integral_constant<std::size_t, I>;
+
+    /**
+     * Finds the next token of the chain.
+     */
+    void next_token()
+    {
+        if (!skip_empty_sentences_)
+        {
+            token_ = pull();
+            return;
+        }
+
+        if (pending_)
+        {
+            token_ = pending_;
+            pending_ = util::nullopt;
+            return;
+        }
+
+        while ((token_ = pull()))
+        {
+            if (*token_ != "<s>")
+                return;
+            pending_ = pull();
+            if (!pending_ || *pending_ != "</s>")
+                return;
+            pending_ = util::nullopt;
+        }
+    }
+
+    /**
+     * @return the next token from the tokenizer that every stage keeps,
+     * if any
+     */
+    util::optional<util::string_view> pull()
+    {
+        // the tokenizer's functions are called by their qualified names so
+        // that they are not dispatched virtually
+        while (tokenizer_.Tokenizer::operator bool())
+        {
+            auto tok = tokenizer_.Tokenizer::next_view(*arena_);
+            if (run(tok, stage_index<0>{}))
+                return tok;
+        }
+        return util::nullopt;
+    }
+
+    /**
+     * Runs a stage and every stage after it on a token.
+     * @param tok The token
+     * @return whether every stage kept the token
+     */
+    template <std::size_t I>
+    bool run(util::string_view& tok, stage_index<I>)
+    {
+        return std::get<I>(stages_)(tok, *arena_)
+               && run(tok, stage_index<I + 1>{});
+    }
+
+    /**
+     * Ends the recursion of run() after the last stage.
+     * @return true
+     */
+    bool run(util::string_view&, stage_index<sizeof...(Stages)>)
+    {
+        return true;
+    }
+
+    /// The tokenizer
+    Tokenizer tokenizer_;
+
+    /// The stages, in the order they are run
+    std::tuple<Stages...> stages_;
+
+    /// Whether to remove empty sentences
+    bool skip_empty_sentences_;
+
+    /// The arena used when this chain is read with next()
+    token_arena own_arena_;
+
+    /// The arena that buffered tokens are written to
+    token_arena* arena_;
+
+    /// The next token
+    util::optional<util::string_view> token_;
+
+    /// The token after the next one, if it had to be read to check for
+    /// an empty sentence
+    util::optional<util::string_view> pending_;
+};
+}
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file ngram_char_analyzer.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_NGRAM_CHAR_ANALYZER_H_
+#define META_NGRAM_CHAR_ANALYZER_H_
+
+#include <string>
+#include <vector>
+
+#include "meta/analyzers/analyzer_factory.h"
+#include "meta/analyzers/feature_hash.h"
+#include "meta/config.h"
+#include "meta/util/clonable.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+/**
+ * Analyzes documents using the character ngrams of their text, where a
+ * character is a utf8 codepoint. The text is not tokenized or filtered:
+ * each ngram is the exact run of n codepoints in the document, including
+ * any whitespace or punctuation.
+ *
+ * The ngrams for every value of n are found in a single pass over the
+ * text. When analyzing into string features, each ngram is a view into
+ * the text that is copied only into the feature_map. When analyzing into
+ * hashed features (see analyzer::analyze_hashed), the id of each ngram is
+ * computed from the hashes of its codepoints with a rolling_hash, so the
+ * ngrams are never built at all; for ASCII text, these are the same ids as
+ * an ngram_word_analyzer over a character_tokenizer gives.
+ *
+ * Required config parameters:
+ * ~~~toml
+ * [[analyzers]]
+ * method = "ngram-char" # this analyzer
+ * ngram = 3 # integer, or an array of integers like [2, 3, 4]
+ * ~~~
+ *
+ * Optional config parameters: none.
+ */
+class ngram_char_analyzer
+    : public util::clonable<analyzer, ngram_char_analyzer>
+{
+  public:
+    /**
+     * Constructor.
+     * @param ns The values of n to use for the ngrams, which must be
+     * positive (duplicates are ignored)
+     */
+    ngram_char_analyzer(std::vector<uint16_t> ns);
+
+    /**
+     * Copy constructor.
+     * @param other The other ngram_char_analyzer to copy from
+     */
+    ngram_char_analyzer(const ngram_char_analyzer& other);
+
+    /**
+     * @return the values of n this analyzer uses, in increasing order
+     */
+    const std::vector<uint16_t>& n_values() const;
+
+    /// Identifier for this analyzer.
+    const static util::string_view id;
+
+  private:
+    virtual void tokenize(const corpus::document& doc,
+                          featurizer& counts) override;
+
+    /// The values of n, in increasing order
+    std::vector<uint16_t> ns_;
+
+    /// The byte offsets of the most recent codepoints in the text, as a
+    /// ring buffer holding as many as the largest ngram has
+    std::vector<uint64_t> starts_;
+
+    /// Computes the ids of the ngrams for each value of n when analyzing
+    /// into hashed features
+    std::vector<rolling_hash> hashes_;
+
+    /// Storage for the current ngram
+    std::string ngram_;
+};
+
+/**
+ * Specialization of the factory method for creating ngram_char_analyzers.
+ */
+template <>
+std::unique_ptr<analyzer>
+make_analyzer<ngram_char_analyzer>(const cpptoml::table&,
+                                   const cpptoml::table&);
+}
+}
+#endif
@@ -10,7 +10,9 @@
 #define META_NGRAM_WORD_ANALYZER_H_
 
 #include "meta/analyzers/analyzer_factory.h"
+#include "meta/analyzers/feature_hash.h"
 #include "meta/analyzers/ngram/ngram_analyzer.h"
+#include "meta/analyzers/token_arena.h"
 #include "meta/util/clonable.h"
 
 namespace meta
@@ -19,7 +21,10 @@ namespace analyzers
 {
 
 /**
- * Analyzes documents using their tokenized words.
+ * Analyzes documents using their tokenized words. When analyzing into
+ * hashed features (see analyzer::analyze_hashed), the id of each ngram is
+ * computed from the hashes of its words with a rolling_hash, so the ngrams
+ * are never built as strings.
  *
  * Required config parameters:
  * ~~~toml
@@ -63,6 +68,15 @@ class ngram_word_analyzer
 
     /// The token stream to be used for extracting tokens
     std::unique_ptr<token_stream> stream_;
+
+    /// Storage for the tokens of the current document
+    token_arena arena_;
+
+    /// Storage for the current ngram
+    std::string ngram_;
+
+    /// Computes the ids of the ngrams when analyzing into hashed features
+    rolling_hash hash_;
 };
 
 /**
@@ -0,0 +1,137 @@
+/**
+ * @file token_arena.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_TOKEN_ARENA_H_
+#define META_TOKEN_ARENA_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+/**
+ * Storage for the tokens of a document. Characters are bump-allocated out
+ * of a list of blocks, so a token never moves once it has been written and
+ * views of it stay valid until the arena is cleared. Clearing the arena
+ * keeps its blocks, so an arena that is reused across documents stops
+ * allocating once it has grown to the size of the largest document's
+ * tokens.
+ *
+ * An arena is meant to be owned by one analyzer (or one stream) and
+ * cannot be copied.
+ */
+class token_arena
+{
+  public:
+    /// The default size of a block, in bytes
+    const static constexpr std::size_t default_block_size = 4096;
+
+    /**
+     * @param block_size The size of each block, in bytes (larger
+     * allocations get a block of their own)
+     */
+    token_arena(std::size_t block_size = default_block_size)
+        : block_size_{std::max<std::size_t>(block_size, 1)},
+          current_{0},
+          used_{0}
+    {
+        // nothing
+    }
+
+    token_arena(token_arena&&) = default;
+    token_arena& operator=(token_arena&&) = default;
+
+    /**
+     * @param size The number of characters to allocate
+     * @return a pointer to size writable characters that stay valid
+     * until the arena is cleared
+     */
+    char* allocate(std::size_t size)
+    {
+        for (; current_ < blocks_.size(); ++current_, used_ = 0)
+        {
+            auto& blk = blocks_[current_];
+            if (used_ + size <= blk.size)
+            {
+                auto result = blk.data.get() + used_;
+                used_ += size;
+                return result;
+            }
+        }
+
+        block blk;
+        blk.size = std::max(size, block_size_);
+        blk.data.reset(new char[blk.size]);
+        blocks_.push_back(std::move(blk));
+        used_ = size;
+        return blocks_.back().data.get();
+    }
+
+    /**
+     * Copies a string into the arena.
+     * @param str The string to copy
+     * @return a view of the copy
+     */
+    util::string_view append(util::string_view str)
+    {
+        auto data = allocate(str.size());
+        std::copy(str.begin(), str.end(), data);
+        return {data, str.size()};
+    }
+
+    /**
+     * Invalidates every view into the arena, keeping its blocks for
+     * reuse.
+     */
+    void clear()
+    {
+        current_ = 0;
+        used_ = 0;
+    }
+
+    /**
+     * @return the total size of the arena's blocks, in bytes
+     */
+    std::size_t capacity() const
+    {
+        std::size_t result = 0;
+        for (const auto& blk : blocks_)
+            result += blk.size;
+        return result;
+    }
+
+  private:
+    /**
+     * A contiguous piece of storage.
+     */
+    struct block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    /// The size of each ordinary block
+    std::size_t block_size_;
+    /// The blocks, in the order they are filled
+    std::vector<block> blocks_;
+    /// The block currently being filled
+    std::size_t current_;
+    /// The number of characters used in the current block
+    std::size_t used_;
+};
+}
+}
+#endif
@@ -14,7 +14,9 @@
 #include <string>
 #include <stdexcept>
 
+#include "meta/analyzers/token_arena.h"
 #include "meta/config.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -25,6 +27,16 @@ namespace analyzers
  * Base class that represents a stream of tokens that have been extracted
  * from a document. These tokens may be raw tokens (in the case of a
  * tokenizer class) or filtered tokens (from the filter classes).
+ *
+ * Tokens can be read in one of two ways. set_content() and next() return
+ * each token as its own std::string. set_view_content() and next_view()
+ * instead return views: a stream may return a view into its own content
+ * or into the token it read from its source, and only writes a token
+ * into the caller's token_arena when it has to change it. A whole filter
+ * chain read this way allocates nothing per token once the arena has
+ * grown. Streams that only implement set_content() and next() can still
+ * be read (or filtered) through views: by default, each token is copied
+ * into the arena.
  */
 class token_stream
 {
@@ -46,6 +58,31 @@ class token_stream
      */
     virtual void set_content(std::string&& content) = 0;
 
+    /**
+     * Sets the content for the stream, to be read with next_view(). The
+     * arena must stay valid (and must not be cleared) for as long as the
+     * tokens of this content are being read.
+     *
+     * @param content The string content to set
+     * @param arena The arena to write any changed tokens to
+     */
+    virtual void set_view_content(std::string&& content,
+                                  token_arena& /* arena */)
+    {
+        set_content(std::move(content));
+    }
+
+    /**
+     * Obtains the next token in the sequence as a view, which is valid
+     * until the arena is cleared or the content of the stream is reset.
+     *
+     * @param arena The arena given to set_view_content()
+     */
+    virtual util::string_view next_view(token_arena& arena)
+    {
+        return arena.append(next());
+    }
+
     /**
      * Destructor.
      */
@@ -53,6 +53,12 @@ class character_tokenizer
      */
     std::string next() override;
 
+    /**
+     * @return the next token in the document, as a view into the
+     * tokenizer's content
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines if there are more tokens in the document.
      */
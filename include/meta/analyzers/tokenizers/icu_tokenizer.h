@@ -34,6 +34,11 @@ namespace tokenizers
  * Converts documents into streams of tokens by following the unicode
  * standards for sentence and word segmentation.
  *
+ * Tokens are found lazily, as they are read. When no language is given,
+ * documents that contain only ASCII and Latin-1 letters are segmented by
+ * a hand-written implementation of the same rules, without ICU; all other
+ * documents are segmented by ICU one sentence at a time.
+ *
  * Required config parameters: none.
  *
  * Optional config parameters:
@@ -87,9 +92,9 @@ class icu_tokenizer : public util::clonable<token_stream, icu_tokenizer>
 
     /**
      * Sets the content for the tokenizer to parse. This input is
-     * assumed to be utf-8 encoded. It will be converted to utf-16
-     * internally by ICU for the segmentation, but all tokens are
-     * output as utf-8 encoded strings.
+     * assumed to be utf-8 encoded. ICU may convert it to utf-16
+     * internally for the segmentation, but all tokens are output as
+     * utf-8 encoded strings.
      * @param content The string content to set
      */
     void set_content(std::string&& content) override;
@@ -102,6 +107,12 @@ class icu_tokenizer : public util::clonable<token_stream, icu_tokenizer>
      */
     std::string next() override;
 
+    /**
+     * @return the next token in the document, as a view into the
+     * tokenizer's content (or of a sentence boundary tag)
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines if there are more tokens in the document.
      */
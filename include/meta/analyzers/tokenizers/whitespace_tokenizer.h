@@ -55,6 +55,12 @@ class whitespace_tokenizer : public util::clonable<token_stream,
      */
     std::string next() override;
 
+    /**
+     * @return the next token in the document, as a view into the
+     * tokenizer's content
+     */
+    util::string_view next_view(token_arena& arena) override;
+
     /**
      * Determines if there are more tokens in the document.
      */
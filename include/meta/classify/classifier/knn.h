@@ -9,7 +9,7 @@
 #ifndef META_KNN_H_
 #define META_KNN_H_
 
-#include <unordered_set>
+#include "meta/index/doc_filter.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/forward_index.h"
 #include "meta/index/ranker/ranker.h"
@@ -97,7 +97,7 @@ class knn : public classifier
     std::unique_ptr<index::ranker> ranker_;
 
     /** documents that are "legal" to be used in the results */
-    std::unordered_set<doc_id> legal_docs_;
+    index::doc_filter legal_docs_;
 
     /** Whether we want the neighbors to be weighted by distance or not */
     const bool weighted_;
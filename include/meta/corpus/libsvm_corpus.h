@@ -59,7 +59,20 @@ class libsvm_corpus : public corpus
 
     metadata::schema_type schema() const override;
 
+    /**
+     * @return the path to the corpus file
+     */
+    const std::string& path() const;
+
+    /**
+     * @return the label type for the data
+     */
+    label_type lbl_type() const;
+
   private:
+    /// The path to the corpus file
+    std::string path_;
+
     /// The current document we are on
     doc_id cur_id_;
 
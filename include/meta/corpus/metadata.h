@@ -18,6 +18,7 @@
 #include "meta/config.h"
 #include "meta/io/packed.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -125,6 +126,44 @@ class metadata
         return util::nullopt;
     }
 
+    /**
+     * @param name The string metadata field to obtain
+     * @return a view of the field's contents where they are stored, if it
+     * exists; unlike get(), this does not copy the string
+     */
+    util::optional<util::string_view> get_view(const std::string& name) const
+    {
+        metadata_input_stream stream{start_};
+        for (uint64_t i = 0; i < schema_->size(); ++i)
+        {
+            switch ((*schema_)[i].type)
+            {
+                case field_type::SIGNED_INT:
+                    io::packed::read<int64_t>(stream);
+                    break;
+
+                case field_type::UNSIGNED_INT:
+                    io::packed::read<uint64_t>(stream);
+                    break;
+
+                case field_type::DOUBLE:
+                    io::packed::read<double>(stream);
+                    break;
+
+                case field_type::STRING:
+                {
+                    util::string_view s{stream.input_};
+                    stream.input_ += s.size() + 1;
+                    if ((*schema_)[i].name == name)
+                        return s;
+                    break;
+                }
+            }
+        }
+
+        return util::nullopt;
+    }
+
     /**
      * Returns the schema for this metadata object.
      */
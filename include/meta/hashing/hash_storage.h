@@ -638,6 +638,14 @@ class external_key_storage
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
     }
 
+    void reset()
+    {
+        // like clear(), but keeps the memory for the keys so that the set
+        // can be refilled without allocating
+        keys_.clear();
+        std::fill(std::begin(table_), std::end(table_), hash_idx{});
+    }
+
     void resize(std::size_t new_cap)
     {
         assert(new_cap > capacity());
@@ -758,6 +766,11 @@ class inline_key_storage
         size_ = 0;
     }
 
+    void reset()
+    {
+        clear();
+    }
+
     void resize(std::size_t new_cap)
     {
         assert(new_cap > capacity());
@@ -891,6 +904,11 @@ class inline_key_value_storage
         size_ = 0;
     }
 
+    void reset()
+    {
+        clear();
+    }
+
     void resize(std::size_t new_cap)
     {
         assert(new_cap > capacity());
@@ -1038,6 +1056,15 @@ class inline_key_external_value_storage
         std::vector<V>{}.swap(values_);
     }
 
+    void reset()
+    {
+        // like clear(), but keeps the memory for the values so that the
+        // table can be refilled without allocating
+        std::fill(std::begin(table_), std::end(table_),
+                  std::make_pair(key_traits<K>::sentinel(), std::size_t{0}));
+        values_.clear();
+    }
+
     void resize(std::size_t new_cap)
     {
         assert(new_cap > capacity());
@@ -1187,6 +1214,14 @@ class external_key_value_storage
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
     }
 
+    void reset()
+    {
+        // like clear(), but keeps the memory for the entries so that the
+        // table can be refilled without allocating
+        storage_.clear();
+        std::fill(std::begin(table_), std::end(table_), hash_idx{});
+    }
+
     void resize(std::size_t new_cap)
     {
         assert(new_cap > capacity());
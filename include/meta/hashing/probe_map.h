@@ -33,6 +33,10 @@ namespace hashing
  * - Hash: The hash function to use (defaults to hashing::hash<>)
  * - KeyEqual: The comparator to use on keys to determine equality
  *   (defaults to std::equal_to<Key>)
+ *
+ * clear() empties the map and frees the memory for its entries (the table
+ * itself keeps its size). reset() empties the map but keeps all of its
+ * memory, for a map that is refilled over and over.
  */
 template <class Key, class Value, class ProbingStrategy = probing::binary,
           class Hash = hash<>, class KeyEqual = std::equal_to<Key>,
@@ -63,6 +67,7 @@ class probe_map
     using storage_type::size;
     using storage_type::capacity;
     using storage_type::clear;
+    using storage_type::reset;
     using storage_type::bytes_used;
     using storage_type::extract;
 
@@ -36,6 +36,10 @@ namespace hashing
  * - Hash: The hash function to use (defaults to hashing::hash<>)
  * - KeyEqual: The comparator to use on keys to determine equality
  *   (defaults to std::equal_to<Key>)
+ *
+ * clear() empties the set and frees the memory for its keys (the table
+ * itself keeps its size). reset() empties the set but keeps all of its
+ * memory, for a set that is refilled over and over.
  */
 template <class Key, class ProbingStrategy = probing::binary,
           class Hash = hash<>, class KeyEqual = std::equal_to<Key>,
@@ -66,6 +70,7 @@ class probe_set
     using storage_type::size;
     using storage_type::capacity;
     using storage_type::clear;
+    using storage_type::reset;
     using storage_type::bytes_used;
     using storage_type::extract_keys;
 
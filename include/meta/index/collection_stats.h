@@ -0,0 +1,101 @@
+/**
+ * @file collection_stats.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_COLLECTION_STATS_H_
+#define META_INDEX_COLLECTION_STATS_H_
+
+#include <cstdint>
+
+#include "meta/config.h"
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Collection-level statistics for an inverted_index. These are computed
+ * while the index is being built and persisted alongside it so that they
+ * can be read in constant time when the index is opened.
+ *
+ * Statistics for indexes built over disjoint sets of documents (shards or
+ * segments) can be combined with operator+= to obtain the statistics for
+ * the whole collection.
+ */
+struct collection_stats
+{
+    /// The number of documents in the collection
+    uint64_t num_docs = 0;
+    /// The total number of term occurrences in the collection
+    uint64_t total_terms = 0;
+
+    /**
+     * @return the average document length in the collection
+     */
+    float avg_doc_length() const
+    {
+        if (num_docs == 0)
+            return 0.0f;
+        return static_cast<float>(total_terms) / num_docs;
+    }
+
+    /**
+     * Combines the statistics for another (disjoint) set of documents
+     * into this one.
+     * @param other The statistics to add
+     * @return this collection_stats
+     */
+    collection_stats& operator+=(const collection_stats& other)
+    {
+        num_docs += other.num_docs;
+        total_terms += other.total_terms;
+        return *this;
+    }
+};
+
+/**
+ * Statistics for a single term in an inverted_index.
+ */
+struct term_stats
+{
+    /// The number of documents the term occurs in
+    uint64_t doc_freq = 0;
+    /// The number of times the term occurs in the collection
+    uint64_t corpus_count = 0;
+
+    /**
+     * Combines the statistics for the same term in another (disjoint) set
+     * of documents into this one.
+     * @param other The statistics to add
+     * @return this term_stats
+     */
+    term_stats& operator+=(const term_stats& other)
+    {
+        doc_freq += other.doc_freq;
+        corpus_count += other.corpus_count;
+        return *this;
+    }
+};
+
+template <class OutputStream>
+uint64_t packed_write(OutputStream& os, const collection_stats& stats)
+{
+    using io::packed::write;
+    return write(os, stats.num_docs) + write(os, stats.total_terms);
+}
+
+template <class InputStream>
+uint64_t packed_read(InputStream& is, collection_stats& stats)
+{
+    using io::packed::read;
+    return read(is, stats.num_docs) + read(is, stats.total_terms);
+}
+}
+}
+#endif
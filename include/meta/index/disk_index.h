@@ -12,6 +12,7 @@
 #define META_DISK_INDEX_H_
 
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "meta/config.h"
@@ -191,6 +192,15 @@ class disk_index
      */
     disk_index& operator=(disk_index&&) = default;
 };
+
+/**
+ * Basic exception for disk_index interactions.
+ */
+class disk_index_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
 }
 }
 
@@ -10,6 +10,7 @@
 #ifndef META_INDEX_DISK_INDEX_IMPL_H_
 #define META_INDEX_DISK_INDEX_IMPL_H_
 
+#include <chrono>
 #include <mutex>
 
 #include "meta/config.h"
@@ -17,9 +18,12 @@
 #include "meta/index/metadata_file.h"
 #include "meta/index/string_list.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/io/mmap_file.h"
+#include "meta/logging/logger.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/invertible_map.h"
 #include "meta/util/optional.h"
+#include "meta/util/time.h"
 
 namespace meta
 {
@@ -43,6 +47,25 @@ enum index_file
     METADATA_INDEX
 };
 
+/**
+ * Options controlling how the components of an existing disk_index are
+ * brought into memory when it is opened. These are read from the optional
+ * `[index-load]` table of the configuration.
+ */
+struct load_options
+{
+    /// Whether components are opened on first use rather than up front
+    bool lazy = false;
+    /// The madvise() hint given for every memory-mapped component
+    util::optional<io::mmap_advice> advice;
+    /// Whether to ask for mapped components to be backed by huge pages
+    bool huge_pages = false;
+    /// Whether to read every page of a component into memory on open
+    bool prefault = false;
+    /// The number of threads used when prefaulting
+    unsigned prefault_threads = 1;
+};
+
 /**
  * The implementation of a disk_index.
  */
@@ -106,6 +129,63 @@ class disk_index::disk_index_impl
      */
     std::vector<class_label> class_labels() const;
 
+    /**
+     * @return the options used when opening this index
+     */
+    const load_options& options() const;
+
+    /**
+     * @return the metadata file, opening it if necessary
+     */
+    const metadata_file& metadata() const;
+
+    /**
+     * @return the term_id mapping, opening it if necessary
+     */
+    const vocabulary_map& term_id_mapping() const;
+
+    /**
+     * @return the document labels, opening them if necessary
+     */
+    const util::disk_vector<label_id>& labels() const;
+
+    /**
+     * @return the label_id mapping, reading it if necessary
+     */
+    const util::invertible_map<class_label, label_id>& label_ids() const;
+
+    /**
+     * Applies the load options (madvise hints, huge pages, and
+     * prefaulting) to a freshly opened memory-mapped component.
+     * @param component The component to prepare
+     */
+    template <class Component>
+    void prepare(const Component& component) const
+    {
+        if (options_.advice)
+            component.advise(*options_.advice);
+        if (options_.huge_pages)
+            component.advise(io::mmap_advice::huge_pages);
+        if (options_.prefault)
+            component.prefault(options_.prefault_threads);
+    }
+
+    /**
+     * Runs the function that opens an index component, logging how long
+     * it took so that the cost of opening an index can be broken down by
+     * component.
+     *
+     * @param component The name of the component being opened
+     * @param fn The function that opens the component
+     */
+    template <class Function>
+    static void timed_load(const char* component, Function&& fn)
+    {
+        auto time = common::time(std::forward<Function>(fn));
+        LOG(info) << "Loaded " << component << " in " << time.count() << "ms"
+                  << ENDLG;
+    }
+
   private:
     /**
      * @param lbl the string class label to find the id for
@@ -117,20 +197,35 @@ class disk_index::disk_index_impl
     /// the location of this index
     std::string index_name_;
 
+    /// how the components of this index are opened
+    load_options options_;
+
     /**
      * Maps which class a document belongs to (if any).
      * Each index corresponds to a doc_id (uint64_t).
      */
-    util::optional<util::disk_vector<label_id>> labels_;
+    mutable util::optional<util::disk_vector<label_id>> labels_;
 
     /// Stores additional metadata for each document
-    util::optional<metadata_file> metadata_;
+    mutable util::optional<metadata_file> metadata_;
 
     /// Maps string terms to term_ids.
-    util::optional<vocabulary_map> term_id_mapping_;
+    mutable util::optional<vocabulary_map> term_id_mapping_;
 
     /// Assigns an integer to each class label (used for liblinear mappings)
-    util::invertible_map<class_label, label_id> label_ids_;
+    mutable util::invertible_map<class_label, label_id> label_ids_;
+
+    /// guards lazily opening labels_
+    mutable std::once_flag labels_flag_;
+
+    /// guards lazily opening metadata_
+    mutable std::once_flag metadata_flag_;
+
+    /// guards lazily opening term_id_mapping_
+    mutable std::once_flag term_id_mapping_flag_;
+
+    /// guards lazily reading label_ids_
+    mutable std::once_flag label_ids_flag_;
 
     /// mutex for thread-safe operations
     mutable std::mutex mutex_;
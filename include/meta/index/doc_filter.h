@@ -0,0 +1,178 @@
+/**
+ * @file doc_filter.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_DOC_FILTER_H_
+#define META_INDEX_DOC_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/meta.h"
+#include "meta/succinct/broadword.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A set of documents stored as a bit vector with one bit per document in
+ * an index. Rankers accept a doc_filter anywhere they accept a filtering
+ * function; checking a document is then a single inlined bit test rather
+ * than a call through a std::function.
+ *
+ * Filters are meant to be built once (for example from metadata, or from
+ * the training documents of a classifier) and then reused across many
+ * queries. They can be combined with `&`, `|`, and `~`.
+ */
+class doc_filter
+{
+  public:
+    /**
+     * Creates an empty filter that accepts no documents.
+     */
+    doc_filter() = default;
+
+    /**
+     * @param num_docs The number of documents in the index
+     * @param value Whether every document is initially accepted
+     */
+    explicit doc_filter(uint64_t num_docs, bool value = false);
+
+    /**
+     * @param num_docs The number of documents in the index
+     * @param begin An iterator to the beginning of the accepted doc_ids
+     * @param end An iterator to the end of the accepted doc_ids
+     */
+    template <class InputIterator>
+    doc_filter(uint64_t num_docs, InputIterator begin, InputIterator end)
+        : doc_filter{num_docs}
+    {
+        for (; begin != end; ++begin)
+            set(doc_id{*begin});
+    }
+
+    /**
+     * Evaluates a predicate once for every document.
+     * @param num_docs The number of documents in the index
+     * @param pred The predicate to evaluate for each doc_id
+     * @return a filter accepting the documents for which pred is true
+     */
+    template <class Predicate>
+    static doc_filter from_predicate(uint64_t num_docs, Predicate&& pred)
+    {
+        doc_filter filter{num_docs};
+        for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        {
+            if (pred(d_id))
+                filter.set(d_id);
+        }
+        return filter;
+    }
+
+    /**
+     * @param d_id The document to check
+     * @return whether the document is accepted
+     */
+    bool contains(doc_id d_id) const
+    {
+        return d_id < num_docs_ && ((words_[d_id / 64] >> (d_id % 64)) & 1);
+    }
+
+    /**
+     * @param d_id The document to check
+     * @return whether the document is accepted
+     */
+    bool operator()(doc_id d_id) const
+    {
+        return contains(d_id);
+    }
+
+    /**
+     * @param d_id The document to accept or reject
+     * @param value Whether the document is accepted
+     */
+    void set(doc_id d_id, bool value = true);
+
+    /**
+     * @param d_id The document to start from
+     * @return the first accepted document with an id of at least d_id, or
+     * size() if there is none
+     */
+    doc_id next(doc_id d_id) const;
+
+    /**
+     * @return the number of documents the filter covers
+     */
+    uint64_t size() const;
+
+    /**
+     * @return the number of accepted documents, which is kept up to date
+     * as the filter is built rather than counted on each call
+     */
+    uint64_t count() const;
+
+    /**
+     * Calls fn with each accepted document, in increasing order of id.
+     * @param fn The function to call
+     */
+    template <class Function>
+    void for_each(Function&& fn) const
+    {
+        for (uint64_t i = 0; i < words_.size(); ++i)
+        {
+            for (auto word = words_[i]; word != 0; word &= word - 1)
+                fn(doc_id{i * 64 + succinct::broadword::lsb(word)});
+        }
+    }
+
+    /**
+     * Restricts this filter to documents also accepted by other.
+     * @param other The filter to intersect with
+     */
+    doc_filter& operator&=(const doc_filter& other);
+
+    /**
+     * Extends this filter to documents accepted by other.
+     * @param other The filter to union with
+     */
+    doc_filter& operator|=(const doc_filter& other);
+
+    /**
+     * @return a filter accepting exactly the documents this one rejects
+     */
+    doc_filter operator~() const;
+
+  private:
+    /// Clears the bits past the last document in the final word
+    void clear_tail();
+
+    /// Recounts the accepted documents after a whole-filter operation
+    void recount();
+
+    /// The number of documents covered
+    uint64_t num_docs_ = 0;
+    /// The number of accepted documents
+    uint64_t count_ = 0;
+    /// The bits, 64 documents per word
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @return a filter accepting the documents accepted by both a and b
+ */
+doc_filter operator&(doc_filter a, const doc_filter& b);
+
+/**
+ * @return a filter accepting the documents accepted by either a or b
+ */
+doc_filter operator|(doc_filter a, const doc_filter& b);
+}
+}
+#endif
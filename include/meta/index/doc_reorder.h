@@ -0,0 +1,138 @@
+/**
+ * @file doc_reorder.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_DOC_REORDER_H_
+#define META_INDEX_DOC_REORDER_H_
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/index/metadata_file.h"
+#include "meta/meta.h"
+#include "meta/util/disk_vector.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Functions for choosing a new numbering for the documents in an index
+ * before its postings are compressed. Documents with similar content
+ * placed next to one another yield smaller gaps in the postings lists,
+ * which both shrinks the index and improves locality when it is searched.
+ *
+ * All functions here return an *ordering*: a vector where element i is
+ * the (old) id of the document that should be given id i.
+ */
+namespace reorder
+{
+
+/**
+ * A document-term graph in compressed sparse row form: the terms of
+ * document d are terms[offsets[d]] through terms[offsets[d + 1]] (not
+ * inclusive). Terms are renumbered densely and only terms that occur in
+ * at least two documents are kept, since no other terms can affect the
+ * ordering.
+ */
+struct forward_graph
+{
+    /// The start of each document's terms, plus one past the end
+    std::vector<uint64_t> offsets;
+    /// The (renumbered) terms of each document
+    std::vector<uint32_t> terms;
+    /// The number of distinct terms in the graph
+    uint64_t num_terms = 0;
+
+    /**
+     * @return the number of documents in the graph
+     */
+    uint64_t num_docs() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+};
+
+/**
+ * Builds the document-term graph from an uncompressed inverted postings
+ * file (as written by postings_inverter::merge_chunks()).
+ *
+ * @param path The path to the uncompressed postings file
+ * @param num_docs The number of documents in the index
+ * @return the document-term graph for the postings
+ */
+forward_graph make_forward_graph(const std::string& path, uint64_t num_docs);
+
+/**
+ * Options for graph_bisection().
+ */
+struct bisection_options
+{
+    /// The number of swapping passes made at each level of recursion
+    uint64_t iterations = 20;
+    /// Partitions with at most this many documents are not split
+    uint64_t min_partition_size = 16;
+    /// The number of threads used to compute move gains
+    unsigned num_threads = 1;
+};
+
+/**
+ * Orders documents by recursive graph bisection (Dhulipala et al.,
+ * "Compressing Graphs and Indexes with Recursive Graph Bisection", KDD
+ * 2016). The documents are repeatedly split in half, swapping documents
+ * between the halves to minimize the estimated cost of encoding the gaps
+ * in each term's postings list.
+ *
+ * @param graph The document-term graph
+ * @param options The parameters for the algorithm
+ * @return the new ordering of the documents
+ */
+std::vector<doc_id> graph_bisection(const forward_graph& graph,
+                                    const bisection_options& options = {});
+
+/**
+ * Orders documents by the value of a metadata field, breaking ties by
+ * the original document id. Sorting by a URL or path field is a cheap
+ * way to place related documents next to one another.
+ *
+ * @param mdata The metadata for the index
+ * @param field The name of the field to sort by
+ * @return the new ordering of the documents
+ */
+std::vector<doc_id> by_metadata(const metadata_file& mdata,
+                                const std::string& field);
+
+/**
+ * Rearranges a vector of per-document values so that element i holds
+ * the value previously held by element order[i].
+ *
+ * @param vec The vector to rearrange
+ * @param order The new ordering of the documents
+ */
+template <class T>
+void permute(util::disk_vector<T>& vec, const std::vector<doc_id>& order)
+{
+    std::vector<T> old(vec.begin(), vec.end());
+    for (uint64_t i = 0; i < order.size(); ++i)
+        vec[i] = old[order[i]];
+}
+
+/**
+ * Basic exception for reordering.
+ */
+class reorder_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+}
+#endif
@@ -120,6 +120,14 @@ class ir_eval
      */
     void reset_stats();
 
+    /**
+     * @param q_id The query
+     * @param d_id The document
+     * @return the judged relevance of the document to the query, or zero
+     * if it was not judged
+     */
+    uint64_t relevance(query_id q_id, doc_id d_id) const;
+
   private:
     /**
      * query_id -> (doc_id -> relevance) mapping
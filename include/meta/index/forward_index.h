@@ -52,6 +52,15 @@ class forward_index_exception : public std::runtime_error
  * The forward_index stores information on a corpus by doc_ids.  Each doc_id key
  * is associated with a distribution of term_ids or term "counts" that occur in
  * that particular document.
+ *
+ * Setting `feature-hash-bits = N` in the configuration (1 to 32) indexes
+ * documents with hashed features instead (see
+ * analyzers::analyzer::analyze_hashed). The term_id of each feature is
+ * the low N bits of its id, so there are 2^N terms and no vocabulary is
+ * kept. Neither indexing nor tokenize() then builds strings for
+ * multi-word features. An index with hashed features cannot be created
+ * by uninverting, and get_term_id() and term_text() cannot be used with
+ * it.
  */
 class forward_index : public disk_index
 {
@@ -0,0 +1,187 @@
+/**
+ * @file impact_index.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_IMPACT_INDEX_H_
+#define META_INDEX_IMPACT_INDEX_H_
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/io/mmap_file.h"
+#include "meta/io/packed.h"
+#include "meta/meta.h"
+#include "meta/util/disk_vector.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+class inverted_index;
+
+/**
+ * An impact-ordered copy of the postings in an inverted_index. The score
+ * contribution of every posting is precomputed and quantized to a small
+ * integer (its *impact*), and each term's postings are grouped into
+ * segments of equal impact stored in decreasing impact order. This
+ * allows queries to be processed score-at-a-time, reading the most
+ * important postings first and stopping early (see saat_ranker).
+ *
+ * The impacts are computed when the inverted_index is created if the
+ * following table is present in the configuration:
+ * ~~~toml
+ * [impact-index]
+ * method = "bm25" # or "dirichlet-prior"
+ * k1 = 1.2        # bm25 only
+ * b = 0.75        # bm25 only
+ * mu = 2000.0     # dirichlet-prior only
+ * bits = 8        # number of bits per impact, at most 16
+ * ~~~
+ *
+ * The file format (impacts.index) is:
+ *
+ * - <Header> => <Method> <Quantum> <Mu>
+ * - <Term> => <NumSegments> <Segment>^<NumSegments>
+ * - <Segment> => <Impact> <NumDocs> <NumBytes> <DocGap>^<NumDocs>
+ *
+ * where every value is packed, <Quantum> is the score represented by an
+ * impact of one, and <NumBytes> is the size of the document gaps so that
+ * segments can be skipped without decoding them. The offset of each term
+ * is stored in impacts.index_index.
+ */
+class impact_index
+{
+  public:
+    /**
+     * A run of postings with the same impact.
+     */
+    class segment
+    {
+      public:
+        /**
+         * @param impact The impact of every posting in the segment
+         * @param size The number of postings in the segment
+         * @param docs The start of the document gaps
+         */
+        segment(uint64_t impact, uint64_t size, const char* docs)
+            : impact_{impact}, size_{size}, docs_{docs}
+        {
+            // nothing
+        }
+
+        /**
+         * @return the impact of every posting in the segment
+         */
+        uint64_t impact() const
+        {
+            return impact_;
+        }
+
+        /**
+         * @return the number of postings in the segment
+         */
+        uint64_t size() const
+        {
+            return size_;
+        }
+
+        /**
+         * Calls fn for the first n documents in this segment, in
+         * increasing order of id.
+         * @param n The number of documents to decode
+         * @param fn The function to call with each doc_id
+         */
+        template <class Function>
+        void for_each(uint64_t n, Function&& fn) const
+        {
+            char_input_stream stream{docs_};
+            uint64_t d_id = 0;
+            for (uint64_t i = 0; i < n && i < size_; ++i)
+            {
+                d_id += io::packed::read<uint64_t>(stream);
+                fn(doc_id{d_id});
+            }
+        }
+
+      private:
+        struct char_input_stream
+        {
+            char get()
+            {
+                return *input_++;
+            }
+
+            const char* input_;
+        };
+
+        uint64_t impact_;
+        uint64_t size_;
+        const char* docs_;
+    };
+
+    /**
+     * Opens the impacts for an inverted_index.
+     * @param idx The inverted_index the impacts were computed for
+     */
+    impact_index(const inverted_index& idx);
+
+    /**
+     * Computes the impacts for an inverted_index and writes them to its
+     * directory.
+     * @param idx The inverted_index to compute impacts for
+     * @param config The [impact-index] configuration table
+     */
+    static void create(const inverted_index& idx,
+                       const cpptoml::table& config);
+
+    /**
+     * @param t_id The term to look up
+     * @return the segments for the term, in decreasing order of impact
+     */
+    std::vector<segment> segments(term_id t_id) const;
+
+    /**
+     * @return the score represented by an impact of one
+     */
+    double quantum() const;
+
+    /**
+     * @return the Dirichlet prior if the impacts were computed for
+     * dirichlet-prior, or zero otherwise
+     */
+    double mu() const;
+
+  private:
+    /// The mapped impacts file
+    io::mmap_file file_;
+    /// The offset of each term in the impacts file
+    util::disk_vector<uint64_t> byte_locations_;
+    /// The score represented by an impact of one
+    double quantum_;
+    /// The Dirichlet prior (zero for bm25)
+    double mu_;
+};
+
+/**
+ * Basic exception for impact_index interactions.
+ */
+class impact_index_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
@@ -16,9 +16,11 @@
 
 #include "meta/analyzers/analyzer.h"
 #include "meta/config.h"
+#include "meta/index/collection_stats.h"
 #include "meta/index/disk_index.h"
 #include "meta/index/make_index.h"
 #include "meta/index/postings_stream.h"
+#include "meta/index/skip_index.h"
 
 namespace meta
 {
@@ -61,6 +63,35 @@ class inverted_index_exception : public std::runtime_error
  * postings file containing the (term_id -> each doc_id) information is saved on
  * disk. A lexicon (or "dictionary") contains pointers into the large postings
  * file. It is assumed that the lexicon will fit in memory.
+ *
+ * How an existing index is brought into memory when it is opened can be
+ * controlled with the following optional config parameters:
+ * ~~~toml
+ * [index-load]
+ * lazy = false          # open each component on first use instead
+ * advice = "random"     # "normal", "sequential", "random", or "will-need"
+ * huge-pages = false    # request transparent huge pages for mapped files
+ * prefault = false      # read every page of each component on open
+ * prefault-threads = 8  # default: hardware concurrency
+ * ~~~
+ * An unknown advice or a prefault-threads value below one throws a
+ * disk_index_exception.
+ *
+ * Documents can optionally be renumbered when the index is created so that
+ * similar documents receive nearby ids, which shrinks the postings file and
+ * improves locality at query time:
+ * ~~~toml
+ * [reorder]
+ * method = "graph-bisection" # or "metadata" to sort by a metadata field
+ * field = "path"             # the field to sort by ("metadata" only)
+ * iterations = 20            # swapping passes per level (bisection only)
+ * min-partition-size = 16    # smallest partition split (bisection only)
+ * ~~~
+ * The new ids are used consistently by the postings, metadata, and labels.
+ * The original (corpus order) id of every document is saved in
+ * `docs.order` in the index directory, so anything that refers to
+ * documents by their corpus position (such as relevance judgments) must
+ * be mapped through it.
  */
 class inverted_index : public disk_index
 {
@@ -131,6 +162,13 @@ class inverted_index : public disk_index
      */
     analyzers::feature_map<uint64_t> tokenize(const corpus::document& doc);
 
+    /**
+     * tokenize() shares a single analyzer, so threads that analyze text
+     * concurrently should each use their own copy.
+     * @return a copy of the analyzer used by this index
+     */
+    std::unique_ptr<analyzers::analyzer> make_analyzer() const;
+
     /**
      * @param t_id The term_id to search for
      * @return the postings data for a given term_id
@@ -144,6 +182,27 @@ class inverted_index : public disk_index
      */
     util::optional<postings_stream<doc_id>> stream_for(term_id t_id) const;
 
+    /**
+     * Finds a document in a term's postings without decoding the whole
+     * list before it, using the skip points written with the index.
+     *
+     * @param stream The postings of the term (from stream_for)
+     * @param t_id The term
+     * @param d_id The document to seek to
+     * @return an iterator to the first posting in the stream with a
+     * document id of at least d_id
+     */
+    postings_stream<doc_id>::iterator
+    seek(const postings_stream<doc_id>& stream, term_id t_id,
+         doc_id d_id) const;
+
+    /**
+     * @param t_id The term
+     * @return the skip points written for the term's postings, which are
+     * empty if the list is short or the index has no skip points
+     */
+    std::vector<skip_index::skip_point> skip_points(term_id t_id) const;
+
     /**
      * @param t_id The term to search for
      * @return the document frequency of a term (number of documents it
@@ -160,7 +219,7 @@ class inverted_index : public disk_index
     /**
      * @return the total number of terms in this index
      */
-    uint64_t total_corpus_terms();
+    uint64_t total_corpus_terms() const;
 
     /**
      * @param t_id The specified term
@@ -171,7 +230,20 @@ class inverted_index : public disk_index
     /**
      * @return the average document length in this index
      */
-    float avg_doc_length();
+    float avg_doc_length() const;
+
+    /**
+     * @return the collection-level statistics for this index, which are
+     * computed when the index is created
+     */
+    const collection_stats& stats() const;
+
+    /**
+     * @param t_id The term to look up
+     * @return the document frequency and corpus count for the term, read
+     * from the header of its postings list (without decoding it)
+     */
+    term_stats stats(term_id t_id) const;
 
   private:
     /**
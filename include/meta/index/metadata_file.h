@@ -71,6 +71,18 @@ class metadata_file
      */
     uint64_t size() const;
 
+    /**
+     * Advises the kernel about how the metadata will be accessed.
+     * @param advice The access pattern to expect
+     */
+    void advise(io::mmap_advice advice) const;
+
+    /**
+     * Reads every page of the metadata into memory.
+     * @param num_threads The number of threads to use
+     */
+    void prefault(unsigned num_threads = 1) const;
+
   private:
     /// the schema for this file
     corpus::metadata::schema_type schema_;
@@ -80,6 +80,26 @@ class postings_file
         return pdata;
     }
 
+    /**
+     * Advises the kernel about how the postings will be accessed.
+     * @param advice The access pattern to expect
+     */
+    void advise(io::mmap_advice advice) const
+    {
+        postings_.advise(advice);
+        byte_locations_.advise(advice);
+    }
+
+    /**
+     * Reads every page of the postings (and their index) into memory.
+     * @param num_threads The number of threads to use
+     */
+    void prefault(unsigned num_threads = 1) const
+    {
+        byte_locations_.prefault(num_threads);
+        postings_.prefault(num_threads);
+    }
+
   private:
     io::mmap_file postings_;
     util::disk_vector<uint64_t> byte_locations_;
@@ -212,6 +212,35 @@ class postings_stream
         return {};
     }
 
+    /**
+     * @param it An iterator into this list (not the end iterator)
+     * @return the number of bytes of encoded postings before the posting
+     * after it, so that the list can later be resumed there with seek()
+     */
+    uint64_t offset(const iterator& it) const
+    {
+        return static_cast<uint64_t>(it.stream_.input_ - start_);
+    }
+
+    /**
+     * Resumes decoding the list partway through.
+     *
+     * @param offset The offset() of an iterator into this list
+     * @param position The number of postings up to and including the one
+     * that iterator pointed to
+     * @param key The SecondaryKey of the posting that iterator pointed to
+     * @return an iterator to the posting after it
+     */
+    iterator seek(uint64_t offset, uint64_t position, SecondaryKey key) const
+    {
+        iterator it;
+        it.stream_ = char_input_stream{start_ + offset};
+        it.size_ = size_;
+        it.pos_ = position;
+        it.count_ = std::make_pair(key, FeatureValue{});
+        return ++it;
+    }
+
   private:
     const char* start_;
     uint64_t size_;
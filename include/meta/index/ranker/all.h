@@ -1,7 +1,10 @@
 #include "meta/index/ranker/ranker.h"
 #include "meta/index/ranker/absolute_discount.h"
+#include "meta/index/ranker/cascade_ranker.h"
 #include "meta/index/ranker/dirichlet_prior.h"
+#include "meta/index/ranker/feedback_ranker.h"
 #include "meta/index/ranker/jelinek_mercer.h"
 #include "meta/index/ranker/lm_ranker.h"
 #include "meta/index/ranker/okapi_bm25.h"
 #include "meta/index/ranker/pivoted_length.h"
+#include "meta/index/ranker/saat_ranker.h"
@@ -0,0 +1,256 @@
+/**
+ * @file cascade_ranker.h
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CASCADE_RANKER_H_
+#define META_CASCADE_RANKER_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "meta/index/forward_index.h"
+#include "meta/index/ranker/ranker.h"
+#include "meta/learn/instance.h"
+#include "meta/learn/sgd.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Computes the features of a query's candidate documents for re-ranking.
+ * For each candidate, the features are, in order:
+ *
+ * - the candidate's first-stage score
+ * - its score under each of the feature rankers
+ * - the log of its length and of its number of unique terms
+ * - the fraction of the query's terms it contains
+ * - the cosine similarity of its term counts and the query's
+ * - the value of each of the prior metadata fields
+ *
+ * Every feature is computed for every candidate in a single pass: the
+ * postings of each query term are read once, and only up to the last
+ * candidate, to find the candidates' term counts, and those counts are
+ * then scored by every feature ranker. Scoring the candidates with the
+ * rankers directly would read every postings list once per ranker. The
+ * norms of the documents' term vectors are read from a forward_index the
+ * first time each document is a candidate and cached after that.
+ *
+ * The index stores no term positions, so there is no proximity feature;
+ * the query term coverage is the nearest substitute.
+ *
+ * The term counts and norms are kept in buffers that are reused across
+ * queries, so a ranking_features should not be shared between threads.
+ */
+class ranking_features
+{
+  public:
+    /**
+     * @param idx The index to rank documents from
+     * @param fwd A forward index over the same documents
+     * @param rankers The rankers whose scores are features
+     * @param priors The names of the numeric metadata fields whose values
+     * are features
+     */
+    ranking_features(inverted_index& idx, forward_index& fwd,
+                     std::vector<std::unique_ptr<ranker>> rankers,
+                     std::vector<std::string> priors = {});
+
+    /**
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string or term_id and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param candidates The candidates and their first-stage scores
+     * @return the features of each candidate, in the same order
+     */
+    template <class ForwardIterator>
+    std::vector<learn::feature_vector>
+    compute(ForwardIterator begin, ForwardIterator end,
+            const std::vector<search_result>& candidates)
+    {
+        postings_.clear();
+        query_length_ = 0;
+        for (; begin != end; ++begin)
+        {
+            const auto& count = *begin;
+
+            using kv_traits = hashing::kv_traits<
+                typename std::decay<decltype(count)>::type>;
+
+            query_length_ += kv_traits::value(count);
+            auto t_id = detail::lookup_term(idx_, kv_traits::key(count));
+            auto pstream = idx_.stream_for(t_id);
+            if (!pstream)
+                continue;
+            postings_.emplace_back(*pstream, kv_traits::value(count), t_id);
+        }
+        return compute(candidates);
+    }
+
+    /**
+     * @param query The current query
+     * @param candidates The candidates and their first-stage scores
+     * @return the features of each candidate, in the same order
+     */
+    std::vector<learn::feature_vector>
+    compute(const corpus::document& query,
+            const std::vector<search_result>& candidates);
+
+    /**
+     * @return the number of features computed for each candidate
+     */
+    uint64_t size() const;
+
+    /**
+     * @return a name for each feature
+     */
+    std::vector<std::string> names() const;
+
+  private:
+    /**
+     * Computes the features of the candidates for the current query.
+     */
+    std::vector<learn::feature_vector>
+    compute(const std::vector<search_result>& candidates);
+
+    /**
+     * @return the norm of a document's term count vector
+     */
+    double doc_norm(doc_id d_id);
+
+    /**
+     * @return the value of a numeric metadata field of a document
+     */
+    double prior(const corpus::metadata& mdata, const std::string& name) const;
+
+    /// The index being searched
+    inverted_index& idx_;
+    /// The forward index the document vectors are read from
+    forward_index& fwd_;
+    /// The rankers whose scores are features
+    std::vector<std::unique_ptr<ranker>> rankers_;
+    /// The metadata fields whose values are features
+    std::vector<std::string> priors_;
+    /// The postings of the current query's terms
+    std::vector<detail::postings_context> postings_;
+    /// The total weight of the current query's terms
+    float query_length_;
+    /// The count of each query term in each candidate
+    std::vector<uint64_t> counts_;
+    /// The cached norm of each document (zero if not yet read)
+    std::vector<double> norms_;
+};
+
+/**
+ * Creates the ranking_features described by a configuration table:
+ * ~~~toml
+ * [cascade]
+ * priors = ["pagerank"] # optional numeric metadata fields
+ *
+ * [[cascade.rankers]]
+ * method = "bm25"
+ *
+ * [[cascade.rankers]]
+ * method = "dirichlet-prior"
+ * mu = 2000
+ * ~~~
+ *
+ * @param idx The index to rank documents from
+ * @param fwd A forward index over the same documents
+ * @param config The table to read from
+ * @return the ranking_features described by config
+ */
+ranking_features make_ranking_features(inverted_index& idx,
+                                       forward_index& fwd,
+                                       const cpptoml::table& config);
+
+/**
+ * Ranks documents in two stages. A first-stage ranker selects the best
+ * candidates for a query, and a linear model re-ranks them by their
+ * ranking_features. Only the candidates are ever scored by the model, so
+ * the cost of the second stage depends on the number of candidates rather
+ * than on the length of the query's postings lists.
+ *
+ * The model is a learn::sgd_model over ranking_features::size() features,
+ * and can be trained from the data written by the rank-features tool.
+ */
+class cascade_ranker
+{
+  public:
+    using filter_function_type = ranker::filter_function_type;
+
+    /**
+     * @param idx The index to rank documents from
+     * @param first_stage The ranker that selects the candidates
+     * @param features The features of the candidates
+     * @param model The model that scores the features
+     * @param num_candidates The number of candidates to re-rank
+     */
+    cascade_ranker(inverted_index& idx, ranker& first_stage,
+                   ranking_features& features, const learn::sgd_model& model,
+                   uint64_t num_candidates = 100);
+
+    /**
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string or term_id and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    template <class ForwardIterator>
+    std::vector<search_result>
+    score(ForwardIterator begin, ForwardIterator end,
+          uint64_t num_results = 10,
+          const filter_function_type& filter = ranker::passthrough)
+    {
+        auto candidates = first_stage_.score(idx_, begin, end,
+                                             num_candidates_, filter);
+        auto features = features_.compute(begin, end, candidates);
+        return rerank(std::move(candidates), features, num_results);
+    }
+
+    /**
+     * @param query The current query
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result>
+    score(const corpus::document& query, uint64_t num_results = 10,
+          const filter_function_type& filter = ranker::passthrough);
+
+  private:
+    /**
+     * Scores the candidates with the model and keeps the best ones.
+     */
+    std::vector<search_result>
+    rerank(std::vector<search_result> candidates,
+           const std::vector<learn::feature_vector>& features,
+           uint64_t num_results) const;
+
+    /// The index being searched
+    inverted_index& idx_;
+    /// The ranker that selects the candidates
+    ranker& first_stage_;
+    /// The features of the candidates
+    ranking_features& features_;
+    /// The model that scores the features
+    const learn::sgd_model& model_;
+    /// The number of candidates to re-rank
+    uint64_t num_candidates_;
+};
+}
+}
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file feedback_ranker.h
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_FEEDBACK_RANKER_H_
+#define META_FEEDBACK_RANKER_H_
+
+#include <utility>
+#include <vector>
+
+#include "meta/index/forward_index.h"
+#include "meta/index/ranker/ranker.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Parameters for pseudo-relevance feedback.
+ */
+struct feedback_options
+{
+    /// The ways of estimating the feedback model
+    enum class method_type
+    {
+        /// Averages the term frequencies of the feedback documents
+        rocchio,
+        /// Weights each feedback document by its query likelihood
+        rm3
+    };
+
+    /// The way the feedback model is estimated
+    method_type method = method_type::rocchio;
+    /// The number of top documents treated as relevant
+    uint64_t feedback_docs = 10;
+    /// The number of terms kept in the feedback model
+    uint64_t feedback_terms = 20;
+    /// The weight of the original query
+    float alpha = 1.0f;
+    /// The weight of the feedback model
+    float beta = 0.5f;
+};
+
+/**
+ * Reads feedback_options from a configuration table:
+ * ~~~toml
+ * [ranker.feedback]
+ * method = "rocchio" # or "rm3"
+ * docs = 10
+ * terms = 20
+ * alpha = 1.0 # original query weight; for rm3, the default is 0.5
+ * beta = 0.5  # feedback model weight
+ * ~~~
+ *
+ * @param config The table to read from
+ * @return the options described by config
+ */
+feedback_options make_feedback_options(const cpptoml::table& config);
+
+/**
+ * Runs queries with pseudo-relevance feedback. The query is first scored
+ * with a base ranker; the top documents are then assumed to be relevant
+ * and their term vectors (read from a forward_index) are combined into a
+ * feedback model. The best terms of that model are interpolated with the
+ * original query, and the expanded query is scored with the base ranker
+ * again.
+ *
+ * Both the original and the feedback model are normalized to sum to one
+ * before they are interpolated, and the result is scaled back to the
+ * length of the original query so that the base ranker sees weights on
+ * the same scale as unexpanded queries.
+ *
+ * The feedback model is accumulated in a dense array that is reused
+ * across queries, so a feedback_ranker should not be shared between
+ * threads.
+ */
+class feedback_ranker
+{
+  public:
+    using filter_function_type = ranker::filter_function_type;
+
+    /**
+     * @param idx The index to rank documents from
+     * @param fwd A forward index over the same documents
+     * @param base The ranker used for both passes
+     * @param options The feedback parameters
+     */
+    feedback_ranker(inverted_index& idx, forward_index& fwd, ranker& base,
+                    feedback_options options = {});
+
+    /**
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    template <class ForwardIterator>
+    std::vector<search_result>
+    score(ForwardIterator begin, ForwardIterator end,
+          uint64_t num_results = 10,
+          const filter_function_type& filter = ranker::passthrough)
+    {
+        query_.clear();
+        for (; begin != end; ++begin)
+        {
+            const auto& count = *begin;
+
+            using kv_traits = hashing::kv_traits<
+                typename std::decay<decltype(count)>::type>;
+
+            auto t_id = idx_.get_term_id(kv_traits::key(count));
+            if (t_id < weights_.size())
+                query_.emplace_back(t_id, kv_traits::value(count));
+        }
+        return rank(num_results, filter);
+    }
+
+    /**
+     * @param query The current query
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result>
+    score(const corpus::document& query, uint64_t num_results = 10,
+          const filter_function_type& filter = ranker::passthrough);
+
+    /**
+     * @return the expanded query used for the last call to score
+     */
+    const std::vector<std::pair<term_id, float>>& expanded_query() const;
+
+  private:
+    /**
+     * Expands the current query and scores it.
+     */
+    std::vector<search_result> rank(uint64_t num_results,
+                                    const filter_function_type& filter);
+
+    /**
+     * Adds the weighted term distribution of a feedback document to the
+     * accumulator.
+     */
+    void add_document(doc_id d_id, float weight);
+
+    /// The index being searched
+    inverted_index& idx_;
+    /// The forward index used to read the feedback documents
+    forward_index& fwd_;
+    /// The ranker used for both passes
+    ranker& base_;
+    /// The feedback parameters
+    feedback_options options_;
+    /// The inverted_index term_id for each forward_index term_id
+    std::vector<term_id> term_ids_;
+    /// The accumulated weight of every term (zero between queries)
+    std::vector<float> weights_;
+    /// The terms with non-zero weights
+    std::vector<term_id> touched_;
+    /// The current query
+    std::vector<std::pair<term_id, float>> query_;
+};
+}
+}
+#endif
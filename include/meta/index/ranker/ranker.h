@@ -9,10 +9,13 @@
 #ifndef META_RANKER_H_
 #define META_RANKER_H_
 
+#include <atomic>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "meta/meta.h"
+#include "meta/index/doc_filter.h"
 #include "meta/index/inverted_index.h"
 
 namespace meta
@@ -27,6 +30,11 @@ namespace index
 {
 struct score_data;
 }
+
+namespace parallel
+{
+class thread_pool;
+}
 }
 
 namespace meta
@@ -78,6 +86,23 @@ struct postings_context
     }
 };
 
+/**
+ * Looks up the term_id for a query term given as a string.
+ */
+template <class Key>
+term_id lookup_term(inverted_index& idx, const Key& key)
+{
+    return idx.get_term_id(key);
+}
+
+/**
+ * Query terms may also be given directly as term_ids.
+ */
+inline term_id lookup_term(inverted_index&, term_id t_id)
+{
+    return t_id;
+}
+
 struct ranker_context
 {
     template <class ForwardIterator, class FilterFunction>
@@ -96,7 +121,7 @@ struct ranker_context
                 typename std::decay<decltype(count)>::type>;
 
             query_length += kv_traits::value(count);
-            auto term = idx.get_term_id(kv_traits::key(count));
+            auto term = lookup_term(idx, kv_traits::key(count));
             auto pstream = idx.stream_for(term);
             if (!pstream)
                 continue;
@@ -122,6 +147,40 @@ struct ranker_context
 };
 }
 
+/**
+ * A query whose terms are required, optional, or excluded. Only documents
+ * that contain every `must` term (or, if there are none, at least one
+ * `should` term) and no `must_not` term are scored, and both `must` and
+ * `should` terms contribute to their scores.
+ *
+ * The terms are features as produced by the index's analyzer (see
+ * inverted_index::tokenize), paired with their query weights.
+ */
+struct boolean_query
+{
+    using term_list = std::vector<std::pair<std::string, float>>;
+
+    /// Terms every result must contain
+    term_list must;
+    /// Terms that only contribute to the score
+    term_list should;
+    /// Terms no result may contain
+    std::vector<std::string> must_not;
+};
+
+/**
+ * Creates a boolean_query from query text of the form `+must -not other`:
+ * words prefixed with `+` are required, words prefixed with `-` are
+ * excluded, and all other words are optional. The words of each of these
+ * clauses are analyzed together with the index's analyzer, and features
+ * that contain a sentence boundary tag are left out of the query.
+ *
+ * @param idx The index the query will be run against
+ * @param text The query text
+ * @return the boolean_query for the text
+ */
+boolean_query make_boolean_query(inverted_index& idx, const std::string& text);
+
 /**
  * Exception class for ranker interactions.
  */
@@ -148,7 +207,7 @@ class ranker
     /**
      * @param idx The index this ranker is operating on
      * @param begin A forward iterator to the beginning of the term
-     * weights (pairs of std::string and a weight)
+     * weights (pairs of std::string or term_id and a weight)
      * @param end A forward iterator to the end of the above range
      * @param num_results The number of results to return in the vector
      * @param filter A filtering function to apply to each doc_id; returns true
@@ -179,6 +238,130 @@ class ranker
                                          return true;
                                      });
 
+    /**
+     * @param idx The index this ranker is operating on
+     * @param query The current query
+     * @param num_results The number of results to return in the vector
+     * @param filter The documents that may be included in results
+     */
+    std::vector<search_result> score(inverted_index& idx,
+                                     const corpus::document& query,
+                                     uint64_t num_results,
+                                     const doc_filter& filter);
+
+    /**
+     * Scores only the documents that match a boolean_query. Required terms
+     * are intersected starting from the rarest one, so the postings of the
+     * more common terms are only advanced up to the candidates it
+     * produces; excluded terms and the filter are checked only for
+     * documents that survive the intersection.
+     *
+     * @param idx The index this ranker is operating on
+     * @param query The boolean query
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result> score(inverted_index& idx,
+                                     const boolean_query& query,
+                                     uint64_t num_results = 10,
+                                     const filter_function_type& filter
+                                     = passthrough);
+
+    /**
+     * Scores only the documents that contain every term of the query.
+     *
+     * @param idx The index this ranker is operating on
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns true
+     * if the document should be included in results
+     */
+    template <class ForwardIterator>
+    std::vector<search_result>
+    score_conjunctive(inverted_index& idx, ForwardIterator begin,
+                      ForwardIterator end, uint64_t num_results = 10,
+                      const filter_function_type& filter = passthrough)
+    {
+        boolean_query query;
+        for (; begin != end; ++begin)
+        {
+            const auto& count = *begin;
+
+            using kv_traits = hashing::kv_traits<
+                typename std::decay<decltype(count)>::type>;
+
+            query.must.emplace_back(kv_traits::key(count),
+                                    kv_traits::value(count));
+        }
+        return score(idx, query, num_results, filter);
+    }
+
+    /**
+     * Scores only the documents that contain every term of the query.
+     *
+     * @param idx The index this ranker is operating on
+     * @param query The current query
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result>
+    score_conjunctive(inverted_index& idx, const corpus::document& query,
+                      uint64_t num_results = 10,
+                      const filter_function_type& filter = passthrough);
+
+    /**
+     * Scores a query with its evaluation split across a thread pool. The
+     * documents are divided into a disjoint range of ids for each thread;
+     * each thread seeks to its range in every postings list, scores its
+     * slice into its own heap, and the heaps are merged at the end. The
+     * lowest score that can still make the results is shared between the
+     * threads, so no thread keeps documents that the others have already
+     * ruled out.
+     *
+     * The results are the same as those of score(), but expensive queries
+     * (ones with long postings lists) finish sooner. score_one(),
+     * initial_score(), and the filter are called concurrently, and the
+     * pool must not be the one running the caller.
+     *
+     * @param idx The index this ranker is operating on
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string or term_id and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param pool The thread pool to evaluate the query with
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns true
+     * if the document should be included in results
+     */
+    template <class ForwardIterator, class Function = bool (*)(doc_id)>
+    std::vector<search_result>
+    score_parallel(inverted_index& idx, ForwardIterator begin,
+                   ForwardIterator end, parallel::thread_pool& pool,
+                   uint64_t num_results = 10, Function&& filter = passthrough)
+    {
+        detail::ranker_context ctx{idx, begin, end, filter};
+        return rank(ctx, num_results, filter, pool);
+    }
+
+    /**
+     * Scores a query with its evaluation split across a thread pool (see
+     * above).
+     *
+     * @param idx The index this ranker is operating on
+     * @param query The current query
+     * @param pool The thread pool to evaluate the query with
+     * @param num_results The number of results to return in the vector
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result>
+    score_parallel(inverted_index& idx, const corpus::document& query,
+                   parallel::thread_pool& pool, uint64_t num_results = 10,
+                   const filter_function_type& filter = passthrough);
+
     /**
      * Computes the contribution to the score of a document for a matched
      * query term.
@@ -208,6 +391,42 @@ class ranker
     std::vector<search_result> rank(detail::ranker_context& ctx,
                                     uint64_t num_results,
                                     const filter_function_type& filter);
+
+    std::vector<search_result> rank(detail::ranker_context& ctx,
+                                    uint64_t num_results,
+                                    const doc_filter& filter);
+
+    std::vector<search_result> rank(detail::ranker_context& ctx,
+                                    uint64_t num_results,
+                                    const filter_function_type& filter,
+                                    parallel::thread_pool& pool);
+
+    std::vector<search_result> rank(detail::ranker_context& ctx,
+                                    uint64_t num_results,
+                                    const doc_filter& filter,
+                                    parallel::thread_pool& pool);
+
+    template <class Filter>
+    std::vector<search_result> rank_postings(detail::ranker_context& ctx,
+                                             uint64_t num_results,
+                                             const Filter& filter);
+
+    template <class Filter>
+    std::vector<search_result> rank_parallel(detail::ranker_context& ctx,
+                                             uint64_t num_results,
+                                             const Filter& filter,
+                                             parallel::thread_pool& pool);
+
+    /**
+     * Scores the documents in [cur_doc, last) into a heap. If a threshold
+     * is given, documents that score below it are skipped, and it is
+     * raised to the lowest score in the heap whenever the heap is full.
+     */
+    template <class Filter, class Heap>
+    void rank_range(detail::ranker_context& ctx,
+                    std::vector<detail::postings_context>& postings,
+                    doc_id cur_doc, doc_id last, const Filter& filter,
+                    Heap& results, std::atomic<float>* threshold);
 };
 }
 }
@@ -0,0 +1,157 @@
+/**
+ * @file saat_ranker.h
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_SAAT_RANKER_H_
+#define META_SAAT_RANKER_H_
+
+#include <chrono>
+#include <vector>
+
+#include "meta/index/impact_index.h"
+#include "meta/index/ranker/ranker.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Limits on the amount of work saat_ranker does for a single query. A
+ * limit of zero means that there is no limit.
+ */
+struct saat_budget
+{
+    /// The maximum number of postings to process
+    uint64_t postings = 0;
+    /// The maximum amount of time to spend processing postings
+    std::chrono::microseconds time{0};
+};
+
+/**
+ * A score-at-a-time query processor over an impact_index. The segments of
+ * all of the query terms are processed in decreasing order of their
+ * (query weighted) impact, so the postings that contribute most to the
+ * final scores are read first. Processing stops once every segment has
+ * been read or the budget for the query is exhausted, in which case the
+ * top documents are approximately correct.
+ *
+ * The time budget is checked before each segment is processed, so a query
+ * may overrun it by at most the time taken by a single segment.
+ *
+ * A saat_ranker keeps an accumulator for every document in the index and
+ * reuses it across queries, so each thread should use its own.
+ */
+class saat_ranker
+{
+  public:
+    using filter_function_type = ranker::filter_function_type;
+
+    /**
+     * @param idx The index to rank documents from
+     * @param impacts The impacts computed for idx
+     */
+    saat_ranker(inverted_index& idx, const impact_index& impacts);
+
+    /**
+     * @param begin A forward iterator to the beginning of the term
+     * weights (pairs of std::string and a weight)
+     * @param end A forward iterator to the end of the above range
+     * @param num_results The number of results to return in the vector
+     * @param budget The limits on the work done for the query
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    template <class ForwardIterator>
+    std::vector<search_result>
+    score(ForwardIterator begin, ForwardIterator end,
+          uint64_t num_results = 10, const saat_budget& budget = {},
+          const filter_function_type& filter = ranker::passthrough)
+    {
+        query_length_ = 0;
+        segments_.clear();
+        for (; begin != end; ++begin)
+        {
+            const auto& count = *begin;
+
+            using kv_traits = hashing::kv_traits<
+                typename std::decay<decltype(count)>::type>;
+
+            auto weight = kv_traits::value(count);
+            query_length_ += weight;
+            add_term(idx_.get_term_id(kv_traits::key(count)), weight);
+        }
+        return rank(num_results, budget, filter);
+    }
+
+    /**
+     * @param query The current query
+     * @param num_results The number of results to return in the vector
+     * @param budget The limits on the work done for the query
+     * @param filter A filtering function to apply to each doc_id; returns
+     * true if the document should be included in results
+     */
+    std::vector<search_result>
+    score(const corpus::document& query, uint64_t num_results = 10,
+          const saat_budget& budget = {},
+          const filter_function_type& filter = ranker::passthrough);
+
+    /**
+     * @return the number of postings processed for the last query
+     */
+    uint64_t postings_processed() const;
+
+    /**
+     * @return whether the last query stopped before processing all of
+     * its postings
+     */
+    bool terminated_early() const;
+
+  private:
+    /**
+     * A segment of a query term's postings, with its impact scaled by the
+     * weight of the term in the query.
+     */
+    struct query_segment
+    {
+        uint64_t impact;
+        impact_index::segment segment;
+    };
+
+    /**
+     * Adds the segments for a query term.
+     * @param t_id The term
+     * @param weight The weight of the term in the query
+     */
+    void add_term(term_id t_id, double weight);
+
+    /**
+     * Processes the segments for the current query.
+     */
+    std::vector<search_result> rank(uint64_t num_results,
+                                    const saat_budget& budget,
+                                    const filter_function_type& filter);
+
+    /// The index being searched
+    inverted_index& idx_;
+    /// The impacts for the index
+    const impact_index& impacts_;
+    /// The accumulated impact for every document (zero between queries)
+    std::vector<uint32_t> accumulators_;
+    /// The documents with non-zero accumulators
+    std::vector<doc_id> touched_;
+    /// The segments for the current query
+    std::vector<query_segment> segments_;
+    /// The total weight of the terms in the current query
+    double query_length_;
+    /// The number of postings processed for the last query
+    uint64_t postings_processed_;
+    /// Whether the last query stopped early
+    bool terminated_early_;
+};
+}
+}
+#endif
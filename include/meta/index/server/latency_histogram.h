@@ -0,0 +1,76 @@
+/**
+ * @file latency_histogram.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_LATENCY_HISTOGRAM_H_
+#define META_INDEX_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "meta/config.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A histogram of request latencies with power-of-two bucket boundaries
+ * (in microseconds). Recording is lock-free, so any number of threads may
+ * record latencies concurrently.
+ */
+class latency_histogram
+{
+  public:
+    /// The number of buckets; the last one holds everything over ~36 min
+    const static uint64_t num_buckets = 32;
+
+    latency_histogram();
+
+    /**
+     * Records the latency of a single request.
+     * @param latency The time taken by the request
+     */
+    void record(std::chrono::microseconds latency);
+
+    /**
+     * @return the number of latencies recorded
+     */
+    uint64_t count() const;
+
+    /**
+     * @return the mean of the latencies recorded
+     */
+    std::chrono::microseconds mean() const;
+
+    /**
+     * @param p The percentile to compute, on [0, 1]
+     * @return an upper bound on the latency at that percentile (the upper
+     * boundary of the bucket containing it)
+     */
+    std::chrono::microseconds percentile(double p) const;
+
+    /**
+     * Prints a summary (count, mean, and percentiles) and the non-empty
+     * buckets.
+     * @param os The stream to print to
+     */
+    void print(std::ostream& os) const;
+
+  private:
+    /// The number of latencies in [2^(i-1), 2^i) microseconds
+    std::array<std::atomic<uint64_t>, num_buckets> buckets_;
+    /// The sum of all latencies recorded, in microseconds
+    std::atomic<uint64_t> total_;
+};
+}
+}
+#endif
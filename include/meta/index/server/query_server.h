@@ -0,0 +1,196 @@
+/**
+ * @file query_server.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_QUERY_SERVER_H_
+#define META_INDEX_QUERY_SERVER_H_
+
+#include <atomic>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/analyzers/analyzer.h"
+#include "meta/config.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/ranker/ranker.h"
+#include "meta/index/server/latency_histogram.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/string_view.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A single search request.
+ */
+struct query_request
+{
+    /// The request id (a JSON string or number, echoed back as JSON)
+    std::string id = "null";
+    /// The query text
+    std::string query;
+    /// The ranker to use, or empty for the server's default
+    std::string ranker;
+    /// The number of results to return
+    uint64_t top_k = 10;
+    /// A command instead of a query ("stats" or "shutdown"), if any
+    std::string command;
+};
+
+/**
+ * Parses a request from a single line of JSON, an object like
+ * ~~~json
+ * {"id": 1, "query": "text", "ranker": "bm25", "top_k": 10}
+ * ~~~
+ * where every key except "query" is optional, and the id is a string or
+ * a number. Instead of a query, the
+ * object may have a "command": "stats" reports the latency histogram,
+ * and "shutdown" stops a server listening on a socket.
+ *
+ * @param line The line to parse
+ * @return the request
+ */
+query_request parse_request(util::string_view line);
+
+/**
+ * Serves search requests against a resident inverted_index. Requests are
+ * newline-delimited JSON objects (see parse_request), read from a stream
+ * or from the connections to a Unix domain socket; each response is a
+ * single line of JSON:
+ * ~~~json
+ * {"id": 1, "results": [{"doc_id": 12, "name": "...", "score": 3.1}],
+ *  "time_us": 250}
+ * ~~~
+ * or `{"id": 1, "error": "..."}` if the request could not be handled.
+ *
+ * The requests that are already available when one is read are handled
+ * together as a batch, spread across a pool of worker threads; responses
+ * are written in the order the requests arrived. Each worker has its own
+ * analyzer and its own rankers, which are created from the configuration
+ * the first time a worker sees a ranker method.
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [server]
+ * threads = 8     # default is the hardware concurrency
+ * max-batch = 64  # the most requests handled together
+ * ~~~
+ */
+class query_server
+{
+  public:
+    /**
+     * @param idx The index to search
+     * @param config The configuration; its [ranker] table is the default
+     * ranker, and the optional [server] table is read as above
+     */
+    query_server(std::shared_ptr<inverted_index> idx,
+                 const cpptoml::table& config);
+
+    /**
+     * Handles requests from a stream until it ends. The requests that
+     * the stream's buffer reports as available (see
+     * std::streambuf::in_avail) are batched with the one just read; a
+     * std::cin that is synchronized with stdio never reports any, so
+     * call std::ios_base::sync_with_stdio(false) before serving it.
+     *
+     * @param in The stream to read requests from
+     * @param out The stream to write responses to
+     */
+    void serve(std::istream& in, std::ostream& out);
+
+    /**
+     * Listens on a Unix domain socket, handling requests from each
+     * connection until a "shutdown" command is received.
+     * @param path The path of the socket to create
+     */
+    void serve_socket(const std::string& path);
+
+    /**
+     * Handles a single request.
+     * @param line The request, a line of JSON
+     * @return the response, a line of JSON (without the newline)
+     */
+    std::string handle(const std::string& line);
+
+    /**
+     * @return the latencies of the queries handled so far, including
+     * the ones that failed
+     */
+    const latency_histogram& latencies() const;
+
+  private:
+    /**
+     * The state used by each worker thread.
+     */
+    struct worker
+    {
+        /// This thread's copy of the index's analyzer
+        std::unique_ptr<analyzers::analyzer> analyzer;
+        /// This thread's rankers, by method
+        std::unordered_map<std::string, std::unique_ptr<ranker>> rankers;
+    };
+
+    /**
+     * Handles a batch of requests on the worker threads.
+     * @param lines The requests
+     * @return the responses, in the same order
+     */
+    std::vector<std::string>
+    handle_batch(const std::vector<std::string>& lines);
+
+    /**
+     * Handles a single request on the current worker thread.
+     */
+    std::string handle(const std::string& line, worker& w);
+
+    /**
+     * Serves a single socket connection.
+     * @param fd The connected socket
+     */
+    void serve_connection(int fd);
+
+    /// The index being searched
+    std::shared_ptr<inverted_index> idx_;
+    /// The default ranker configuration
+    std::shared_ptr<cpptoml::table> ranker_config_;
+    /// The most requests handled together
+    uint64_t max_batch_;
+    /// The worker threads
+    parallel::thread_pool pool_;
+    /// The state for each thread in the pool
+    std::unordered_map<std::thread::id, worker> workers_;
+    /// The latencies of the requests handled
+    latency_histogram latencies_;
+    /// Whether a shutdown has been requested
+    std::atomic<bool> shutdown_;
+};
+
+/**
+ * Basic exception for query_server interactions.
+ */
+class query_server_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
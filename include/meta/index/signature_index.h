@@ -0,0 +1,251 @@
+/**
+ * @file signature_index.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_SIGNATURE_INDEX_H_
+#define META_INDEX_SIGNATURE_INDEX_H_
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/analyzers/featurizer.h"
+#include "meta/config.h"
+#include "meta/meta.h"
+#include "meta/util/array_view.h"
+#include "meta/util/disk_vector.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+class inverted_index;
+struct search_result;
+
+/**
+ * The parameters for computing document signatures.
+ */
+struct signature_options
+{
+    enum class method_type
+    {
+        minhash,
+        simhash
+    };
+
+    /// How signatures are computed
+    method_type method = method_type::minhash;
+    /// The number of LSH bands
+    uint64_t bands = 16;
+    /// The number of hashes in each band (minhash only; a simhash band
+    /// is 64 / bands bits of its fingerprint)
+    uint64_t rows = 4;
+
+    /**
+     * @return the number of 64-bit values in each document's signature
+     */
+    uint64_t width() const;
+};
+
+/**
+ * Reads the signature options from a configuration table:
+ * ~~~toml
+ * [signatures]
+ * method = "minhash" # or "simhash"
+ * bands = 16
+ * rows = 4           # minhash only
+ * ~~~
+ * @param config The table to read
+ * @return the options
+ */
+signature_options make_signature_options(const cpptoml::table& config);
+
+/**
+ * Computes the signature of a single document.
+ *
+ * For minhash, the signature is bands * rows minimum hash values of the
+ * document's set of features, and the fraction of positions where two
+ * signatures agree estimates the Jaccard similarity of their documents.
+ * For simhash, the signature is a single 64-bit fingerprint where each
+ * bit is the sign of the count-weighted sum of that bit over the
+ * features' hashes, so similar documents differ in few bits.
+ *
+ * @param options The signature options
+ * @param counts The analyzer output for the document
+ * @param out Where to write the options.width() values of the signature
+ */
+void compute_signature(const signature_options& options,
+                       const analyzers::feature_map<uint64_t>& counts,
+                       uint64_t* out);
+
+/**
+ * Writes the signatures of the documents in an index as they are
+ * tokenized. Signatures are written directly into their mapped column,
+ * so documents may be written concurrently from many threads.
+ */
+class signature_writer
+{
+  public:
+    /**
+     * @param prefix The index directory
+     * @param num_docs The number of documents in the index
+     * @param options The signature options
+     */
+    signature_writer(const std::string& prefix, uint64_t num_docs,
+                     signature_options options);
+
+    /**
+     * Computes and writes a document's signature.
+     * @param d_id The document
+     * @param counts The analyzer output for the document
+     */
+    void write(doc_id d_id, const analyzers::feature_map<uint64_t>& counts);
+
+    /**
+     * Moves each signature to its document's new id after the documents
+     * have been reordered.
+     * @param new_ids The new id of each document
+     */
+    void reorder(const std::vector<doc_id>& new_ids);
+
+  private:
+    /// The signature options
+    signature_options options_;
+    /// The signatures, options_.width() values per document
+    util::disk_vector<uint64_t> signatures_;
+};
+
+/**
+ * The signatures of the documents in an inverted_index, with an LSH
+ * banding table for finding near-duplicate documents without comparing
+ * every pair. Two documents are candidates if they agree on every value
+ * in at least one band, which makes highly similar documents very likely
+ * to be found while dissimilar ones rarely are.
+ *
+ * The signatures are computed from the analyzer's output when the
+ * inverted_index is created if a [signatures] table is present in the
+ * configuration (see make_signature_options). They are stored in
+ * signatures.index, a mapped column of options.width() values per
+ * document, and the options in signatures.header.
+ *
+ * Documents with no features all have the same signature, so they are
+ * left out of the banding table and are similar only to themselves.
+ */
+class signature_index
+{
+  public:
+    /**
+     * Opens the signatures for an inverted_index and builds the banding
+     * table.
+     * @param idx The inverted_index the signatures were computed for
+     */
+    signature_index(const inverted_index& idx);
+
+    /**
+     * @param idx An inverted_index
+     * @return whether signatures were computed for it
+     */
+    static bool exists(const inverted_index& idx);
+
+    /**
+     * @return the options the signatures were computed with
+     */
+    const signature_options& options() const;
+
+    /**
+     * @return the number of documents
+     */
+    uint64_t num_docs() const;
+
+    /**
+     * @param d_id The document
+     * @return the document's signature
+     */
+    util::array_view<const uint64_t> signature(doc_id d_id) const;
+
+    /**
+     * @return the estimated similarity of two documents on [0, 1]: the
+     * Jaccard similarity for minhash, or one minus the fraction of
+     * differing bits for simhash (zero if only one of them is a document
+     * with no features)
+     */
+    double similarity(doc_id a, doc_id b) const;
+
+    /**
+     * @param d_id The document
+     * @return the documents that share at least one band with d_id, in
+     * increasing order of id (not including d_id itself, and empty if
+     * d_id has no features)
+     */
+    std::vector<doc_id> candidates(doc_id d_id) const;
+
+    /**
+     * Groups the documents into clusters of near-duplicates. Each
+     * document's candidates are verified in parallel, and documents whose
+     * similarity is at least the threshold are joined transitively.
+     *
+     * @param threshold The minimum similarity of a duplicate pair
+     * @param num_threads The number of threads to use
+     * @return the clusters of more than one document, each in increasing
+     * order of id
+     */
+    std::vector<std::vector<doc_id>>
+    clusters(double threshold,
+             unsigned num_threads = std::thread::hardware_concurrency()) const;
+
+  private:
+    /**
+     * @return the hash of band b of d_id's signature
+     */
+    uint64_t band_hash(doc_id d_id, uint64_t b) const;
+
+    /// The options the signatures were computed with
+    signature_options options_;
+    /// The number of documents
+    uint64_t num_docs_;
+    /// The signatures, options_.width() values per document
+    util::disk_vector<uint64_t> signatures_;
+    /// Whether each document has no features
+    std::vector<bool> empty_;
+    /// For each band, the documents with each band hash
+    std::vector<std::unordered_map<uint64_t, std::vector<doc_id>>> bands_;
+};
+
+/**
+ * Removes the results that are near-duplicates of a higher ranked
+ * result.
+ *
+ * @param sigs The signatures of the index the results are from
+ * @param results The ranked results to collapse
+ * @param threshold The minimum similarity of a duplicate
+ * @param n The most results to keep
+ * @return the remaining results, in their original order
+ */
+std::vector<search_result>
+collapse_duplicates(const signature_index& sigs,
+                    const std::vector<search_result>& results,
+                    double threshold, uint64_t n);
+
+/**
+ * Basic exception for signature_index interactions.
+ */
+class signature_index_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
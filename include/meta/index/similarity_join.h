@@ -0,0 +1,99 @@
+/**
+ * @file similarity_join.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_SIMILARITY_JOIN_H_
+#define META_INDEX_SIMILARITY_JOIN_H_
+
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/graph/directed_graph.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace index
+{
+
+class forward_index;
+
+/**
+ * The parameters for an all-pairs similarity join.
+ */
+struct similarity_join_options
+{
+    /// The minimum cosine similarity of a pair of documents, on (0, 1]
+    double threshold = 0.5;
+    /// The most neighbors to keep for each document, or zero to keep
+    /// every pair over the threshold
+    uint64_t top_k = 0;
+    /// The number of threads to use
+    unsigned num_threads = std::thread::hardware_concurrency();
+};
+
+/**
+ * For each document, its neighbors and their similarities in decreasing
+ * order of similarity.
+ */
+using similarity_lists = std::vector<std::vector<std::pair<doc_id, double>>>;
+
+/**
+ * Finds every pair of documents whose tf-idf vectors have a cosine
+ * similarity of at least a threshold, without comparing every pair.
+ *
+ * The features are ordered from most to least frequent, and each vector
+ * is split into a prefix that is not indexed and a suffix that is: the
+ * prefix is as long as possible while its norm stays below the threshold,
+ * so any pair over the threshold must share an indexed feature (prefix
+ * filtering). The postings of the indexed suffixes are much shorter than
+ * those of a full inverted index, since the most frequent features are
+ * mostly left out. Candidates are then verified with the bound given by
+ * the norm of their unindexed prefix (as in L2AP) before their exact
+ * similarity is computed.
+ *
+ * The documents are partitioned across threads, each with its own
+ * accumulator, and every document's neighbors are written directly into
+ * the result.
+ *
+ * @param fwd The forward index of the documents
+ * @param options The threshold, top-k, and number of threads
+ * @return the similarity lists; with a top_k, each document's list holds
+ * at most top_k neighbors, and otherwise the lists are symmetric
+ */
+similarity_lists all_pairs_similarity(const forward_index& fwd,
+                                      const similarity_join_options& options
+                                      = {});
+
+/**
+ * Converts similarity lists into a graph with a node for each document
+ * (labeled with its name) and an edge from each document to each of its
+ * neighbors, weighted by their similarity. The graph can be passed
+ * directly to the algorithms in graph::algorithms, such as
+ * page_rank_centrality.
+ *
+ * @param fwd The forward index the lists were computed from
+ * @param lists The similarity lists
+ * @return the similarity graph
+ */
+graph::directed_graph<> make_similarity_graph(const forward_index& fwd,
+                                              const similarity_lists& lists);
+
+/**
+ * Basic exception for similarity join interactions.
+ */
+class similarity_join_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file skip_index.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_SKIP_INDEX_H_
+#define META_INDEX_SKIP_INDEX_H_
+
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/index/postings_stream.h"
+#include "meta/io/mmap_file.h"
+#include "meta/meta.h"
+#include "meta/util/disk_vector.h"
+
+namespace meta
+{
+namespace index
+{
+
+class inverted_index;
+
+/**
+ * Skip points into the postings lists of an inverted_index. The postings
+ * are gap encoded, so reaching a document in the middle of a list would
+ * otherwise mean decoding every posting before it; with a skip point
+ * every skip_index::interval postings, a list can be resumed close to any
+ * document instead.
+ *
+ * The skip points are written when the inverted_index is created. The
+ * file format (postings.skips) is:
+ *
+ * - <Term> => <NumSkips> <Skip>^<NumSkips>
+ * - <Skip> => <DocId> <Position> <Offset>
+ *
+ * where every value is packed, and each skip is taken after the
+ * <Position>-th posting of the list, whose document is <DocId>; <Offset>
+ * is the postings_stream::offset() of the posting after it. Lists of at
+ * most interval postings have no skips. The offset of each term is stored
+ * in postings.skips_index.
+ */
+class skip_index
+{
+  public:
+    /// The number of postings between skip points
+    const static uint64_t interval = 128;
+
+    /**
+     * A place a postings list can be resumed from.
+     */
+    struct skip_point
+    {
+        /// The document of the posting the skip is taken after
+        doc_id key;
+        /// The number of postings up to and including that one
+        uint64_t position;
+        /// The postings_stream::offset() of the posting after it
+        uint64_t offset;
+    };
+
+    /**
+     * Opens the skip points for an inverted_index.
+     * @param idx The inverted_index the skip points were written for
+     */
+    skip_index(const inverted_index& idx);
+
+    /**
+     * Writes the skip points for an inverted_index to its directory.
+     * @param idx The inverted_index to write skip points for
+     */
+    static void create(const inverted_index& idx);
+
+    /**
+     * @param idx An inverted_index
+     * @return whether skip points were written for it
+     */
+    static bool exists(const inverted_index& idx);
+
+    /**
+     * @param t_id The term
+     * @return the skip points of the term's postings, in increasing
+     * order of document
+     */
+    std::vector<skip_point> points(term_id t_id) const;
+
+    /**
+     * @param stream The postings of the term
+     * @param t_id The term
+     * @param d_id The document to seek to
+     * @return an iterator to the first posting in the stream with a
+     * document id of at least d_id
+     */
+    postings_stream<doc_id>::iterator
+    seek(const postings_stream<doc_id>& stream, term_id t_id,
+         doc_id d_id) const;
+
+  private:
+    /// The mapped skips file
+    io::mmap_file file_;
+    /// The offset of each term in the skips file
+    util::disk_vector<uint64_t> byte_locations_;
+};
+}
+}
+#endif
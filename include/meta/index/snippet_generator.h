@@ -0,0 +1,149 @@
+/**
+ * @file snippet_generator.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_SNIPPET_GENERATOR_H_
+#define META_INDEX_SNIPPET_GENERATOR_H_
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/analyzers/analyzer.h"
+#include "meta/config.h"
+#include "meta/meta.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace corpus
+{
+class document;
+}
+
+namespace index
+{
+
+class inverted_index;
+
+/**
+ * Parameters for snippet generation.
+ */
+struct snippet_options
+{
+    /// The string metadata field holding each document's text
+    std::string field = "content";
+    /// The number of words in each fragment
+    uint64_t window = 20;
+    /// The maximum number of fragments per snippet
+    uint64_t max_fragments = 2;
+    /// Inserted before each word that matches the query
+    std::string open_tag = "<b>";
+    /// Inserted after each word that matches the query
+    std::string close_tag = "</b>";
+};
+
+/**
+ * The highlighted passages of a document that best match a query.
+ */
+struct snippet
+{
+    /// The document the snippet is from
+    doc_id d_id;
+    /// The fragments of text, in document order
+    std::vector<std::string> fragments;
+};
+
+/**
+ * Creates query-biased snippets for search results. The stored text of
+ * each result is read in place from the index's metadata, split into
+ * words, and each distinct word is run through the index's analyzer to
+ * find the ones that produce a query feature. The windows of words with
+ * the largest total (idf weighted) matches become the snippet's
+ * fragments, with the matching words highlighted.
+ *
+ * The results of a query are processed in parallel; each thread has its
+ * own copy of the analyzer.
+ */
+class snippet_generator
+{
+  public:
+    /**
+     * @param idx The index the results are from; its metadata must
+     * include the text field named in options
+     * @param options The snippet parameters
+     * @param num_threads The number of threads to use
+     */
+    snippet_generator(inverted_index& idx, snippet_options options = {},
+                      unsigned num_threads
+                      = std::thread::hardware_concurrency());
+
+    /**
+     * @param query The query the results were ranked for
+     * @param begin An iterator to the beginning of the results (anything
+     * with a d_id member, like search_result)
+     * @param end An iterator to the end of the results
+     * @return a snippet for each result, in the same order
+     */
+    template <class ForwardIterator>
+    std::vector<snippet> generate(const corpus::document& query,
+                                  ForwardIterator begin, ForwardIterator end)
+    {
+        std::vector<doc_id> docs;
+        for (; begin != end; ++begin)
+            docs.push_back(begin->d_id);
+        return generate(query, docs);
+    }
+
+    /**
+     * @param query The query the documents were ranked for
+     * @param docs The documents to create snippets for
+     * @return a snippet for each document, in the same order
+     */
+    std::vector<snippet> generate(const corpus::document& query,
+                                  const std::vector<doc_id>& docs);
+
+  private:
+    /**
+     * The state used by each thread.
+     */
+    struct worker
+    {
+        /// This thread's copy of the index's analyzer
+        std::unique_ptr<analyzers::analyzer> analyzer;
+        /// The query weight of each word seen so far for this query
+        std::unordered_map<std::string, double> word_weights;
+    };
+
+    /**
+     * Creates the snippet for a single document.
+     */
+    snippet make_snippet(doc_id d_id, worker& w) const;
+
+    /**
+     * @return the query weight of a word, analyzing it if it has not been
+     * seen yet
+     */
+    double weight(util::string_view word, worker& w) const;
+
+    /// The index the results are from
+    inverted_index& idx_;
+    /// The snippet parameters
+    snippet_options options_;
+    /// The weight of each feature of the current query
+    std::unordered_map<std::string, double> query_weights_;
+    /// The threads used to create snippets
+    parallel::thread_pool pool_;
+    /// The state for each thread in the pool
+    std::unordered_map<std::thread::id, worker> workers_;
+};
+}
+}
+#endif
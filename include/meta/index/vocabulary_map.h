@@ -106,6 +106,18 @@ class vocabulary_map
      * The number of terms in the map.
      */
     uint64_t size() const;
+
+    /**
+     * Advises the kernel about how the map will be accessed.
+     * @param advice The access pattern to expect
+     */
+    void advise(io::mmap_advice advice) const;
+
+    /**
+     * Reads every page of the map into memory.
+     * @param num_threads The number of threads to use
+     */
+    void prefault(unsigned num_threads = 1) const;
 };
 }
 }
@@ -16,6 +16,7 @@
 
 #include "meta/config.h"
 #include "meta/meta.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -43,6 +44,21 @@ class_label label(const std::string& text);
  */
 counts_t counts(const std::string& text, bool contains_label = true);
 
+/**
+ * Parses a labeled line of libsvm-formatted data without allocating. This
+ * is intended for bulk ingestion: the features are written into a
+ * caller-owned buffer that can be reused from line to line, and the label
+ * is returned as a view into the line itself.
+ *
+ * @param line A libsvm-formatted line; throws an exception if it can't be
+ * parsed correctly
+ * @param counts The buffer to place the (feature, count) pairs in (it is
+ * cleared first)
+ * @return the class label of the line
+ */
+util::string_view parse(util::string_view line,
+                        std::vector<std::pair<term_id, double>>& counts);
+
 /**
  * Exception class for this parser.
  */
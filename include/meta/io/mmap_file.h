@@ -20,6 +20,41 @@ namespace meta
 namespace io
 {
 
+/**
+ * Hints that can be given to the kernel about how a memory-mapped region
+ * is going to be accessed. These correspond to the advice values accepted
+ * by madvise(2).
+ */
+enum class mmap_advice
+{
+    normal,
+    sequential,
+    random,
+    will_need,
+    huge_pages
+};
+
+/**
+ * Advises the kernel about the expected access pattern for a mapped
+ * region. This is only a hint: it is silently ignored on platforms (or
+ * for advice values) that do not support it.
+ *
+ * @param start The (page-aligned) beginning of the mapped region
+ * @param length The length of the region in bytes
+ * @param advice The access pattern to expect
+ */
+void advise(const void* start, uint64_t length, mmap_advice advice);
+
+/**
+ * Touches every page of a mapped region so that later accesses do not
+ * incur page faults.
+ *
+ * @param start The beginning of the mapped region
+ * @param length The length of the region in bytes
+ * @param num_threads The number of threads to split the pages across
+ */
+void prefault(const void* start, uint64_t length, unsigned num_threads = 1);
+
 /**
  * Memory maps a text file readonly.
  */
@@ -71,6 +106,18 @@ class mmap_file
      */
     char* begin() const;
 
+    /**
+     * Advises the kernel about how this file will be accessed.
+     * @param advice The access pattern to expect
+     */
+    void advise(mmap_advice advice) const;
+
+    /**
+     * Reads every page of this file into memory.
+     * @param num_threads The number of threads to use
+     */
+    void prefault(unsigned num_threads = 1) const;
+
   private:
     /// Filename of the text file
     std::string path_;
@@ -0,0 +1,271 @@
+/**
+ * @file ascii.h
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTF_ASCII_H_
+#define META_UTF_ASCII_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "meta/config.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace utf
+{
+
+/*
+ * Functions for checking and transforming the ASCII parts of utf8 strings
+ * without decoding them. These read eight bytes at a time (as one 64-bit
+ * word) and test every byte of the word at once with "broadword" bit
+ * operations, so they are much faster than decoding and classifying one
+ * codepoint at a time. They are meant to be a fast path in front of the
+ * general (ICU) functions in utf.h, which are then only needed for the
+ * parts of a string that aren't ASCII.
+ *
+ * The character classes are those of the "C" locale, so for an ASCII
+ * character they agree with the functions of the same names in <cctype>.
+ * Bytes that aren't ASCII never belong to any of them.
+ */
+
+namespace detail
+{
+/**
+ * @param byte A byte value
+ * @return a word with every byte set to that value
+ */
+constexpr uint64_t broadcast(uint8_t byte)
+{
+    return 0x0101010101010101ULL * byte;
+}
+
+/// The high bit of every byte of a word
+constexpr uint64_t high_bits = broadcast(0x80);
+
+/**
+ * @param data The bytes to read, of which there must be at least eight
+ * @return the first eight bytes as a word
+ */
+inline uint64_t load(const char* data)
+{
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+/**
+ * @param c A byte
+ * @return a word holding only that byte in its lowest eight bits, which
+ * the functions below can test in the same way as a word of eight bytes
+ */
+inline uint64_t widen(char c)
+{
+    return static_cast<unsigned char>(c);
+}
+
+/**
+ * @param word A word of bytes
+ * @param lo The smallest byte value in the range (at most 0x7F)
+ * @param hi The largest byte value in the range (at most 0x7F)
+ * @return a word with the high bit set in each byte of the given word
+ * that is ASCII and within [lo, hi], and every other bit clear
+ */
+inline uint64_t in_range(uint64_t word, uint8_t lo, uint8_t hi)
+{
+    // with the high bits cleared, adding 0x80 - lo to a byte sets its high
+    // bit exactly when the byte is at least lo (and never carries into
+    // the next byte), and likewise for 0x7F - hi and being above hi
+    auto low = word & ~high_bits;
+    auto at_least_lo = low + broadcast(static_cast<uint8_t>(0x80 - lo));
+    auto above_hi = low + broadcast(static_cast<uint8_t>(0x7F - hi));
+    return at_least_lo & ~above_hi & ~word & high_bits;
+}
+
+inline uint64_t upper(uint64_t word)
+{
+    return in_range(word, 'A', 'Z');
+}
+
+inline uint64_t alpha(uint64_t word)
+{
+    // setting 0x20 maps the uppercase letters onto the lowercase ones, and
+    // no other ASCII byte onto a letter
+    return in_range(word | broadcast(0x20), 'a', 'z');
+}
+
+inline uint64_t alnum(uint64_t word)
+{
+    return alpha(word) | in_range(word, '0', '9');
+}
+
+inline uint64_t space(uint64_t word)
+{
+    return in_range(word, '\t', '\r') | in_range(word, ' ', ' ');
+}
+
+inline uint64_t punct(uint64_t word)
+{
+    return in_range(word, '!', '~') & ~alnum(word);
+}
+
+/**
+ * @param str The string to check
+ * @param cls A function that marks the bytes of a word that are in the
+ * class, as in_range() does
+ * @return whether every byte of the string is in the class
+ */
+template <class Class>
+bool all_in_class(util::string_view str, Class&& cls)
+{
+    // whole words are checked at once, and the few bytes after them one
+    // at a time (which is also how most tokens, being short, are checked)
+    uint64_t pos = 0;
+    for (; pos + 8 <= str.size(); pos += 8)
+    {
+        if (cls(load(str.data() + pos)) != high_bits)
+            return false;
+    }
+    for (; pos < str.size(); ++pos)
+    {
+        if ((cls(widen(str[pos])) & 0x80) == 0)
+            return false;
+    }
+    return true;
+}
+}
+
+/**
+ * @param str The string to check
+ * @return whether every byte of the string is ASCII
+ */
+inline bool is_ascii(util::string_view str)
+{
+    return detail::all_in_class(str, [](uint64_t word)
+                                {
+                                    return ~word & detail::high_bits;
+                                });
+}
+
+/**
+ * @param str The string to check
+ * @return the number of ASCII bytes at the start of the string
+ */
+inline uint64_t ascii_prefix(util::string_view str)
+{
+    // find the first word with a non-ASCII byte, then the byte itself
+    uint64_t pos = 0;
+    while (pos + 8 <= str.size()
+           && (detail::load(str.data() + pos) & detail::high_bits) == 0)
+        pos += 8;
+    while (pos < str.size() && static_cast<unsigned char>(str[pos]) < 0x80)
+        ++pos;
+    return pos;
+}
+
+/**
+ * @param str The string to check
+ * @return whether the string is well-formed utf8 (without overlong
+ * encodings, surrogates, or codepoints past U+10FFFF)
+ */
+bool is_valid_utf8(util::string_view str);
+
+/**
+ * @param str The string to check
+ * @return whether the string contains an uppercase ASCII letter
+ */
+inline bool has_ascii_upper(util::string_view str)
+{
+    return !detail::all_in_class(str, [](uint64_t word)
+                                 {
+                                     return ~detail::upper(word)
+                                            & detail::high_bits;
+                                 });
+}
+
+/**
+ * Lowercases the ASCII letters of a string, copying every other byte
+ * unchanged.
+ *
+ * @param str The string to lowercase
+ * @param out Where to write the str.size() bytes of the result, which may
+ * be str.data() itself
+ */
+inline void ascii_tolower(util::string_view str, char* out)
+{
+    // an uppercase letter's high bit, shifted down to 0x20, lowercases it
+    uint64_t pos = 0;
+    for (; pos + 8 <= str.size(); pos += 8)
+    {
+        auto word = detail::load(str.data() + pos);
+        word |= detail::upper(word) >> 2;
+        std::memcpy(out + pos, &word, sizeof(word));
+    }
+    for (; pos < str.size(); ++pos)
+    {
+        auto c = detail::widen(str[pos]);
+        out[pos] = static_cast<char>(c | (detail::upper(c) >> 2));
+    }
+}
+
+/**
+ * @param str The string to check
+ * @return whether every byte of the string is an ASCII letter
+ */
+inline bool is_ascii_alpha(util::string_view str)
+{
+    return detail::all_in_class(str, detail::alpha);
+}
+
+/**
+ * @param str The string to check
+ * @return whether every byte of the string is an ASCII letter or digit
+ */
+inline bool is_ascii_alnum(util::string_view str)
+{
+    return detail::all_in_class(str, detail::alnum);
+}
+
+/**
+ * @param str The string to check
+ * @return whether every byte of the string is ASCII whitespace
+ */
+inline bool is_ascii_space(util::string_view str)
+{
+    return detail::all_in_class(str, detail::space);
+}
+
+/**
+ * @param str The string to check
+ * @return whether every byte of the string is ASCII punctuation
+ */
+inline bool is_ascii_punct(util::string_view str)
+{
+    return detail::all_in_class(str, detail::punct);
+}
+
+/**
+ * @param str The string to search
+ * @return the position of the first ASCII punctuation byte of the string,
+ * or its size if it has none
+ */
+inline uint64_t ascii_punct_offset(util::string_view str)
+{
+    // find the first word with punctuation, then the byte itself
+    uint64_t pos = 0;
+    while (pos + 8 <= str.size()
+           && detail::punct(detail::load(str.data() + pos)) == 0)
+        pos += 8;
+    while (pos < str.size() && (detail::punct(detail::widen(str[pos])) & 0x80)
+                                   == 0)
+        ++pos;
+    return pos;
+}
+}
+}
+#endif
@@ -16,6 +16,7 @@
 #include <string>
 
 #include "meta/config.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -91,12 +92,14 @@ std::string toupper(const std::string& str);
 
 /**
  * Folds the case of a utf8 string. This is like lowercase, but a bit more
- * general.
+ * general. Runs of ASCII characters are lowercased a word at a time (see
+ * ascii_tolower()); only the rest of the string is decoded and folded by
+ * ICU.
  *
  * @param str The string to convert
  * @return a case-folded utf8 string
  */
-std::string foldcase(const std::string& str);
+std::string foldcase(util::string_view str);
 
 /**
  * Transliterates a utf8 string, using the rules defined in ICU.
@@ -118,11 +121,11 @@ std::string transform(const std::string& str, const std::string& id);
  * removed
  */
 template <class Predicate>
-std::string remove_if(const std::string& str, Predicate&& pred)
+std::string remove_if(util::string_view str, Predicate&& pred)
 {
     std::string result;
     result.reserve(str.size());
-    const char* s = str.c_str();
+    const char* s = str.data();
     auto length = static_cast<int32_t>(str.length());
     for (int32_t i = 0; i < length;)
     {
@@ -162,7 +165,7 @@ std::string transform(const std::string& str, Function&& fun)
  * @return the number of code points in a utf8 string.
  * @param str The string to find the length of
  */
-uint64_t length(const std::string& str);
+uint64_t length(util::string_view str);
 
 /**
  * @return whether a code point is a letter character
@@ -22,6 +22,7 @@
 #include <unistd.h>
 
 #include "meta/config.h"
+#include "meta/io/mmap_file.h"
 #include "meta/meta.h"
 
 namespace meta
@@ -130,6 +131,18 @@ class disk_vector
      */
     const_iterator end() const;
 
+    /**
+     * Advises the kernel about how this vector will be accessed.
+     * @param advice The access pattern to expect
+     */
+    void advise(io::mmap_advice advice) const;
+
+    /**
+     * Reads every page of this vector into memory.
+     * @param num_threads The number of threads to use
+     */
+    void prefault(unsigned num_threads = 1) const;
+
   private:
     /// the path to the file this disk_vector uses for storage
     std::string path_;
@@ -151,5 +151,17 @@ auto disk_vector<T>::end() -> iterator
 {
     return start_ + size_;
 }
+
+template <class T>
+void disk_vector<T>::advise(io::mmap_advice advice) const
+{
+    io::advise(start_, sizeof(T) * size_, advice);
+}
+
+template <class T>
+void disk_vector<T>::prefault(unsigned num_threads) const
+{
+    io::prefault(start_, sizeof(T) * size_, num_threads);
+}
 }
 }
@@ -68,6 +68,12 @@ class fixed_heap
      */
     size_type max_elems() const;
 
+    /**
+     * @return the lowest-priority element in the heap, which is the next
+     * one to be removed when the heap is full; the heap must not be empty
+     */
+    const T& min() const;
+
     /**
      * Clears the heap and returns the top elements
      * @return the top elements in sorted order
@@ -54,6 +54,13 @@ auto fixed_heap<T, Comp>::max_elems() const -> size_type
     return max_elems_;
 }
 
+template <class T, class Comp>
+const T& fixed_heap<T, Comp>::min() const
+{
+    assert(!pq_.empty());
+    return pq_.front();
+}
+
 template <class T, class Comp>
 std::vector<T> fixed_heap<T, Comp>::extract_top()
 {
@@ -4,14 +4,10 @@
 
 #include "meta/analyzers/analyzer_factory.h"
 #include "meta/analyzers/filter_factory.h"
+#include "meta/analyzers/fused_chain.h"
 #include "meta/analyzers/multi_analyzer.h"
 #include "meta/analyzers/token_stream.h"
-#include "meta/analyzers/filters/alpha_filter.h"
-#include "meta/analyzers/filters/empty_sentence_filter.h"
-#include "meta/analyzers/filters/length_filter.h"
-#include "meta/analyzers/filters/list_filter.h"
-#include "meta/analyzers/filters/lowercase_filter.h"
-#include "meta/analyzers/filters/porter2_filter.h"
+#include "meta/analyzers/filters/stages.h"
 #include "meta/analyzers/tokenizers/icu_tokenizer.h"
 #include "meta/corpus/document.h"
 #include "cpptoml.h"
@@ -35,37 +31,41 @@ std::string get_content(const corpus::document& doc)
 
 namespace
 {
+/**
+ * The type of the default filter chains: an icu_tokenizer followed by a
+ * lowercase_filter, an alpha_filter, a length_filter, a list_filter and a
+ * porter2_filter.
+ */
+using default_chain = fused_chain<tokenizers::icu_tokenizer,
+                                  filters::stages::lowercase,
+                                  filters::stages::alpha,
+                                  filters::stages::length,
+                                  filters::stages::list,
+                                  filters::stages::porter2_stem>;
+
 std::unique_ptr<token_stream>
-add_default_filters(std::unique_ptr<token_stream> tokenizer,
-                    const cpptoml::table& config)
+make_default_chain(tokenizers::icu_tokenizer tokenizer,
+                   const cpptoml::table& config, bool skip_empty_sentences)
 {
     auto stopwords = config.get_as<std::string>("stop-words");
-
-    std::unique_ptr<token_stream> result;
-
-    result = make_unique<filters::lowercase_filter>(std::move(tokenizer));
-    result = make_unique<filters::alpha_filter>(std::move(result));
-    result = make_unique<filters::length_filter>(std::move(result), 2, 35);
-    result = make_unique<filters::list_filter>(std::move(result), *stopwords);
-    result = make_unique<filters::porter2_filter>(std::move(result));
-    return result;
+    return make_unique<default_chain>(
+        std::move(tokenizer), filters::stages::lowercase{},
+        filters::stages::alpha{}, filters::stages::length{2, 35},
+        filters::stages::list{*stopwords, filters::stages::list::type::REJECT},
+        filters::stages::porter2_stem{}, skip_empty_sentences);
 }
 }
 
 std::unique_ptr<token_stream> default_filter_chain(const cpptoml::table& config)
 {
-    auto tokenizer = make_unique<tokenizers::icu_tokenizer>();
-    auto result = add_default_filters(std::move(tokenizer), config);
-    result = make_unique<filters::empty_sentence_filter>(std::move(result));
-    return result;
+    return make_default_chain(tokenizers::icu_tokenizer{}, config, true);
 }
 
 std::unique_ptr<token_stream>
 default_unigram_chain(const cpptoml::table& config)
 {
     // suppress "<s>", "</s>"
-    auto tokenizer = make_unique<tokenizers::icu_tokenizer>(true);
-    return add_default_filters(std::move(tokenizer), config);
+    return make_default_chain(tokenizers::icu_tokenizer{true}, config, false);
 }
 
 std::unique_ptr<token_stream> load_filter(std::unique_ptr<token_stream> src,
@@ -22,6 +22,7 @@ analyzer_factory::analyzer_factory()
 {
     // built-in analyzers
     register_analyzer<ngram_word_analyzer>();
+    register_analyzer<ngram_char_analyzer>();
 }
 }
 }
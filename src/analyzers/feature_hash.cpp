@@ -0,0 +1,49 @@
+/**
+ * @file feature_hash.cpp
+ */
+
+#include <algorithm>
+
+#include "meta/analyzers/feature_hash.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+void feature_dictionary::insert(uint64_t id, util::string_view feature)
+{
+    auto& features = features_[id];
+    for (const auto& feat : features)
+    {
+        if (feat == feature)
+            return;
+    }
+    features.push_back(feature.to_string());
+}
+
+const std::vector<std::string>& feature_dictionary::features(uint64_t id) const
+{
+    static const std::vector<std::string> none;
+    auto it = features_.find(id);
+    return it == features_.end() ? none : it->second;
+}
+
+std::vector<uint64_t> feature_dictionary::collisions() const
+{
+    std::vector<uint64_t> results;
+    for (const auto& pr : features_)
+    {
+        if (pr.second.size() > 1)
+            results.push_back(pr.first);
+    }
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+uint64_t feature_dictionary::size() const
+{
+    return features_.size();
+}
+}
+}
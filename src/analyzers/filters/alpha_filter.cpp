@@ -3,9 +3,8 @@
  * @author Chase Geigle
  */
 
-#include <algorithm>
 #include "meta/analyzers/filters/alpha_filter.h"
-#include "meta/utf/utf.h"
+#include "meta/analyzers/filters/stages.h"
 
 namespace meta
 {
@@ -17,26 +16,39 @@ namespace filters
 const util::string_view alpha_filter::id = "alpha";
 
 alpha_filter::alpha_filter(std::unique_ptr<token_stream> source)
-    : source_{std::move(source)}
+    : source_{std::move(source)}, arena_{&own_arena_}
 {
     next_token();
 }
 
 alpha_filter::alpha_filter(const alpha_filter& other)
-    : source_{other.source_->clone()}, token_{other.token_}
+    : source_{other.source_->clone()}, arena_{&own_arena_}
 {
-    // nothing
+    if (other.token_)
+        token_ = own_arena_.append(*other.token_);
 }
 
 void alpha_filter::set_content(std::string&& content)
 {
-    source_->set_content(std::move(content));
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void alpha_filter::set_view_content(std::string&& content, token_arena& arena)
+{
+    arena_ = &arena;
+    source_->set_view_content(std::move(content), arena);
     next_token();
 }
 
 std::string alpha_filter::next()
 {
-    auto tok = std::move(*token_);
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view alpha_filter::next_view(token_arena&)
+{
+    auto tok = *token_;
     next_token();
     return tok;
 }
@@ -45,22 +57,10 @@ void alpha_filter::next_token()
 {
     while (*source_)
     {
-        auto tok = source_->next();
-        if (tok.size() <= 4 && tok.size() >= 3
-            && (tok == "<s>" || tok == "</s>"))
-        {
-            token_ = std::move(tok);
-            return;
-        }
-
-        auto filt = utf::remove_if(tok, [](uint32_t codepoint)
-                                   {
-                                       return !utf::isalpha(codepoint)
-                                              && codepoint != '\'';
-                                   });
-        if (!filt.empty())
+        auto tok = source_->next_view(*arena_);
+        if (stages::alpha{}(tok, *arena_))
         {
-            token_ = std::move(filt);
+            token_ = tok;
             return;
         }
     }
@@ -16,22 +16,31 @@ const util::string_view empty_sentence_filter::id = "empty-sentence";
 
 empty_sentence_filter::empty_sentence_filter(
     std::unique_ptr<token_stream> source)
-    : source_{std::move(source)}
+    : source_{std::move(source)}, arena_{&own_arena_}
 {
     next_token();
 }
 
 empty_sentence_filter::empty_sentence_filter(const empty_sentence_filter& other)
-    : source_{other.source_->clone()},
-      first_{other.first_},
-      second_{other.second_}
+    : source_{other.source_->clone()}, arena_{&own_arena_}
 {
-    // nothing
+    if (other.first_)
+        first_ = own_arena_.append(*other.first_);
+    if (other.second_)
+        second_ = own_arena_.append(*other.second_);
 }
 
 void empty_sentence_filter::set_content(std::string&& content)
 {
-    source_->set_content(std::move(content));
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void empty_sentence_filter::set_view_content(std::string&& content,
+                                             token_arena& arena)
+{
+    arena_ = &arena;
+    source_->set_view_content(std::move(content), arena);
     first_ = second_ = util::nullopt;
     next_token();
 }
@@ -47,10 +56,10 @@ void empty_sentence_filter::next_token()
 
     while (*source_)
     {
-        first_ = source_->next();
+        first_ = source_->next_view(*arena_);
         if (!*source_ || *first_ != "<s>")
             return;
-        second_ = source_->next();
+        second_ = source_->next_view(*arena_);
         if (*second_ != "</s>")
             return;
         first_ = second_ = util::nullopt;
@@ -58,6 +67,11 @@ void empty_sentence_filter::next_token()
 }
 
 std::string empty_sentence_filter::next()
+{
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view empty_sentence_filter::next_view(token_arena&)
 {
     auto tok = *first_;
     next_token();
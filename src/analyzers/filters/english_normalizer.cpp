@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cctype>
 #include "meta/analyzers/filters/english_normalizer.h"
+#include "meta/utf/ascii.h"
 
 namespace meta
 {
@@ -14,6 +15,20 @@ namespace analyzers
 namespace filters
 {
 
+namespace
+{
+/**
+ * @param c A byte of a token
+ * @return whether the byte is part of a word: an ASCII letter or digit,
+ * or any byte of a codepoint that isn't ASCII
+ */
+bool is_word_byte(char c)
+{
+    auto byte = static_cast<unsigned char>(c);
+    return byte >= 0x80 || std::isalnum(byte);
+}
+}
+
 const util::string_view english_normalizer::id = "english-normalizer";
 
 english_normalizer::english_normalizer(std::unique_ptr<token_stream> source)
@@ -23,18 +38,31 @@ english_normalizer::english_normalizer(std::unique_ptr<token_stream> source)
 }
 
 english_normalizer::english_normalizer(const english_normalizer& other)
-    : source_{other.source_->clone()}, tokens_{other.tokens_}
+    : source_{other.source_->clone()}
 {
-    // nothing
+    for (const auto& token : other.tokens_)
+        tokens_.push_back(own_arena_.append(token));
 }
 
 void english_normalizer::set_content(std::string&& content)
+{
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void english_normalizer::set_view_content(std::string&& content,
+                                          token_arena& arena)
 {
     tokens_.clear();
-    source_->set_content(std::move(content));
+    source_->set_view_content(std::move(content), arena);
 }
 
 std::string english_normalizer::next()
+{
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view english_normalizer::next_view(token_arena& arena)
 {
     // if we have buffered tokens, keep returning them until we have
     // exhausted the buffer
@@ -44,7 +72,7 @@ std::string english_normalizer::next()
     if (!*source_)
         throw token_stream_exception{"next() called with empty source"};
 
-    auto token = source_->next();
+    auto token = source_->next_view(arena);
 
     // if we have a whitespace token, keep reading any following whitespace
     // tokens to collapse them down to a single space. token_, afterwards,
@@ -53,7 +81,7 @@ std::string english_normalizer::next()
     if (is_whitespace(token))
     {
         while (is_whitespace(token) && *source_)
-            token = source_->next();
+            token = source_->next_view(arena);
         if (!is_whitespace(token)) // source_ was non-empty after whitespace
             parse_token(token);
         return " ";
@@ -68,13 +96,12 @@ english_normalizer::operator bool() const
     return !tokens_.empty() || *source_;
 }
 
-bool english_normalizer::is_whitespace(const std::string& token) const
+bool english_normalizer::is_whitespace(util::string_view token) const
 {
-    auto space = [](char c) { return std::isspace(c); };
-    return std::all_of(token.begin(), token.end(), space);
+    return utf::is_ascii_space(token);
 }
 
-void english_normalizer::parse_token(const std::string& token)
+void english_normalizer::parse_token(util::string_view token)
 {
     if (token.length() < 2)
     {
@@ -82,6 +109,14 @@ void english_normalizer::parse_token(const std::string& token)
         return;
     }
 
+    // a token of only letters and digits is a single word, so there is
+    // nothing to split off
+    if (utf::is_ascii_alnum(token))
+    {
+        tokens_.push_back(token);
+        return;
+    }
+
     uint64_t idx = 0;
     uint64_t end = token.length();
 
@@ -103,8 +138,8 @@ void english_normalizer::parse_token(const std::string& token)
     idx = starting_quotes(idx, token);
 
     // other leading punctuation should be separate tokens
-    while (idx < end && !std::isalnum(token[idx]))
-        tokens_.emplace_back(1, token[idx++]);
+    while (idx < end && !is_word_byte(token[idx]))
+        tokens_.push_back(token.substr(idx++, 1));
 
     // split out sequences of alphanumeric characters into separate tokens
     while (idx < end)
@@ -115,7 +150,7 @@ void english_normalizer::parse_token(const std::string& token)
 }
 
 uint64_t english_normalizer::starting_quotes(uint64_t start,
-                                             const std::string& token)
+                                             util::string_view token)
 {
     if (token[start] == '"')
     {
@@ -138,16 +173,16 @@ bool english_normalizer::is_quote(char c)
 }
 
 uint64_t english_normalizer::strip_dashes(uint64_t start,
-                                          const std::string& token)
+                                          util::string_view token)
 {
     auto idx = start + 1;
     while (idx < token.length() && token[idx] == '-')
         ++idx;
-    tokens_.emplace_back(token, start, idx - start);
+    tokens_.push_back(token.substr(start, idx - start));
     return idx;
 }
 
-uint64_t english_normalizer::word(uint64_t start, const std::string& token)
+uint64_t english_normalizer::word(uint64_t start, util::string_view token)
 {
     // special case leading dashes: if there are consecutive ones, we want
     // to strip them out into their own token
@@ -160,6 +195,12 @@ uint64_t english_normalizer::word(uint64_t start, const std::string& token)
                               // previous pass
     while (idx < token.length())
     {
+        // only punctuation ends or splits a word, so everything up to the
+        // next punctuation byte is skipped a word at a time
+        idx += utf::ascii_punct_offset(token.substr(idx));
+        if (idx == token.length())
+            break;
+
         if (token[idx] == '-' && idx + 1 < token.length() && token[idx + 1]
                                                              == '-')
         {
@@ -167,23 +208,23 @@ uint64_t english_normalizer::word(uint64_t start, const std::string& token)
             // or something
 
             // place the current token, before the dash, into the buffer
-            tokens_.emplace_back(token, start, idx - start);
+            tokens_.push_back(token.substr(start, idx - start));
             // place the dashes onto the buffer
             start = strip_dashes(idx, token);
         }
 
         // stop at first punctuation that is not a dash (we want to keep
         // words like "forty-five")
-        if (std::ispunct(token[idx]) && token[idx] != '-')
+        if (token[idx] != '-')
             break;
         ++idx;
     }
 
-    tokens_.emplace_back(token, start, idx - start);
+    tokens_.push_back(token.substr(start, idx - start));
     return idx;
 }
 
-std::string english_normalizer::current_token()
+util::string_view english_normalizer::current_token()
 {
     auto token = tokens_.front();
     tokens_.pop_front();
@@ -17,26 +17,39 @@ const util::string_view icu_filter::id = "icu";
 
 icu_filter::icu_filter(std::unique_ptr<token_stream> source,
                        const std::string& id)
-    : source_{std::move(source)}, trans_{id}
+    : source_{std::move(source)}, arena_{&own_arena_}, trans_{id}
 {
     next_token();
 }
 
 icu_filter::icu_filter(const icu_filter& other)
     : source_{other.source_->clone()},
-      trans_{other.trans_},
-      token_{other.token_}
+      arena_{&own_arena_},
+      trans_{other.trans_}
 {
-    // nothing
+    if (other.token_)
+        token_ = own_arena_.append(*other.token_);
 }
 
 void icu_filter::set_content(std::string&& content)
 {
-    source_->set_content(std::move(content));
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void icu_filter::set_view_content(std::string&& content, token_arena& arena)
+{
+    arena_ = &arena;
+    source_->set_view_content(std::move(content), arena);
     next_token();
 }
 
 std::string icu_filter::next()
+{
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view icu_filter::next_view(token_arena&)
 {
     auto tok = *token_;
     next_token();
@@ -47,16 +60,16 @@ void icu_filter::next_token()
 {
     while (*source_)
     {
-        auto tok = source_->next();
+        auto tok = source_->next_view(*arena_);
         if (tok == "<s>" || tok == "</s>")
         {
             token_ = tok;
             return;
         }
-        auto trans = trans_(tok);
+        auto trans = trans_(tok.to_string());
         if (!trans.empty())
         {
-            token_ = trans;
+            token_ = arena_->append(trans);
             return;
         }
     }
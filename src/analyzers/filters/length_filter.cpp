@@ -5,7 +5,6 @@
 
 #include "cpptoml.h"
 #include "meta/analyzers/filters/length_filter.h"
-#include "meta/utf/utf.h"
 
 namespace meta
 {
@@ -18,33 +17,42 @@ const util::string_view length_filter::id = "length";
 
 length_filter::length_filter(std::unique_ptr<token_stream> source, uint64_t min,
                              uint64_t max)
-    : source_{std::move(source)}, min_length_{min}, max_length_{max}
+    : source_{std::move(source)}, arena_{&own_arena_}, length_{min, max}
 {
-    if (min_length_ > max_length_)
-        throw token_stream_exception{
-            "min filter length is greater than max filter length"};
     next_token();
 }
 
 length_filter::length_filter(const length_filter& other)
     : source_{other.source_->clone()},
-      token_{other.token_},
-      min_length_{other.min_length_},
-      max_length_{other.max_length_}
+      arena_{&own_arena_},
+      length_{other.length_}
 {
-    // nothing
+    if (other.token_)
+        token_ = own_arena_.append(*other.token_);
 }
 
 void length_filter::set_content(std::string&& content)
 {
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void length_filter::set_view_content(std::string&& content, token_arena& arena)
+{
+    arena_ = &arena;
     token_ = util::nullopt;
-    source_->set_content(std::move(content));
+    source_->set_view_content(std::move(content), arena);
     next_token();
 }
 
 std::string length_filter::next()
 {
-    auto tok = std::move(*token_);
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view length_filter::next_view(token_arena&)
+{
+    auto tok = *token_;
     next_token();
     return tok;
 }
@@ -64,17 +72,10 @@ void length_filter::next_token()
 
     while (*source_)
     {
-        auto tok = source_->next();
-        if (tok.size() <= 4 && tok.size() >= 3
-            && (tok == "<s>" || tok == "</s>"))
-        {
-            token_ = std::move(tok);
-            return;
-        }
-        auto len = utf::length(tok);
-        if (len >= min_length_ && len <= max_length_)
+        auto tok = source_->next_view(*arena_);
+        if (length_(tok, *arena_))
         {
-            token_ = std::move(tok);
+            token_ = tok;
             return;
         }
     }
@@ -3,7 +3,6 @@
  * @author Chase Geigle
  */
 
-#include <fstream>
 #include "meta/analyzers/filters/list_filter.h"
 #include "cpptoml.h"
 
@@ -18,38 +17,44 @@ const util::string_view list_filter::id = "list";
 
 list_filter::list_filter(std::unique_ptr<token_stream> source,
                          const std::string& filename, type method)
-    : source_{std::move(source)}, method_{method}
+    : source_{std::move(source)},
+      arena_{&own_arena_},
+      list_{filename, method}
 {
-    std::ifstream file{filename};
-    if (!file)
-        throw token_stream_exception{"invalid file for list filter"};
-
-    std::string line;
-    while (std::getline(file, line))
-        list_.emplace(std::move(line));
-
     next_token();
 }
 
 list_filter::list_filter(const list_filter& other)
     : source_{other.source_->clone()},
-      token_{other.token_},
-      list_{other.list_},
-      method_{other.method_}
+      arena_{&own_arena_},
+      list_{other.list_}
 {
-    // nothing
+    if (other.token_)
+        token_ = own_arena_.append(*other.token_);
 }
 
 void list_filter::set_content(std::string&& content)
 {
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void list_filter::set_view_content(std::string&& content, token_arena& arena)
+{
+    arena_ = &arena;
     token_ = util::nullopt;
-    source_->set_content(std::move(content));
+    source_->set_view_content(std::move(content), arena);
     next_token();
 }
 
 std::string list_filter::next()
 {
-    auto tok = std::move(*token_);
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view list_filter::next_view(token_arena&)
+{
+    auto tok = *token_;
     next_token();
     return tok;
 }
@@ -69,26 +74,11 @@ void list_filter::next_token()
 
     while (*source_)
     {
-        auto tok = source_->next();
-        auto found = list_.find(tok) != list_.end();
-        switch (method_)
+        auto tok = source_->next_view(*arena_);
+        if (list_(tok, *arena_))
         {
-            case type::ACCEPT:
-                if (found)
-                {
-                    token_ = std::move(tok);
-                    return;
-                }
-                break;
-            case type::REJECT:
-                if (!found)
-                {
-                    token_ = std::move(tok);
-                    return;
-                }
-                break;
-            default:
-                throw token_stream_exception{"invalid method"};
+            token_ = tok;
+            return;
         }
     }
     token_ = util::nullopt;
@@ -3,10 +3,8 @@
  * @author Chase Geigle
  */
 
-#include <algorithm>
-#include <cctype>
 #include "meta/analyzers/filters/lowercase_filter.h"
-#include "meta/utf/utf.h"
+#include "meta/analyzers/filters/stages.h"
 
 namespace meta
 {
@@ -31,12 +29,26 @@ lowercase_filter::lowercase_filter(const lowercase_filter& other)
 
 void lowercase_filter::set_content(std::string&& content)
 {
-    source_->set_content(std::move(content));
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void lowercase_filter::set_view_content(std::string&& content,
+                                        token_arena& arena)
+{
+    source_->set_view_content(std::move(content), arena);
 }
 
 std::string lowercase_filter::next()
 {
-    return utf::foldcase(source_->next());
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view lowercase_filter::next_view(token_arena& arena)
+{
+    auto tok = source_->next_view(arena);
+    stages::lowercase{}(tok, arena);
+    return tok;
 }
 
 lowercase_filter::operator bool() const
@@ -3,8 +3,8 @@
  * @author Chase Geigle
  */
 
+#include "cpptoml.h"
 #include "meta/analyzers/filters/porter2_filter.h"
-#include "meta/analyzers/filters/porter2_stemmer.h"
 
 namespace meta
 {
@@ -15,25 +15,40 @@ namespace filters
 
 const util::string_view porter2_filter::id = "porter2-filter";
 
-porter2_filter::porter2_filter(std::unique_ptr<token_stream> source)
-    : source_{std::move(source)}
+porter2_filter::porter2_filter(std::unique_ptr<token_stream> source,
+                               uint64_t cache_size)
+    : source_{std::move(source)}, arena_{&own_arena_}, stem_{cache_size}
 {
     next_token();
 }
 
 porter2_filter::porter2_filter(const porter2_filter& other)
-    : source_{other.source_->clone()}, token_{other.token_}
+    : source_{other.source_->clone()}, arena_{&own_arena_}, stem_{other.stem_}
 {
-    // nothing
+    if (other.token_)
+        token_ = own_arena_.append(*other.token_);
 }
 
 void porter2_filter::set_content(std::string&& content)
 {
-    source_->set_content(std::move(content));
+    own_arena_.clear();
+    set_view_content(std::move(content), own_arena_);
+}
+
+void porter2_filter::set_view_content(std::string&& content,
+                                      token_arena& arena)
+{
+    arena_ = &arena;
+    source_->set_view_content(std::move(content), arena);
     next_token();
 }
 
 std::string porter2_filter::next()
+{
+    return next_view(own_arena_).to_string();
+}
+
+util::string_view porter2_filter::next_view(token_arena&)
 {
     auto tok = *token_;
     next_token();
@@ -44,11 +59,10 @@ void porter2_filter::next_token()
 {
     while (*source_)
     {
-        auto tok = source_->next();
-        porter2::stem(tok);
-        if (!tok.empty())
+        auto tok = source_->next_view(*arena_);
+        if (stem_(tok, *arena_))
         {
-            token_ = std::move(tok);
+            token_ = tok;
             return;
         }
     }
@@ -59,6 +73,21 @@ porter2_filter::operator bool() const
 {
     return static_cast<bool>(token_);
 }
+
+template <>
+std::unique_ptr<token_stream>
+    make_filter<porter2_filter>(std::unique_ptr<token_stream> src,
+                                const cpptoml::table& config)
+{
+    auto cache_size = config.get_as<int64_t>("cache-size");
+    if (!cache_size)
+        return make_unique<porter2_filter>(std::move(src));
+    if (*cache_size < 0)
+        throw token_stream_exception{
+            "cache-size for porter2 filter must be nonnegative"};
+    return make_unique<porter2_filter>(std::move(src),
+                                       static_cast<uint64_t>(*cache_size));
+}
 }
 }
 }
@@ -19,9 +19,9 @@ namespace filters
 const util::string_view sentence_boundary::id = "sentence-boundary";
 
 // static members
-std::unordered_set<std::string> sentence_boundary::punc_set{};
-std::unordered_set<std::string> sentence_boundary::start_exception_set{};
-std::unordered_set<std::string> sentence_boundary::end_exception_set{};
+word_set sentence_boundary::punc_set{};
+word_set sentence_boundary::start_exception_set{};
+word_set sentence_boundary::end_exception_set{};
 bool sentence_boundary::heuristics_loaded = false;
 
 sentence_boundary::sentence_boundary(std::unique_ptr<token_stream> source)
@@ -73,25 +73,21 @@ void sentence_boundary::load_heuristics(const cpptoml::table& config)
             + *punc};
 
     std::ifstream punc_file{*punc};
-    std::string line;
-    while (std::getline(punc_file, line))
-        punc_set.emplace(std::move(line));
+    punc_set = word_set{punc_file};
 
     if (!filesystem::file_exists(*start_exceptions))
         throw token_stream_exception{"start exceptions file does not exist: "
             + *start_exceptions};
 
     std::ifstream start_ex_file{*start_exceptions};
-    while (std::getline(start_ex_file, line))
-        start_exception_set.emplace(std::move(line));
+    start_exception_set = word_set{start_ex_file};
 
     if (!filesystem::file_exists(*end_exceptions))
         throw token_stream_exception{"end exceptions file does not exist: "
             + *end_exceptions};
 
     std::ifstream end_ex_file{*end_exceptions};
-    while (std::getline(end_ex_file, line))
-        end_exception_set.emplace(std::move(line));
+    end_exception_set = word_set{end_ex_file};
 
     heuristics_loaded = true;
 }
@@ -165,20 +161,20 @@ std::string sentence_boundary::current_token()
     return token;
 }
 
-bool sentence_boundary::possible_punc(const std::string& token)
+bool sentence_boundary::possible_punc(util::string_view token)
 {
-    return punc_set.find(token) != punc_set.end();
+    return punc_set.contains(token);
 }
 
-bool sentence_boundary::possible_end(const std::string& token)
+bool sentence_boundary::possible_end(util::string_view token)
 {
-    return end_exception_set.find(token) == end_exception_set.end()
-           && token[0] != '.';
+    return !end_exception_set.contains(token)
+           && (token.empty() || token[0] != '.');
 }
 
-bool sentence_boundary::possible_start(const std::string& token)
+bool sentence_boundary::possible_start(util::string_view token)
 {
-    return start_exception_set.find(token) == start_exception_set.end();
+    return !start_exception_set.contains(token);
 }
 
 template <>
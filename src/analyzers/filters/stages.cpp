@@ -0,0 +1,59 @@
+/**
+ * @file stages.cpp
+ */
+
+#include <fstream>
+#include "meta/analyzers/filters/stages.h"
+
+namespace meta
+{
+namespace analyzers
+{
+namespace filters
+{
+namespace stages
+{
+
+list::list(const std::string& filename, type method) : method_{method}
+{
+    std::ifstream file{filename};
+    if (!file)
+        throw token_stream_exception{"invalid file for list filter"};
+
+    list_ = std::make_shared<const word_set>(file);
+}
+
+porter2_stem::porter2_stem(uint64_t cache_size) : cache_size_{cache_size}
+{
+    // nothing
+}
+
+porter2_stem::porter2_stem(const porter2_stem& other)
+    : cache_size_{other.cache_size_}
+{
+    // nothing
+}
+
+util::string_view porter2_stem::stem_uncached(util::string_view tok)
+{
+    scratch_.assign(tok.data(), tok.size());
+    filters::porter2::stem(scratch_);
+    if (cache_size_ == 0)
+        return scratch_;
+
+    if (stems_.size() == cache_size_)
+    {
+        stems_.reset();
+        strings_.clear();
+    }
+
+    // a stem that is the token itself shares its storage
+    auto key = strings_.append(tok);
+    auto stem = scratch_ == tok ? key : strings_.append(scratch_);
+    stems_.emplace(key, stem);
+    return stem;
+}
+}
+}
+}
+}
@@ -0,0 +1,40 @@
+/**
+ * @file word_set.cpp
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "meta/analyzers/filters/word_set.h"
+
+namespace meta
+{
+namespace analyzers
+{
+namespace filters
+{
+
+word_set::word_set(std::istream& in)
+    : buffer_{std::istreambuf_iterator<char>{in},
+              std::istreambuf_iterator<char>{}}
+{
+    // the buffer is complete (and won't move) before any views of it are
+    // taken; lines are split as std::getline would split them
+    auto first = buffer_.begin();
+    while (first != buffer_.end())
+    {
+        auto last = std::find(first, buffer_.end(), '\n');
+        util::string_view word{&*first,
+                               static_cast<std::size_t>(last - first)};
+        if (words_.find(word) == words_.end())
+            words_.emplace(word);
+        max_size_ = std::max<uint64_t>(max_size_, word.size());
+
+        if (last == buffer_.end())
+            break;
+        first = last + 1;
+    }
+}
+}
+}
+}
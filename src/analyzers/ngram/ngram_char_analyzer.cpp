@@ -0,0 +1,170 @@
+/**
+ * @file ngram_char_analyzer.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/corpus/document.h"
+#include "meta/analyzers/ngram/ngram_char_analyzer.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+namespace
+{
+/**
+ * @return the hash_feature() of every ASCII codepoint, computed on first
+ * use
+ */
+const std::array<uint64_t, 128>& ascii_hashes()
+{
+    static const auto hashes = []()
+    {
+        std::array<uint64_t, 128> table;
+        for (std::size_t i = 0; i < table.size(); ++i)
+        {
+            auto c = static_cast<char>(i);
+            table[i] = hash_feature(util::string_view{&c, 1});
+        }
+        return table;
+    }();
+    return hashes;
+}
+
+/**
+ * @param n The value of n from the configuration
+ * @return the value as an ngram size
+ */
+uint16_t ngram_size(int64_t n)
+{
+    if (n < 1 || n > std::numeric_limits<uint16_t>::max())
+        throw analyzer_exception{"invalid ngram size for ngram char analyzer: "
+                                 + std::to_string(n)};
+    return static_cast<uint16_t>(n);
+}
+}
+
+const util::string_view ngram_char_analyzer::id = "ngram-char";
+
+ngram_char_analyzer::ngram_char_analyzer(std::vector<uint16_t> ns)
+    : ns_{std::move(ns)}
+{
+    std::sort(ns_.begin(), ns_.end());
+    ns_.erase(std::unique(ns_.begin(), ns_.end()), ns_.end());
+    if (ns_.empty())
+        throw analyzer_exception{"ngram char analyzer needs a value of n"};
+    if (ns_.front() == 0)
+        throw analyzer_exception{"ngram char analyzer needs positive n"};
+
+    // the ring buffer's size is a power of two so that it can be indexed
+    // with a mask
+    uint64_t ring_size = 1;
+    while (ring_size < ns_.back())
+        ring_size *= 2;
+    starts_.resize(ring_size);
+
+    hashes_.reserve(ns_.size());
+    for (const auto& n : ns_)
+        hashes_.emplace_back(n);
+}
+
+ngram_char_analyzer::ngram_char_analyzer(const ngram_char_analyzer& other)
+    : ngram_char_analyzer{other.ns_}
+{
+    // nothing
+}
+
+const std::vector<uint16_t>& ngram_char_analyzer::n_values() const
+{
+    return ns_;
+}
+
+void ngram_char_analyzer::tokenize(const corpus::document& doc,
+                                   featurizer& counts)
+{
+    auto content = get_content(doc);
+    auto hashed = counts.hashed();
+    auto naming = hashed && counts.naming();
+    const auto& ascii = ascii_hashes();
+    for (auto& hash : hashes_)
+        hash.clear();
+
+    auto bytes = reinterpret_cast<const unsigned char*>(content.data());
+    auto mask = starts_.size() - 1;
+    uint64_t num_chars = 0;
+    uint64_t pos = 0;
+    while (pos < content.size())
+    {
+        // a codepoint is a lead byte and the continuation bytes after it;
+        // malformed sequences are grouped the same way rather than rejected
+        auto start = pos++;
+        if (bytes[start] >= 0x80)
+        {
+            while (pos < content.size() && (bytes[pos] & 0xC0) == 0x80)
+                ++pos;
+        }
+        starts_[num_chars & mask] = start;
+        ++num_chars;
+
+        if (hashed)
+        {
+            auto char_hash
+                = bytes[start] < 0x80
+                      ? ascii[bytes[start]]
+                      : hash_feature({content.data() + start, pos - start});
+            for (auto& hash : hashes_)
+                hash.push(char_hash);
+        }
+
+        // every ngram ends at this codepoint, so the ngram for each n
+        // starts n codepoints back
+        for (std::size_t i = 0; i < ns_.size() && ns_[i] <= num_chars; ++i)
+        {
+            auto first = starts_[(num_chars - ns_[i]) & mask];
+            if (!hashed)
+            {
+                ngram_.assign(content.data() + first, pos - first);
+                counts(ngram_, 1ul);
+                continue;
+            }
+
+            auto id = hashes_[i].value();
+            if (naming)
+                counts.name(id, {content.data() + first, pos - first});
+            counts(id, 1ul);
+        }
+    }
+}
+
+template <>
+std::unique_ptr<analyzer>
+make_analyzer<ngram_char_analyzer>(const cpptoml::table&,
+                                   const cpptoml::table& config)
+{
+    std::vector<uint16_t> ns;
+    if (auto n_val = config.get_as<int64_t>("ngram"))
+    {
+        ns.push_back(ngram_size(*n_val));
+    }
+    else if (auto n_arr = config.get_array("ngram"))
+    {
+        for (const auto& n : n_arr->array_of<int64_t>())
+            ns.push_back(ngram_size(n->get()));
+    }
+    else
+    {
+        throw analyzer_exception{
+            "ngram size needed for ngram char analyzer in config file"};
+    }
+
+    return make_unique<ngram_char_analyzer>(std::move(ns));
+}
+}
+}
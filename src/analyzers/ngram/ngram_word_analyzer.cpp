@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -20,13 +21,15 @@ const util::string_view ngram_word_analyzer::id = "ngram-word";
 
 ngram_word_analyzer::ngram_word_analyzer(uint16_t n,
                                          std::unique_ptr<token_stream> stream)
-    : base{n}, stream_{std::move(stream)}
+    : base{n}, stream_{std::move(stream)}, hash_{n}
 {
     // nothing
 }
 
 ngram_word_analyzer::ngram_word_analyzer(const ngram_word_analyzer& other)
-    : base{other.n_value()}, stream_{other.stream_->clone()}
+    : base{other.n_value()},
+      stream_{other.stream_->clone()},
+      hash_{other.n_value()}
 {
     // nothing
 }
@@ -34,19 +37,43 @@ ngram_word_analyzer::ngram_word_analyzer(const ngram_word_analyzer& other)
 void ngram_word_analyzer::tokenize(const corpus::document& doc,
                                    featurizer& counts)
 {
-    stream_->set_content(get_content(doc));
-    std::deque<std::string> tokens;
+    // the tokens are views into the arena, which is reused across
+    // documents, so only the ngrams themselves are ever built as strings;
+    // when hashing, their ids are computed from the tokens' hashes instead
+    arena_.clear();
+    hash_.clear();
+    stream_->set_view_content(get_content(doc), arena_);
+    auto hashed = counts.hashed();
+    auto naming = !hashed || counts.naming();
+    std::deque<util::string_view> tokens;
     while (*stream_)
     {
-        tokens.emplace_back(stream_->next());
+        tokens.push_back(stream_->next_view(arena_));
+        if (hashed)
+            hash_.push(hash_feature(tokens.back()));
+
         if (tokens.size() == this->n_value())
         {
-            auto combined = std::move(tokens.front());
+            if (naming)
+            {
+                ngram_.assign(tokens.front().data(), tokens.front().size());
+                for (auto it = tokens.begin() + 1; it != tokens.end(); ++it)
+                {
+                    ngram_ += '_';
+                    ngram_.append(it->data(), it->size());
+                }
+            }
             tokens.pop_front();
-            for (const auto& token : tokens)
-                combined += "_" + token;
 
-            counts(combined, 1ul);
+            if (!hashed)
+            {
+                counts(ngram_, 1ul);
+                continue;
+            }
+
+            auto id = hash_.value();
+            counts.name(id, ngram_);
+            counts(id, 1ul);
         }
     }
 }
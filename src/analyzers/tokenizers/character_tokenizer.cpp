@@ -28,11 +28,17 @@ void character_tokenizer::set_content(std::string&& content)
 }
 
 std::string character_tokenizer::next()
+{
+    token_arena arena;
+    return next_view(arena).to_string();
+}
+
+util::string_view character_tokenizer::next_view(token_arena&)
 {
     if (!*this)
         throw token_stream_exception{"next() called with no tokens left"};
 
-    return {content_[idx_++]};
+    return {content_.data() + idx_++, 1};
 }
 
 character_tokenizer::operator bool() const
@@ -4,12 +4,13 @@
  */
 
 #include <algorithm>
-#include <deque>
+#include <vector>
 
 #include "cpptoml.h"
 #include "meta/analyzers/tokenizers/icu_tokenizer.h"
 #include "meta/utf/segmenter.h"
 #include "meta/utf/utf.h"
+#include "meta/util/optional.h"
 #include "meta/util/pimpl.tcc"
 
 namespace meta
@@ -21,94 +22,542 @@ namespace tokenizers
 
 const util::string_view icu_tokenizer::id = "icu-tokenizer";
 
+namespace
+{
+
+/**
+ * The Word_Break classes (from UAX #29) of the characters that the fast
+ * path handles.
+ */
+enum class word_class
+{
+    LETTER,
+    NUMERIC,
+    MID_NUM_LET,
+    MID_NUM,
+    EXTEND_NUM_LET,
+    OTHER
+};
+
+/**
+ * The Sentence_Break classes (from UAX #29) of the characters that the
+ * fast path handles.
+ */
+enum class sentence_class
+{
+    UPPER,
+    LOWER,
+    NUMERIC,
+    ATERM,
+    STERM,
+    CLOSE,
+    SP,
+    SCONTINUE,
+    OTHER
+};
+
+/**
+ * Determines whether a string can be segmented by the fast path: it may
+ * contain only ASCII and the Latin-1 letters (U+00C0 to U+00FF, which are
+ * encoded as 0xC3 followed by a continuation byte). '@' is left to ICU,
+ * since newer versions treat it as a letter (for email addresses).
+ */
+bool is_latin1(util::string_view str)
+{
+    for (std::size_t i = 0; i < str.size(); ++i)
+    {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (c == '@')
+            return false;
+        if (c < 0x80)
+            continue;
+        if (c != 0xC3 || i + 1 == str.size()
+            || (static_cast<unsigned char>(str[i + 1]) & 0xC0) != 0x80)
+            return false;
+        ++i;
+    }
+    return true;
+}
+
+/**
+ * Decodes the code point at a position in a string that is_latin1,
+ * advancing the position past it.
+ */
+uint32_t next_codepoint(util::string_view str, std::size_t& i)
+{
+    auto c = static_cast<unsigned char>(str[i++]);
+    if (c < 0x80)
+        return c;
+    return 0xC0 | (static_cast<unsigned char>(str[i++]) & 0x3F);
+}
+
+word_class word_break(uint32_t cp)
+{
+    if ((cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z')
+        || (cp >= 0xC0 && cp != 0xD7 && cp != 0xF7))
+        return word_class::LETTER;
+    if (cp >= '0' && cp <= '9')
+        return word_class::NUMERIC;
+    switch (cp)
+    {
+        case '.':
+        case '\'':
+            return word_class::MID_NUM_LET;
+        case ',':
+        case ';':
+            return word_class::MID_NUM;
+        case '_':
+            return word_class::EXTEND_NUM_LET;
+        default:
+            return word_class::OTHER;
+    }
+}
+
+sentence_class sentence_break(uint32_t cp)
+{
+    if ((cp >= 'A' && cp <= 'Z') || (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7))
+        return sentence_class::UPPER;
+    if ((cp >= 'a' && cp <= 'z') || (cp >= 0xDF && cp != 0xF7))
+        return sentence_class::LOWER;
+    if (cp >= '0' && cp <= '9')
+        return sentence_class::NUMERIC;
+    switch (cp)
+    {
+        case '.':
+            return sentence_class::ATERM;
+        case '!':
+        case '?':
+            return sentence_class::STERM;
+        case '"':
+        case '\'':
+        case '(':
+        case ')':
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+            return sentence_class::CLOSE;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\v':
+        case '\f':
+        case '\r':
+            return sentence_class::SP;
+        case ',':
+        case '-':
+        case ':':
+            return sentence_class::SCONTINUE;
+        default:
+            return sentence_class::OTHER;
+    }
+}
+
+/**
+ * Finds the end of the word that starts at begin, following the word
+ * boundary rules of UAX #29 (as tailored by ICU, which does not join words
+ * across a colon) for the characters that is_latin1 accepts.
+ *
+ * @param str The string being segmented
+ * @param begin The start of the word
+ * @param end The end of the sentence the word is in
+ * @return the end of the word
+ */
+std::size_t word_end(util::string_view str, std::size_t begin,
+                     std::size_t end)
+{
+    auto i = begin;
+    auto prev = word_break(next_codepoint(str, i));
+    if (prev != word_class::LETTER && prev != word_class::NUMERIC
+        && prev != word_class::EXTEND_NUM_LET)
+        return i;
+
+    while (i < end)
+    {
+        auto j = i;
+        auto cur = word_break(next_codepoint(str, j));
+        if (cur == word_class::MID_NUM_LET || cur == word_class::MID_NUM)
+        {
+            // WB6, WB7, WB11, and WB12: a letter or number followed by
+            // punctuation only continues if the same kind follows it
+            if (j == end)
+                break;
+            auto nxt = word_break(next_codepoint(str, j));
+            auto letters = prev == word_class::LETTER
+                           && cur == word_class::MID_NUM_LET
+                           && nxt == word_class::LETTER;
+            auto numbers = prev == word_class::NUMERIC
+                           && nxt == word_class::NUMERIC;
+            if (!letters && !numbers)
+                break;
+            cur = nxt;
+        }
+        else if (cur == word_class::OTHER)
+        {
+            break;
+        }
+        else if (prev != word_class::LETTER && prev != word_class::NUMERIC
+                 && prev != word_class::EXTEND_NUM_LET)
+        {
+            // WB5, WB8 to WB10, WB13a, and WB13b
+            break;
+        }
+        prev = cur;
+        i = j;
+    }
+    return i;
+}
+
+/**
+ * Finds the end of the sentence that starts at begin, following the
+ * sentence boundary rules of UAX #29 for the characters that is_latin1
+ * accepts.
+ *
+ * @param str The string being segmented
+ * @param begin The start of the sentence
+ * @return the end of the sentence
+ */
+std::size_t sentence_end(util::string_view str, std::size_t begin)
+{
+    auto i = begin;
+    auto prev = sentence_class::OTHER;
+    while (i < str.size())
+    {
+        auto j = i;
+        auto cur = sentence_break(next_codepoint(str, j));
+        if (cur != sentence_class::ATERM && cur != sentence_class::STERM)
+        {
+            prev = cur;
+            i = j;
+            continue;
+        }
+
+        if (j == str.size())
+            break;
+
+        auto k = j;
+        auto nxt = sentence_break(next_codepoint(str, k));
+        // SB6: "3.14"; SB7: "U.S."
+        if (cur == sentence_class::ATERM
+            && (nxt == sentence_class::NUMERIC
+                || (nxt == sentence_class::UPPER
+                    && (prev == sentence_class::UPPER
+                        || prev == sentence_class::LOWER))))
+        {
+            prev = cur;
+            i = j;
+            continue;
+        }
+
+        // SB9 and SB10: the terminator keeps any closing punctuation and
+        // spaces that follow it
+        auto last = cur;
+        auto end = j;
+        for (auto cls : {sentence_class::CLOSE, sentence_class::SP})
+        {
+            while (end < str.size())
+            {
+                k = end;
+                if (sentence_break(next_codepoint(str, k)) != cls)
+                    break;
+                last = cls;
+                end = k;
+            }
+        }
+        if (end == str.size())
+            break;
+
+        k = end;
+        nxt = sentence_break(next_codepoint(str, k));
+        auto cont = nxt == sentence_class::SCONTINUE
+                    || nxt == sentence_class::ATERM
+                    || nxt == sentence_class::STERM;
+
+        // SB8: there is no break after a period if the next letter is
+        // lowercase
+        if (!cont && cur == sentence_class::ATERM)
+        {
+            while (nxt != sentence_class::UPPER && nxt != sentence_class::LOWER
+                   && nxt != sentence_class::ATERM
+                   && nxt != sentence_class::STERM && k < str.size())
+                nxt = sentence_break(next_codepoint(str, k));
+            cont = nxt == sentence_class::LOWER;
+        }
+
+        // SB11
+        if (!cont)
+            return end;
+        prev = last;
+        i = end;
+    }
+    return str.size();
+}
+}
+
 /**
  * Implementation class for the icu_tokenizer.
  */
 class icu_tokenizer::impl
 {
   public:
-    impl(bool suppress_tags) : suppress_tags_{suppress_tags}
+    impl(bool suppress_tags)
+        : suppress_tags_{suppress_tags}, default_rules_{true}, fast_{false}
     {
-        // nothing
+        clear();
     }
 
     explicit impl(utf::segmenter segmenter, bool suppress_tags)
-        : suppress_tags_{suppress_tags}, segmenter_{std::move(segmenter)}
+        : suppress_tags_{suppress_tags},
+          default_rules_{false},
+          segmenter_{std::move(segmenter)},
+          fast_{false}
     {
-        // nothing
+        clear();
+    }
+
+    impl(const impl& other)
+        : suppress_tags_{other.suppress_tags_},
+          default_rules_{other.default_rules_},
+          segmenter_{other.segmenter_},
+          content_{other.content_},
+          fast_{other.fast_},
+          in_sentence_{other.in_sentence_},
+          pos_{other.pos_},
+          sentence_end_{other.sentence_end_},
+          sentences_{other.sentences_},
+          words_{other.words_},
+          sentence_idx_{other.sentence_idx_},
+          word_idx_{other.word_idx_}
+    {
+        segmenter_.set_content(content_);
+
+        // the buffered token is a view into the content, so it is moved
+        // over to the copy of the content
+        if (other.token_)
+        {
+            const auto* begin = other.content_.data();
+            const auto& tok = *other.token_;
+            if (tok.data() >= begin
+                && tok.data() < begin + other.content_.size())
+                token_ = util::string_view{
+                    content_.data() + (tok.data() - begin), tok.size()};
+            else
+                token_ = tok;
+        }
     }
 
     /**
+     * Sets the content to be tokenized. Text that contains only ASCII and
+     * Latin-1 letters is segmented by hand; all other text is segmented
+     * with ICU, one sentence at a time as the tokens are read.
+     *
      * @param content The string content to set
-     * TODO: can we make this be a streaming API instead of buffering all
-     * of the tokens?
      */
-    void set_content(std::string content)
-    {
-        auto pred = [](char c) {
-            return c == '\n' || c == '\v' || c == '\f' || c == '\r';
-        };
-        // doing this because the sentence segmenter gets confused by
-        // newlines appearing within a pargraph. Plus, we don't really care
-        // about the kind of whitespace that was used for IR tasks.
-        std::replace_if(content.begin(), content.end(), pred, ' ');
-
-        segmenter_.set_content(content);
-        for (const auto& sentence : segmenter_.sentences())
+    void set_content(std::string&& content)
+    {
+        content_ = std::move(content);
+        clear();
+
+        fast_ = default_rules_ && is_latin1(content_);
+        if (!fast_)
         {
-            if (!suppress_tags_)
-                tokens_.emplace_back("<s>");
-            for (const auto& word : segmenter_.words(sentence))
+            // doing this because the sentence segmenter gets confused by
+            // newlines appearing within a pargraph. Plus, we don't really
+            // care about the kind of whitespace that was used for IR
+            // tasks. (The fast path treats them as spaces already.)
+            auto pred = [](char c)
             {
-                auto wrd = segmenter_.content(word);
-                if (wrd.empty())
-                    continue;
-
-                // check first character, if it's whitespace skip it
-                int32_t i = 0;
-                auto length = static_cast<int32_t>(wrd.size());
-                auto codepoint
-                    = utf::detail::utf8_next_codepoint(wrd.data(), i, length);
-                if (codepoint < 0
-                    || utf::isspace(static_cast<uint32_t>(codepoint)))
-                    continue;
-
-                tokens_.emplace_back(wrd.to_string());
-            }
-            if (!suppress_tags_)
-                tokens_.emplace_back("</s>");
+                return c == '\n' || c == '\v' || c == '\f' || c == '\r';
+            };
+            std::replace_if(content_.begin(), content_.end(), pred, ' ');
+            segmenter_.set_content(content_);
+            sentences_ = segmenter_.sentences();
         }
+
+        next_token();
     }
 
     /**
-     * @return the next token
+     * @return the next token, as a view into the content
      */
-    std::string next()
+    util::string_view next()
     {
         if (!*this)
             throw token_stream_exception{"next() called with no tokens left"};
-        auto result = std::move(tokens_.front());
-        tokens_.pop_front();
-        return result;
+        auto tok = *token_;
+        next_token();
+        return tok;
     }
 
     /**
-     * True if tokens is not empty.
+     * True if there are tokens left.
      */
     explicit operator bool() const
     {
-        return !tokens_.empty();
+        return static_cast<bool>(token_);
     }
 
   private:
+    /**
+     * Resets the position to the beginning of the content.
+     */
+    void clear()
+    {
+        token_ = util::nullopt;
+        in_sentence_ = false;
+        pos_ = sentence_end_ = 0;
+        sentences_.clear();
+        words_.clear();
+        sentence_idx_ = word_idx_ = 0;
+    }
+
+    /**
+     * Finds the next token, moving on to the next sentence if the current
+     * one has run out.
+     */
+    void next_token()
+    {
+        while (true)
+        {
+            if (in_sentence_)
+            {
+                util::string_view word;
+                while (next_word(word))
+                {
+                    if (!is_space(word))
+                    {
+                        token_ = word;
+                        return;
+                    }
+                }
+
+                in_sentence_ = false;
+                if (!suppress_tags_)
+                {
+                    token_ = util::string_view{"</s>"};
+                    return;
+                }
+            }
+
+            if (!next_sentence())
+            {
+                token_ = util::nullopt;
+                return;
+            }
+
+            in_sentence_ = true;
+            if (!suppress_tags_)
+            {
+                token_ = util::string_view{"<s>"};
+                return;
+            }
+        }
+    }
+
+    /**
+     * Moves to the next sentence.
+     * @return whether there was another sentence
+     */
+    bool next_sentence()
+    {
+        if (fast_)
+        {
+            pos_ = sentence_end_;
+            if (pos_ == content_.size())
+                return false;
+            sentence_end_ = sentence_end(content_, pos_);
+            return true;
+        }
+
+        if (sentence_idx_ == sentences_.size())
+            return false;
+        words_ = segmenter_.words(sentences_[sentence_idx_++]);
+        word_idx_ = 0;
+        return true;
+    }
+
+    /**
+     * Reads the next word of the current sentence.
+     * @param word Set to the next word
+     * @return whether there was another word in the sentence
+     */
+    bool next_word(util::string_view& word)
+    {
+        if (fast_)
+        {
+            if (pos_ == sentence_end_)
+                return false;
+            auto end = word_end(content_, pos_, sentence_end_);
+            word = util::string_view{content_.data() + pos_, end - pos_};
+            pos_ = end;
+            return true;
+        }
+
+        if (word_idx_ == words_.size())
+            return false;
+        word = segmenter_.content(words_[word_idx_++]);
+        return true;
+    }
+
+    /**
+     * @return whether a word is whitespace (or empty), and so is skipped
+     */
+    bool is_space(util::string_view word) const
+    {
+        if (word.empty())
+            return true;
+
+        if (fast_)
+            return sentence_break(static_cast<unsigned char>(word[0]))
+                   == sentence_class::SP;
+
+        // check first character, if it's whitespace skip it
+        int32_t i = 0;
+        auto length = static_cast<int32_t>(word.size());
+        auto codepoint
+            = utf::detail::utf8_next_codepoint(word.data(), i, length);
+        return codepoint < 0 || utf::isspace(static_cast<uint32_t>(codepoint));
+    }
+
     /// Whether or not to suppress "<s>" or "</s>" generation
     const bool suppress_tags_;
 
+    /// Whether the segmenter uses the default (root locale) rules, which
+    /// the fast path reproduces
+    const bool default_rules_;
+
     /// UTF segmenter to use for this tokenizer
     utf::segmenter segmenter_;
 
-    /// Buffered tokens
-    std::deque<std::string> tokens_;
+    /// The content being tokenized
+    std::string content_;
+
+    /// Whether the content is being segmented by the fast path
+    bool fast_;
+
+    /// The next token: a view into the content, or a sentence tag
+    util::optional<util::string_view> token_;
+
+    /// Whether the words of a sentence are being read
+    bool in_sentence_;
+
+    /// The fast path's position in the content
+    std::size_t pos_;
+
+    /// The end of the fast path's current sentence
+    std::size_t sentence_end_;
+
+    /// The sentences found by ICU
+    std::vector<utf::segmenter::segment> sentences_;
+
+    /// The words of ICU's current sentence
+    std::vector<utf::segmenter::segment> words_;
+
+    /// The index of ICU's next sentence
+    uint64_t sentence_idx_;
+
+    /// The index of the next word in ICU's current sentence
+    uint64_t word_idx_;
 };
 
 icu_tokenizer::icu_tokenizer(bool suppress_tags) : impl_{suppress_tags}
@@ -137,6 +586,11 @@ void icu_tokenizer::set_content(std::string&& content)
 }
 
 std::string icu_tokenizer::next()
+{
+    return impl_->next().to_string();
+}
+
+util::string_view icu_tokenizer::next_view(token_arena&)
 {
     return impl_->next();
 }
@@ -30,25 +30,31 @@ void whitespace_tokenizer::set_content(std::string&& content)
 }
 
 std::string whitespace_tokenizer::next()
+{
+    token_arena arena;
+    return next_view(arena).to_string();
+}
+
+util::string_view whitespace_tokenizer::next_view(token_arena&)
 {
     if (!*this)
         throw token_stream_exception{"next() called with no tokens left"};
 
-    std::string ret;
+    auto start = idx_;
     // all whitespace chars are their own token
     if (std::isspace(content_[idx_]))
     {
-        ret.push_back(content_[idx_++]);
+        ++idx_;
     }
     // otherwise, concatenate all non-whitespace chars together until we
     // find a whitespace char
     else
     {
         while (*this && !std::isspace(content_[idx_]))
-            ret.push_back(content_[idx_++]);
+            ++idx_;
     }
-    assert(!ret.empty());
-    return ret;
+    assert(idx_ > start);
+    return {content_.data() + start, idx_ - start};
 }
 
 whitespace_tokenizer::operator bool() const
@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "cpptoml.h"
 #include "meta/classify/classifier/knn.h"
@@ -26,11 +27,11 @@ knn::knn(multiclass_dataset_view docs,
     : inv_idx_{std::move(idx)},
       k_{k},
       ranker_{std::move(ranker)},
+      legal_docs_{inv_idx_->num_docs()},
       weighted_{weighted}
 {
-    legal_docs_.reserve(docs.size());
     for (const auto& instance : docs)
-        legal_docs_.insert(doc_id(instance.id));
+        legal_docs_.set(doc_id(instance.id));
 }
 
 knn::knn(std::istream& in)
@@ -44,13 +45,10 @@ knn::knn(std::istream& in)
     io::packed::read(in, k_);
     ranker_ = index::load_ranker(in);
 
+    legal_docs_ = index::doc_filter{inv_idx_->num_docs()};
     auto size = io::packed::read<std::size_t>(in);
-    legal_docs_.reserve(size);
     for (std::size_t i = 0; i < size; ++i)
-    {
-        auto id = io::packed::read<doc_id>(in);
-        legal_docs_.insert(id);
-    }
+        legal_docs_.set(io::packed::read<doc_id>(in));
 }
 
 void knn::save(std::ostream& out) const
@@ -62,28 +60,29 @@ void knn::save(std::ostream& out) const
     io::packed::write(out, k_);
     ranker_->save(out);
 
-    io::packed::write(out, legal_docs_.size());
-    for (const auto& doc : legal_docs_)
-        io::packed::write(out, doc);
+    io::packed::write(out, static_cast<std::size_t>(legal_docs_.count()));
+    legal_docs_.for_each([&](doc_id d_id)
+                         {
+                             io::packed::write(out, d_id);
+                         });
 }
 
 class_label knn::classify(const feature_vector& instance) const
 {
-    if (k_ > legal_docs_.size())
+    if (k_ > legal_docs_.count())
         throw knn_exception{
             "k must be smaller than the "
             "number of documents in the index (training documents)"};
 
-    analyzers::feature_map<uint64_t> query{instance.size()};
+    // each thread reuses one map for every instance it classifies
+    static thread_local analyzers::feature_map<uint64_t> query;
+    query.reset();
     for (const auto& count : instance)
         query[inv_idx_->term_text(count.first)] += count.second;
     assert(query.size() > 0);
 
-    auto scored = ranker_->score(
-        *inv_idx_, query.begin(), query.end(), k_, [&](doc_id d_id)
-        {
-            return legal_docs_.find(d_id) != legal_docs_.end();
-        });
+    auto scored = ranker_->score(*inv_idx_, query.begin(), query.end(), k_,
+                                 legal_docs_);
 
     std::unordered_map<class_label, double> counts;
     for (auto& s : scored)
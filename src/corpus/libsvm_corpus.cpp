@@ -19,6 +19,7 @@ libsvm_corpus::libsvm_corpus(const std::string& file,
                              label_type type /* = label_type::CLASSIFICATION */,
                              uint64_t num_docs /* = 0 */)
     : corpus{"utf-8"},
+      path_{file},
       cur_id_{0},
       lbl_type_{type},
       num_lines_{num_docs},
@@ -82,6 +83,16 @@ uint64_t libsvm_corpus::size() const
     return num_lines_;
 }
 
+const std::string& libsvm_corpus::path() const
+{
+    return path_;
+}
+
+auto libsvm_corpus::lbl_type() const -> label_type
+{
+    return lbl_type_;
+}
+
 template <>
 std::unique_ptr<corpus> make_corpus<libsvm_corpus>(util::string_view prefix,
                                                    util::string_view dataset,
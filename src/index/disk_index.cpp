@@ -3,9 +3,12 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
 #include <numeric>
 #include <stdexcept>
+#include <thread>
 
+#include "cpptoml.h"
 #include "meta/index/disk_index.h"
 #include "meta/index/disk_index_impl.h"
 #include "meta/index/string_list.h"
@@ -22,9 +25,48 @@ namespace meta
 namespace index
 {
 
-disk_index::disk_index(const cpptoml::table&, const std::string& name)
+namespace
+{
+io::mmap_advice parse_advice(const std::string& advice)
+{
+    if (advice == "normal")
+        return io::mmap_advice::normal;
+    if (advice == "sequential")
+        return io::mmap_advice::sequential;
+    if (advice == "random")
+        return io::mmap_advice::random;
+    if (advice == "will-need")
+        return io::mmap_advice::will_need;
+    throw disk_index_exception{"unknown index-load advice: " + advice};
+}
+}
+
+disk_index::disk_index(const cpptoml::table& config, const std::string& name)
 {
     impl_->index_name_ = name;
+
+    if (auto load = config.get_table("index-load"))
+    {
+        auto& options = impl_->options_;
+        options.lazy = load->get_as<bool>("lazy").value_or(false);
+        if (auto advice = load->get_as<std::string>("advice"))
+            options.advice = parse_advice(*advice);
+        options.huge_pages = load->get_as<bool>("huge-pages").value_or(false);
+        options.prefault = load->get_as<bool>("prefault").value_or(false);
+        if (auto threads = load->get_as<int64_t>("prefault-threads"))
+        {
+            if (*threads < 1)
+                throw disk_index_exception{
+                    "index-load prefault-threads must be positive"};
+            options.prefault_threads = static_cast<unsigned>(*threads);
+        }
+        else
+        {
+            // hardware_concurrency() may not know, in which case it is 0
+            options.prefault_threads
+                = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+    }
 }
 
 std::string disk_index::index_name() const
@@ -36,41 +78,44 @@ term_id disk_index::get_term_id(const std::string& term)
 {
     std::lock_guard<std::mutex> lock{impl_->mutex_};
 
-    auto termID = impl_->term_id_mapping_->find(term);
+    const auto& mapping = impl_->term_id_mapping();
+    auto termID = mapping.find(term);
     if (termID)
         return term_id{*termID};
 
-    uint64_t size = impl_->term_id_mapping_->size();
+    uint64_t size = mapping.size();
     return term_id{size};
 }
 
 class_label disk_index::label(doc_id d_id) const
 {
-    return class_label_from_id(impl_->labels_->at(d_id));
+    return class_label_from_id(impl_->labels().at(d_id));
 }
 
 label_id disk_index::lbl_id(doc_id d_id) const
 {
-    return impl_->labels_->at(d_id);
+    return impl_->labels().at(d_id);
 }
 
 label_id disk_index::id(class_label label) const
 {
-    if (!impl_->label_ids_.contains_key(label))
+    const auto& label_ids = impl_->label_ids();
+    if (!label_ids.contains_key(label))
         throw std::out_of_range{"Invalid class_label: " + std::string(label)};
-    return impl_->label_ids_.get_value(label);
+    return label_ids.get_value(label);
 }
 
 class_label disk_index::class_label_from_id(label_id l_id) const
 {
-    if (!impl_->label_ids_.contains_value(l_id))
+    const auto& label_ids = impl_->label_ids();
+    if (!label_ids.contains_value(l_id))
         throw std::out_of_range{"Invalid label_id: " + std::to_string(l_id)};
-    return impl_->label_ids_.get_key(l_id);
+    return label_ids.get_key(l_id);
 }
 
 uint64_t disk_index::num_labels() const
 {
-    return impl_->label_ids_.size();
+    return impl_->label_ids().size();
 }
 
 std::vector<class_label> disk_index::class_labels() const
@@ -80,7 +125,7 @@ std::vector<class_label> disk_index::class_labels() const
 
 corpus::metadata disk_index::metadata(doc_id d_id) const
 {
-    return impl_->metadata_->get(d_id);
+    return impl_->metadata().get(d_id);
 }
 
 uint64_t disk_index::unique_terms(doc_id d_id) const
@@ -90,7 +135,7 @@ uint64_t disk_index::unique_terms(doc_id d_id) const
 
 uint64_t disk_index::unique_terms() const
 {
-    return impl_->term_id_mapping_->size();
+    return impl_->term_id_mapping().size();
 }
 
 uint64_t disk_index::doc_size(doc_id d_id) const
@@ -100,7 +145,7 @@ uint64_t disk_index::doc_size(doc_id d_id) const
 
 uint64_t disk_index::num_docs() const
 {
-    return impl_->metadata_->size();
+    return impl_->metadata().size();
 }
 
 std::string disk_index::doc_name(doc_id d_id) const
@@ -111,7 +156,7 @@ std::string disk_index::doc_name(doc_id d_id) const
 
 std::string disk_index::doc_path(doc_id d_id) const
 {
-    if (auto path = impl_->metadata_->get(d_id).get<std::string>("path"))
+    if (auto path = impl_->metadata().get(d_id).get<std::string>("path"))
         return *path;
     return "[none]";
 }
@@ -182,28 +227,100 @@ void disk_index::disk_index_impl::set_label(doc_id id, const class_label& label)
 
 uint64_t disk_index::disk_index_impl::total_unique_terms() const
 {
-    return term_id_mapping_->size();
+    return term_id_mapping().size();
 }
 
 label_id disk_index::disk_index_impl::doc_label_id(doc_id id) const
 {
-    return labels_->at(id);
+    return labels().at(id);
 }
 
 std::vector<class_label> disk_index::disk_index_impl::class_labels() const
 {
+    const auto& ids = label_ids();
     std::vector<class_label> labels;
-    labels.reserve(label_ids_.size());
-    for (const auto& pair : label_ids_)
+    labels.reserve(ids.size());
+    for (const auto& pair : ids)
         labels.emplace_back(pair.first);
     return labels;
 }
 
+auto disk_index::disk_index_impl::options() const -> const load_options&
+{
+    return options_;
+}
+
+const metadata_file& disk_index::disk_index_impl::metadata() const
+{
+    auto open = [&]()
+    {
+        metadata_ = metadata_file{index_name_};
+        prepare(*metadata_);
+    };
+
+    std::call_once(metadata_flag_, [&]()
+                   {
+                       if (!metadata_)
+                           timed_load("metadata", open);
+                   });
+    return *metadata_;
+}
+
+const vocabulary_map& disk_index::disk_index_impl::term_id_mapping() const
+{
+    auto open = [&]()
+    {
+        term_id_mapping_
+            = vocabulary_map{index_name_ + files[TERM_IDS_MAPPING]};
+        prepare(*term_id_mapping_);
+    };
+
+    std::call_once(term_id_mapping_flag_, [&]()
+                   {
+                       if (!term_id_mapping_)
+                           timed_load("term_id mapping", open);
+                   });
+    return *term_id_mapping_;
+}
+
+const util::disk_vector<label_id>& disk_index::disk_index_impl::labels() const
+{
+    auto open = [&]()
+    {
+        labels_ = util::disk_vector<label_id>{index_name_ + files[DOC_LABELS]};
+        prepare(*labels_);
+    };
+
+    std::call_once(labels_flag_, [&]()
+                   {
+                       if (!labels_)
+                           timed_load("labels", open);
+                   });
+    return *labels_;
+}
+
+auto disk_index::disk_index_impl::label_ids() const
+    -> const util::invertible_map<class_label, label_id> &
+{
+    auto read = [&]()
+    {
+        map::load_mapping(label_ids_, index_name_ + files[LABEL_IDS_MAPPING]);
+    };
+
+    std::call_once(label_ids_flag_, [&]()
+                   {
+                       if (label_ids_.size() == 0)
+                           timed_load("label_id mapping", read);
+                   });
+    return label_ids_;
+}
+
 std::string disk_index::term_text(term_id t_id) const
 {
-    if (t_id >= impl_->term_id_mapping_->size())
+    const auto& mapping = impl_->term_id_mapping();
+    if (t_id >= mapping.size())
         return "";
-    return impl_->term_id_mapping_->find_term(t_id);
+    return mapping.find_term(t_id);
 }
 }
 }
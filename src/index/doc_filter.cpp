@@ -0,0 +1,128 @@
+/**
+ * @file doc_filter.cpp
+ */
+
+#include <algorithm>
+
+#include "meta/index/doc_filter.h"
+
+namespace meta
+{
+namespace index
+{
+
+doc_filter::doc_filter(uint64_t num_docs, bool value /* = false */)
+    : num_docs_{num_docs},
+      words_((num_docs + 63) / 64, value ? ~uint64_t{0} : uint64_t{0})
+{
+    clear_tail();
+    count_ = value ? num_docs : 0;
+}
+
+void doc_filter::set(doc_id d_id, bool value /* = true */)
+{
+    if (d_id >= num_docs_)
+        return;
+
+    auto& word = words_[d_id / 64];
+    auto mask = uint64_t{1} << (d_id % 64);
+    if (value && !(word & mask))
+    {
+        word |= mask;
+        ++count_;
+    }
+    else if (!value && (word & mask))
+    {
+        word &= ~mask;
+        --count_;
+    }
+}
+
+doc_id doc_filter::next(doc_id d_id) const
+{
+    if (d_id >= num_docs_)
+        return doc_id{num_docs_};
+
+    auto i = d_id / 64;
+    // mask off the documents before d_id in its word
+    auto word = words_[i] & (~uint64_t{0} << (d_id % 64));
+    while (word == 0)
+    {
+        if (++i == words_.size())
+            return doc_id{num_docs_};
+        word = words_[i];
+    }
+    return doc_id{i * 64 + succinct::broadword::lsb(word)};
+}
+
+uint64_t doc_filter::size() const
+{
+    return num_docs_;
+}
+
+uint64_t doc_filter::count() const
+{
+    return count_;
+}
+
+doc_filter& doc_filter::operator&=(const doc_filter& other)
+{
+    auto common = std::min(words_.size(), other.words_.size());
+    for (uint64_t i = 0; i < common; ++i)
+        words_[i] &= other.words_[i];
+    // documents other doesn't cover are rejected by it
+    std::fill(words_.begin() + static_cast<std::ptrdiff_t>(common),
+              words_.end(), 0);
+    recount();
+    return *this;
+}
+
+doc_filter& doc_filter::operator|=(const doc_filter& other)
+{
+    if (other.num_docs_ > num_docs_)
+    {
+        num_docs_ = other.num_docs_;
+        words_.resize(other.words_.size(), 0);
+    }
+    for (uint64_t i = 0; i < other.words_.size(); ++i)
+        words_[i] |= other.words_[i];
+    recount();
+    return *this;
+}
+
+doc_filter doc_filter::operator~() const
+{
+    doc_filter result{*this};
+    for (auto& word : result.words_)
+        word = ~word;
+    result.clear_tail();
+    result.count_ = num_docs_ - count_;
+    return result;
+}
+
+void doc_filter::clear_tail()
+{
+    if (num_docs_ % 64 != 0)
+        words_.back() &= (uint64_t{1} << (num_docs_ % 64)) - 1;
+}
+
+void doc_filter::recount()
+{
+    count_ = 0;
+    for (const auto& word : words_)
+        count_ += succinct::broadword::popcount(word);
+}
+
+doc_filter operator&(doc_filter a, const doc_filter& b)
+{
+    a &= b;
+    return a;
+}
+
+doc_filter operator|(doc_filter a, const doc_filter& b)
+{
+    a |= b;
+    return a;
+}
+}
+}
@@ -0,0 +1,335 @@
+/**
+ * @file doc_reorder.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+#include "meta/index/doc_reorder.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/postings_data.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/progress.h"
+
+namespace meta
+{
+namespace index
+{
+namespace reorder
+{
+
+forward_graph make_forward_graph(const std::string& path, uint64_t num_docs)
+{
+    forward_graph graph;
+    graph.offsets.resize(num_docs + 1, 0);
+
+    // first pass: count the degree of each document so that the terms
+    // can be placed directly into their final positions
+    {
+        std::ifstream in{path, std::ios::binary};
+        inverted_index::index_pdata_type pdata;
+        while (pdata.read_packed(in))
+        {
+            if (pdata.counts().size() < 2)
+                continue;
+
+            for (const auto& count : pdata.counts())
+                ++graph.offsets[count.first + 1];
+            ++graph.num_terms;
+        }
+    }
+
+    if (graph.num_terms > std::numeric_limits<uint32_t>::max())
+        throw reorder_exception{"too many terms to reorder documents"};
+
+    std::partial_sum(graph.offsets.begin(), graph.offsets.end(),
+                     graph.offsets.begin());
+    graph.terms.resize(graph.offsets.back());
+
+    // second pass: fill in the terms for each document
+    {
+        std::vector<uint64_t> pos(graph.offsets.begin(),
+                                  graph.offsets.end() - 1);
+        std::ifstream in{path, std::ios::binary};
+        inverted_index::index_pdata_type pdata;
+        uint32_t t_id = 0;
+        while (pdata.read_packed(in))
+        {
+            if (pdata.counts().size() < 2)
+                continue;
+
+            for (const auto& count : pdata.counts())
+                graph.terms[pos[count.first]++] = t_id;
+            ++t_id;
+        }
+    }
+
+    return graph;
+}
+
+namespace
+{
+/**
+ * Recursive graph bisection over a single ordering of the documents. The
+ * degree arrays are shared across all levels of recursion (only the
+ * entries for terms in the current partition are ever non-zero), so the
+ * recursion itself is sequential and the parallelism comes from
+ * computing the move gains.
+ */
+class bisector
+{
+  public:
+    bisector(const forward_graph& graph, const bisection_options& options)
+        : graph_(graph),
+          options_(options),
+          left_deg_(graph.num_terms, 0),
+          right_deg_(graph.num_terms, 0),
+          pool_{std::max(options.num_threads, 1u)},
+          progress_{" > Reordering documents: ", graph.num_docs()}
+    {
+        // nothing
+    }
+
+    void operator()(std::vector<doc_id>& order)
+    {
+        bisect(order.begin(), order.end());
+        progress_.end();
+    }
+
+  private:
+    using iterator = std::vector<doc_id>::iterator;
+    using move_type = std::pair<double, doc_id>;
+
+    /**
+     * The estimated number of bits needed to encode a term's gaps in a
+     * partition of size n in which it occurs deg times.
+     */
+    static double cost(double deg, double n)
+    {
+        return deg * std::log2(n / (deg + 1));
+    }
+
+    template <class Function>
+    void for_each_term(doc_id d_id, Function&& fn) const
+    {
+        auto first = graph_.offsets[d_id];
+        auto last = graph_.offsets[d_id + 1];
+        for (auto i = first; i < last; ++i)
+            fn(graph_.terms[i]);
+    }
+
+    void compute_gains(std::vector<move_type>& moves,
+                       const std::vector<uint32_t>& from,
+                       const std::vector<uint32_t>& to, double from_size,
+                       double to_size)
+    {
+        auto gain = [&](move_type& move)
+        {
+            double before = 0;
+            double after = 0;
+            for_each_term(move.second, [&](uint32_t t)
+                          {
+                              before += cost(from[t], from_size)
+                                        + cost(to[t], to_size);
+                              after += cost(from[t] - 1.0, from_size)
+                                       + cost(to[t] + 1.0, to_size);
+                          });
+            move.first = before - after;
+        };
+
+        if (moves.size() < 4096)
+            std::for_each(moves.begin(), moves.end(), gain);
+        else
+            parallel::parallel_for(moves.begin(), moves.end(), pool_, gain);
+
+        std::sort(moves.begin(), moves.end(),
+                  [](const move_type& a, const move_type& b)
+                  {
+                      return a.first > b.first;
+                  });
+    }
+
+    void bisect(iterator begin, iterator end)
+    {
+        auto size = static_cast<uint64_t>(std::distance(begin, end));
+        if (size <= options_.min_partition_size)
+        {
+            done_ += size;
+            progress_(done_);
+            return;
+        }
+
+        auto mid = begin + static_cast<std::ptrdiff_t>(size / 2);
+        auto left_size = static_cast<double>(std::distance(begin, mid));
+        auto right_size = static_cast<double>(std::distance(mid, end));
+
+        for (auto it = begin; it != mid; ++it)
+            for_each_term(*it, [&](uint32_t t) { ++left_deg_[t]; });
+        for (auto it = mid; it != end; ++it)
+            for_each_term(*it, [&](uint32_t t) { ++right_deg_[t]; });
+
+        std::vector<move_type> left_moves;
+        std::vector<move_type> right_moves;
+        for (uint64_t iter = 0; iter < options_.iterations; ++iter)
+        {
+            left_moves.clear();
+            right_moves.clear();
+            for (auto it = begin; it != mid; ++it)
+                left_moves.emplace_back(0.0, *it);
+            for (auto it = mid; it != end; ++it)
+                right_moves.emplace_back(0.0, *it);
+
+            compute_gains(left_moves, left_deg_, right_deg_, left_size,
+                          right_size);
+            compute_gains(right_moves, right_deg_, left_deg_, right_size,
+                          left_size);
+
+            // swap pairs of documents for as long as doing so decreases
+            // the total cost
+            uint64_t swaps = 0;
+            auto num_pairs = std::min(left_moves.size(), right_moves.size());
+            for (; swaps < num_pairs; ++swaps)
+            {
+                auto& lhs = left_moves[swaps];
+                auto& rhs = right_moves[swaps];
+                if (lhs.first + rhs.first <= 0)
+                    break;
+
+                for_each_term(lhs.second, [&](uint32_t t)
+                              {
+                                  --left_deg_[t];
+                                  ++right_deg_[t];
+                              });
+                for_each_term(rhs.second, [&](uint32_t t)
+                              {
+                                  --right_deg_[t];
+                                  ++left_deg_[t];
+                              });
+                std::swap(lhs.second, rhs.second);
+            }
+
+            if (swaps == 0)
+                break;
+
+            std::transform(left_moves.begin(), left_moves.end(), begin,
+                           [](const move_type& move)
+                           {
+                               return move.second;
+                           });
+            std::transform(right_moves.begin(), right_moves.end(), mid,
+                           [](const move_type& move)
+                           {
+                               return move.second;
+                           });
+        }
+
+        // reset the degrees for the next partition
+        for (auto it = begin; it != end; ++it)
+        {
+            for_each_term(*it, [&](uint32_t t)
+                          {
+                              left_deg_[t] = 0;
+                              right_deg_[t] = 0;
+                          });
+        }
+
+        bisect(begin, mid);
+        bisect(mid, end);
+    }
+
+    const forward_graph& graph_;
+    const bisection_options& options_;
+    std::vector<uint32_t> left_deg_;
+    std::vector<uint32_t> right_deg_;
+    parallel::thread_pool pool_;
+    printing::progress progress_;
+    uint64_t done_ = 0;
+};
+
+/**
+ * Stably sorts the documents by the key computed for each of them.
+ */
+template <class KeyFunction>
+void sort_by_key(std::vector<doc_id>& order, KeyFunction&& key)
+{
+    using key_type = typename std::decay<decltype(key(doc_id{0}))>::type;
+    std::vector<key_type> keys;
+    keys.reserve(order.size());
+    for (const auto& d_id : order)
+        keys.emplace_back(key(d_id));
+
+    std::stable_sort(order.begin(), order.end(), [&](doc_id a, doc_id b)
+                     {
+                         return keys[a] < keys[b];
+                     });
+}
+}
+
+std::vector<doc_id> graph_bisection(const forward_graph& graph,
+                                    const bisection_options& options)
+{
+    std::vector<doc_id> order(graph.num_docs());
+    std::iota(order.begin(), order.end(), doc_id{0});
+
+    bisector bisect{graph, options};
+    bisect(order);
+
+    return order;
+}
+
+std::vector<doc_id> by_metadata(const metadata_file& mdata,
+                                const std::string& field)
+{
+    std::vector<doc_id> order(mdata.size());
+    std::iota(order.begin(), order.end(), doc_id{0});
+    if (order.empty())
+        return order;
+
+    const auto& schema = mdata.get(doc_id{0}).schema();
+    auto it = std::find_if(schema.begin(), schema.end(),
+                           [&](const corpus::metadata::field_info& info)
+                           {
+                               return info.name == field;
+                           });
+    if (it == schema.end())
+        throw reorder_exception{"no metadata field named " + field};
+
+    switch (it->type)
+    {
+        case corpus::metadata::field_type::SIGNED_INT:
+            sort_by_key(order, [&](doc_id d_id)
+                        {
+                            return *mdata.get(d_id).get<int64_t>(field);
+                        });
+            break;
+
+        case corpus::metadata::field_type::UNSIGNED_INT:
+            sort_by_key(order, [&](doc_id d_id)
+                        {
+                            return *mdata.get(d_id).get<uint64_t>(field);
+                        });
+            break;
+
+        case corpus::metadata::field_type::DOUBLE:
+            sort_by_key(order, [&](doc_id d_id)
+                        {
+                            return *mdata.get(d_id).get<double>(field);
+                        });
+            break;
+
+        case corpus::metadata::field_type::STRING:
+            sort_by_key(order, [&](doc_id d_id)
+                        {
+                            return *mdata.get(d_id).get<std::string>(field);
+                        });
+            break;
+    }
+
+    return order;
+}
+}
+}
+}
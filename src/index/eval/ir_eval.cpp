@@ -240,5 +240,13 @@ void ir_eval::reset_stats()
 {
     scores_.clear();
 }
+
+uint64_t ir_eval::relevance(query_id q_id, doc_id d_id) const
+{
+    auto ht = qrels_.find(q_id);
+    if (ht == qrels_.end())
+        return 0;
+    return map::safe_at(ht->second, d_id);
+}
 }
 }
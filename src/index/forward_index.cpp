@@ -3,6 +3,9 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "cpptoml.h"
 #include "meta/analyzers/analyzer.h"
 #include "meta/corpus/corpus.h"
@@ -22,6 +25,7 @@
 #include "meta/index/vocabulary_map.h"
 #include "meta/index/vocabulary_map_writer.h"
 #include "meta/io/libsvm_parser.h"
+#include "meta/io/mmap_file.h"
 #include "meta/logging/logger.h"
 #include "meta/parallel/thread_pool.h"
 #include "meta/util/disk_vector.h"
@@ -67,23 +71,72 @@ class forward_index::impl
     void merge_chunks(size_t num_chunks, uint64_t num_docs,
                       hashing::probe_map<std::string, term_id> vocab);
 
+    /**
+     * Analyzes a document into hashed features, folding each feature's id
+     * down to a term_id.
+     * @param an The analyzer to use
+     * @param doc The document to analyze
+     * @param counts A map to analyze the document into, which is emptied
+     * first so that it can be reused for every document
+     * @return the document's term counts, sorted by term_id
+     */
+    forward_index::postings_data_type::count_t
+    hashed_counts(analyzers::analyzer& an, const corpus::document& doc,
+                  analyzers::hashed_feature_map<double>& counts) const;
+
     /**
      * @param docs The documents to index (that are in libsvm format)
+     * @param num_threads The number of threads to parse the corpus with
      */
-    void create_libsvm_postings(corpus::corpus& docs);
+    void create_libsvm_postings(corpus::libsvm_corpus& docs,
+                                unsigned num_threads);
 
     /**
+     * Creates the postings file by reading documents from the corpus one
+     * at a time. This handles corpora with arbitrary metadata.
+     * @param docs The documents to index (that are in libsvm format)
+     */
+    void parse_libsvm_sequential(corpus::corpus& docs);
+
+    /**
+     * Creates the postings file by splitting the corpus file into
+     * num_threads ranges on line boundaries and parsing each of them in
+     * parallel. The per-thread postings are then concatenated in document
+     * order.
+     * @param docs The documents to index (that are in libsvm format)
+     * @param num_threads The number of threads to parse the corpus with
+     */
+    void parse_libsvm_parallel(const corpus::libsvm_corpus& docs,
+                               unsigned num_threads);
+
+    /**
+     * Uninverts the postings of an inverted index in parallel. The term
+     * id space is handed out to num_threads producers in contiguous
+     * blocks; each producer builds document-keyed chunks from the terms it
+     * was given, and the chunks are merged afterwards.
+     *
      * @param inv_idx The inverted index to uninvert
-     * @param ram_budget The **estimated** allowed size of an in-memory
-     * chunk
+     * @param ram_budget The **estimated** allowed size of all in-memory
+     * chunks combined
+     * @param num_threads The number of producer threads to use
+     * @param max_writers The maximum number of threads writing chunks to
+     * disk at once
      */
-    void uninvert(const inverted_index& inv_idx, uint64_t ram_budget);
+    void uninvert(const inverted_index& inv_idx, uint64_t ram_budget,
+                  unsigned num_threads, unsigned max_writers);
 
     /**
      * @param name The name of the inverted index to copy data from
      */
     void create_uninverted_metadata(const std::string& name);
 
+    /**
+     * Sets hash_bits_ from the feature-hash-bits in a configuration.
+     * @param config The configuration the index was (or will be) created
+     * with
+     */
+    void read_hash_bits(const cpptoml::table& config);
+
     /**
      * @param config the configuration settings for this index
      * @return whether this index will be based off of a single
@@ -104,16 +157,36 @@ class forward_index::impl
      */
     void load_postings();
 
+    using postings_file_type
+        = postings_file<forward_index::primary_key_type,
+                        forward_index::secondary_key_type, double>;
+
+    /**
+     * @return the postings file, opening it if necessary
+     */
+    const postings_file_type& postings() const;
+
     /// The analyzer used to tokenize documents (nullptr if libsvm).
     std::unique_ptr<analyzers::analyzer> analyzer_;
 
+    /// The map tokenize() analyzes each document into
+    analyzers::feature_map<double> tokenize_counts_;
+
+    /// The map tokenize() analyzes each document into when hashing
+    analyzers::hashed_feature_map<double> tokenize_hashed_;
+
     /// the total number of unique terms if term_id_mapping_ is unused
     uint64_t total_unique_terms_;
 
-    /// the postings file
-    util::optional<postings_file<forward_index::primary_key_type,
-                                 forward_index::secondary_key_type, double>>
-        postings_;
+    /// the number of bits of each hashed feature id kept as its term_id,
+    /// or zero if features are not hashed
+    uint64_t hash_bits_;
+
+    /// the postings file (lazily opened if requested in the config)
+    mutable util::optional<postings_file_type> postings_;
+
+    /// guards lazily opening postings_
+    mutable std::once_flag postings_flag_;
 
   private:
     /// Pointer to the forward_index this is an implementation of
@@ -128,10 +201,26 @@ forward_index::forward_index(const cpptoml::table& config)
 }
 
 forward_index::impl::impl(forward_index* idx, const cpptoml::table& config)
-    : idx_{idx}
+    : hash_bits_{0}, idx_{idx}
 {
     if (!is_libsvm_analyzer(config))
         analyzer_ = analyzers::load(config);
+    read_hash_bits(config);
+}
+
+void forward_index::impl::read_hash_bits(const cpptoml::table& config)
+{
+    hash_bits_ = 0;
+    if (auto bits = config.get_as<int64_t>("feature-hash-bits"))
+    {
+        if (!analyzer_)
+            throw forward_index_exception{
+                "libsvm data cannot be indexed with hashed features"};
+        if (*bits < 1 || *bits > 32)
+            throw forward_index_exception{
+                "feature-hash-bits must be between 1 and 32"};
+        hash_bits_ = static_cast<uint64_t>(*bits);
+    }
 }
 
 forward_index::forward_index(forward_index&&) = default;
@@ -181,18 +270,35 @@ void forward_index::load_index()
 {
     LOG(info) << "Loading index from disk: " << index_name() << ENDLG;
 
-    impl_->initialize_metadata();
-    impl_->load_labels();
+    std::ifstream unique_terms_file{index_name() + "/corpus.uniqueterms"};
+    unique_terms_file >> fwd_impl_->total_unique_terms_;
 
+    // the term ids are hashed features only if they were when the index
+    // was created, whatever the current configuration says
     auto config = cpptoml::parse_file(index_name() + "/config.toml");
-    if (!fwd_impl_->is_libsvm_analyzer(*config))
-        impl_->load_term_id_mapping();
+    fwd_impl_->read_hash_bits(*config);
 
-    impl_->load_label_id_mapping();
-    fwd_impl_->load_postings();
+    if (impl_->options().lazy)
+    {
+        LOG(info) << "Index components will be loaded on first use" << ENDLG;
+        return;
+    }
 
-    std::ifstream unique_terms_file{index_name() + "/corpus.uniqueterms"};
-    unique_terms_file >> fwd_impl_->total_unique_terms_;
+    auto time = common::time([&]()
+                             {
+                                 impl_->metadata();
+                                 impl_->labels();
+
+                                 if (!fwd_impl_->is_libsvm_analyzer(*config)
+                                     && fwd_impl_->hash_bits_ == 0)
+                                     impl_->term_id_mapping();
+
+                                 impl_->label_ids();
+                                 fwd_impl_->postings();
+                             });
+
+    LOG(info) << "Done loading index: " << index_name() << " ("
+              << time.count() << "ms)" << ENDLG;
 }
 
 void forward_index::create_index(const cpptoml::table& config,
@@ -206,12 +312,31 @@ void forward_index::create_index(const cpptoml::table& config,
         config_file << config;
     }
 
+    auto max_threads = std::thread::hardware_concurrency();
+    auto num_threads = static_cast<unsigned>(
+        config.get_as<int64_t>("indexer-num-threads").value_or(max_threads));
+    if (num_threads > max_threads)
+    {
+        num_threads = max_threads;
+        LOG(warning) << "Reducing indexer-num-threads to the hardware "
+                        "concurrency level of "
+                     << max_threads << ENDLG;
+    }
+
+    auto uninvert = config.get_as<bool>("uninvert").value_or(false);
+    if (config.get_table("reorder") && !uninvert)
+        LOG(warning) << "Documents are only reordered in forward indexes "
+                        "created by uninverting; ids will not match the "
+                        "inverted index"
+                     << ENDLG;
+
     // if the corpus is a single libsvm formatted file, then we are done;
     // otherwise, we will create an inverted index and the uninvert it
     if (fwd_impl_->is_libsvm_analyzer(config))
     {
         // double check that the corpus is libsvm-corpus
-        if (!dynamic_cast<corpus::libsvm_corpus*>(&docs))
+        auto libsvm_docs = dynamic_cast<corpus::libsvm_corpus*>(&docs);
+        if (!libsvm_docs)
             throw forward_index_exception{"both analyzer and corpus type must "
                                           "be libsvm in order to use libsvm "
                                           "formatted data"};
@@ -219,7 +344,7 @@ void forward_index::create_index(const cpptoml::table& config,
         LOG(info) << "Creating index from libsvm data: " << index_name()
                   << ENDLG;
 
-        fwd_impl_->create_libsvm_postings(docs);
+        fwd_impl_->create_libsvm_postings(*libsvm_docs, num_threads);
         impl_->save_label_id_mapping();
     }
     else
@@ -227,7 +352,12 @@ void forward_index::create_index(const cpptoml::table& config,
         auto ram_budget = static_cast<uint64_t>(
             config.get_as<int64_t>("indexer-ram-budget").value_or(1024));
 
-        if (config.get_as<bool>("uninvert").value_or(false))
+        if (uninvert && fwd_impl_->hash_bits_ > 0)
+            throw forward_index_exception{
+                "an index with hashed features cannot be created by "
+                "uninverting"};
+
+        if (uninvert)
         {
             LOG(info) << "Creating index by uninverting: " << index_name()
                       << ENDLG;
@@ -238,10 +368,14 @@ void forward_index::create_index(const cpptoml::table& config,
             }
             auto inv_idx = make_index<inverted_index>(config);
 
+            auto max_writers = static_cast<unsigned>(
+                config.get_as<int64_t>("indexer-max-writers").value_or(8));
+
             fwd_impl_->create_uninverted_metadata(inv_idx->index_name());
             impl_->load_labels();
             // RAM budget is given in MB
-            fwd_impl_->uninvert(*inv_idx, ram_budget * 1024 * 1024);
+            fwd_impl_->uninvert(*inv_idx, ram_budget * 1024 * 1024,
+                                num_threads, max_writers);
             impl_->load_term_id_mapping();
             fwd_impl_->total_unique_terms_ = impl_->total_unique_terms();
         }
@@ -254,24 +388,20 @@ void forward_index::create_index(const cpptoml::table& config,
 
             impl_->load_labels(docs.size());
 
-            auto max_threads = std::thread::hardware_concurrency();
-            auto num_threads = static_cast<unsigned>(
-                config.get_as<int64_t>("indexer-num-threads")
-                    .value_or(max_threads));
-            if (num_threads > max_threads)
-            {
-                num_threads = max_threads;
-                LOG(warning) << "Reducing indexer-num-threads to the hardware "
-                                "concurrency level of "
-                             << max_threads << ENDLG;
-            }
-
             // RAM budget is given in MB
             fwd_impl_->tokenize_docs(docs, mdata_writer,
                                      ram_budget * 1024 * 1024, num_threads);
-            impl_->load_term_id_mapping();
             impl_->save_label_id_mapping();
-            fwd_impl_->total_unique_terms_ = impl_->total_unique_terms();
+            if (fwd_impl_->hash_bits_ > 0)
+            {
+                fwd_impl_->total_unique_terms_ = uint64_t{1}
+                                                 << fwd_impl_->hash_bits_;
+            }
+            else
+            {
+                impl_->load_term_id_mapping();
+                fwd_impl_->total_unique_terms_ = impl_->total_unique_terms();
+            }
 
             // reload the label file to ensure it was flushed
             impl_->load_labels();
@@ -310,6 +440,9 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
                                 + std::to_string(chunk_id),
                             std::ios::binary};
         auto analyzer = analyzer_->clone();
+        // one map is reused for every document this thread analyzes
+        analyzers::feature_map<double> counts;
+        analyzers::hashed_feature_map<double> hashed;
         while (true)
         {
             util::optional<corpus::document> doc;
@@ -326,30 +459,19 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
                 progress(doc->id());
             }
 
-            auto counts = analyzer->analyze<double>(*doc);
-
-            // warn if there is an empty document
-            if (counts.empty())
+            forward_index::postings_data_type::count_t pd_counts;
+            if (hash_bits_ > 0)
             {
-                std::lock_guard<std::mutex> lock{io_mutex};
-                LOG(progress) << '\n' << ENDLG;
-                LOG(warning) << "Empty document (id = " << doc->id()
-                             << ") generated!" << ENDLG;
+                // hashed features are their own term_ids, so there is no
+                // vocabulary to share between the threads
+                pd_counts = hashed_counts(*analyzer, *doc, hashed);
             }
-
-            auto length = std::accumulate(
-                counts.begin(), counts.end(), 0ul,
-                [](uint64_t acc, const std::pair<std::string, double>& count)
-                {
-                    return acc + std::round(count.second);
-                });
-
-            mdata_writer.write(doc->id(), length, counts.size(), doc->mdata());
-            idx_->impl_->set_label(doc->id(), doc->label());
-
-            forward_index::postings_data_type::count_t pd_counts;
-            pd_counts.reserve(counts.size());
+            else
             {
+                counts.reset();
+                analyzer->analyze(*doc, counts);
+                pd_counts.reserve(counts.size());
+
                 std::lock_guard<std::mutex> lock{vocab_mutex};
                 for (const auto& count : counts)
                 {
@@ -372,6 +494,26 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
                 }
             }
 
+            // warn if there is an empty document
+            if (pd_counts.empty())
+            {
+                std::lock_guard<std::mutex> lock{io_mutex};
+                LOG(progress) << '\n' << ENDLG;
+                LOG(warning) << "Empty document (id = " << doc->id()
+                             << ") generated!" << ENDLG;
+            }
+
+            auto length = std::accumulate(
+                pd_counts.begin(), pd_counts.end(), 0ul,
+                [](uint64_t acc, const std::pair<term_id, double>& count)
+                {
+                    return acc + std::round(count.second);
+                });
+
+            mdata_writer.write(doc->id(), length, pd_counts.size(),
+                               doc->mdata());
+            idx_->impl_->set_label(doc->id(), doc->label());
+
             forward_index::postings_data_type pdata{doc->id()};
             pdata.set_counts(std::move(pd_counts));
             pdata.write_packed(chunk);
@@ -402,7 +544,9 @@ void forward_index::impl::merge_chunks(
         keys[pr.value()] = pr.key();
 
     vocab.clear();
-    // vocab is now empty, but has enough space for the vocabulary
+    // vocab is now empty, but has enough space for the vocabulary; with
+    // hashed features, there is no vocabulary and nothing to renumber
+    if (hash_bits_ == 0)
     {
         // we now create a new vocab with the keys in sorted order
         vocabulary_map_writer writer{idx_->index_name() + "/"
@@ -439,6 +583,12 @@ void forward_index::impl::merge_chunks(
     util::multiway_merge(chunks.begin(), chunks.end(),
                          [&](forward_index::postings_data_type&& to_write)
                          {
+                             if (hash_bits_ > 0)
+                             {
+                                 writer.write(to_write);
+                                 return;
+                             }
+
                              // renumber the postings
                              forward_index::postings_data_type::count_t counts;
                              counts.reserve(to_write.counts().size());
@@ -457,59 +607,298 @@ void forward_index::impl::merge_chunks(
                          });
 }
 
-void forward_index::impl::create_libsvm_postings(corpus::corpus& docs)
+forward_index::postings_data_type::count_t
+forward_index::impl::hashed_counts(
+    analyzers::analyzer& an, const corpus::document& doc,
+    analyzers::hashed_feature_map<double>& counts) const
+{
+    counts.reset();
+    an.analyze_hashed(doc, counts);
+    auto mask = (uint64_t{1} << hash_bits_) - 1;
+
+    forward_index::postings_data_type::count_t pd_counts;
+    pd_counts.reserve(counts.size());
+    for (const auto& count : counts)
+        pd_counts.emplace_back(term_id{count.key() & mask}, count.value());
+
+    // features whose ids share their low bits are summed
+    std::sort(pd_counts.begin(), pd_counts.end());
+    auto out = pd_counts.begin();
+    for (auto it = pd_counts.begin(); it != pd_counts.end(); ++it)
+    {
+        if (out != pd_counts.begin() && (out - 1)->first == it->first)
+            (out - 1)->second += it->second;
+        else
+            *out++ = *it;
+    }
+    pd_counts.erase(out, pd_counts.end());
+    return pd_counts;
+}
+
+void forward_index::impl::create_libsvm_postings(
+    corpus::libsvm_corpus& docs, unsigned num_threads)
+{
+    // the parallel path reads the corpus file directly, so it can only be
+    // used when there is no metadata other than what comes from the label
+    auto regression
+        = docs.lbl_type() == corpus::libsvm_corpus::label_type::REGRESSION;
+    auto num_fields = regression ? 1u : 0u;
+    if (num_threads > 1 && docs.schema().size() == num_fields
+        && filesystem::file_size(docs.path()) > 0)
+    {
+        parse_libsvm_parallel(docs, num_threads);
+    }
+    else
+    {
+        parse_libsvm_sequential(docs);
+    }
+
+    // reload the label file to ensure it was flushed
+    idx_->impl_->load_labels();
+
+    auto filename = idx_->index_name() + idx_->impl_->files[POSTINGS];
+    LOG(info) << "Created compressed postings file ("
+              << printing::bytes_to_units(filesystem::file_size(filename))
+              << ")" << ENDLG;
+}
+
+void forward_index::impl::parse_libsvm_sequential(corpus::corpus& docs)
 {
     auto filename = idx_->index_name() + idx_->impl_->files[POSTINGS];
     auto num_docs = docs.size();
     idx_->impl_->load_labels(num_docs);
 
     total_unique_terms_ = 0;
+    postings_file_writer<forward_index::postings_data_type> out{filename,
+                                                                num_docs};
+
+    // make md_writer with empty schema
+    metadata_writer md_writer{idx_->index_name(), num_docs, docs.schema()};
+
+    printing::progress progress{" > Creating postings from libsvm data: ",
+                                num_docs};
+    while (docs.has_next())
     {
-        postings_file_writer<forward_index::postings_data_type> out{filename,
-                                                                    num_docs};
+        auto doc = docs.next();
+        progress(doc.id());
 
-        // make md_writer with empty schema
-        metadata_writer md_writer{idx_->index_name(), num_docs, docs.schema()};
+        uint64_t num_unique = 0;
+        double length = 0;
+        forward_index::postings_data_type pdata{doc.id()};
 
-        printing::progress progress{" > Creating postings from libsvm data: ",
-                                    num_docs};
-        while (docs.has_next())
+        auto counts = io::libsvm_parser::counts(doc.content());
+        for (const auto& count : counts)
         {
-            auto doc = docs.next();
-            progress(doc.id());
+            ++num_unique;
+            if (count.first > total_unique_terms_)
+                total_unique_terms_ = count.first;
+            length += count.second;
+        }
 
-            uint64_t num_unique = 0;
-            double length = 0;
-            forward_index::postings_data_type pdata{doc.id()};
+        pdata.set_counts(std::move(counts));
+        out.write(pdata);
 
-            auto counts = io::libsvm_parser::counts(doc.content());
-            for (const auto& count : counts)
+        md_writer.write(doc.id(), static_cast<uint64_t>(length), num_unique,
+                        doc.mdata());
+        idx_->impl_->set_label(doc.id(), doc.label());
+    }
+
+    // +1 since we subtracted one from each of the ids in the
+    // libsvm_parser::counts() function
+    ++total_unique_terms_;
+}
+
+namespace
+{
+/**
+ * Calls fn for each non-empty line in [begin, end), with any trailing
+ * carriage return removed.
+ */
+template <class Function>
+void for_each_line(const char* begin, const char* end, Function&& fn)
+{
+    while (begin != end)
+    {
+        auto newline = static_cast<const char*>(
+            std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+        auto line_end = newline ? newline : end;
+        if (line_end != begin && line_end[-1] == '\r')
+            --line_end;
+        if (line_end != begin)
+            fn(util::string_view{begin,
+                                 static_cast<std::size_t>(line_end - begin)});
+        begin = newline ? newline + 1 : end;
+    }
+}
+}
+
+void forward_index::impl::parse_libsvm_parallel(
+    const corpus::libsvm_corpus& docs, unsigned num_threads)
+{
+    io::mmap_file file{docs.path()};
+    file.advise(io::mmap_advice::sequential);
+    const char* begin = file.begin();
+    const char* end = begin + file.size();
+
+    // split the file into num_threads ranges that start at line boundaries
+    std::vector<const char*> bounds(num_threads + 1, end);
+    bounds[0] = begin;
+    for (unsigned i = 1; i < num_threads; ++i)
+    {
+        auto pos = begin + std::max<uint64_t>(file.size() * i / num_threads, 1);
+        auto newline = static_cast<const char*>(std::memchr(
+            pos - 1, '\n', static_cast<std::size_t>(end - pos + 1)));
+        bounds[i] = std::max(newline ? newline + 1 : end, bounds[i - 1]);
+    }
+
+    parallel::thread_pool pool{num_threads};
+
+    // count the documents in each range so that each thread knows the id
+    // of its first document
+    std::vector<doc_id> first_ids(num_threads + 1, doc_id{0});
+    {
+        std::vector<std::future<uint64_t>> futures;
+        futures.reserve(num_threads);
+        auto count_lines = [&](unsigned i)
+        {
+            uint64_t lines = 0;
+            for_each_line(bounds[i], bounds[i + 1], [&](util::string_view)
+                          {
+                              ++lines;
+                          });
+            return lines;
+        };
+
+        for (unsigned i = 0; i < num_threads; ++i)
+            futures.emplace_back(pool.submit_task(std::bind(count_lines, i)));
+        for (unsigned i = 0; i < num_threads; ++i)
+            first_ids[i + 1] = doc_id{first_ids[i] + futures[i].get()};
+    }
+
+    uint64_t num_docs = first_ids.back();
+    if (num_docs == 0)
+        throw forward_index_exception{"no documents in libsvm corpus: "
+                                      + docs.path()};
+
+    idx_->impl_->load_labels(num_docs);
+
+    auto filename = idx_->index_name() + idx_->impl_->files[POSTINGS];
+    util::disk_vector<uint64_t> byte_locations{filename + "_index", num_docs};
+
+    auto regression
+        = docs.lbl_type() == corpus::libsvm_corpus::label_type::REGRESSION;
+    metadata_writer md_writer{idx_->index_name(), num_docs, docs.schema()};
+
+    // the labels are views into the memory mapped corpus file
+    std::vector<util::string_view> labels;
+    if (!regression)
+        labels.resize(num_docs);
+
+    printing::progress progress{" > Creating postings from libsvm data: ",
+                                num_docs};
+    std::atomic<uint64_t> num_done{0};
+
+    auto chunk_name = [&](unsigned i)
+    {
+        return idx_->index_name() + "/chunk-" + std::to_string(i);
+    };
+
+    // each thread writes the postings for its range to its own chunk file,
+    // recording offsets relative to the start of that chunk
+    auto task = [&](unsigned i)
+    {
+        std::ofstream chunk{chunk_name(i), std::ios::binary};
+        forward_index::postings_data_type pdata{first_ids[i]};
+        forward_index::postings_data_type::count_t counts;
+        std::vector<corpus::metadata::field> mdata;
+        uint64_t bytes = 0;
+        uint64_t max_term = 0;
+        auto id = first_ids[i];
+
+        for_each_line(bounds[i], bounds[i + 1], [&](util::string_view line)
+                      {
+                          auto lbl = io::libsvm_parser::parse(line, counts);
+
+                          double length = 0;
+                          for (const auto& count : counts)
+                          {
+                              if (count.first > max_term)
+                                  max_term = count.first;
+                              length += count.second;
+                          }
+
+                          mdata.clear();
+                          if (regression)
+                              mdata.emplace_back(std::stod(lbl.to_string()));
+                          else
+                              labels[id] = lbl;
+
+                          md_writer.write(id, static_cast<uint64_t>(length),
+                                          counts.size(), mdata);
+
+                          pdata.set_primary_key(id);
+                          pdata.set_counts(counts);
+                          byte_locations[id] = bytes;
+                          bytes += pdata.write_packed_counts(chunk);
+
+                          progress(++num_done);
+                          ++id;
+                      });
+
+        return max_term;
+    };
+
+    uint64_t max_term = 0;
+    {
+        std::vector<std::future<uint64_t>> futures;
+        futures.reserve(num_threads);
+        for (unsigned i = 0; i < num_threads; ++i)
+            futures.emplace_back(pool.submit_task(std::bind(task, i)));
+
+        for (auto& fut : futures)
+            max_term = std::max(max_term, fut.get());
+    }
+    progress.end();
+
+    // concatenate the chunks in document order, shifting each chunk's
+    // offsets by the number of bytes that precede it
+    {
+        std::ofstream out{filename, std::ios::binary};
+        uint64_t base = 0;
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            auto name = chunk_name(i);
+            auto size = filesystem::file_size(name);
+            if (size > 0)
             {
-                ++num_unique;
-                if (count.first > total_unique_terms_)
-                    total_unique_terms_ = count.first;
-                length += count.second;
+                std::ifstream in{name, std::ios::binary};
+                out << in.rdbuf();
             }
+            filesystem::delete_file(name);
 
-            pdata.set_counts(std::move(counts));
-            out.write(pdata);
-
-            md_writer.write(doc.id(), static_cast<uint64_t>(length), num_unique,
-                            doc.mdata());
-            idx_->impl_->set_label(doc.id(), doc.label());
+            for (auto id = first_ids[i]; id < first_ids[i + 1]; ++id)
+                byte_locations[id] += base;
+            base += size;
         }
-
-        // +1 since we subtracted one from each of the ids in the
-        // libsvm_parser::counts() function
-        ++total_unique_terms_;
     }
 
-    // reload the label file to ensure it was flushed
-    idx_->impl_->load_labels();
+    // labels are assigned ids in order of first occurrence, so this is
+    // done sequentially to keep them identical to the sequential path
+    if (regression)
+    {
+        class_label none{"[none]"};
+        for (doc_id id{0}; id < num_docs; ++id)
+            idx_->impl_->set_label(id, none);
+    }
+    else
+    {
+        for (doc_id id{0}; id < num_docs; ++id)
+            idx_->impl_->set_label(id, class_label{labels[id].to_string()});
+    }
 
-    LOG(info) << "Created compressed postings file ("
-              << printing::bytes_to_units(filesystem::file_size(filename))
-              << ")" << ENDLG;
+    // +1 since we subtracted one from each of the ids in the
+    // libsvm_parser::parse() function
+    total_unique_terms_ = max_term + 1;
 }
 
 void forward_index::impl::create_uninverted_metadata(const std::string& name)
@@ -521,6 +910,11 @@ void forward_index::impl::create_uninverted_metadata(const std::string& name)
     for (const auto& file : files)
         filesystem::copy_file(name + idx_->impl_->files[file],
                               idx_->index_name() + idx_->impl_->files[file]);
+
+    // present only if the inverted index reordered its documents
+    if (filesystem::file_exists(name + "/docs.order"))
+        filesystem::copy_file(name + "/docs.order",
+                              idx_->index_name() + "/docs.order");
 }
 
 bool forward_index::impl::is_libsvm_analyzer(const cpptoml::table& config) const
@@ -542,7 +936,18 @@ learn::feature_vector forward_index::tokenize(const corpus::document& doc)
         throw exception{"this forward index type can't analyze docs"};
 
     learn::feature_vector f_vec;
-    auto map = fwd_impl_->analyzer_->analyze<double>(doc);
+    if (fwd_impl_->hash_bits_ > 0)
+    {
+        for (const auto& count : fwd_impl_->hashed_counts(
+                 *fwd_impl_->analyzer_, doc, fwd_impl_->tokenize_hashed_))
+            f_vec[count.first] = count.second;
+        return f_vec;
+    }
+
+    // the map is reused for every document, as when indexing
+    auto& map = fwd_impl_->tokenize_counts_;
+    map.reset();
+    fwd_impl_->analyzer_->analyze(doc, map);
     for (auto& pr : map)
     {
         auto t_id = get_term_id(pr.key());
@@ -561,26 +966,63 @@ uint64_t forward_index::unique_terms() const
 auto forward_index::search_primary(doc_id d_id) const
     -> std::shared_ptr<postings_data_type>
 {
-    return fwd_impl_->postings_->find(d_id);
+    return fwd_impl_->postings().find(d_id);
 }
 
 util::optional<postings_stream<term_id, double>>
 forward_index::stream_for(doc_id d_id) const
 {
-    return fwd_impl_->postings_->find_stream(d_id);
+    return fwd_impl_->postings().find_stream(d_id);
 }
 
 void forward_index::impl::uninvert(const inverted_index& inv_idx,
-                                   uint64_t ram_budget)
+                                   uint64_t ram_budget, unsigned num_threads,
+                                   unsigned max_writers)
 {
-    postings_inverter<forward_index> handler{idx_->index_name()};
+    postings_inverter<forward_index> handler{idx_->index_name(), max_writers};
     {
-        auto producer = handler.make_producer(ram_budget);
-        for (term_id t_id{0}; t_id < inv_idx.unique_terms(); ++t_id)
+        // terms are handed out in increasing blocks so that each producer
+        // still sees its term ids in sorted order, which the postings
+        // buffers rely on for gap encoding
+        const uint64_t block_size = 1024;
+        const uint64_t num_terms = inv_idx.unique_terms();
+        std::atomic<uint64_t> next_term{0};
+        std::atomic<uint64_t> num_done{0};
+        printing::progress progress{" > Uninverting postings: ", num_terms};
+
+        auto task = [&](uint64_t ram_budget)
+        {
+            auto producer = handler.make_producer(ram_budget);
+            while (true)
+            {
+                auto first = next_term.fetch_add(block_size);
+                if (first >= num_terms)
+                    return; // destructor for producer will write any
+                            // intermediate chunks
+
+                auto last = std::min(first + block_size, num_terms);
+                for (term_id t_id{first}; t_id < last; ++t_id)
+                {
+                    auto pdata = inv_idx.search_primary(t_id);
+                    producer(pdata->primary_key(), pdata->counts());
+                }
+                progress(num_done += last - first);
+            }
+        };
+
+        parallel::thread_pool pool{num_threads};
+        std::vector<std::future<void>> futures;
+        futures.reserve(num_threads);
+        for (unsigned i = 0; i < num_threads; ++i)
         {
-            auto pdata = inv_idx.search_primary(t_id);
-            producer(pdata->primary_key(), pdata->counts());
+            futures.emplace_back(
+                pool.submit_task(std::bind(task, ram_budget / num_threads)));
         }
+
+        for (auto& fut : futures)
+            fut.get();
+
+        progress.end();
     }
 
     handler.merge_chunks();
@@ -649,5 +1091,21 @@ void forward_index::impl::load_postings()
 {
     postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
 }
+
+auto forward_index::impl::postings() const -> const postings_file_type &
+{
+    auto open = [&]()
+    {
+        postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+        idx_->impl_->prepare(*postings_);
+    };
+
+    std::call_once(postings_flag_, [&]()
+                   {
+                       if (!postings_)
+                           disk_index_impl::timed_load("postings", open);
+                   });
+    return *postings_;
+}
 }
 }
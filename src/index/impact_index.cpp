@@ -0,0 +1,259 @@
+/**
+ * @file impact_index.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+
+#include "cpptoml.h"
+#include "meta/index/impact_index.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/postings_stream.h"
+#include "meta/io/filesystem.h"
+#include "meta/logging/logger.h"
+#include "meta/util/printing.h"
+#include "meta/util/progress.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Output stream that appends to a buffer, used to measure the encoded
+ * size of a segment before it is written.
+ */
+struct buffer_output_stream
+{
+    void put(char c)
+    {
+        buffer_.push_back(c);
+    }
+
+    std::vector<char> buffer_;
+};
+
+struct char_input_stream
+{
+    char get()
+    {
+        return *input_++;
+    }
+
+    const char* input_;
+};
+
+const char* impacts_file = "/impacts.index";
+}
+
+impact_index::impact_index(const inverted_index& idx)
+    : file_{idx.index_name() + impacts_file},
+      byte_locations_{idx.index_name() + impacts_file + "_index"}
+{
+    char_input_stream stream{file_.begin()};
+
+    std::string method;
+    io::packed::read(stream, method);
+    io::packed::read(stream, quantum_);
+    io::packed::read(stream, mu_);
+}
+
+void impact_index::create(const inverted_index& idx,
+                          const cpptoml::table& config)
+{
+    auto method = config.get_as<std::string>("method").value_or("bm25");
+    auto bits = config.get_as<int64_t>("bits").value_or(8);
+    if (bits < 1 || bits > 16)
+        throw impact_index_exception{"impact bits must be on [1,16]"};
+
+    auto k1 = config.get_as<double>("k1").value_or(1.2);
+    auto b = config.get_as<double>("b").value_or(0.75);
+    auto mu = config.get_as<double>("mu").value_or(2000.0);
+
+    auto num_docs = idx.num_docs();
+    auto avg_dl = static_cast<double>(idx.avg_doc_length());
+    auto total_terms = static_cast<double>(idx.total_corpus_terms());
+
+    std::vector<uint64_t> doc_sizes(num_docs);
+    for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        doc_sizes[d_id] = idx.doc_size(d_id);
+
+    std::function<double(const postings_stream<doc_id>&, doc_id, uint64_t)>
+        score;
+    if (method == "bm25")
+    {
+        mu = 0;
+        score = [&](const postings_stream<doc_id>& stream, doc_id d_id,
+                    uint64_t count)
+        {
+            auto df = static_cast<double>(stream.size());
+            auto idf = std::log(1.0 + (num_docs - df + 0.5) / (df + 0.5));
+            auto tf = ((k1 + 1.0) * count)
+                      / (k1 * ((1.0 - b) + b * doc_sizes[d_id] / avg_dl)
+                         + count);
+            return tf * idf;
+        };
+    }
+    else if (method == "dirichlet-prior")
+    {
+        // this is the only part of the Dirichlet prior score that depends
+        // on the term; the document-length part is added at query time
+        score = [&](const postings_stream<doc_id>& stream, doc_id,
+                    uint64_t count)
+        {
+            auto pc = stream.total_counts() / total_terms;
+            return std::log(1.0 + count / (mu * pc));
+        };
+    }
+    else
+    {
+        throw impact_index_exception{"unknown impact method: " + method};
+    }
+
+    auto num_terms = idx.unique_terms();
+
+    // first pass: find the largest score so that the impacts can use the
+    // full range of the quantization
+    double max_score = 0;
+    {
+        printing::progress progress{" > Computing impact range: ", num_terms};
+        for (term_id t_id{0}; t_id < num_terms; ++t_id)
+        {
+            progress(t_id);
+            auto stream = idx.stream_for(t_id);
+            if (!stream)
+                continue;
+            for (const auto& count : *stream)
+                max_score = std::max(
+                    max_score, score(*stream, count.first, count.second));
+        }
+    }
+
+    auto levels = static_cast<double>((uint64_t{1} << bits) - 1);
+    auto quantum = max_score > 0 ? max_score / levels : 1.0;
+
+    // second pass: quantize and write each term's segments
+    auto filename = idx.index_name() + impacts_file;
+    {
+        std::ofstream out{filename, std::ios::binary};
+        util::disk_vector<uint64_t> byte_locations{filename + "_index",
+                                                   num_terms};
+
+        uint64_t bytes = io::packed::write(out, method);
+        bytes += io::packed::write(out, quantum);
+        bytes += io::packed::write(out, mu);
+
+        printing::progress progress{" > Writing impacts: ", num_terms};
+        std::vector<std::pair<uint64_t, doc_id>> postings;
+        buffer_output_stream gaps;
+        for (term_id t_id{0}; t_id < num_terms; ++t_id)
+        {
+            progress(t_id);
+            byte_locations[t_id] = bytes;
+
+            postings.clear();
+            if (auto stream = idx.stream_for(t_id))
+            {
+                for (const auto& count : *stream)
+                {
+                    auto impact = std::llround(
+                        score(*stream, count.first, count.second) / quantum);
+                    impact = std::max(impact, 1ll);
+                    impact = std::min(impact, static_cast<long long>(levels));
+                    postings.emplace_back(static_cast<uint64_t>(impact),
+                                          count.first);
+                }
+            }
+
+            // decreasing impact, increasing document id
+            std::sort(postings.begin(), postings.end(),
+                      [](const std::pair<uint64_t, doc_id>& a,
+                         const std::pair<uint64_t, doc_id>& b)
+                      {
+                          if (a.first != b.first)
+                              return a.first > b.first;
+                          return a.second < b.second;
+                      });
+
+            uint64_t num_segments = 0;
+            for (uint64_t i = 0; i < postings.size(); ++i)
+            {
+                if (i == 0 || postings[i].first != postings[i - 1].first)
+                    ++num_segments;
+            }
+            bytes += io::packed::write(out, num_segments);
+
+            auto it = postings.begin();
+            while (it != postings.end())
+            {
+                auto impact = it->first;
+                auto last = std::find_if(
+                    it, postings.end(),
+                    [&](const std::pair<uint64_t, doc_id>& posting)
+                    {
+                        return posting.first != impact;
+                    });
+
+                gaps.buffer_.clear();
+                uint64_t prev = 0;
+                for (auto pit = it; pit != last; ++pit)
+                {
+                    uint64_t d_id{pit->second};
+                    io::packed::write(gaps, d_id - prev);
+                    prev = d_id;
+                }
+
+                bytes += io::packed::write(out, impact);
+                bytes += io::packed::write(
+                    out, static_cast<uint64_t>(std::distance(it, last)));
+                bytes += io::packed::write(
+                    out, static_cast<uint64_t>(gaps.buffer_.size()));
+                out.write(gaps.buffer_.data(),
+                          static_cast<std::streamsize>(gaps.buffer_.size()));
+                bytes += gaps.buffer_.size();
+
+                it = last;
+            }
+        }
+    }
+
+    LOG(info) << "Created impact index ("
+              << printing::bytes_to_units(filesystem::file_size(filename))
+              << ")" << ENDLG;
+}
+
+auto impact_index::segments(term_id t_id) const -> std::vector<segment>
+{
+    std::vector<segment> result;
+    if (t_id >= byte_locations_.size())
+        return result;
+
+    char_input_stream stream{file_.begin() + byte_locations_[t_id]};
+    auto num_segments = io::packed::read<uint64_t>(stream);
+    result.reserve(num_segments);
+    for (uint64_t i = 0; i < num_segments; ++i)
+    {
+        auto impact = io::packed::read<uint64_t>(stream);
+        auto size = io::packed::read<uint64_t>(stream);
+        auto bytes = io::packed::read<uint64_t>(stream);
+        result.emplace_back(impact, size, stream.input_);
+        stream.input_ += bytes;
+    }
+    return result;
+}
+
+double impact_index::quantum() const
+{
+    return quantum_;
+}
+
+double impact_index::mu() const
+{
+    return mu_;
+}
+}
+}
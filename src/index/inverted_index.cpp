@@ -9,11 +9,16 @@
 #include "meta/corpus/corpus_factory.h"
 #include "meta/corpus/metadata_parser.h"
 #include "meta/index/disk_index_impl.h"
+#include "meta/index/doc_reorder.h"
+#include "meta/index/impact_index.h"
 #include "meta/index/inverted_index.h"
+#include "meta/index/metadata_file.h"
 #include "meta/index/metadata_writer.h"
 #include "meta/index/postings_file.h"
 #include "meta/index/postings_file_writer.h"
 #include "meta/index/postings_inverter.h"
+#include "meta/index/signature_index.h"
+#include "meta/index/skip_index.h"
 #include "meta/index/vocabulary_map.h"
 #include "meta/index/vocabulary_map_writer.h"
 #include "meta/logging/logger.h"
@@ -23,6 +28,7 @@
 #include "meta/util/printing.h"
 #include "meta/util/progress.h"
 #include "meta/util/shim.h"
+#include "meta/util/time.h"
 
 namespace meta
 {
@@ -51,37 +57,94 @@ class inverted_index::impl
      * @param inverter The postings inverter for this index
      * @param mdata_parser The parser for reading metadata
      * @param mdata_writer The writer for metadata
+     * @param sig_writer The writer for document signatures, if they were
+     * requested
      * @param ram_budget The total **estimated** RAM budget
      * @param num_threads The number of threads to tokenize and index docs with
      * @return the number of chunks created
      */
     void tokenize_docs(corpus::corpus& docs,
                        postings_inverter<inverted_index>& inverter,
-                       metadata_writer& mdata_writer, uint64_t ram_budget,
+                       metadata_writer& mdata_writer,
+                       signature_writer* sig_writer, uint64_t ram_budget,
                        uint64_t num_threads);
 
+    /**
+     * Saves the collection statistics.
+     */
+    void save_stats() const;
+
+    /**
+     * Loads the collection statistics, computing them from the metadata
+     * if they were not saved when the index was created.
+     */
+    void load_stats();
+
+    /**
+     * Computes a new ordering for the documents if one was requested in
+     * the configuration and applies it to the labels and metadata. This
+     * must be called after the chunks have been merged and before the
+     * postings are compressed.
+     *
+     * @param config The configuration for the index
+     * @param num_threads The number of threads to use
+     * @return the new id for each document, or an empty vector if the
+     * documents are not being reordered
+     */
+    std::vector<doc_id> reorder_docs(const cpptoml::table& config,
+                                     unsigned num_threads);
+
     /**
      * Compresses the large postings file.
+     * @param filename The postings file to compress
+     * @param num_unique_terms The number of terms in the postings file
+     * @param new_ids The new id for each document (if the documents were
+     * reordered)
      */
-    void compress(const std::string& filename, uint64_t num_unique_terms);
+    void compress(const std::string& filename, uint64_t num_unique_terms,
+                  const std::vector<doc_id>& new_ids);
 
     /**
      * Loads the postings file.
      */
     void load_postings();
 
+    using postings_file_type
+        = postings_file<inverted_index::primary_key_type,
+                        inverted_index::secondary_key_type>;
+
+    /**
+     * @return the postings file, opening it if necessary
+     */
+    const postings_file_type& postings() const;
+
     /// The analyzer used to tokenize documents.
     std::unique_ptr<analyzers::analyzer> analyzer_;
 
-    util::optional<postings_file<inverted_index::primary_key_type,
-                                 inverted_index::secondary_key_type>> postings_;
+    /// The postings file (lazily opened if requested in the config)
+    mutable util::optional<postings_file_type> postings_;
+
+    /// guards lazily opening postings_
+    mutable std::once_flag postings_flag_;
+
+    /**
+     * @return the skip points for the postings, opening them if
+     * necessary, or nullptr if the index has none
+     */
+    const skip_index* skips() const;
+
+    /// collection-level statistics (number of docs, total terms)
+    collection_stats stats_;
 
-    /// the total number of term occurrences in the entire corpus
-    uint64_t total_corpus_terms_;
+    /// The skip points into the postings, if the index has them
+    mutable util::optional<skip_index> skips_;
+
+    /// guards lazily opening skips_
+    mutable std::once_flag skips_flag_;
 };
 
 inverted_index::impl::impl(inverted_index* idx, const cpptoml::table& config)
-    : idx_{idx}, analyzer_{analyzers::load(config)}, total_corpus_terms_{0}
+    : idx_{idx}, analyzer_{analyzers::load(config)}
 {
     // nothing
 }
@@ -142,6 +205,13 @@ void inverted_index::create_index(const cpptoml::table& config,
                      << max_threads << ENDLG;
     }
 
+    std::unique_ptr<signature_writer> sig_writer;
+    if (auto sig_cfg = config.get_table("signatures"))
+    {
+        sig_writer = make_unique<signature_writer>(
+            index_name(), docs.size(), make_signature_options(*sig_cfg));
+    }
+
     postings_inverter<inverted_index> inverter{index_name(), max_writers};
     {
         metadata_writer mdata_writer{index_name(), docs.size(), docs.schema()};
@@ -150,8 +220,11 @@ void inverted_index::create_index(const cpptoml::table& config,
 
         // RAM budget is given in megabytes
         inv_impl_->tokenize_docs(docs, inverter, mdata_writer,
-                                 ram_budget * 1024 * 1024, num_threads);
+                                 sig_writer.get(), ram_budget * 1024 * 1024,
+                                 num_threads);
+        inv_impl_->stats_.num_docs = num_docs;
     }
+    inv_impl_->save_stats();
 
     inverter.merge_chunks();
 
@@ -160,9 +233,14 @@ void inverted_index::create_index(const cpptoml::table& config,
               << printing::bytes_to_units(inverter.final_size()) << ")"
               << ENDLG;
 
+    auto new_ids = inv_impl_->reorder_docs(config, num_threads);
+    if (sig_writer && !new_ids.empty())
+        sig_writer->reorder(new_ids);
+    sig_writer = nullptr;
+
     uint64_t num_unique_terms = inverter.unique_primary_keys();
     inv_impl_->compress(index_name() + impl_->files[POSTINGS],
-                        num_unique_terms);
+                        num_unique_terms, new_ids);
 
     impl_->load_term_id_mapping();
     impl_->initialize_metadata();
@@ -172,6 +250,10 @@ void inverted_index::create_index(const cpptoml::table& config,
 
     impl_->save_label_id_mapping();
     inv_impl_->load_postings();
+    skip_index::create(*this);
+
+    if (auto impact_cfg = config.get_table("impact-index"))
+        impact_index::create(*this, *impact_cfg);
 
     LOG(info) << "Done creating index: " << index_name() << ENDLG;
 }
@@ -180,16 +262,31 @@ void inverted_index::load_index()
 {
     LOG(info) << "Loading index from disk: " << index_name() << ENDLG;
 
-    impl_->initialize_metadata();
-    impl_->load_term_id_mapping();
-    impl_->load_label_id_mapping();
-    impl_->load_labels();
-    inv_impl_->load_postings();
+    inv_impl_->load_stats();
+
+    if (impl_->options().lazy)
+    {
+        LOG(info) << "Index components will be loaded on first use" << ENDLG;
+        return;
+    }
+
+    auto time = common::time([&]()
+                             {
+                                 impl_->metadata();
+                                 impl_->term_id_mapping();
+                                 impl_->label_ids();
+                                 impl_->labels();
+                                 inv_impl_->postings();
+                             });
+
+    LOG(info) << "Done loading index: " << index_name() << " ("
+              << time.count() << "ms)" << ENDLG;
 }
 
 void inverted_index::impl::tokenize_docs(
     corpus::corpus& docs, postings_inverter<inverted_index>& inverter,
-    metadata_writer& mdata_writer, uint64_t ram_budget, uint64_t num_threads)
+    metadata_writer& mdata_writer, signature_writer* sig_writer,
+    uint64_t ram_budget, uint64_t num_threads)
 {
     std::mutex mutex;
     printing::progress progress{" > Tokenizing Docs: ", docs.size()};
@@ -198,6 +295,9 @@ void inverted_index::impl::tokenize_docs(
     {
         auto producer = inverter.make_producer(ram_budget);
         auto analyzer = analyzer_->clone();
+        // one map is reused for every document this thread analyzes
+        analyzers::feature_map<uint64_t> counts;
+        uint64_t total_terms = 0;
         while (true)
         {
             util::optional<corpus::document> doc;
@@ -205,13 +305,17 @@ void inverted_index::impl::tokenize_docs(
                 std::lock_guard<std::mutex> lock{mutex};
 
                 if (!docs.has_next())
+                {
+                    stats_.total_terms += total_terms;
                     return; // destructor for producer will write
                             // any intermediate chunks
+                }
                 doc = docs.next();
                 progress(doc->id());
             }
 
-            auto counts = analyzer->analyze<uint64_t>(*doc);
+            counts.reset();
+            analyzer->analyze(*doc, counts);
 
             // warn if there is an empty document
             if (counts.empty())
@@ -230,7 +334,10 @@ void inverted_index::impl::tokenize_docs(
                 });
 
             mdata_writer.write(doc->id(), length, counts.size(), doc->mdata());
+            if (sig_writer)
+                sig_writer->write(doc->id(), counts);
             idx_->impl_->set_label(doc->id(), doc->label());
+            total_terms += length;
 
             // update chunk
             producer(doc->id(), counts);
@@ -249,8 +356,81 @@ void inverted_index::impl::tokenize_docs(
         fut.get();
 }
 
+std::vector<doc_id>
+inverted_index::impl::reorder_docs(const cpptoml::table& config,
+                                   unsigned num_threads)
+{
+    auto reorder_cfg = config.get_table("reorder");
+    if (!reorder_cfg)
+        return {};
+
+    auto method = reorder_cfg->get_as<std::string>("method");
+    if (!method)
+        throw inverted_index_exception{"reorder method must be specified"};
+
+    auto prefix = idx_->index_name();
+    auto num_docs = stats_.num_docs;
+
+    auto make_order = [&]() -> std::vector<doc_id>
+    {
+        if (*method == "graph-bisection")
+        {
+            reorder::bisection_options options;
+            options.iterations = static_cast<uint64_t>(
+                reorder_cfg->get_as<int64_t>("iterations").value_or(20));
+            options.min_partition_size = static_cast<uint64_t>(
+                reorder_cfg->get_as<int64_t>("min-partition-size")
+                    .value_or(16));
+            options.num_threads = num_threads;
+
+            auto graph = reorder::make_forward_graph(
+                prefix + idx_->impl_->files[POSTINGS], num_docs);
+            return reorder::graph_bisection(graph, options);
+        }
+        else if (*method == "metadata")
+        {
+            auto field = reorder_cfg->get_as<std::string>("field");
+            if (!field)
+                throw inverted_index_exception{
+                    "reorder field must be specified to reorder by metadata"};
+
+            metadata_file mdata{prefix};
+            return reorder::by_metadata(mdata, *field);
+        }
+
+        throw inverted_index_exception{"unknown reorder method: " + *method};
+    };
+
+    std::vector<doc_id> order;
+    auto time = common::time([&]() { order = make_order(); });
+
+    LOG(info) << "Reordered documents (" << time.count() << "ms)" << ENDLG;
+
+    // the metadata database is addressed through its index, so only the
+    // seek positions need to be moved
+    {
+        util::disk_vector<label_id> labels{prefix
+                                           + idx_->impl_->files[DOC_LABELS]};
+        reorder::permute(labels, order);
+
+        util::disk_vector<uint64_t> mdata_index{
+            prefix + idx_->impl_->files[METADATA_INDEX]};
+        reorder::permute(mdata_index, order);
+
+        util::disk_vector<doc_id> original_ids{prefix + "/docs.order",
+                                               num_docs};
+        std::copy(order.begin(), order.end(), original_ids.begin());
+    }
+
+    std::vector<doc_id> new_ids(num_docs);
+    for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        new_ids[order[d_id]] = d_id;
+    return new_ids;
+}
+
 void inverted_index::impl::compress(const std::string& filename,
-                                    uint64_t num_unique_terms)
+                                    uint64_t num_unique_terms,
+                                    const std::vector<doc_id>& new_ids)
 {
     std::string ucfilename{filename + ".uncompressed"};
     filesystem::rename_file(filename, ucfilename);
@@ -277,6 +457,15 @@ void inverted_index::impl::compress(const std::string& filename,
             byte_pos += bytes;
             progress(byte_pos);
             vocab.insert(pdata.primary_key());
+
+            if (!new_ids.empty())
+            {
+                auto counts = pdata.counts();
+                for (auto& count : counts)
+                    count.first = new_ids[count.first];
+                pdata.set_counts(std::move(counts));
+            }
+
             out.write(pdata);
         }
     }
@@ -288,42 +477,102 @@ void inverted_index::impl::compress(const std::string& filename,
     filesystem::delete_file(ucfilename);
 }
 
+void inverted_index::impl::save_stats() const
+{
+    std::ofstream stats_file{idx_->index_name() + "/corpus.stats",
+                             std::ios::binary};
+    io::packed::write(stats_file, stats_);
+}
+
+void inverted_index::impl::load_stats()
+{
+    std::ifstream stats_file{idx_->index_name() + "/corpus.stats",
+                             std::ios::binary};
+    if (stats_file)
+    {
+        io::packed::read(stats_file, stats_);
+        return;
+    }
+
+    // indexes created before statistics were persisted need a full pass
+    // over the document lengths
+    LOG(warning) << "No collection statistics found; computing them from "
+                    "document metadata"
+                 << ENDLG;
+    stats_ = collection_stats{};
+    stats_.num_docs = idx_->num_docs();
+    for (doc_id d_id{0}; d_id < stats_.num_docs; ++d_id)
+        stats_.total_terms += idx_->doc_size(d_id);
+}
+
 void inverted_index::impl::load_postings()
 {
     postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
 }
 
+auto inverted_index::impl::postings() const -> const postings_file_type &
+{
+    auto open = [&]()
+    {
+        postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+        idx_->impl_->prepare(*postings_);
+    };
+
+    std::call_once(postings_flag_, [&]()
+                   {
+                       if (!postings_)
+                           disk_index_impl::timed_load("postings", open);
+                   });
+    return *postings_;
+}
+
+const skip_index* inverted_index::impl::skips() const
+{
+    std::call_once(skips_flag_, [&]()
+                   {
+                       // indexes created before skip points were written
+                       // have to be decoded from the start
+                       if (skip_index::exists(*idx_))
+                           skips_ = skip_index{*idx_};
+                   });
+    return skips_ ? &*skips_ : nullptr;
+}
+
 uint64_t inverted_index::term_freq(term_id t_id, doc_id d_id) const
 {
     auto pdata = search_primary(t_id);
     return pdata->count(d_id);
 }
 
-uint64_t inverted_index::total_corpus_terms()
+uint64_t inverted_index::total_corpus_terms() const
 {
-    if (inv_impl_->total_corpus_terms_ == 0)
-    {
-        for (auto& id : docs())
-            inv_impl_->total_corpus_terms_ += doc_size(id);
-    }
-
-    return inv_impl_->total_corpus_terms_;
+    return inv_impl_->stats_.total_terms;
 }
 
 uint64_t inverted_index::total_num_occurences(term_id t_id) const
 {
-    auto pdata = search_primary(t_id);
+    return stats(t_id).corpus_count;
+}
 
-    double sum = 0;
-    for (auto& c : pdata->counts())
-        sum += c.second;
+float inverted_index::avg_doc_length() const
+{
+    return inv_impl_->stats_.avg_doc_length();
+}
 
-    return static_cast<uint64_t>(sum);
+const collection_stats& inverted_index::stats() const
+{
+    return inv_impl_->stats_;
 }
 
-float inverted_index::avg_doc_length()
+term_stats inverted_index::stats(term_id t_id) const
 {
-    return static_cast<float>(total_corpus_terms()) / num_docs();
+    term_stats ts;
+    if (auto stream = stream_for(t_id))
+    {
+        ts.doc_freq = stream->size();
+        ts.corpus_count = stream->total_counts();
+    }
+    return ts;
 }
 
 analyzers::feature_map<uint64_t>
@@ -332,21 +581,48 @@ inverted_index::tokenize(const corpus::document& doc)
     return inv_impl_->analyzer_->analyze<uint64_t>(doc);
 }
 
+std::unique_ptr<analyzers::analyzer> inverted_index::make_analyzer() const
+{
+    return inv_impl_->analyzer_->clone();
+}
+
 uint64_t inverted_index::doc_freq(term_id t_id) const
 {
-    return search_primary(t_id)->counts().size();
+    return stats(t_id).doc_freq;
 }
 
 auto inverted_index::search_primary(term_id t_id) const
     -> std::shared_ptr<postings_data_type>
 {
-    return inv_impl_->postings_->find(t_id);
+    return inv_impl_->postings().find(t_id);
 }
 
 util::optional<postings_stream<doc_id>>
 inverted_index::stream_for(term_id t_id) const
 {
-    return inv_impl_->postings_->find_stream(t_id);
+    return inv_impl_->postings().find_stream(t_id);
+}
+
+postings_stream<doc_id>::iterator
+    inverted_index::seek(const postings_stream<doc_id>& stream, term_id t_id,
+                         doc_id d_id) const
+{
+    if (auto skips = inv_impl_->skips())
+        return skips->seek(stream, t_id, d_id);
+
+    auto it = stream.begin();
+    auto end = stream.end();
+    while (it != end && it->first < d_id)
+        ++it;
+    return it;
+}
+
+std::vector<skip_index::skip_point>
+    inverted_index::skip_points(term_id t_id) const
+{
+    if (auto skips = inv_impl_->skips())
+        return skips->points(t_id);
+    return {};
 }
 }
 }
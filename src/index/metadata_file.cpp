@@ -70,5 +70,17 @@ uint64_t metadata_file::size() const
 {
     return index_.size();
 }
+
+void metadata_file::advise(io::mmap_advice advice) const
+{
+    index_.advise(advice);
+    md_db_.advise(advice);
+}
+
+void metadata_file::prefault(unsigned num_threads) const
+{
+    index_.prefault(num_threads);
+    md_db_.prefault(num_threads);
+}
 }
 }
@@ -0,0 +1,273 @@
+/**
+ * @file cascade_ranker.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "cpptoml.h"
+#include "meta/corpus/document.h"
+#include "meta/index/ranker/cascade_ranker.h"
+#include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/score_data.h"
+
+namespace meta
+{
+namespace index
+{
+
+ranking_features::ranking_features(inverted_index& idx, forward_index& fwd,
+                                   std::vector<std::unique_ptr<ranker>> rankers,
+                                   std::vector<std::string> priors /* = {} */)
+    : idx_(idx),
+      fwd_(fwd),
+      rankers_(std::move(rankers)),
+      priors_(std::move(priors)),
+      query_length_{0},
+      norms_(idx.num_docs(), 0.0)
+{
+    if (idx_.num_docs() == 0)
+        return;
+
+    // every document has the same schema, so the priors are checked once
+    auto mdata = idx_.metadata(doc_id{0});
+    for (const auto& name : priors_)
+        prior(mdata, name);
+}
+
+std::vector<learn::feature_vector>
+ranking_features::compute(const corpus::document& query,
+                          const std::vector<search_result>& candidates)
+{
+    auto counts = idx_.tokenize(query);
+    return compute(counts.begin(), counts.end(), candidates);
+}
+
+uint64_t ranking_features::size() const
+{
+    return 5 + rankers_.size() + priors_.size();
+}
+
+std::vector<std::string> ranking_features::names() const
+{
+    std::vector<std::string> result{"first-stage"};
+    for (uint64_t i = 0; i < rankers_.size(); ++i)
+        result.push_back("ranker-" + std::to_string(i + 1));
+    result.push_back("log-length");
+    result.push_back("log-unique-terms");
+    result.push_back("coverage");
+    result.push_back("cosine");
+    for (const auto& name : priors_)
+        result.push_back("prior-" + name);
+    return result;
+}
+
+std::vector<learn::feature_vector>
+ranking_features::compute(const std::vector<search_result>& candidates)
+{
+    auto num_terms = postings_.size();
+    std::vector<learn::feature_vector> results(candidates.size());
+    if (candidates.empty())
+        return results;
+
+    // the candidates are visited in doc_id order so that each postings
+    // list is read at most once, and only up to the last candidate
+    std::vector<uint64_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b)
+              {
+                  return candidates[a].d_id < candidates[b].d_id;
+              });
+
+    counts_.assign(candidates.size() * num_terms, 0);
+    for (uint64_t t = 0; t < num_terms; ++t)
+    {
+        auto& pc = postings_[t];
+        auto it = pc.begin;
+        for (const auto& i : order)
+        {
+            auto d_id = candidates[i].d_id;
+            while (it != pc.end && it->first < d_id)
+                ++it;
+            if (it == pc.end)
+                break;
+            if (it->first == d_id)
+                counts_[i * num_terms + t] = it->second;
+        }
+    }
+
+    double query_norm = 0;
+    for (const auto& pc : postings_)
+        query_norm += pc.query_term_weight * pc.query_term_weight;
+    query_norm = std::sqrt(query_norm);
+
+    score_data sd{idx_, idx_.avg_doc_length(), idx_.num_docs(),
+                  idx_.total_corpus_terms(), query_length_};
+    for (uint64_t i = 0; i < candidates.size(); ++i)
+    {
+        sd.d_id = candidates[i].d_id;
+        sd.doc_size = idx_.doc_size(sd.d_id);
+        sd.doc_unique_terms = idx_.unique_terms(sd.d_id);
+        const auto* counts = counts_.data() + i * num_terms;
+
+        auto& feats = results[i];
+        learn::feature_id f_id{0};
+        feats.emplace_back(f_id++, candidates[i].score);
+
+        for (auto& rnk : rankers_)
+        {
+            double score = rnk->initial_score(sd);
+            for (uint64_t t = 0; t < num_terms; ++t)
+            {
+                if (counts[t] == 0)
+                    continue;
+                const auto& pc = postings_[t];
+                sd.t_id = pc.t_id;
+                sd.query_term_weight = pc.query_term_weight;
+                sd.doc_count = pc.doc_count;
+                sd.corpus_term_count = pc.corpus_term_count;
+                sd.doc_term_count = counts[t];
+                score += rnk->score_one(sd);
+            }
+            feats.emplace_back(f_id++, score);
+        }
+
+        feats.emplace_back(f_id++, std::log(1.0 + sd.doc_size));
+        feats.emplace_back(f_id++, std::log(1.0 + sd.doc_unique_terms));
+
+        uint64_t matched = 0;
+        double dot = 0;
+        for (uint64_t t = 0; t < num_terms; ++t)
+        {
+            matched += counts[t] > 0;
+            dot += postings_[t].query_term_weight * counts[t];
+        }
+        feats.emplace_back(f_id++, num_terms == 0
+                                       ? 0.0
+                                       : static_cast<double>(matched)
+                                             / num_terms);
+
+        auto norm = doc_norm(sd.d_id) * query_norm;
+        feats.emplace_back(f_id++, norm > 0 ? dot / norm : 0.0);
+
+        if (!priors_.empty())
+        {
+            auto mdata = idx_.metadata(sd.d_id);
+            for (const auto& name : priors_)
+                feats.emplace_back(f_id++, prior(mdata, name));
+        }
+    }
+
+    return results;
+}
+
+double ranking_features::doc_norm(doc_id d_id)
+{
+    if (norms_[d_id] > 0)
+        return norms_[d_id];
+
+    auto stream = fwd_.stream_for(d_id);
+    if (!stream)
+        return 0;
+
+    double norm = 0;
+    for (const auto& count : *stream)
+        norm += count.second * count.second;
+    norms_[d_id] = std::sqrt(norm);
+    return norms_[d_id];
+}
+
+double ranking_features::prior(const corpus::metadata& mdata,
+                               const std::string& name) const
+{
+    using field_type = corpus::metadata::field_type;
+    for (const auto& field : mdata.schema())
+    {
+        if (field.name != name)
+            continue;
+
+        switch (field.type)
+        {
+            case field_type::SIGNED_INT:
+                return static_cast<double>(*mdata.get<int64_t>(name));
+
+            case field_type::UNSIGNED_INT:
+                return static_cast<double>(*mdata.get<uint64_t>(name));
+
+            case field_type::DOUBLE:
+                return *mdata.get<double>(name);
+
+            case field_type::STRING:
+                throw ranker_exception{"prior metadata field is not numeric: "
+                                       + name};
+        }
+    }
+    throw ranker_exception{"no metadata field for prior: " + name};
+}
+
+ranking_features make_ranking_features(inverted_index& idx,
+                                       forward_index& fwd,
+                                       const cpptoml::table& config)
+{
+    std::vector<std::unique_ptr<ranker>> rankers;
+    if (auto tables = config.get_table_array("rankers"))
+    {
+        for (const auto& table : tables->get())
+            rankers.push_back(make_ranker(*table));
+    }
+
+    std::vector<std::string> priors;
+    if (auto arr = config.get_array("priors"))
+    {
+        for (const auto& name : arr->array_of<std::string>())
+            priors.push_back(name->get());
+    }
+
+    return {idx, fwd, std::move(rankers), std::move(priors)};
+}
+
+cascade_ranker::cascade_ranker(inverted_index& idx, ranker& first_stage,
+                               ranking_features& features,
+                               const learn::sgd_model& model,
+                               uint64_t num_candidates /* = 100 */)
+    : idx_(idx),
+      first_stage_(first_stage),
+      features_(features),
+      model_(model),
+      num_candidates_{num_candidates}
+{
+    // nothing
+}
+
+std::vector<search_result>
+cascade_ranker::score(const corpus::document& query,
+                      uint64_t num_results /* = 10 */,
+                      const filter_function_type& filter /* = passthrough */)
+{
+    auto counts = idx_.tokenize(query);
+    return score(counts.begin(), counts.end(), num_results, filter);
+}
+
+std::vector<search_result>
+cascade_ranker::rerank(std::vector<search_result> candidates,
+                       const std::vector<learn::feature_vector>& features,
+                       uint64_t num_results) const
+{
+    for (uint64_t i = 0; i < candidates.size(); ++i)
+        candidates[i].score = static_cast<float>(model_.predict(features[i]));
+
+    // ties keep their first-stage order
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const search_result& a, const search_result& b)
+                     {
+                         return a.score > b.score;
+                     });
+    if (candidates.size() > num_results)
+        candidates.erase(candidates.begin()
+                             + static_cast<std::ptrdiff_t>(num_results),
+                         candidates.end());
+    return candidates;
+}
+}
+}
@@ -0,0 +1,172 @@
+/**
+ * @file feedback_ranker.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "cpptoml.h"
+#include "meta/corpus/document.h"
+#include "meta/index/ranker/feedback_ranker.h"
+
+namespace meta
+{
+namespace index
+{
+
+feedback_options make_feedback_options(const cpptoml::table& config)
+{
+    feedback_options options;
+
+    auto method = config.get_as<std::string>("method").value_or("rocchio");
+    if (method == "rm3")
+    {
+        options.method = feedback_options::method_type::rm3;
+        options.alpha = 0.5f;
+    }
+    else if (method != "rocchio")
+    {
+        throw ranker_exception{"unknown feedback method: " + method};
+    }
+
+    options.feedback_docs = static_cast<uint64_t>(
+        config.get_as<int64_t>("docs").value_or(
+            static_cast<int64_t>(options.feedback_docs)));
+    options.feedback_terms = static_cast<uint64_t>(
+        config.get_as<int64_t>("terms").value_or(
+            static_cast<int64_t>(options.feedback_terms)));
+    options.alpha = static_cast<float>(
+        config.get_as<double>("alpha").value_or(options.alpha));
+    options.beta = static_cast<float>(
+        config.get_as<double>("beta").value_or(options.beta));
+    return options;
+}
+
+feedback_ranker::feedback_ranker(inverted_index& idx, forward_index& fwd,
+                                 ranker& base,
+                                 feedback_options options /* = {} */)
+    : idx_(idx),
+      fwd_(fwd),
+      base_(base),
+      options_(options),
+      weights_(idx.unique_terms(), 0.0f)
+{
+    // the forward index may have its own vocabulary, so its term ids are
+    // translated once here rather than for every feedback document
+    term_ids_.reserve(fwd_.unique_terms());
+    for (term_id t_id{0}; t_id < fwd_.unique_terms(); ++t_id)
+        term_ids_.push_back(idx_.get_term_id(fwd_.term_text(t_id)));
+}
+
+std::vector<search_result>
+feedback_ranker::score(const corpus::document& query,
+                       uint64_t num_results /* = 10 */,
+                       const filter_function_type& filter /* = passthrough */)
+{
+    auto counts = idx_.tokenize(query);
+    return score(counts.begin(), counts.end(), num_results, filter);
+}
+
+void feedback_ranker::add_document(doc_id d_id, float weight)
+{
+    auto stream = fwd_.stream_for(d_id);
+    if (!stream || stream->total_counts() <= 0)
+        return;
+
+    auto length = static_cast<float>(stream->total_counts());
+    for (const auto& count : *stream)
+    {
+        if (count.first >= term_ids_.size())
+            continue;
+
+        auto t_id = term_ids_[count.first];
+        if (t_id >= weights_.size())
+            continue;
+
+        if (weights_[t_id] == 0)
+            touched_.push_back(t_id);
+        weights_[t_id] += weight * static_cast<float>(count.second) / length;
+    }
+}
+
+std::vector<search_result>
+feedback_ranker::rank(uint64_t num_results, const filter_function_type& filter)
+{
+    float query_length = 0;
+    for (const auto& term : query_)
+        query_length += term.second;
+
+    if (query_length <= 0 || options_.feedback_docs == 0
+        || options_.feedback_terms == 0)
+        return base_.score(idx_, query_.begin(), query_.end(), num_results,
+                           filter);
+
+    auto feedback = base_.score(idx_, query_.begin(), query_.end(),
+                                options_.feedback_docs, filter);
+    if (feedback.empty())
+        return feedback;
+
+    // rocchio weights every feedback document equally; rm3 weights them
+    // by their (normalized) query likelihood, exp(score)
+    auto max_score = feedback.front().score;
+    float total = 0;
+    for (auto& result : feedback)
+    {
+        if (options_.method == feedback_options::method_type::rm3)
+            result.score = std::exp(result.score - max_score);
+        else
+            result.score = 1.0f;
+        total += result.score;
+    }
+
+    for (const auto& result : feedback)
+        add_document(result.d_id, result.score / total);
+
+    // keep only the heaviest terms of the feedback model
+    auto heavier = [&](term_id a, term_id b)
+    {
+        return weights_[a] > weights_[b];
+    };
+    if (touched_.size() > options_.feedback_terms)
+    {
+        auto nth = touched_.begin()
+                   + static_cast<std::ptrdiff_t>(options_.feedback_terms);
+        std::nth_element(touched_.begin(), nth, touched_.end(), heavier);
+        for (auto it = nth; it != touched_.end(); ++it)
+            weights_[*it] = 0;
+        touched_.erase(nth, touched_.end());
+    }
+
+    float model_total = 0;
+    for (const auto& t_id : touched_)
+        model_total += weights_[t_id];
+    for (const auto& t_id : touched_)
+        weights_[t_id] = options_.beta * weights_[t_id] / model_total;
+
+    for (const auto& term : query_)
+    {
+        if (weights_[term.first] == 0)
+            touched_.push_back(term.first);
+        weights_[term.first] += options_.alpha * term.second / query_length;
+    }
+
+    query_.clear();
+    for (const auto& t_id : touched_)
+    {
+        if (weights_[t_id] > 0)
+            query_.emplace_back(t_id, weights_[t_id] * query_length);
+        weights_[t_id] = 0;
+    }
+    touched_.clear();
+
+    return base_.score(idx_, query_.begin(), query_.end(), num_results,
+                       filter);
+}
+
+const std::vector<std::pair<term_id, float>>&
+feedback_ranker::expanded_query() const
+{
+    return query_;
+}
+}
+}
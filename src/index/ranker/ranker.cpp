@@ -4,12 +4,18 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <sstream>
 #include <unordered_map>
+#include "meta/analyzers/filters/stages.h"
 #include "meta/corpus/document.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/postings_data.h"
 #include "meta/index/ranker/ranker.h"
 #include "meta/index/score_data.h"
+#include "meta/parallel/thread_pool.h"
 #include "meta/util/fixed_heap.h"
 
 namespace meta
@@ -26,12 +32,204 @@ std::vector<search_result>
     return score(idx, counts.begin(), counts.end(), num_results, filter);
 }
 
-std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
-                                        uint64_t num_results,
-                                        const filter_function_type& filter)
+std::vector<search_result> ranker::score_parallel(
+    inverted_index& idx, const corpus::document& query,
+    parallel::thread_pool& pool, uint64_t num_results /* = 10 */,
+    const filter_function_type& filter /* = passthrough */)
 {
-    score_data sd{ctx.idx, ctx.idx.avg_doc_length(), ctx.idx.num_docs(),
-                  ctx.idx.total_corpus_terms(), ctx.query_length};
+    auto counts = idx.tokenize(query);
+    return score_parallel(idx, counts.begin(), counts.end(), pool,
+                          num_results, filter);
+}
+
+namespace
+{
+/**
+ * A position in the postings list of a term of a boolean_query.
+ */
+struct boolean_cursor
+{
+    using iterator = postings_stream<doc_id>::iterator;
+    using skip_point = skip_index::skip_point;
+
+    boolean_cursor(const inverted_index& idx, postings_stream<doc_id> strm,
+                   float weight, term_id term)
+        : stream{strm},
+          begin{stream.begin()},
+          end{stream.end()},
+          skips{idx.skip_points(term)},
+          t_id{term},
+          query_term_weight{weight}
+    {
+        // nothing
+    }
+
+    /**
+     * Moves to the first posting with a document id of at least d_id.
+     * The skip points ahead of the cursor are searched by galloping, so
+     * a long list is resumed from the last block before d_id, and only
+     * that block is decoded.
+     *
+     * @return whether there is such a posting
+     */
+    bool advance_to(doc_id d_id)
+    {
+        if (begin == end || begin->first >= d_id)
+            return begin != end;
+
+        // find the last skip point before d_id: double the step until it
+        // passes d_id, then binary search the last step
+        auto before = [](const skip_point& sp, doc_id id)
+        {
+            return sp.key < id;
+        };
+        uint64_t step = 1;
+        while (next_skip + step <= skips.size()
+               && skips[next_skip + step - 1].key < d_id)
+            step *= 2;
+        auto first = next_skip + step / 2;
+        auto last = std::min<uint64_t>(next_skip + step, skips.size());
+        auto skip = std::lower_bound(skips.begin() + first,
+                                     skips.begin() + last, d_id, before);
+        next_skip = static_cast<uint64_t>(skip - skips.begin());
+
+        // only skips at or past the current posting move the cursor ahead
+        if (skip != skips.begin() && (skip - 1)->key >= begin->first)
+        {
+            auto& sp = *(skip - 1);
+            begin = stream.seek(sp.offset, sp.position, sp.key);
+        }
+
+        while (begin != end && begin->first < d_id)
+            ++begin;
+        return begin != end;
+    }
+
+    postings_stream<doc_id> stream;
+    iterator begin;
+    iterator end;
+    /// The term's skip points, empty for short lists
+    std::vector<skip_point> skips;
+    /// The first skip point that may still be ahead of the cursor
+    uint64_t next_skip = 0;
+    term_id t_id;
+    float query_term_weight;
+};
+
+/**
+ * Finds the next document contained in every list, starting from the
+ * current position of the first (rarest) list. Each list only moves
+ * forward to the current candidate, and the candidate jumps ahead
+ * whenever a list has no posting for it.
+ *
+ * @param cursors The required terms' cursors, sorted by increasing size
+ * @param d_id Set to the matching document
+ * @return whether a matching document was found
+ */
+bool next_match(std::vector<boolean_cursor>& cursors, doc_id& d_id)
+{
+    if (cursors[0].begin == cursors[0].end)
+        return false;
+
+    d_id = cursors[0].begin->first;
+    uint64_t matched = 1;
+    for (uint64_t i = 1 % cursors.size(); matched < cursors.size();
+         i = (i + 1) % cursors.size())
+    {
+        auto& cursor = cursors[i];
+        if (!cursor.advance_to(d_id))
+            return false;
+
+        if (cursor.begin->first == d_id)
+        {
+            ++matched;
+        }
+        else
+        {
+            d_id = cursor.begin->first;
+            matched = 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * Finds the smallest document in any of the optional terms' lists.
+ * @return whether there is such a document
+ */
+bool next_any(std::vector<boolean_cursor>& cursors, doc_id& d_id)
+{
+    bool found = false;
+    for (auto& cursor : cursors)
+    {
+        if (cursor.begin == cursor.end)
+            continue;
+        if (!found || cursor.begin->first < d_id)
+            d_id = cursor.begin->first;
+        found = true;
+    }
+    return found;
+}
+}
+
+std::vector<search_result>
+    ranker::score_conjunctive(inverted_index& idx,
+                              const corpus::document& query,
+                              uint64_t num_results /* = 10 */,
+                              const filter_function_type& filter
+                              /* = passthrough */)
+{
+    auto counts = idx.tokenize(query);
+    return score_conjunctive(idx, counts.begin(), counts.end(), num_results,
+                             filter);
+}
+
+std::vector<search_result>
+    ranker::score(inverted_index& idx, const boolean_query& query,
+                  uint64_t num_results /* = 10 */,
+                  const filter_function_type& filter /* = passthrough */)
+{
+    float query_length = 0;
+    auto open = [&](const boolean_query::term_list& terms,
+                    std::vector<boolean_cursor>& cursors)
+    {
+        bool all_found = true;
+        for (const auto& term : terms)
+        {
+            query_length += term.second;
+            auto t_id = idx.get_term_id(term.first);
+            auto pstream = idx.stream_for(t_id);
+            if (pstream && pstream->size() > 0)
+                cursors.emplace_back(idx, *pstream, term.second, t_id);
+            else
+                all_found = false;
+        }
+        return all_found;
+    };
+
+    std::vector<boolean_cursor> must;
+    std::vector<boolean_cursor> should;
+    std::vector<boolean_cursor> must_not;
+
+    // a required term that appears nowhere means that nothing matches
+    if (!open(query.must, must))
+        return {};
+    open(query.should, should);
+    for (const auto& term : query.must_not)
+    {
+        auto t_id = idx.get_term_id(term);
+        if (auto pstream = idx.stream_for(t_id))
+            must_not.emplace_back(idx, *pstream, 0, t_id);
+    }
+
+    std::sort(must.begin(), must.end(),
+              [](const boolean_cursor& a, const boolean_cursor& b)
+              {
+                  return a.stream.size() < b.stream.size();
+              });
+
+    score_data sd{idx, idx.avg_doc_length(), idx.num_docs(),
+                  idx.total_corpus_terms(), query_length};
 
     auto comp = [](const search_result& a, const search_result& b)
     {
@@ -40,20 +238,167 @@ std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
     };
     util::fixed_heap<search_result, decltype(comp)> results{num_results, comp};
 
-    doc_id next_doc{ctx.idx.num_docs()};
-    while (ctx.cur_doc < ctx.idx.num_docs())
+    auto add_term = [&](boolean_cursor& cursor, float& score)
+    {
+        sd.t_id = cursor.t_id;
+        sd.query_term_weight = cursor.query_term_weight;
+        sd.doc_count = cursor.stream.size();
+        sd.corpus_term_count = cursor.stream.total_counts();
+        sd.doc_term_count = cursor.begin->second;
+        score += score_one(sd);
+    };
+
+    doc_id d_id{0};
+    while (must.empty() ? next_any(should, d_id) : next_match(must, d_id))
+    {
+        bool excluded = std::any_of(must_not.begin(), must_not.end(),
+                                    [&](boolean_cursor& cursor)
+                                    {
+                                        return cursor.advance_to(d_id)
+                                               && cursor.begin->first == d_id;
+                                    });
+
+        if (!excluded && filter(d_id))
+        {
+            sd.d_id = d_id;
+            sd.doc_size = idx.doc_size(d_id);
+            sd.doc_unique_terms = idx.unique_terms(d_id);
+
+            auto score = initial_score(sd);
+            for (auto& cursor : must)
+                add_term(cursor, score);
+            for (auto& cursor : should)
+            {
+                if (cursor.advance_to(d_id) && cursor.begin->first == d_id)
+                    add_term(cursor, score);
+            }
+            results.emplace(d_id, score);
+        }
+
+        if (must.empty())
+        {
+            for (auto& cursor : should)
+            {
+                if (cursor.begin != cursor.end && cursor.begin->first == d_id)
+                    ++cursor.begin;
+            }
+        }
+        else
+        {
+            ++must[0].begin;
+        }
+    }
+
+    return results.extract_top();
+}
+
+boolean_query make_boolean_query(inverted_index& idx, const std::string& text)
+{
+    // the words of each clause are analyzed together, so that analyzers
+    // that combine words (like ngram analyzers) see them in order
+    std::string must;
+    std::string should;
+    std::string must_not;
+    std::istringstream words{text};
+    std::string word;
+    while (words >> word)
+    {
+        auto op = word.size() > 1 ? word[0] : ' ';
+        if (op == '+')
+            must += ' ' + word.substr(1);
+        else if (op == '-')
+            must_not += ' ' + word.substr(1);
+        else
+            should += ' ' + word;
+    }
+
+    auto analyze = [&](const std::string& clause,
+                       boolean_query::term_list& terms)
+    {
+        corpus::document doc;
+        doc.content(clause);
+        for (const auto& count : idx.tokenize(doc))
+        {
+            // the clause's sentence boundary tags say nothing about the
+            // query, and would otherwise be required or excluded with it
+            if (!analyzers::filters::stages::has_sentence_tag(count.key()))
+                terms.emplace_back(count.key(), count.value());
+        }
+    };
+
+    boolean_query query;
+    analyze(must, query.must);
+    analyze(should, query.should);
+
+    boolean_query::term_list excluded;
+    analyze(must_not, excluded);
+    for (const auto& term : excluded)
+        query.must_not.push_back(term.first);
+    return query;
+}
+
+std::vector<search_result>
+    ranker::score(inverted_index& idx, const corpus::document& query,
+                  uint64_t num_results, const doc_filter& filter)
+{
+    auto counts = idx.tokenize(query);
+    return score(idx, counts.begin(), counts.end(), num_results, filter);
+}
+
+namespace
+{
+/**
+ * Orders search results by decreasing score.
+ */
+struct result_comparator
+{
+    bool operator()(const search_result& a, const search_result& b) const
+    {
+        // comparison is reversed since we want a min-heap
+        return a.score > b.score;
+    }
+};
+
+using result_heap = util::fixed_heap<search_result, result_comparator>;
+
+/**
+ * Raises a shared threshold to at least the given score.
+ */
+void raise_threshold(std::atomic<float>& threshold, float score)
+{
+    auto current = threshold.load(std::memory_order_relaxed);
+    while (current < score
+           && !threshold.compare_exchange_weak(current, score,
+                                               std::memory_order_relaxed))
+    {
+        // current was reloaded; try again
+    }
+}
+}
+
+template <class Filter, class Heap>
+void ranker::rank_range(detail::ranker_context& ctx,
+                        std::vector<detail::postings_context>& postings,
+                        doc_id cur_doc, doc_id last, const Filter& filter,
+                        Heap& results, std::atomic<float>* threshold)
+{
+    score_data sd{ctx.idx, ctx.idx.avg_doc_length(), ctx.idx.num_docs(),
+                  ctx.idx.total_corpus_terms(), ctx.query_length};
+
+    doc_id next_doc{last};
+    while (cur_doc < last)
     {
-        sd.d_id = ctx.cur_doc;
-        sd.doc_size = ctx.idx.doc_size(ctx.cur_doc);
-        sd.doc_unique_terms = ctx.idx.unique_terms(ctx.cur_doc);
+        sd.d_id = cur_doc;
+        sd.doc_size = ctx.idx.doc_size(cur_doc);
+        sd.doc_unique_terms = ctx.idx.unique_terms(cur_doc);
 
         auto score = initial_score(sd);
-        for (auto& pc : ctx.postings)
+        for (auto& pc : postings)
         {
             if (pc.begin == pc.end)
                 continue;
 
-            if (pc.begin->first == ctx.cur_doc)
+            if (pc.begin->first == cur_doc)
             {
                 // set up this term
                 sd.t_id = pc.t_id;
@@ -69,7 +414,8 @@ std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
                 do
                 {
                     ++pc.begin;
-                } while (pc.begin != pc.end && !filter(pc.begin->first));
+                } while (pc.begin != pc.end && pc.begin->first < last
+                         && !filter(pc.begin->first));
             }
 
             if (pc.begin != pc.end)
@@ -81,14 +427,122 @@ std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
             }
         }
 
-        results.emplace(ctx.cur_doc, score);
-        ctx.cur_doc = next_doc;
-        next_doc = doc_id{ctx.idx.num_docs()};
+        if (!threshold)
+        {
+            results.emplace(cur_doc, score);
+        }
+        else if (score >= threshold->load(std::memory_order_relaxed))
+        {
+            results.emplace(cur_doc, score);
+            if (results.size() == results.max_elems() && results.size() > 0)
+                raise_threshold(*threshold, results.min().score);
+        }
+
+        cur_doc = next_doc;
+        next_doc = last;
     }
+}
 
+template <class Filter>
+std::vector<search_result>
+    ranker::rank_postings(detail::ranker_context& ctx, uint64_t num_results,
+                          const Filter& filter)
+{
+    result_heap results{num_results, result_comparator{}};
+    rank_range(ctx, ctx.postings, ctx.cur_doc, doc_id{ctx.idx.num_docs()},
+               filter, results, nullptr);
     return results.extract_top();
 }
 
+template <class Filter>
+std::vector<search_result>
+    ranker::rank_parallel(detail::ranker_context& ctx, uint64_t num_results,
+                          const Filter& filter, parallel::thread_pool& pool)
+{
+    auto num_docs = ctx.idx.num_docs();
+    auto num_ranges = std::min<uint64_t>(pool.size(), num_docs);
+    if (num_ranges <= 1 || num_results == 0)
+        return rank_postings(ctx, num_results, filter);
+
+    std::vector<doc_id> bounds;
+    for (uint64_t r = 0; r <= num_ranges; ++r)
+        bounds.push_back(doc_id{r * num_docs / num_ranges});
+
+    std::atomic<float> threshold{std::numeric_limits<float>::lowest()};
+    auto rank_slice = [&](uint64_t r)
+    {
+        auto last = bounds[r + 1];
+
+        // each range works on its own copy of the postings contexts,
+        // which seek to the start of the range with the index's skip
+        // points rather than decoding the lists up to it
+        auto postings = ctx.postings;
+        doc_id cur_doc{last};
+        for (auto& pc : postings)
+        {
+            pc.begin = ctx.idx.seek(pc.stream, pc.t_id, bounds[r]);
+            while (pc.begin != pc.end && pc.begin->first < last
+                   && !filter(pc.begin->first))
+                ++pc.begin;
+            if (pc.begin != pc.end && pc.begin->first < cur_doc)
+                cur_doc = pc.begin->first;
+        }
+
+        result_heap results{num_results, result_comparator{}};
+        rank_range(ctx, postings, cur_doc, last, filter, results,
+                   &threshold);
+        return results.extract_top();
+    };
+
+    std::vector<std::future<std::vector<search_result>>> futures;
+    for (uint64_t r = 0; r < num_ranges; ++r)
+        futures.emplace_back(pool.submit_task(std::bind(rank_slice, r)));
+
+    std::vector<search_result> results;
+    for (auto& fut : futures)
+    {
+        auto top = fut.get();
+        results.insert(results.end(), top.begin(), top.end());
+    }
+
+    std::sort(results.begin(), results.end(), result_comparator{});
+    if (results.size() > num_results)
+        results.erase(results.begin() + static_cast<std::ptrdiff_t>(
+                                            num_results),
+                      results.end());
+    return results;
+}
+
+std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
+                                        uint64_t num_results,
+                                        const filter_function_type& filter)
+{
+    return rank_postings(ctx, num_results, filter);
+}
+
+std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
+                                        uint64_t num_results,
+                                        const doc_filter& filter)
+{
+    return rank_postings(ctx, num_results, filter);
+}
+
+std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
+                                        uint64_t num_results,
+                                        const filter_function_type& filter,
+                                        parallel::thread_pool& pool)
+{
+    return rank_parallel(ctx, num_results, filter, pool);
+}
+
+std::vector<search_result> ranker::rank(detail::ranker_context& ctx,
+                                        uint64_t num_results,
+                                        const doc_filter& filter,
+                                        parallel::thread_pool& pool)
+{
+    return rank_parallel(ctx, num_results, filter, pool);
+}
+
 float ranker::initial_score(const score_data&) const
 {
     return 0.0;
@@ -0,0 +1,138 @@
+/**
+ * @file saat_ranker.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "meta/corpus/document.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/ranker/saat_ranker.h"
+#include "meta/util/fixed_heap.h"
+
+namespace meta
+{
+namespace index
+{
+
+saat_ranker::saat_ranker(inverted_index& idx, const impact_index& impacts)
+    : idx_(idx),
+      impacts_(impacts),
+      accumulators_(idx.num_docs(), 0),
+      query_length_{0},
+      postings_processed_{0},
+      terminated_early_{false}
+{
+    // nothing
+}
+
+std::vector<search_result>
+saat_ranker::score(const corpus::document& query,
+                   uint64_t num_results /* = 10 */,
+                   const saat_budget& budget /* = {} */,
+                   const filter_function_type& filter /* = passthrough */)
+{
+    auto counts = idx_.tokenize(query);
+    return score(counts.begin(), counts.end(), num_results, budget, filter);
+}
+
+void saat_ranker::add_term(term_id t_id, double weight)
+{
+    // impacts are integers, so the query weight is too
+    auto multiplier
+        = static_cast<uint64_t>(std::max(std::llround(weight), 1ll));
+    for (const auto& seg : impacts_.segments(t_id))
+        segments_.push_back({seg.impact() * multiplier, seg});
+}
+
+std::vector<search_result>
+saat_ranker::rank(uint64_t num_results, const saat_budget& budget,
+                  const filter_function_type& filter)
+{
+    std::stable_sort(segments_.begin(), segments_.end(),
+                     [](const query_segment& a, const query_segment& b)
+                     {
+                         return a.impact > b.impact;
+                     });
+
+    postings_processed_ = 0;
+    terminated_early_ = false;
+    touched_.clear();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& qs : segments_)
+    {
+        if (budget.postings > 0 && postings_processed_ >= budget.postings)
+        {
+            terminated_early_ = true;
+            break;
+        }
+
+        if (budget.time.count() > 0
+            && std::chrono::steady_clock::now() - start >= budget.time)
+        {
+            terminated_early_ = true;
+            break;
+        }
+
+        auto n = qs.segment.size();
+        if (budget.postings > 0)
+            n = std::min(n, budget.postings - postings_processed_);
+
+        auto impact = static_cast<uint32_t>(qs.impact);
+        qs.segment.for_each(n, [&](doc_id d_id)
+                            {
+                                auto& acc = accumulators_[d_id];
+                                if (acc == 0)
+                                    touched_.push_back(d_id);
+                                acc += impact;
+                            });
+        postings_processed_ += n;
+
+        // the budget ran out partway through this segment
+        if (n < qs.segment.size())
+        {
+            terminated_early_ = true;
+            break;
+        }
+    }
+
+    auto comp = [](const search_result& a, const search_result& b)
+    {
+        // comparison is reversed since we want a min-heap
+        return a.score > b.score;
+    };
+    util::fixed_heap<search_result, decltype(comp)> results{num_results, comp};
+
+    auto mu = impacts_.mu();
+    for (const auto& d_id : touched_)
+    {
+        auto acc = accumulators_[d_id];
+        accumulators_[d_id] = 0;
+        if (!filter(d_id))
+            continue;
+
+        auto score = acc * impacts_.quantum();
+
+        // the Dirichlet prior's document-length component can't be
+        // stored as an impact, so it is added for the candidates here
+        if (mu > 0)
+            score += query_length_ * std::log(mu / (idx_.doc_size(d_id) + mu));
+
+        results.emplace(d_id, static_cast<float>(score));
+    }
+
+    return results.extract_top();
+}
+
+uint64_t saat_ranker::postings_processed() const
+{
+    return postings_processed_;
+}
+
+bool saat_ranker::terminated_early() const
+{
+    return terminated_early_;
+}
+}
+}
@@ -0,0 +1,97 @@
+/**
+ * @file latency_histogram.cpp
+ */
+
+#include <algorithm>
+
+#include "meta/index/server/latency_histogram.h"
+
+namespace meta
+{
+namespace index
+{
+
+const uint64_t latency_histogram::num_buckets;
+
+namespace
+{
+uint64_t upper_bound(uint64_t bucket)
+{
+    return uint64_t{1} << bucket;
+}
+}
+
+latency_histogram::latency_histogram() : total_{0}
+{
+    for (auto& bucket : buckets_)
+        bucket = 0;
+}
+
+void latency_histogram::record(std::chrono::microseconds latency)
+{
+    auto us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+
+    // bucket i holds [2^(i-1), 2^i), so it is one past the highest set bit
+    uint64_t bucket = 0;
+    for (auto v = us; v != 0; v >>= 1)
+        ++bucket;
+    if (bucket >= num_buckets)
+        bucket = num_buckets - 1;
+
+    ++buckets_[bucket];
+    total_ += us;
+}
+
+uint64_t latency_histogram::count() const
+{
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_)
+        total += bucket.load();
+    return total;
+}
+
+std::chrono::microseconds latency_histogram::mean() const
+{
+    auto n = count();
+    if (n == 0)
+        return std::chrono::microseconds{0};
+    return std::chrono::microseconds{static_cast<int64_t>(total_ / n)};
+}
+
+std::chrono::microseconds latency_histogram::percentile(double p) const
+{
+    auto n = count();
+    if (n == 0)
+        return std::chrono::microseconds{0};
+
+    auto rank = static_cast<uint64_t>(p * n);
+    uint64_t seen = 0;
+    uint64_t i = 0;
+    for (; i < num_buckets - 1; ++i)
+    {
+        seen += buckets_[i].load();
+        if (seen > rank || seen == n)
+            break;
+    }
+    return std::chrono::microseconds{static_cast<int64_t>(upper_bound(i))};
+}
+
+void latency_histogram::print(std::ostream& os) const
+{
+    os << "requests: " << count() << ", mean: " << mean().count()
+       << "us, p50: " << percentile(0.50).count()
+       << "us, p90: " << percentile(0.90).count()
+       << "us, p99: " << percentile(0.99).count() << "us\n";
+
+    for (uint64_t i = 0; i < num_buckets; ++i)
+    {
+        auto n = buckets_[i].load();
+        if (n == 0)
+            continue;
+        auto lower = i == 0 ? 0 : upper_bound(i - 1);
+        os << "  [" << lower << "us, " << upper_bound(i) << "us): " << n
+           << "\n";
+    }
+}
+}
+}
@@ -0,0 +1,751 @@
+/**
+ * @file query_server.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "cpptoml.h"
+#include "meta/corpus/document.h"
+#include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/server/query_server.h"
+#include "meta/utf/utf.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Reads the values of a flat JSON object. Nested objects and arrays are
+ * not needed for requests, so they are rejected.
+ */
+class json_reader
+{
+  public:
+    json_reader(util::string_view text) : text_{text}, pos_{0}
+    {
+        // nothing
+    }
+
+    /**
+     * Reads the object, calling fn(key, value, is_string) for each of
+     * its members. Strings are unescaped; other values are passed as
+     * their literal text.
+     */
+    template <class Function>
+    void read_object(Function&& fn)
+    {
+        expect('{');
+        skip_whitespace();
+        if (peek() == '}')
+        {
+            ++pos_;
+            return finish();
+        }
+
+        while (true)
+        {
+            skip_whitespace();
+            auto key = read_string();
+            expect(':');
+            skip_whitespace();
+            if (peek() == '"')
+                fn(key, read_string(), true);
+            else
+                fn(key, read_literal(), false);
+
+            skip_whitespace();
+            if (peek() == ',')
+            {
+                ++pos_;
+                continue;
+            }
+            expect('}');
+            return finish();
+        }
+    }
+
+  private:
+    void skip_whitespace()
+    {
+        while (pos_ < text_.size()
+               && (text_[pos_] == ' ' || text_[pos_] == '\t'
+                   || text_[pos_] == '\r' || text_[pos_] == '\n'))
+            ++pos_;
+    }
+
+    char peek() const
+    {
+        if (pos_ >= text_.size())
+            throw query_server_exception{"unexpected end of request"};
+        return text_[pos_];
+    }
+
+    void expect(char c)
+    {
+        skip_whitespace();
+        if (peek() != c)
+            throw query_server_exception{std::string{"expected '"} + c
+                                         + "' in request"};
+        ++pos_;
+    }
+
+    void finish()
+    {
+        skip_whitespace();
+        if (pos_ != text_.size())
+            throw query_server_exception{"trailing characters in request"};
+    }
+
+    uint32_t read_hex()
+    {
+        if (pos_ + 4 > text_.size())
+            throw query_server_exception{"invalid unicode escape"};
+        uint32_t value = 0;
+        for (uint64_t i = 0; i < 4; ++i)
+        {
+            auto c = text_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            else
+                throw query_server_exception{"invalid unicode escape"};
+        }
+        return value;
+    }
+
+    std::string read_string()
+    {
+        expect('"');
+        std::string result;
+        while (true)
+        {
+            auto c = peek();
+            ++pos_;
+            if (c == '"')
+                return result;
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+
+            c = peek();
+            ++pos_;
+            switch (c)
+            {
+                case '"':
+                case '\\':
+                case '/':
+                    result += c;
+                    break;
+                case 'b':
+                    result += '\b';
+                    break;
+                case 'f':
+                    result += '\f';
+                    break;
+                case 'n':
+                    result += '\n';
+                    break;
+                case 'r':
+                    result += '\r';
+                    break;
+                case 't':
+                    result += '\t';
+                    break;
+                case 'u':
+                {
+                    auto cp = read_hex();
+                    // combine a surrogate pair into a single code point
+                    if (cp >= 0xD800 && cp < 0xDC00 && pos_ + 1 < text_.size()
+                        && text_[pos_] == '\\' && text_[pos_ + 1] == 'u')
+                    {
+                        pos_ += 2;
+                        auto low = read_hex();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    utf::detail::utf8_append_codepoint(
+                        result, static_cast<int32_t>(cp));
+                    break;
+                }
+                default:
+                    throw query_server_exception{"invalid escape in request"};
+            }
+        }
+    }
+
+    std::string read_literal()
+    {
+        auto start = pos_;
+        while (pos_ < text_.size() && text_[pos_] != ','
+               && text_[pos_] != '}' && text_[pos_] != ' '
+               && text_[pos_] != '\t')
+        {
+            if (text_[pos_] == '{' || text_[pos_] == '[')
+                throw query_server_exception{
+                    "nested values are not supported in requests"};
+            ++pos_;
+        }
+        if (pos_ == start)
+            throw query_server_exception{"missing value in request"};
+        return text_.substr(start, pos_ - start).to_string();
+    }
+
+    util::string_view text_;
+    uint64_t pos_;
+};
+
+/**
+ * Writes a string as a JSON string literal.
+ */
+void write_string(std::ostream& os, util::string_view str)
+{
+    os << '"';
+    for (const auto& c : str)
+    {
+        switch (c)
+        {
+            case '"':
+                os << "\\\"";
+                break;
+            case '\\':
+                os << "\\\\";
+                break;
+            case '\n':
+                os << "\\n";
+                break;
+            case '\r':
+                os << "\\r";
+                break;
+            case '\t':
+                os << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    const char* hex = "0123456789abcdef";
+                    os << "\\u00" << hex[(c >> 4) & 0xF] << hex[c & 0xF];
+                }
+                else
+                {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+}
+
+/**
+ * @return the [server] table's value for key, or def if there is none
+ */
+uint64_t server_option(const cpptoml::table& config, const std::string& key,
+                       uint64_t def)
+{
+    auto server = config.get_table("server");
+    if (!server)
+        return def;
+
+    auto value = server->get_as<int64_t>(key);
+    if (!value)
+        return def;
+    if (*value <= 0)
+        throw query_server_exception{"server " + key + " must be positive"};
+    return static_cast<uint64_t>(*value);
+}
+
+/**
+ * @return whether the text is a JSON number
+ */
+bool is_number(const std::string& text)
+{
+    std::size_t pos = 0;
+    auto digits = [&]()
+    {
+        auto start = pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+            ++pos;
+        return pos > start;
+    };
+
+    if (pos < text.size() && text[pos] == '-')
+        ++pos;
+    if (pos < text.size() && text[pos] == '0')
+        ++pos;
+    else if (!digits())
+        return false;
+
+    if (pos < text.size() && text[pos] == '.')
+    {
+        ++pos;
+        if (!digits())
+            return false;
+    }
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+    {
+        ++pos;
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+            ++pos;
+        if (!digits())
+            return false;
+    }
+    return pos == text.size();
+}
+
+/**
+ * @param value The text of the top_k member of a request
+ * @return the number of results it asks for
+ */
+uint64_t parse_top_k(const std::string& value)
+{
+    // std::stoll alone would read "1.5" as 1 and "10abc" as 10, so the
+    // whole value has to be a number
+    std::size_t end = 0;
+    long long k = 0;
+    try
+    {
+        k = std::stoll(value, &end);
+    }
+    catch (const std::logic_error&)
+    {
+        // std::invalid_argument or std::out_of_range
+        end = 0;
+    }
+    if (end == 0 || end != value.size() || k <= 0)
+        throw query_server_exception{"top_k must be a positive integer"};
+    return static_cast<uint64_t>(k);
+}
+
+std::string error_response(const std::string& id, const std::string& error)
+{
+    std::ostringstream response;
+    response << "{\"id\": " << id << ", \"error\": ";
+    write_string(response, error);
+    response << "}";
+    return response.str();
+}
+}
+
+query_request parse_request(util::string_view line)
+{
+    query_request request;
+    bool has_query = false;
+    json_reader reader{line};
+    reader.read_object([&](const std::string& key, const std::string& value,
+                           bool is_string)
+                       {
+                           if (key == "id")
+                           {
+                               if (is_string)
+                               {
+                                   std::ostringstream id;
+                                   write_string(id, value);
+                                   request.id = id.str();
+                               }
+                               else if (value == "null" || is_number(value))
+                               {
+                                   request.id = value;
+                               }
+                               else
+                               {
+                                   throw query_server_exception{
+                                       "request id must be a string or a "
+                                       "number"};
+                               }
+                           }
+                           else if (key == "query" && is_string)
+                           {
+                               request.query = value;
+                               has_query = true;
+                           }
+                           else if (key == "ranker" && is_string)
+                           {
+                               request.ranker = value;
+                           }
+                           else if (key == "top_k" && !is_string)
+                           {
+                               request.top_k = parse_top_k(value);
+                           }
+                           else if (key == "command" && is_string)
+                           {
+                               request.command = value;
+                           }
+                           else
+                           {
+                               throw query_server_exception{
+                                   "invalid request member: " + key};
+                           }
+                       });
+
+    if (!has_query && request.command.empty())
+        throw query_server_exception{"request has no query"};
+    return request;
+}
+
+query_server::query_server(std::shared_ptr<inverted_index> idx,
+                           const cpptoml::table& config)
+    : idx_{std::move(idx)},
+      ranker_config_{config.get_table("ranker")},
+      max_batch_{server_option(config, "max-batch", 64)},
+      pool_{server_option(config, "threads",
+                          std::max(std::thread::hardware_concurrency(), 1u))},
+      shutdown_{false}
+{
+    if (!ranker_config_)
+        throw query_server_exception{"\"ranker\" group needed in config"};
+
+    for (const auto& id : pool_.thread_ids())
+        workers_[id].analyzer = idx_->make_analyzer();
+}
+
+void query_server::serve(std::istream& in, std::ostream& out)
+{
+    std::vector<std::string> lines;
+    std::string line;
+    while (!shutdown_ && std::getline(in, line))
+    {
+        lines.clear();
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            lines.push_back(line);
+
+        // the requests that have already arrived are handled together
+        while (lines.size() < max_batch_ && in.rdbuf()->in_avail() > 0
+               && std::getline(in, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                lines.push_back(line);
+        }
+
+        for (const auto& response : handle_batch(lines))
+            out << response << '\n';
+        out.flush();
+    }
+}
+
+std::string query_server::handle(const std::string& line)
+{
+    return handle_batch({line}).front();
+}
+
+const latency_histogram& query_server::latencies() const
+{
+    return latencies_;
+}
+
+std::vector<std::string>
+query_server::handle_batch(const std::vector<std::string>& lines)
+{
+    std::vector<std::future<std::string>> futures;
+    futures.reserve(lines.size());
+    for (const auto& line : lines)
+    {
+        auto task = [this, &line]()
+        {
+            auto& w = workers_.at(std::this_thread::get_id());
+            return handle(line, w);
+        };
+        futures.emplace_back(pool_.submit_task(task));
+    }
+
+    std::vector<std::string> responses;
+    responses.reserve(lines.size());
+    for (auto& fut : futures)
+        responses.push_back(fut.get());
+    return responses;
+}
+
+std::string query_server::handle(const std::string& line, worker& w)
+{
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+
+    // every query is timed, including the ones that fail
+    auto record = [&]()
+    {
+        auto elapsed = duration_cast<microseconds>(steady_clock::now()
+                                                   - start);
+        latencies_.record(elapsed);
+        return elapsed;
+    };
+
+    query_request request;
+    try
+    {
+        request = parse_request(line);
+    }
+    catch (const std::exception& ex)
+    {
+        record();
+        return error_response("null", ex.what());
+    }
+
+    std::ostringstream response;
+    response << "{\"id\": " << request.id;
+    if (request.command == "stats")
+    {
+        response << ", \"stats\": {\"count\": " << latencies_.count()
+                 << ", \"mean_us\": " << latencies_.mean().count()
+                 << ", \"p50_us\": " << latencies_.percentile(0.50).count()
+                 << ", \"p90_us\": " << latencies_.percentile(0.90).count()
+                 << ", \"p99_us\": " << latencies_.percentile(0.99).count()
+                 << "}}";
+        return response.str();
+    }
+    else if (request.command == "shutdown")
+    {
+        shutdown_ = true;
+        response << ", \"status\": \"shutting down\"}";
+        return response.str();
+    }
+    else if (!request.command.empty())
+    {
+        return error_response(request.id,
+                              "unknown command: " + request.command);
+    }
+
+    std::vector<search_result> results;
+    try
+    {
+        // the default method uses the parameters from the configuration
+        auto method = ranker_config_->get_as<std::string>("method");
+        if (method && request.ranker == *method)
+            request.ranker.clear();
+
+        auto& rnk = w.rankers[request.ranker];
+        if (!rnk)
+        {
+            if (request.ranker.empty())
+            {
+                rnk = make_ranker(*ranker_config_);
+            }
+            else
+            {
+                auto cfg = cpptoml::make_table();
+                cfg->insert("method", request.ranker);
+                rnk = make_ranker(*cfg);
+            }
+        }
+
+        corpus::document query;
+        query.content(request.query);
+        auto counts = w.analyzer->analyze<uint64_t>(query);
+        results = rnk->score(*idx_, counts.begin(), counts.end(),
+                             request.top_k);
+    }
+    catch (const std::exception& ex)
+    {
+        w.rankers.erase(request.ranker);
+        record();
+        return error_response(request.id, ex.what());
+    }
+
+    auto elapsed = record();
+
+    response << ", \"results\": [";
+    for (uint64_t i = 0; i < results.size(); ++i)
+    {
+        if (i > 0)
+            response << ", ";
+        response << "{\"doc_id\": " << results[i].d_id << ", \"name\": ";
+        write_string(response, idx_->doc_name(results[i].d_id));
+        response << ", \"score\": " << results[i].score << "}";
+    }
+    response << "], \"time_us\": " << elapsed.count() << "}";
+    return response.str();
+}
+
+#ifndef _WIN32
+namespace
+{
+/**
+ * Writes all of a buffer to a socket.
+ * @return whether the write succeeded
+ */
+bool write_all(int fd, const std::string& data)
+{
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    uint64_t written = 0;
+    while (written < data.size())
+    {
+        auto n = ::send(fd, data.data() + written, data.size() - written,
+                        flags);
+        if (n <= 0)
+            return false;
+        written += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+/**
+ * A thread serving a socket connection.
+ */
+struct connection
+{
+    std::thread thread;
+    /// Set by the thread when the connection has closed
+    std::shared_ptr<std::atomic<bool>> done;
+};
+
+/**
+ * Waits up to 100ms for a file descriptor to be readable, so that loops
+ * notice a shutdown.
+ */
+bool wait_readable(int fd)
+{
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return ::poll(&pfd, 1, 100) > 0;
+}
+}
+
+void query_server::serve_connection(int fd)
+{
+    std::string buffer;
+    std::vector<std::string> lines;
+    char chunk[4096];
+    while (!shutdown_)
+    {
+        if (!wait_readable(fd))
+            continue;
+
+        auto n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0)
+            break;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+
+        // every complete request that has arrived is part of the batch
+        lines.clear();
+        std::size_t start = 0;
+        std::size_t end;
+        while ((end = buffer.find('\n', start)) != std::string::npos)
+        {
+            auto line = buffer.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                lines.push_back(std::move(line));
+            start = end + 1;
+        }
+        buffer.erase(0, start);
+
+        bool ok = true;
+        for (std::size_t i = 0; ok && i < lines.size(); i += max_batch_)
+        {
+            auto last = std::min(lines.size(), i + max_batch_);
+            std::vector<std::string> batch{lines.begin() + i,
+                                           lines.begin() + last};
+            std::string out;
+            for (const auto& response : handle_batch(batch))
+            {
+                out += response;
+                out += '\n';
+            }
+            ok = write_all(fd, out);
+        }
+        if (!ok)
+            break;
+    }
+    ::close(fd);
+}
+
+void query_server::serve_socket(const std::string& path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw query_server_exception{"socket path is too long: " + path};
+    std::copy(path.begin(), path.end(), addr.sun_path);
+
+    auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        throw query_server_exception{"failed to create socket"};
+
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::listen(fd, 16) < 0)
+    {
+        ::close(fd);
+        throw query_server_exception{"failed to listen on " + path};
+    }
+
+    // each connection's thread is joined once its connection closes, so
+    // that a long-running server does not keep every thread it started
+    std::vector<connection> connections;
+    auto reap = [&]()
+    {
+        auto finished = std::partition(connections.begin(), connections.end(),
+                                       [](const connection& conn)
+                                       {
+                                           return !*conn.done;
+                                       });
+        for (auto it = finished; it != connections.end(); ++it)
+            it->thread.join();
+        connections.erase(finished, connections.end());
+    };
+
+    while (!shutdown_)
+    {
+        reap();
+        if (!wait_readable(fd))
+            continue;
+
+        auto client = ::accept(fd, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::thread thread{[this, client, done]()
+                           {
+                               serve_connection(client);
+                               *done = true;
+                           }};
+        connections.push_back({std::move(thread), std::move(done)});
+    }
+
+    for (auto& conn : connections)
+        conn.thread.join();
+    ::close(fd);
+    ::unlink(path.c_str());
+}
+#else
+void query_server::serve_connection(int)
+{
+    // nothing
+}
+
+void query_server::serve_socket(const std::string&)
+{
+    throw query_server_exception{
+        "Unix domain sockets are not supported on this platform"};
+}
+#endif
+}
+}
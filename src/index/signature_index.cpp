@@ -0,0 +1,388 @@
+/**
+ * @file signature_index.cpp
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+#include "cpptoml.h"
+#include "meta/hashing/hashes/farm_hash.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/ranker/ranker.h"
+#include "meta/index/signature_index.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/succinct/broadword.h"
+#include "meta/util/range.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+const char* signatures_file = "/signatures.index";
+const char* header_file = "/signatures.header";
+
+/**
+ * The seeds for the two hashes of each feature.
+ */
+const uint64_t seed1 = 0x9e3779b97f4a7c15ull;
+const uint64_t seed2 = 0xc2b2ae3d27d4eb4full;
+
+/**
+ * A 64-bit finalizer (from splitmix64), used to turn the combinations of
+ * a feature's two hashes into independent-looking hash values.
+ */
+uint64_t mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t hash_feature(const std::string& feature, uint64_t seed)
+{
+    hashing::farm_hash_seeded hasher{seed};
+    hasher(feature.data(), feature.size());
+    return static_cast<uint64_t>(hasher);
+}
+
+/**
+ * A disjoint-set forest over document ids.
+ */
+class disjoint_sets
+{
+  public:
+    disjoint_sets(uint64_t size) : parents_(size)
+    {
+        std::iota(parents_.begin(), parents_.end(), 0);
+    }
+
+    uint64_t find(uint64_t x)
+    {
+        while (parents_[x] != x)
+        {
+            parents_[x] = parents_[parents_[x]];
+            x = parents_[x];
+        }
+        return x;
+    }
+
+    void join(uint64_t a, uint64_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a < b)
+            parents_[b] = a;
+        else if (b < a)
+            parents_[a] = b;
+    }
+
+  private:
+    std::vector<uint64_t> parents_;
+};
+}
+
+uint64_t signature_options::width() const
+{
+    return method == method_type::minhash ? bands * rows : 1;
+}
+
+signature_options make_signature_options(const cpptoml::table& config)
+{
+    signature_options options;
+
+    auto method = config.get_as<std::string>("method").value_or("minhash");
+    if (method == "minhash")
+        options.method = signature_options::method_type::minhash;
+    else if (method == "simhash")
+        options.method = signature_options::method_type::simhash;
+    else
+        throw signature_index_exception{"unknown signature method: "
+                                        + method};
+
+    auto bands = config.get_as<int64_t>("bands").value_or(16);
+    auto rows = config.get_as<int64_t>("rows").value_or(4);
+    if (bands <= 0 || rows <= 0)
+        throw signature_index_exception{
+            "signature bands and rows must be positive"};
+    if (options.method == signature_options::method_type::simhash
+        && bands > 64)
+        throw signature_index_exception{"simhash allows at most 64 bands"};
+
+    options.bands = static_cast<uint64_t>(bands);
+    options.rows = static_cast<uint64_t>(rows);
+    return options;
+}
+
+void compute_signature(const signature_options& options,
+                       const analyzers::feature_map<uint64_t>& counts,
+                       uint64_t* out)
+{
+    if (options.method == signature_options::method_type::minhash)
+    {
+        auto width = options.width();
+        std::fill(out, out + width, std::numeric_limits<uint64_t>::max());
+        for (const auto& count : counts)
+        {
+            // the i-th hash of a feature is derived from two base hashes
+            // (Kirsch and Mitzenmacher), so each feature is hashed twice
+            // no matter how long the signature is
+            auto h1 = hash_feature(count.key(), seed1);
+            auto h2 = hash_feature(count.key(), seed2);
+            for (uint64_t i = 0; i < width; ++i)
+                out[i] = std::min(out[i], mix(h1 + i * h2));
+        }
+    }
+    else
+    {
+        int64_t weights[64] = {0};
+        for (const auto& count : counts)
+        {
+            auto h = hash_feature(count.key(), seed1);
+            auto weight = static_cast<int64_t>(count.value());
+            for (uint64_t bit = 0; bit < 64; ++bit)
+                weights[bit] += (h >> bit) & 1 ? weight : -weight;
+        }
+
+        uint64_t fingerprint = 0;
+        for (uint64_t bit = 0; bit < 64; ++bit)
+        {
+            if (weights[bit] > 0)
+                fingerprint |= uint64_t{1} << bit;
+        }
+        *out = fingerprint;
+    }
+}
+
+signature_writer::signature_writer(const std::string& prefix,
+                                   uint64_t num_docs,
+                                   signature_options options)
+    : options_(options),
+      signatures_{prefix + signatures_file,
+                  std::max<uint64_t>(num_docs * options.width(), 1)}
+{
+    std::ofstream header{prefix + header_file, std::ios::binary};
+    io::packed::write(header, static_cast<uint64_t>(options_.method));
+    io::packed::write(header, options_.bands);
+    io::packed::write(header, options_.rows);
+    io::packed::write(header, num_docs);
+}
+
+void signature_writer::write(doc_id d_id,
+                             const analyzers::feature_map<uint64_t>& counts)
+{
+    compute_signature(options_, counts,
+                      &signatures_[d_id * options_.width()]);
+}
+
+void signature_writer::reorder(const std::vector<doc_id>& new_ids)
+{
+    auto width = options_.width();
+    std::vector<uint64_t> old(signatures_.begin(), signatures_.end());
+    for (uint64_t d_id = 0; d_id < new_ids.size(); ++d_id)
+    {
+        std::copy_n(old.begin() + d_id * width, width,
+                    signatures_.begin() + new_ids[d_id] * width);
+    }
+}
+
+signature_index::signature_index(const inverted_index& idx)
+    : num_docs_{0}, signatures_{idx.index_name() + signatures_file}
+{
+    std::ifstream header{idx.index_name() + header_file, std::ios::binary};
+    if (!header)
+        throw signature_index_exception{"no signatures for index "
+                                        + idx.index_name()};
+
+    uint64_t method;
+    io::packed::read(header, method);
+    io::packed::read(header, options_.bands);
+    io::packed::read(header, options_.rows);
+    options_.method = static_cast<signature_options::method_type>(method);
+
+    io::packed::read(header, num_docs_);
+    if (num_docs_ != idx.num_docs()
+        || signatures_.size() < num_docs_ * options_.width())
+        throw signature_index_exception{"signatures do not match index "
+                                        + idx.index_name()};
+
+    // the signatures of documents with no features are all the same, and
+    // would make every such document a duplicate of the others
+    empty_.resize(num_docs_);
+    bands_.resize(options_.bands);
+    for (doc_id d_id{0}; d_id < num_docs_; ++d_id)
+    {
+        empty_[d_id] = idx.doc_size(d_id) == 0;
+        if (empty_[d_id])
+            continue;
+
+        for (uint64_t b = 0; b < options_.bands; ++b)
+            bands_[b][band_hash(d_id, b)].push_back(d_id);
+    }
+}
+
+bool signature_index::exists(const inverted_index& idx)
+{
+    return filesystem::file_exists(idx.index_name() + header_file);
+}
+
+const signature_options& signature_index::options() const
+{
+    return options_;
+}
+
+uint64_t signature_index::num_docs() const
+{
+    return num_docs_;
+}
+
+util::array_view<const uint64_t> signature_index::signature(doc_id d_id) const
+{
+    return {&signatures_[d_id * options_.width()], options_.width()};
+}
+
+double signature_index::similarity(doc_id a, doc_id b) const
+{
+    if (empty_[a] || empty_[b])
+        return a == b ? 1.0 : 0.0;
+
+    auto sig_a = signature(a);
+    auto sig_b = signature(b);
+    if (options_.method == signature_options::method_type::simhash)
+    {
+        auto distance = succinct::broadword::popcount(sig_a[0] ^ sig_b[0]);
+        return 1.0 - static_cast<double>(distance) / 64;
+    }
+
+    uint64_t agree = 0;
+    for (uint64_t i = 0; i < sig_a.size(); ++i)
+        agree += sig_a[i] == sig_b[i];
+    return static_cast<double>(agree) / sig_a.size();
+}
+
+uint64_t signature_index::band_hash(doc_id d_id, uint64_t b) const
+{
+    auto sig = signature(d_id);
+    if (options_.method == signature_options::method_type::simhash)
+    {
+        // the bits are split evenly between the bands, and the last band
+        // takes any that are left over
+        auto bits = 64 / options_.bands;
+        auto shift = b * bits;
+        if (b + 1 == options_.bands)
+            bits = 64 - shift;
+        auto mask = bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+        return (sig[0] >> shift) & mask;
+    }
+
+    hashing::farm_hash hasher;
+    hasher(sig.begin() + b * options_.rows, options_.rows * sizeof(uint64_t));
+    return static_cast<uint64_t>(hasher);
+}
+
+std::vector<doc_id> signature_index::candidates(doc_id d_id) const
+{
+    std::vector<doc_id> results;
+    if (empty_[d_id])
+        return results;
+
+    for (uint64_t b = 0; b < options_.bands; ++b)
+    {
+        const auto& bucket = bands_[b].at(band_hash(d_id, b));
+        results.insert(results.end(), bucket.begin(), bucket.end());
+    }
+
+    std::sort(results.begin(), results.end());
+    results.erase(std::unique(results.begin(), results.end()),
+                  results.end());
+    results.erase(std::remove(results.begin(), results.end(), d_id),
+                  results.end());
+    return results;
+}
+
+std::vector<std::vector<doc_id>>
+signature_index::clusters(double threshold, unsigned num_threads) const
+{
+    auto size = num_docs();
+    if (size == 0)
+        return {};
+
+    // each thread verifies the candidates of a block of documents,
+    // keeping the pairs that are similar enough
+    parallel::thread_pool pool{std::max(num_threads, 1u)};
+    std::unordered_map<std::thread::id, std::vector<std::pair<doc_id, doc_id>>>
+        pairs;
+    for (const auto& id : pool.thread_ids())
+        pairs[id];
+
+    auto range = util::range<uint64_t>(0, size - 1);
+    parallel::parallel_for(
+        range.begin(), range.end(), pool, [&](uint64_t d)
+        {
+            auto& found = pairs.at(std::this_thread::get_id());
+            doc_id d_id{d};
+            for (const auto& other : candidates(d_id))
+            {
+                if (other > d_id && similarity(d_id, other) >= threshold)
+                    found.emplace_back(d_id, other);
+            }
+        });
+
+    disjoint_sets sets{size};
+    for (const auto& found : pairs)
+    {
+        for (const auto& pair : found.second)
+            sets.join(pair.first, pair.second);
+    }
+
+    std::unordered_map<uint64_t, std::vector<doc_id>> groups;
+    for (uint64_t d = 0; d < size; ++d)
+        groups[sets.find(d)].push_back(doc_id{d});
+
+    std::vector<std::vector<doc_id>> results;
+    for (auto& group : groups)
+    {
+        if (group.second.size() > 1)
+            results.push_back(std::move(group.second));
+    }
+
+    // clusters are listed by their first document
+    std::sort(results.begin(), results.end(),
+              [](const std::vector<doc_id>& a, const std::vector<doc_id>& b)
+              {
+                  return a.front() < b.front();
+              });
+    return results;
+}
+
+std::vector<search_result>
+collapse_duplicates(const signature_index& sigs,
+                    const std::vector<search_result>& results,
+                    double threshold, uint64_t n)
+{
+    std::vector<search_result> kept;
+    for (const auto& result : results)
+    {
+        if (kept.size() == n)
+            break;
+
+        auto duplicate = std::any_of(kept.begin(), kept.end(),
+                                     [&](const search_result& other)
+                                     {
+                                         return sigs.similarity(result.d_id,
+                                                                other.d_id)
+                                                >= threshold;
+                                     });
+        if (!duplicate)
+            kept.push_back(result);
+    }
+    return kept;
+}
+}
+}
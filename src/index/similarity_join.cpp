@@ -0,0 +1,295 @@
+/**
+ * @file similarity_join.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "meta/index/forward_index.h"
+#include "meta/index/postings_stream.h"
+#include "meta/index/similarity_join.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/range.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * A weighted feature of a document, identified by its position in the
+ * global order of features (most frequent first).
+ */
+struct feature
+{
+    uint64_t rank;
+    double weight;
+};
+
+/**
+ * An entry in the index of vector suffixes.
+ */
+struct posting
+{
+    doc_id d_id;
+    double weight;
+};
+
+/**
+ * The state of a single thread while querying.
+ */
+struct accumulator
+{
+    /// The partial dot product with every document
+    std::vector<double> scores;
+    /// The documents with a nonzero partial dot product
+    std::vector<doc_id> touched;
+};
+
+/**
+ * @return the dot product of two vectors, both sorted by rank
+ */
+double dot(std::vector<feature>::const_iterator first1,
+           std::vector<feature>::const_iterator last1,
+           std::vector<feature>::const_iterator first2,
+           std::vector<feature>::const_iterator last2)
+{
+    double result = 0;
+    while (first1 != last1 && first2 != last2)
+    {
+        if (first1->rank < first2->rank)
+        {
+            ++first1;
+        }
+        else if (first2->rank < first1->rank)
+        {
+            ++first2;
+        }
+        else
+        {
+            result += first1->weight * first2->weight;
+            ++first1;
+            ++first2;
+        }
+    }
+    return result;
+}
+}
+
+similarity_lists all_pairs_similarity(const forward_index& fwd,
+                                      const similarity_join_options& options)
+{
+    if (options.threshold <= 0 || options.threshold > 1)
+        throw similarity_join_exception{
+            "similarity threshold must be on (0, 1]"};
+
+    auto num_docs = fwd.num_docs();
+    auto num_terms = fwd.unique_terms();
+    similarity_lists results(num_docs);
+    if (num_docs == 0)
+        return results;
+
+    parallel::thread_pool pool{std::max(options.num_threads, 1u)};
+    auto range = util::range<uint64_t>(0, num_docs - 1);
+
+    std::vector<uint64_t> doc_freqs(num_terms, 0);
+    for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+    {
+        auto stream = fwd.stream_for(d_id);
+        if (!stream)
+            continue;
+        for (const auto& count : *stream)
+            ++doc_freqs[count.first];
+    }
+
+    // the features are ordered from most to least frequent, so the
+    // unindexed prefixes hold the features with the longest postings
+    std::vector<uint64_t> ranks(num_terms);
+    {
+        std::vector<uint64_t> order(num_terms);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint64_t a, uint64_t b)
+                         {
+                             return doc_freqs[a] > doc_freqs[b];
+                         });
+        for (uint64_t i = 0; i < num_terms; ++i)
+            ranks[order[i]] = i;
+    }
+
+    // unit-length tf-idf vectors, sorted by rank
+    std::vector<std::vector<feature>> vectors(num_docs);
+    parallel::parallel_for(
+        range.begin(), range.end(), pool, [&](uint64_t d)
+        {
+            auto stream = fwd.stream_for(doc_id{d});
+            if (!stream)
+                return;
+
+            auto& vec = vectors[d];
+            double norm = 0;
+            for (const auto& count : *stream)
+            {
+                if (count.second <= 0)
+                    continue;
+                auto idf = std::log(static_cast<double>(num_docs)
+                                    / doc_freqs[count.first]);
+                auto weight = (1.0 + std::log(count.second)) * idf;
+                if (weight <= 0)
+                    continue;
+                vec.push_back({ranks[count.first], weight});
+                norm += weight * weight;
+            }
+
+            norm = std::sqrt(norm);
+            for (auto& feat : vec)
+                feat.weight /= norm;
+            std::sort(vec.begin(), vec.end(),
+                      [](const feature& a, const feature& b)
+                      {
+                          return a.rank < b.rank;
+                      });
+        });
+
+    // each vector's prefix is left out of the index for as long as its
+    // norm stays below the threshold: any document that only shares
+    // prefix features with it can't be similar enough
+    std::vector<uint64_t> prefix_ends(num_docs, 0);
+    std::vector<double> prefix_norms(num_docs, 0.0);
+    std::vector<std::vector<posting>> postings(num_terms);
+    for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+    {
+        const auto& vec = vectors[d_id];
+        double squared = 0;
+        uint64_t i = 0;
+        for (; i < vec.size(); ++i)
+        {
+            auto next = squared + vec[i].weight * vec[i].weight;
+            if (std::sqrt(next) >= options.threshold)
+                break;
+            squared = next;
+        }
+        prefix_ends[d_id] = i;
+        prefix_norms[d_id] = std::sqrt(squared);
+
+        for (; i < vec.size(); ++i)
+            postings[vec[i].rank].push_back({d_id, vec[i].weight});
+    }
+
+    std::unordered_map<std::thread::id, accumulator> accumulators;
+    for (const auto& id : pool.thread_ids())
+        accumulators[id].scores.resize(num_docs, 0.0);
+
+    // without a top-k, each pair is found from its larger id only and
+    // mirrored afterward
+    auto symmetric = options.top_k == 0;
+    parallel::parallel_for(
+        range.begin(), range.end(), pool, [&](uint64_t d)
+        {
+            auto& acc = accumulators.at(std::this_thread::get_id());
+            doc_id d_id{d};
+            const auto& vec = vectors[d_id];
+
+            for (const auto& feat : vec)
+            {
+                for (const auto& post : postings[feat.rank])
+                {
+                    if (symmetric && post.d_id >= d_id)
+                        break;
+                    if (post.d_id == d_id)
+                        continue;
+                    if (acc.scores[post.d_id] == 0)
+                        acc.touched.push_back(post.d_id);
+                    acc.scores[post.d_id] += feat.weight * post.weight;
+                }
+            }
+
+            auto& neighbors = results[d_id];
+            for (const auto& other : acc.touched)
+            {
+                auto score = acc.scores[other];
+                acc.scores[other] = 0;
+
+                // the unindexed prefix can add at most its norm
+                if (score + prefix_norms[other] < options.threshold)
+                    continue;
+
+                const auto& other_vec = vectors[other];
+                score += dot(other_vec.begin(),
+                             other_vec.begin() + prefix_ends[other],
+                             vec.begin(), vec.end());
+                if (score >= options.threshold)
+                    neighbors.emplace_back(other, score);
+            }
+            acc.touched.clear();
+
+            if (!symmetric && neighbors.size() > options.top_k)
+            {
+                std::nth_element(neighbors.begin(),
+                                 neighbors.begin() + options.top_k - 1,
+                                 neighbors.end(),
+                                 [](const std::pair<doc_id, double>& a,
+                                    const std::pair<doc_id, double>& b)
+                                 {
+                                     return a.second > b.second;
+                                 });
+                neighbors.resize(options.top_k);
+            }
+        });
+
+    if (symmetric)
+    {
+        // only the pairs found so far (with smaller neighbors) are mirrored
+        std::vector<uint64_t> found(num_docs);
+        for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+            found[d_id] = results[d_id].size();
+
+        for (doc_id d_id{0}; d_id < num_docs; ++d_id)
+        {
+            for (uint64_t i = 0; i < found[d_id]; ++i)
+            {
+                const auto& pair = results[d_id][i];
+                results[pair.first].emplace_back(d_id, pair.second);
+            }
+        }
+    }
+
+    parallel::parallel_for(
+        range.begin(), range.end(), pool, [&](uint64_t d)
+        {
+            std::sort(results[d].begin(), results[d].end(),
+                      [](const std::pair<doc_id, double>& a,
+                         const std::pair<doc_id, double>& b)
+                      {
+                          if (a.second != b.second)
+                              return a.second > b.second;
+                          return a.first < b.first;
+                      });
+        });
+
+    return results;
+}
+
+graph::directed_graph<> make_similarity_graph(const forward_index& fwd,
+                                              const similarity_lists& lists)
+{
+    graph::directed_graph<> result;
+    for (doc_id d_id{0}; d_id < lists.size(); ++d_id)
+        result.insert(graph::default_node{fwd.doc_name(d_id)});
+
+    for (doc_id d_id{0}; d_id < lists.size(); ++d_id)
+    {
+        for (const auto& neighbor : lists[d_id])
+        {
+            result.add_edge(graph::default_edge{neighbor.second},
+                            node_id{d_id}, node_id{neighbor.first});
+        }
+    }
+    return result;
+}
+}
+}
@@ -0,0 +1,136 @@
+/**
+ * @file skip_index.cpp
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "meta/index/inverted_index.h"
+#include "meta/index/skip_index.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+#include "meta/logging/logger.h"
+#include "meta/util/printing.h"
+#include "meta/util/progress.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+struct char_input_stream
+{
+    char get()
+    {
+        return *input_++;
+    }
+
+    const char* input_;
+};
+
+const char* skips_file = "/postings.skips";
+}
+
+const uint64_t skip_index::interval;
+
+skip_index::skip_index(const inverted_index& idx)
+    : file_{idx.index_name() + skips_file},
+      byte_locations_{idx.index_name() + skips_file + "_index"}
+{
+    // nothing
+}
+
+void skip_index::create(const inverted_index& idx)
+{
+    auto filename = idx.index_name() + skips_file;
+    auto num_terms = idx.unique_terms();
+    {
+        std::ofstream out{filename, std::ios::binary};
+        util::disk_vector<uint64_t> byte_locations{filename + "_index",
+                                                   num_terms};
+
+        printing::progress progress{" > Writing skip points: ", num_terms};
+        std::vector<uint64_t> skips;
+        uint64_t bytes = 0;
+        for (term_id t_id{0}; t_id < num_terms; ++t_id)
+        {
+            progress(t_id);
+            byte_locations[t_id] = bytes;
+
+            skips.clear();
+            auto stream = idx.stream_for(t_id);
+            if (stream && stream->size() > interval)
+            {
+                uint64_t position = 0;
+                for (auto it = stream->begin(); it != stream->end(); ++it)
+                {
+                    ++position;
+                    if (position % interval != 0 || position == stream->size())
+                        continue;
+                    skips.push_back(uint64_t{it->first});
+                    skips.push_back(position);
+                    skips.push_back(stream->offset(it));
+                }
+            }
+
+            bytes += io::packed::write(out, skips.size() / 3);
+            for (const auto& value : skips)
+                bytes += io::packed::write(out, value);
+        }
+    }
+
+    LOG(info) << "Created skip points ("
+              << printing::bytes_to_units(filesystem::file_size(filename))
+              << ")" << ENDLG;
+}
+
+bool skip_index::exists(const inverted_index& idx)
+{
+    return filesystem::file_exists(idx.index_name() + skips_file);
+}
+
+std::vector<skip_index::skip_point> skip_index::points(term_id t_id) const
+{
+    std::vector<skip_point> skips;
+    if (t_id >= byte_locations_.size())
+        return skips;
+
+    char_input_stream in{file_.begin() + byte_locations_[t_id]};
+    auto num_skips = io::packed::read<uint64_t>(in);
+    skips.reserve(num_skips);
+    for (uint64_t i = 0; i < num_skips; ++i)
+    {
+        auto key = io::packed::read<uint64_t>(in);
+        auto position = io::packed::read<uint64_t>(in);
+        auto offset = io::packed::read<uint64_t>(in);
+        skips.push_back({doc_id{key}, position, offset});
+    }
+    return skips;
+}
+
+postings_stream<doc_id>::iterator
+    skip_index::seek(const postings_stream<doc_id>& stream, term_id t_id,
+                     doc_id d_id) const
+{
+    // resume from the last skip point before the document, if any
+    auto skips = points(t_id);
+    auto skip = std::lower_bound(skips.begin(), skips.end(), d_id,
+                                 [](const skip_point& sp, doc_id id)
+                                 {
+                                     return sp.key < id;
+                                 });
+
+    auto it = skip == skips.begin()
+                  ? stream.begin()
+                  : stream.seek((skip - 1)->offset, (skip - 1)->position,
+                                (skip - 1)->key);
+    auto end = stream.end();
+    while (it != end && it->first < d_id)
+        ++it;
+    return it;
+}
+}
+}
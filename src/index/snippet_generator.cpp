@@ -0,0 +1,203 @@
+/**
+ * @file snippet_generator.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "meta/analyzers/filters/stages.h"
+#include "meta/corpus/document.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/snippet_generator.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/range.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Bytes that are part of a word: ASCII letters and digits, and any byte
+ * of a multi-byte UTF-8 sequence.
+ */
+bool is_word_byte(char c)
+{
+    auto byte = static_cast<unsigned char>(c);
+    return byte >= 0x80 || (byte >= '0' && byte <= '9')
+           || (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z');
+}
+
+/**
+ * A word of a document's text and its weight for the current query.
+ */
+struct word_span
+{
+    uint64_t begin;
+    uint64_t end;
+    double weight;
+};
+}
+
+snippet_generator::snippet_generator(inverted_index& idx,
+                                     snippet_options options /* = {} */,
+                                     unsigned num_threads /* = hw conc. */)
+    : idx_(idx),
+      options_(std::move(options)),
+      pool_{std::max(num_threads, 1u)}
+{
+    for (const auto& id : pool_.thread_ids())
+        workers_[id].analyzer = idx_.make_analyzer();
+}
+
+std::vector<snippet>
+snippet_generator::generate(const corpus::document& query,
+                            const std::vector<doc_id>& docs)
+{
+    query_weights_.clear();
+    auto num_docs = static_cast<double>(idx_.num_docs());
+    for (const auto& count : idx_.tokenize(query))
+    {
+        if (analyzers::filters::stages::has_sentence_tag(count.key()))
+            continue;
+
+        auto df = idx_.doc_freq(idx_.get_term_id(count.key()));
+        if (df > 0)
+            query_weights_[count.key()] = std::log(1.0 + num_docs / df);
+    }
+
+    std::vector<snippet> results(docs.size());
+    if (docs.empty())
+        return results;
+
+    for (auto& w : workers_)
+        w.second.word_weights.clear();
+
+    auto range = util::range<uint64_t>(0, docs.size() - 1);
+    parallel::parallel_for(
+        range.begin(), range.end(), pool_, [&](uint64_t i)
+        {
+            auto& w = workers_.at(std::this_thread::get_id());
+            results[i] = make_snippet(docs[i], w);
+        });
+    return results;
+}
+
+double snippet_generator::weight(util::string_view word, worker& w) const
+{
+    auto key = word.to_string();
+    auto it = w.word_weights.find(key);
+    if (it != w.word_weights.end())
+        return it->second;
+
+    corpus::document doc;
+    doc.content(key);
+
+    double best = 0;
+    for (const auto& count : w.analyzer->analyze<uint64_t>(doc))
+    {
+        auto qit = query_weights_.find(count.key());
+        if (qit != query_weights_.end())
+            best = std::max(best, qit->second);
+    }
+    w.word_weights.emplace(std::move(key), best);
+    return best;
+}
+
+snippet snippet_generator::make_snippet(doc_id d_id, worker& w) const
+{
+    snippet result;
+    result.d_id = d_id;
+
+    // the text is read directly from the metadata file
+    auto mdata = idx_.metadata(d_id);
+    auto text = mdata.get_view(options_.field);
+    if (!text)
+        return result;
+
+    std::vector<word_span> words;
+    for (uint64_t i = 0; i < text->size();)
+    {
+        if (!is_word_byte((*text)[i]))
+        {
+            ++i;
+            continue;
+        }
+
+        auto start = i;
+        while (i < text->size() && is_word_byte((*text)[i]))
+            ++i;
+        words.push_back(
+            {start, i, weight(text->substr(start, i - start), w)});
+    }
+
+    if (words.empty() || options_.window == 0)
+        return result;
+
+    // score every window of words with a prefix sum over the weights
+    auto window = std::min<uint64_t>(options_.window, words.size());
+    std::vector<double> prefix(words.size() + 1, 0.0);
+    for (uint64_t i = 0; i < words.size(); ++i)
+        prefix[i + 1] = prefix[i] + words[i].weight;
+
+    // greedily take the best windows that don't overlap any taken so far
+    std::vector<uint64_t> starts;
+    for (uint64_t f = 0; f < options_.max_fragments; ++f)
+    {
+        double best_score = 0;
+        uint64_t best_start = words.size();
+        for (uint64_t s = 0; s + window <= words.size(); ++s)
+        {
+            auto overlaps = std::any_of(starts.begin(), starts.end(),
+                                        [&](uint64_t taken)
+                                        {
+                                            return s < taken + window
+                                                   && taken < s + window;
+                                        });
+            auto score = prefix[s + window] - prefix[s];
+            if (!overlaps && score > best_score)
+            {
+                best_score = score;
+                best_start = s;
+            }
+        }
+
+        if (best_start == words.size())
+            break;
+        starts.push_back(best_start);
+    }
+
+    // without any matches, the beginning of the document is used
+    if (starts.empty())
+        starts.push_back(0);
+    std::sort(starts.begin(), starts.end());
+
+    for (const auto& start : starts)
+    {
+        std::string fragment;
+        for (uint64_t i = start; i < start + window; ++i)
+        {
+            if (i > start)
+            {
+                auto gap = text->substr(words[i - 1].end,
+                                        words[i].begin - words[i - 1].end);
+                fragment.append(gap.data(), gap.size());
+            }
+
+            auto word = text->substr(words[i].begin,
+                                     words[i].end - words[i].begin);
+            if (words[i].weight > 0)
+                fragment += options_.open_tag;
+            fragment.append(word.data(), word.size());
+            if (words[i].weight > 0)
+                fragment += options_.close_tag;
+        }
+        result.fragments.push_back(std::move(fragment));
+    }
+
+    return result;
+}
+}
+}
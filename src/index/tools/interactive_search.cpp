@@ -11,9 +11,13 @@
 #include "meta/corpus/document.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/server/query_server.h"
+#include "meta/index/signature_index.h"
+#include "meta/index/snippet_generator.h"
 #include "meta/parser/analyzers/tree_analyzer.h"
 #include "meta/sequence/analyzers/ngram_pos_analyzer.h"
 #include "meta/util/printing.h"
+#include "meta/util/shim.h"
 #include "meta/util/time.h"
 
 using namespace meta;
@@ -23,12 +27,23 @@ using namespace meta;
  */
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    bool server_mode = argc > 2 && argv[2] == std::string{"--server"};
+    if (argc < 2 || argc > 4 || (argc > 2 && !server_mode))
     {
-        std::cerr << "Usage:\t" << argv[0] << " configFile" << std::endl;
+        std::cerr << "Usage:\t" << argv[0] << " configFile [--server [socket]]"
+                  << std::endl;
+        std::cerr << "\t--server reads JSON requests, one per line, from "
+                     "stdin (or from connections to a Unix domain socket) "
+                     "and writes JSON responses"
+                  << std::endl;
         return 1;
     }
 
+    // Without this, std::cin never reports the requests that are already
+    // waiting, and the server could not batch them.
+    if (server_mode)
+        std::ios_base::sync_with_stdio(false);
+
     // Turn on logging to std::cerr.
     logging::set_cerr_logging();
 
@@ -40,15 +55,40 @@ int main(int argc, char* argv[])
     auto config = cpptoml::parse_file(argv[1]);
     auto idx = index::make_index<index::inverted_index>(*config);
 
+    if (server_mode)
+    {
+        index::query_server server{idx, *config};
+        if (argc == 4)
+            server.serve_socket(argv[3]);
+        else
+            server.serve(std::cin, std::cout);
+        server.latencies().print(std::cerr);
+        return 0;
+    }
+
     // Create a ranking class based on the config file.
     auto group = config->get_table("ranker");
     if (!group)
         throw std::runtime_error{"\"ranker\" group needed in config file!"};
     auto ranker = index::make_ranker(*group);
 
-    // Find the path prefix to each document so we can print out the contents.
-    std::string prefix = *config->get_as<std::string>("prefix") + "/"
-                         + *config->get_as<std::string>("dataset") + "/";
+    // Collapse near-duplicate results if the index has signatures and
+    // collapsing was requested.
+    std::unique_ptr<index::signature_index> sigs;
+    double threshold = 0;
+    auto sig_cfg = config->get_table("signatures");
+    if (sig_cfg && sig_cfg->get_as<bool>("collapse").value_or(false))
+    {
+        sigs = make_unique<index::signature_index>(*idx);
+        threshold = sig_cfg->get_as<double>("threshold").value_or(0.8);
+    }
+
+    // Show the passages of each result that best match the query, with the
+    // matching words in bold.
+    index::snippet_options options;
+    options.open_tag = "\033[1m";
+    options.close_tag = "\033[22m";
+    index::snippet_generator snippets{*idx, options};
 
     std::cout << "Enter a query, or blank to quit." << std::endl << std::endl;
 
@@ -66,30 +106,42 @@ int main(int argc, char* argv[])
 
         // Use the ranker to score the query over the index.
         std::vector<index::search_result> ranking;
-        auto time = common::time([&]()
-                                 {
-                                     ranking = ranker->score(*idx, query, 5);
-                                 });
+        auto time = common::time(
+            [&]()
+            {
+                if (!sigs)
+                {
+                    ranking = ranker->score(*idx, query, 5);
+                    return;
+                }
+
+                // look further down the ranking to make up for the
+                // duplicates that are removed
+                ranking = ranker->score(*idx, query, 50);
+                ranking = index::collapse_duplicates(*sigs, ranking,
+                                                     threshold, 5);
+            });
 
         std::cout << "Showing top 5 results (" << time.count() << "ms)"
                   << std::endl;
 
+        auto results = snippets.generate(query, ranking.begin(), ranking.end());
+
         uint64_t result_num = 1;
-        for (auto& result : ranking)
+        for (uint64_t i = 0; i < ranking.size(); ++i)
         {
+            const auto& result = ranking[i];
             std::string path{idx->doc_path(result.d_id)};
             auto output
                 = printing::make_bold(std::to_string(result_num) + ". " + path)
                   + " (score = " + std::to_string(result.score) + ", docid = "
                   + std::to_string(result.d_id) + ")";
             std::cout << output << std::endl;
-            auto mdata = idx->metadata(result.d_id);
-            if (auto content = mdata.get<std::string>("content"))
+            if (!results[i].fragments.empty())
             {
-                auto len
-                    = std::min(std::string::size_type{77}, content->size());
-                std::cout << content->substr(0, len) << "..." << std::endl
-                          << std::endl;
+                for (const auto& fragment : results[i].fragments)
+                    std::cout << "... " << fragment << " ";
+                std::cout << "..." << std::endl << std::endl;
             }
             if (result_num++ == 5)
                 break;
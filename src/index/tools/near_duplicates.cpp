@@ -0,0 +1,89 @@
+/**
+ * @file near_duplicates.cpp
+ */
+
+#include <iostream>
+
+#include "cpptoml.h"
+#include "meta/index/inverted_index.h"
+#include "meta/index/signature_index.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+/**
+ * Finds clusters of near-duplicate documents in an index using the
+ * signatures computed when it was created. Each cluster is printed on its
+ * own line as the tab-separated names of its documents.
+ *
+ * Optional config parameters, in addition to those of
+ * index::make_signature_options:
+ * ~~~toml
+ * [signatures]
+ * threshold = 0.8 # the minimum similarity of a duplicate pair
+ * threads = 8     # default is the hardware concurrency
+ * ~~~
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage:\t" << argv[0] << " configFile" << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+    auto sig_cfg = config->get_table("signatures");
+    if (!sig_cfg)
+    {
+        std::cerr << "\"signatures\" group needed in config file!"
+                  << std::endl;
+        return 1;
+    }
+
+    auto threshold = sig_cfg->get_as<double>("threshold").value_or(0.8);
+    auto threads = static_cast<unsigned>(
+        sig_cfg->get_as<int64_t>("threads").value_or(
+            std::thread::hardware_concurrency()));
+
+    auto idx = index::make_index<index::inverted_index>(*config);
+    if (!index::signature_index::exists(*idx))
+    {
+        std::cerr << "The index has no signatures; delete it and recreate "
+                     "it with the \"signatures\" group in the config file"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<doc_id>> clusters;
+    auto time = common::time([&]()
+                             {
+                                 index::signature_index sigs{*idx};
+                                 clusters = sigs.clusters(threshold, threads);
+                             });
+
+    uint64_t duplicates = 0;
+    for (const auto& cluster : clusters)
+    {
+        for (uint64_t i = 0; i < cluster.size(); ++i)
+        {
+            if (i > 0)
+                std::cout << '\t';
+            std::cout << idx->doc_name(cluster[i]);
+        }
+        std::cout << '\n';
+        duplicates += cluster.size() - 1;
+    }
+
+    LOG(info) << "Found " << clusters.size() << " clusters with "
+              << duplicates << " near-duplicate documents (" << time.count()
+              << "ms)" << ENDLG;
+}
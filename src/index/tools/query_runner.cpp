@@ -16,6 +16,7 @@
 #include "meta/index/inverted_index.h"
 #include "meta/index/eval/ir_eval.h"
 #include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/snippet_generator.h"
 #include "meta/parser/analyzers/tree_analyzer.h"
 #include "meta/sequence/analyzers/ngram_pos_analyzer.h"
 #include "meta/index/score_data.h"
@@ -31,16 +32,16 @@ std::vector < std::vector <std::string> > vec_dict, query_dict;
 std::unordered_map <std::string, int> pointer_dict;
 
 template <class Index, class SearchResult>
-void print_results(const Index& idx, const SearchResult& result, uint64_t result_num)
+void print_results(const Index& idx, const SearchResult& result, uint64_t result_num, const index::snippet& snip)
 {
 	std::string path{idx->doc_path(result.d_id)};
 	auto output = printing::make_bold(std::to_string(result_num) + ". " + path) + " (score = " + std::to_string(result.score) + ", docid = " + std::to_string(result.d_id) + ")";
 	std::cout << output << std::endl;
-	auto mdata = idx->metadata(result.d_id);
-	if (auto content = mdata.template get<std::string>("content"))
+	if (!snip.fragments.empty())
 	{
-		auto len = std::min(std::string::size_type{77}, content->size());
-		std::cout << content->substr(0, len) << "..." << std::endl << std::endl;
+		for (const auto& fragment : snip.fragments)
+			std::cout << "... " << fragment << " ";
+		std::cout << "..." << std::endl << std::endl;
 	}
 }
 
@@ -786,6 +787,7 @@ void dirichlet_tune(const std::shared_ptr<index::dblru_inverted_index> & idx, st
 	std::ofstream outfile;
 	double maxmap = 0;
 	double mumax = 0.0;
+	index::snippet_generator snippets{*idx};
 
 	for (auto & mu : muvalues)
 	{
@@ -794,13 +796,10 @@ void dirichlet_tune(const std::shared_ptr<index::dblru_inverted_index> & idx, st
 		for (std::vector<corpus::document>::iterator query = allqueries.begin(); query != allqueries.end(); ++query)
 		{
 			auto ranking = ranker->score(*idx, *query, 10);
-			// std::cout << "Results for query " << (*query).id() << std::endl;
-			// auto result_num = 1;
-			// for (auto& result : ranking)
-			// {
-			// 	print_results(idx, result, result_num);
-			// 	result_num++;
-			// }
+			std::cout << "Results for query " << (*query).id() << std::endl;
+			auto results = snippets.generate(*query, ranking.begin(), ranking.end());
+			for (uint64_t j = 0; j < ranking.size(); ++j)
+				print_results(idx, ranking[j], j + 1, results[j]);
 			eval.avg_p(ranking,(*query).id(),10);
 			mean_ndcg += eval.ndcg(ranking,(*query).id(),10);
 			// eval.print_stats(ranking, (*query).id());
@@ -0,0 +1,121 @@
+/**
+ * @file rank_features.cpp
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "cpptoml.h"
+#include "meta/corpus/document.h"
+#include "meta/index/eval/ir_eval.h"
+#include "meta/index/ranker/cascade_ranker.h"
+#include "meta/index/ranker/ranker_factory.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+
+using namespace meta;
+
+/**
+ * Writes training data for a cascade_ranker's model. Each query in the
+ * query file is scored with the first-stage ranker (the [ranker] group),
+ * and every candidate is written as one line of libsvm data: its judged
+ * relevance to the query (zero if unjudged), optionally the query's id,
+ * and its ranking_features.
+ *
+ * Required config parameters:
+ * ~~~toml
+ * [query-runner]
+ * query-judgements = "qrels.txt"
+ * query-path = "queries.txt" # one query per line
+ *
+ * [ranker]
+ * method = "bm25"
+ * ~~~
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [query-runner]
+ * query-id-start = 1 # the id of the first query (default is 1)
+ *
+ * [cascade]
+ * candidates = 100 # the number of candidates per query
+ * qid = true       # write "qid:N" on each line, as for SVMrank or RankLib
+ * priors = []      # see make_ranking_features
+ * ~~~
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage:\t" << argv[0] << " config.toml output-file"
+                  << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+
+    auto group = config->get_table("ranker");
+    if (!group)
+        throw std::runtime_error{"\"ranker\" group needed in config file!"};
+
+    auto run_group = config->get_table("query-runner");
+    if (!run_group)
+        throw std::runtime_error{"\"query-runner\" group needed in config"};
+
+    auto query_path = run_group->get_as<std::string>("query-path");
+    if (!query_path)
+        throw std::runtime_error{"config file needs a \"query-path\""};
+
+    auto cascade_cfg = config->get_table("cascade");
+    if (!cascade_cfg)
+        cascade_cfg = cpptoml::make_table();
+
+    auto num_candidates = static_cast<uint64_t>(
+        cascade_cfg->get_as<int64_t>("candidates").value_or(100));
+    auto write_qid = cascade_cfg->get_as<bool>("qid").value_or(true);
+    auto start = run_group->get_as<int64_t>("query-id-start").value_or(1);
+
+    auto idx = index::make_index<index::inverted_index>(*config);
+    auto fwd = index::make_index<index::forward_index>(*config);
+    auto first_stage = index::make_ranker(*group);
+    auto features = index::make_ranking_features(*idx, *fwd, *cascade_cfg);
+    index::ir_eval eval{*run_group};
+
+    auto names = features.names();
+    for (uint64_t i = 0; i < names.size(); ++i)
+        LOG(info) << "Feature " << (i + 1) << ": " << names[i] << ENDLG;
+
+    std::ifstream queries{*query_path};
+    std::ofstream output{argv[2]};
+    auto q_id = static_cast<uint64_t>(start);
+    uint64_t lines = 0;
+    std::string content;
+    while (std::getline(queries, content))
+    {
+        corpus::document query;
+        query.content(content);
+
+        auto candidates = first_stage->score(*idx, query, num_candidates);
+        auto feats = features.compute(query, candidates);
+        for (uint64_t i = 0; i < candidates.size(); ++i)
+        {
+            output << eval.relevance(query_id{q_id}, candidates[i].d_id);
+            if (write_qid)
+                output << " qid:" << q_id;
+            learn::print_liblinear(output, feats[i]);
+            output << '\n';
+        }
+
+        lines += candidates.size();
+        ++q_id;
+    }
+
+    LOG(info) << "Wrote " << lines << " candidates for "
+              << (q_id - static_cast<uint64_t>(start)) << " queries" << ENDLG;
+}
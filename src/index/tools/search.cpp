@@ -11,6 +11,7 @@
 #include "meta/corpus/document.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/snippet_generator.h"
 #include "meta/parser/analyzers/tree_analyzer.h"
 #include "meta/sequence/analyzers/ngram_pos_analyzer.h"
 #include "meta/util/time.h"
@@ -49,6 +50,10 @@ int main(int argc, char* argv[])
         throw std::runtime_error{"\"ranker\" group needed in config file!"};
     auto ranker = index::make_ranker(*group);
 
+    // Show the passages of each result that best match the query, if the
+    //  index stores the documents' content.
+    index::snippet_generator snippets{*idx};
+
     // Use UTF-8 for the default encoding unless otherwise specified.
     auto encoding = config->get_as<std::string>("encoding").value_or("utf-8");
 
@@ -82,12 +87,19 @@ int main(int argc, char* argv[])
                 auto ranking = ranker->score(*idx, query);
                 std::cout << "Showing top 10 results." << std::endl;
 
+                auto results
+                    = snippets.generate(query, ranking.begin(), ranking.end());
+
                 uint64_t result_num = 1;
-                for (auto& result : ranking)
+                for (uint64_t j = 0; j < ranking.size(); ++j)
                 {
+                    const auto& result = ranking[j];
                     std::cout << result_num << ". "
                               << idx->doc_name(result.d_id) << " "
                               << result.score << std::endl;
+                    for (const auto& fragment : results[j].fragments)
+                        std::cout << "    ... " << fragment << " ..."
+                                  << std::endl;
                     if (result_num++ == 10)
                         break;
                 }
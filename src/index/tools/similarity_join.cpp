@@ -0,0 +1,88 @@
+/**
+ * @file similarity_join.cpp
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "cpptoml.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/similarity_join.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+/**
+ * Finds the pairs of similar documents in an index and writes them as a
+ * sparse similarity graph: one edge per line, as the tab-separated ids of
+ * the two documents and their cosine similarity. Without a top-k, each
+ * pair is written once (smaller id first); with one, each document's
+ * edges to its nearest neighbors are written.
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [similarity-join]
+ * threshold = 0.5 # the minimum cosine similarity of a pair
+ * top-k = 10      # the most neighbors per document (default is all)
+ * threads = 8     # default is the hardware concurrency
+ * ~~~
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage:\t" << argv[0] << " config.toml output-file"
+                  << std::endl;
+        return 1;
+    }
+
+    logging::set_cerr_logging();
+
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+
+    index::similarity_join_options options;
+    if (auto join_cfg = config->get_table("similarity-join"))
+    {
+        options.threshold = join_cfg->get_as<double>("threshold")
+                                .value_or(options.threshold);
+        options.top_k = static_cast<uint64_t>(
+            join_cfg->get_as<int64_t>("top-k").value_or(0));
+        options.num_threads = static_cast<unsigned>(
+            join_cfg->get_as<int64_t>("threads")
+                .value_or(options.num_threads));
+    }
+
+    auto fwd = index::make_index<index::forward_index>(*config);
+
+    index::similarity_lists lists;
+    auto time = common::time([&]()
+                             {
+                                 lists = index::all_pairs_similarity(*fwd,
+                                                                     options);
+                             });
+
+    uint64_t edges = 0;
+    {
+        std::ofstream output{argv[2]};
+        for (doc_id d_id{0}; d_id < lists.size(); ++d_id)
+        {
+            for (const auto& neighbor : lists[d_id])
+            {
+                if (options.top_k == 0 && neighbor.first < d_id)
+                    continue;
+                output << d_id << '\t' << neighbor.first << '\t'
+                       << neighbor.second << '\n';
+                ++edges;
+            }
+        }
+    }
+
+    LOG(info) << "Found " << edges << " similar pairs (" << time.count()
+              << "ms)" << ENDLG;
+}
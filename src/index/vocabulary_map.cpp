@@ -89,5 +89,17 @@ uint64_t vocabulary_map::size() const
 {
     return inverse_.size();
 }
+
+void vocabulary_map::advise(io::mmap_advice advice) const
+{
+    file_.advise(advice);
+    inverse_.advise(advice);
+}
+
+void vocabulary_map::prefault(unsigned num_threads) const
+{
+    file_.prefault(num_threads);
+    inverse_.prefault(num_threads);
+}
 }
 }
@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "meta/io/libsvm_parser.h"
@@ -90,6 +91,186 @@ counts_t counts(const std::string& text, bool contains_label /* = true */)
 
     return counts;
 }
+
+namespace
+{
+bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Fallback for values the fast path can't handle exactly (very long
+ * mantissas, large exponents, hex floats, inf/nan, ...).
+ */
+const char* parse_double_slow(const char* begin, const char* end,
+                              double& value)
+{
+    auto token_end = begin;
+    while (token_end != end && !is_space(*token_end))
+        ++token_end;
+
+    // strtod requires a null-terminated string, and the input may be the
+    // tail of a memory-mapped file
+    char buffer[64];
+    auto length = static_cast<std::size_t>(token_end - begin);
+    if (length >= sizeof(buffer))
+    {
+        std::string token{begin, token_end};
+        char* parsed = nullptr;
+        value = std::strtod(token.c_str(), &parsed);
+        return begin + (parsed - token.c_str());
+    }
+
+    std::copy(begin, token_end, buffer);
+    buffer[length] = '\0';
+    char* parsed = nullptr;
+    value = std::strtod(buffer, &parsed);
+    return begin + (parsed - buffer);
+}
+
+/**
+ * Parses a decimal floating point number. Values with at most 15
+ * significant digits and a small decimal exponent are computed exactly
+ * with a single multiplication or division (Clinger's fast path), which
+ * covers nearly all feature values in practice.
+ *
+ * @return one past the last character consumed
+ */
+const char* parse_double(const char* begin, const char* end, double& value)
+{
+    static constexpr double powers[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    auto pos = begin;
+    bool negative = false;
+    if (pos != end && (*pos == '-' || *pos == '+'))
+        negative = *pos++ == '-';
+
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    int digits = 0;
+    bool any_digits = false;
+    for (; pos != end && is_digit(*pos); ++pos)
+    {
+        any_digits = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*pos - '0');
+            digits += mantissa != 0;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if (pos != end && *pos == '.')
+    {
+        for (++pos; pos != end && is_digit(*pos); ++pos)
+        {
+            any_digits = true;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*pos - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+
+    if (!any_digits)
+        return parse_double_slow(begin, end, value);
+
+    if (pos != end && (*pos == 'e' || *pos == 'E'))
+    {
+        auto exp_pos = pos + 1;
+        bool exp_negative = false;
+        if (exp_pos != end && (*exp_pos == '-' || *exp_pos == '+'))
+            exp_negative = *exp_pos++ == '-';
+
+        if (exp_pos != end && is_digit(*exp_pos))
+        {
+            int64_t exp = 0;
+            for (; exp_pos != end && is_digit(*exp_pos); ++exp_pos)
+            {
+                if (exp < 100000)
+                    exp = exp * 10 + (*exp_pos - '0');
+            }
+            exponent += exp_negative ? -exp : exp;
+            pos = exp_pos;
+        }
+    }
+
+    if (digits > 15 || exponent < -22 || exponent > 22
+        || (pos != end && !is_space(*pos)))
+        return parse_double_slow(begin, end, value);
+
+    auto result = static_cast<double>(mantissa);
+    if (exponent < 0)
+        result /= powers[-exponent];
+    else
+        result *= powers[exponent];
+    value = negative ? -result : result;
+    return pos;
+}
+}
+
+util::string_view parse(util::string_view line,
+                        std::vector<std::pair<term_id, double>>& counts)
+{
+    counts.clear();
+
+    auto pos = line.data();
+    auto end = pos + line.size();
+
+    auto label_end = pos;
+    while (label_end != end && !is_space(*label_end))
+        ++label_end;
+
+    if (label_end == pos || label_end == end)
+        throw_exception(line.to_string());
+
+    util::string_view label{pos, static_cast<std::size_t>(label_end - pos)};
+    pos = label_end;
+
+    while (true)
+    {
+        while (pos != end && is_space(*pos))
+            ++pos;
+        if (pos == end)
+            break;
+
+        auto token = pos;
+        uint64_t term = 0;
+        for (; pos != end && is_digit(*pos); ++pos)
+            term = term * 10 + static_cast<uint64_t>(*pos - '0');
+
+        if (pos == token || pos == end || *pos != ':')
+            throw_exception("no colon in token: " + line.to_string());
+
+        ++pos;
+        double count;
+        auto value_end = parse_double(pos, end, count);
+        if (value_end == pos || (value_end != end && !is_space(*value_end)))
+            throw_exception("full token not consumed: " + line.to_string());
+        pos = value_end;
+
+        if (term == 0)
+            throw libsvm_parser_exception{"term id was 0 from libsvm format"};
+
+        // liblinear has term_ids start at 1 instead of 0 like MeTA and libsvm
+        counts.emplace_back(term_id{term - 1}, count);
+    }
+
+    return label;
+}
 }
 }
 }
@@ -13,14 +13,103 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <future>
+#include <vector>
+
 #include "meta/io/filesystem.h"
 #include "meta/io/mmap_file.h"
+#include "meta/parallel/thread_pool.h"
 
 namespace meta
 {
 namespace io
 {
 
+void advise(const void* start, uint64_t length, mmap_advice advice)
+{
+#ifndef _WIN32
+    if (!start || length == 0)
+        return;
+
+    int flag = MADV_NORMAL;
+    switch (advice)
+    {
+        case mmap_advice::normal:
+            flag = MADV_NORMAL;
+            break;
+        case mmap_advice::sequential:
+            flag = MADV_SEQUENTIAL;
+            break;
+        case mmap_advice::random:
+            flag = MADV_RANDOM;
+            break;
+        case mmap_advice::will_need:
+            flag = MADV_WILLNEED;
+            break;
+        case mmap_advice::huge_pages:
+#ifdef MADV_HUGEPAGE
+            flag = MADV_HUGEPAGE;
+            break;
+#else
+            return;
+#endif
+    }
+
+    // failure here is harmless: the kernel just won't use the hint
+    madvise(const_cast<void*>(start), length, flag);
+#else
+    (void)start;
+    (void)length;
+    (void)advice;
+#endif
+}
+
+void prefault(const void* start, uint64_t length, unsigned num_threads)
+{
+    if (!start || length == 0)
+        return;
+
+#ifndef _WIN32
+    auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+    uint64_t page_size = 4096;
+#endif
+    auto num_pages = (length + page_size - 1) / page_size;
+    num_threads = static_cast<unsigned>(
+        std::max<uint64_t>(1, std::min<uint64_t>(num_threads, num_pages)));
+
+    auto bytes = static_cast<const volatile char*>(start);
+    auto touch = [=](uint64_t first, uint64_t last)
+    {
+        char sum = 0;
+        for (auto page = first; page < last; ++page)
+            sum ^= bytes[page * page_size];
+        return sum;
+    };
+
+    if (num_threads == 1)
+    {
+        touch(0, num_pages);
+        return;
+    }
+
+    parallel::thread_pool pool{num_threads};
+    std::vector<std::future<char>> futures;
+    futures.reserve(num_threads);
+    auto block_size = num_pages / num_threads;
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        auto first = i * block_size;
+        auto last = i + 1 == num_threads ? num_pages : first + block_size;
+        futures.emplace_back(
+            pool.submit_task([=]() { return touch(first, last); }));
+    }
+
+    for (auto& fut : futures)
+        fut.get();
+}
+
 mmap_file::mmap_file(const std::string& path)
     : path_{path}, start_{nullptr}, size_{filesystem::file_size(path)}
 {
@@ -60,6 +149,16 @@ char* mmap_file::begin() const
     return start_;
 }
 
+void mmap_file::advise(mmap_advice advice) const
+{
+    io::advise(start_, size_, advice);
+}
+
+void mmap_file::prefault(unsigned num_threads) const
+{
+    io::prefault(start_, size_, num_threads);
+}
+
 mmap_file& mmap_file::operator=(mmap_file&& other)
 {
     if (this != &other)
@@ -0,0 +1,717 @@
+/**
+ * @file analyzer_bench.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cpptoml.h"
+#include "meta/analyzers/all.h"
+#include "meta/analyzers/analyzer_factory.h"
+#include "meta/analyzers/filters/all.h"
+#include "meta/analyzers/token_arena.h"
+#include "meta/analyzers/token_stream.h"
+#include "meta/analyzers/tokenizers/icu_tokenizer.h"
+#include "meta/analyzers/tokenizers/whitespace_tokenizer.h"
+#include "meta/corpus/corpus.h"
+#include "meta/corpus/corpus_factory.h"
+#include "meta/corpus/document.h"
+#include "meta/logging/logger.h"
+#include "meta/parser/analyzers/tree_analyzer.h"
+#include "meta/sequence/analyzers/ngram_pos_analyzer.h"
+#include "meta/util/clonable.h"
+#include "meta/util/shim.h"
+
+using namespace meta;
+
+namespace
+{
+/// The number of allocations made by the program so far
+std::atomic<uint64_t> num_allocations{0};
+}
+
+// every allocation goes through these, so that the allocations made while
+// analyzing can be counted
+void* operator new(std::size_t size)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+using bench_clock = std::chrono::steady_clock;
+
+/**
+ * @param duration A length of time
+ * @return the length of time in seconds
+ */
+double seconds(bench_clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+/**
+ * The time spent in one stage of a filter chain (and every stage before
+ * it), and the number of tokens the stage produced.
+ */
+struct stage_stats
+{
+    /// The tokenizer or filter's id
+    std::string name;
+    /// The time spent reading from the stage
+    bench_clock::duration time{0};
+    /// The number of tokens read from the stage
+    uint64_t tokens = 0;
+};
+
+/**
+ * Wraps a stage of a dynamic filter chain and records how long each call
+ * into it takes. Since the stage calls into the stages before it, its time
+ * includes theirs, and the time of the stage alone is the difference from
+ * the time of the stage before it.
+ */
+class timed_stream
+    : public util::clonable<analyzers::token_stream, timed_stream>
+{
+  public:
+    /**
+     * @param source The stage to time
+     * @param stats Where to record the stage's time and tokens
+     */
+    timed_stream(std::unique_ptr<analyzers::token_stream> source,
+                 stage_stats& stats)
+        : source_{std::move(source)}, stats_{&stats}
+    {
+        // nothing
+    }
+
+    /**
+     * Copy constructor. The copy records into the same stage_stats.
+     * @param other The timed_stream to copy
+     */
+    timed_stream(const timed_stream& other)
+        : source_{other.source_->clone()}, stats_{other.stats_}
+    {
+        // nothing
+    }
+
+    void set_content(std::string&& content) override
+    {
+        auto start = bench_clock::now();
+        source_->set_content(std::move(content));
+        stats_->time += bench_clock::now() - start;
+    }
+
+    void set_view_content(std::string&& content,
+                          analyzers::token_arena& arena) override
+    {
+        auto start = bench_clock::now();
+        source_->set_view_content(std::move(content), arena);
+        stats_->time += bench_clock::now() - start;
+    }
+
+    std::string next() override
+    {
+        auto start = bench_clock::now();
+        auto tok = source_->next();
+        stats_->time += bench_clock::now() - start;
+        ++stats_->tokens;
+        return tok;
+    }
+
+    util::string_view next_view(analyzers::token_arena& arena) override
+    {
+        auto start = bench_clock::now();
+        auto tok = source_->next_view(arena);
+        stats_->time += bench_clock::now() - start;
+        ++stats_->tokens;
+        return tok;
+    }
+
+    operator bool() const override
+    {
+        return static_cast<bool>(*source_);
+    }
+
+  private:
+    /// The stage being timed
+    std::unique_ptr<analyzers::token_stream> source_;
+
+    /// Where the stage's time and tokens are recorded
+    stage_stats* stats_;
+};
+
+/**
+ * @param stage A stage of a filter chain
+ * @param name The stage's id
+ * @param stats The stats of the chain's stages so far, or nullptr if the
+ * chain isn't being timed
+ * @return the stage, wrapped in a timed_stream if the chain is being timed
+ */
+std::unique_ptr<analyzers::token_stream>
+timed(std::unique_ptr<analyzers::token_stream> stage, util::string_view name,
+      std::deque<stage_stats>* stats)
+{
+    if (!stats)
+        return stage;
+    stats->emplace_back();
+    stats->back().name = name.to_string();
+    return make_unique<timed_stream>(std::move(stage), stats->back());
+}
+
+/**
+ * Creates a stage of a filter chain.
+ * @param stats The stats of the chain's stages so far, or nullptr if the
+ * chain isn't being timed
+ * @param args The arguments to the stage's constructor
+ * @return the stage, wrapped in a timed_stream if the chain is being timed
+ */
+template <class Stage, class... Args>
+std::unique_ptr<analyzers::token_stream>
+make_stage(std::deque<stage_stats>* stats, Args&&... args)
+{
+    return timed(make_unique<Stage>(std::forward<Args>(args)...), Stage::id,
+                 stats);
+}
+
+/**
+ * @param config The configuration, for the list of stop words
+ * @param unigram Whether to build the chain of default_unigram_chain()
+ * rather than default_filter_chain()
+ * @param stats Where to add the stats of the chain's stages, or nullptr
+ * to not time them
+ * @return the dynamic chain of filters that the fused default chain
+ * stands in for
+ */
+std::unique_ptr<analyzers::token_stream>
+virtual_default_chain(const cpptoml::table& config, bool unigram,
+                      std::deque<stage_stats>* stats)
+{
+    using namespace analyzers;
+    auto stopwords = config.get_as<std::string>("stop-words");
+    if (!stopwords)
+        throw analyzer_exception{"stop-words file needed in config file"};
+
+    auto chain = make_stage<tokenizers::icu_tokenizer>(stats, unigram);
+    chain = make_stage<filters::lowercase_filter>(stats, std::move(chain));
+    chain = make_stage<filters::alpha_filter>(stats, std::move(chain));
+    chain = make_stage<filters::length_filter>(stats, std::move(chain), 2, 35);
+    chain = make_stage<filters::list_filter>(stats, std::move(chain),
+                                             *stopwords);
+    chain = make_stage<filters::porter2_filter>(stats, std::move(chain));
+    if (!unigram)
+        chain = make_stage<filters::empty_sentence_filter>(stats,
+                                                           std::move(chain));
+    return chain;
+}
+
+/**
+ * @param filters The filter groups of an analyzer's configuration
+ * @param stats Where to add the stats of the chain's stages
+ * @return the chain of filters the groups describe, with every stage timed
+ */
+std::unique_ptr<analyzers::token_stream>
+configured_chain(const cpptoml::table_array& filters,
+                 std::deque<stage_stats>& stats)
+{
+    std::unique_ptr<analyzers::token_stream> chain;
+    for (const auto& filter : filters.get())
+    {
+        chain = analyzers::load_filter(std::move(chain), *filter);
+        chain = timed(std::move(chain), *filter->get_as<std::string>("type"),
+                      &stats);
+    }
+    return chain;
+}
+
+/**
+ * The measurements of one benchmark case.
+ */
+struct bench_result
+{
+    /// The name of the case
+    std::string name;
+    /// How the case's filter chain is built: "fused", "virtual", or
+    /// empty if it has none
+    std::string chain;
+    /// The fastest time taken to analyze the documents
+    bench_clock::duration time{bench_clock::duration::max()};
+    /// The number of features in the documents (the sum of their counts)
+    uint64_t features = 0;
+    /// The fewest allocations made while analyzing the documents
+    uint64_t allocations = std::numeric_limits<uint64_t>::max();
+    /// The stats of each stage of the chain, from the fastest run of the
+    /// timed chain, if it was timed
+    std::vector<stage_stats> stages;
+};
+
+/**
+ * The documents to analyze, and the options for running the cases.
+ */
+struct bench_corpus
+{
+    /// The documents
+    std::vector<corpus::document> docs;
+    /// The total size of the documents' content, in utf8
+    uint64_t bytes = 0;
+    /// The number of times to analyze the documents in each case
+    uint64_t repeats = 3;
+};
+
+/**
+ * Analyzes the documents with an analyzer, keeping the fastest of the
+ * repeated runs.
+ * @param ana The analyzer to measure
+ * @param corp The documents to analyze
+ * @param result Where to record the measurements
+ */
+void measure(analyzers::analyzer& ana, const bench_corpus& corp,
+             bench_result& result)
+{
+    // the map is reused for every document, as the indexers do, so that
+    // what's measured is the analyzer and not the map's allocations
+    analyzers::feature_map<uint64_t> counts;
+    for (uint64_t rep = 0; rep < corp.repeats; ++rep)
+    {
+        bench_clock::duration time{0};
+        uint64_t allocations = 0;
+        uint64_t features = 0;
+        for (const auto& doc : corp.docs)
+        {
+            counts.reset();
+            auto allocs = num_allocations.load(std::memory_order_relaxed);
+            auto start = bench_clock::now();
+            ana.analyze(doc, counts);
+            time += bench_clock::now() - start;
+            allocations += num_allocations.load(std::memory_order_relaxed)
+                           - allocs;
+
+            for (const auto& count : counts)
+                features += count.value();
+        }
+        result.time = std::min(result.time, time);
+        result.allocations = std::min(result.allocations, allocations);
+        result.features = features;
+    }
+}
+
+/**
+ * Reads the documents through a chain whose stages are timed, keeping
+ * the stats of the fastest of the repeated runs.
+ * @param chain The timed chain
+ * @param stats The stats the chain's stages record into
+ * @param corp The documents to read
+ * @param result Where to record the stages' stats
+ */
+void measure_stages(analyzers::token_stream& chain,
+                    std::deque<stage_stats>& stats, const bench_corpus& corp,
+                    bench_result& result)
+{
+    if (stats.empty())
+        return;
+
+    analyzers::token_arena arena;
+    for (uint64_t rep = 0; rep < corp.repeats; ++rep)
+    {
+        for (auto& stage : stats)
+        {
+            stage.time = bench_clock::duration{0};
+            stage.tokens = 0;
+        }
+
+        for (const auto& doc : corp.docs)
+        {
+            arena.clear();
+            chain.set_view_content(analyzers::get_content(doc), arena);
+            while (chain)
+                chain.next_view(arena);
+        }
+
+        if (result.stages.empty()
+            || stats.back().time < result.stages.back().time)
+            result.stages.assign(stats.begin(), stats.end());
+    }
+}
+
+/**
+ * @param os The stream to write to
+ * @param str The string to write as a JSON string
+ */
+void write_string(std::ostream& os, util::string_view str)
+{
+    os << '"';
+    for (const auto& c : str)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+/**
+ * Writes the measurements of a case as one line of JSON.
+ * @param os The stream to write to
+ * @param result The measurements
+ * @param corp The documents that were analyzed
+ */
+void write_result(std::ostream& os, const bench_result& result,
+                  const bench_corpus& corp)
+{
+    auto secs = seconds(result.time);
+    auto docs = static_cast<double>(corp.docs.size());
+    auto features = static_cast<double>(std::max<uint64_t>(result.features,
+                                                           1));
+    os << "{\"name\": ";
+    write_string(os, result.name);
+    os << ", \"chain\": ";
+    write_string(os, result.chain);
+    os << ", \"docs\": " << corp.docs.size() << ", \"bytes\": " << corp.bytes
+       << ", \"seconds\": " << secs << ", \"docs_per_s\": " << docs / secs
+       << ", \"mb_per_s\": " << corp.bytes / secs / (1024 * 1024)
+       << ", \"features\": " << result.features
+       << ", \"features_per_s\": " << result.features / secs
+       << ", \"allocs_per_doc\": " << result.allocations / docs
+       << ", \"allocs_per_feature\": " << result.allocations / features
+       << ", \"stages\": [";
+
+    bench_clock::duration before{0};
+    for (std::size_t i = 0; i < result.stages.size(); ++i)
+    {
+        const auto& stage = result.stages[i];
+        auto self = seconds(stage.time - before);
+        before = stage.time;
+        if (i > 0)
+            os << ", ";
+        os << "{\"name\": ";
+        write_string(os, stage.name);
+        os << ", \"tokens\": " << stage.tokens
+           << ", \"seconds\": " << seconds(stage.time)
+           << ", \"self_seconds\": " << self << "}";
+    }
+    os << "]}" << std::endl;
+}
+
+/**
+ * Runs a case, writing its measurements to stdout.
+ * @param name The name of the case
+ * @param chain How the case's filter chain is built
+ * @param ana The analyzer to measure
+ * @param corp The documents to analyze
+ * @param timed_chain A copy of the analyzer's chain with timed stages, if
+ * the stages should be measured
+ * @param stats The stats the timed chain records into
+ */
+void run_case(const std::string& name, const std::string& chain,
+              analyzers::analyzer& ana, const bench_corpus& corp,
+              analyzers::token_stream* timed_chain = nullptr,
+              std::deque<stage_stats>* stats = nullptr)
+{
+    bench_result result;
+    result.name = name;
+    result.chain = chain;
+    measure(ana, corp, result);
+    if (timed_chain)
+        measure_stages(*timed_chain, *stats, corp, result);
+
+    LOG(info) << name << (chain.empty() ? "" : " (" + chain + ")") << ": "
+              << corp.bytes / seconds(result.time) / (1024 * 1024)
+              << " MB/s, " << result.features / seconds(result.time)
+              << " features/s" << ENDLG;
+    write_result(std::cout, result, corp);
+}
+
+/**
+ * @param config The configuration, for the corpus
+ * @param max_docs The most documents to read
+ * @return the first documents of the configured corpus
+ */
+std::vector<corpus::document> read_documents(const cpptoml::table& config,
+                                             uint64_t max_docs)
+{
+    std::vector<corpus::document> docs;
+    auto docs_corpus = corpus::make_corpus(config);
+    while (docs.size() < max_docs && docs_corpus->has_next())
+        docs.push_back(docs_corpus->next());
+    return docs;
+}
+
+/**
+ * Generates documents of English-like text: sentences of made-up words,
+ * whose frequencies follow Zipf's law, with capitalization, punctuation,
+ * and some words that aren't ASCII. The documents are the same in every
+ * run.
+ *
+ * @param num_docs The number of documents to generate
+ * @return the documents
+ */
+std::vector<corpus::document> generate_documents(uint64_t num_docs)
+{
+    // the generator's output is fixed by the standard, but the
+    // distributions' isn't, so they aren't used
+    std::mt19937_64 rng{47};
+    auto uniform = [&](uint64_t n)
+    {
+        return rng() % n;
+    };
+
+    std::vector<std::string> vocab{"na\xC3\xAFve", "caf\xC3\xA9",
+                                   "\xC3\xBC" "ber", "\xE6\x97\xA5\xE6\x9C\xAC",
+                                   "stra\xC3\x9F" "e"};
+    const uint64_t vocab_size = 5000;
+    while (vocab.size() < vocab_size)
+    {
+        std::string word;
+        auto length = 1 + uniform(4) + uniform(6);
+        for (uint64_t i = 0; i < length; ++i)
+            word += static_cast<char>('a' + uniform(26));
+        vocab.push_back(std::move(word));
+    }
+
+    // the word of each rank is drawn with probability proportional to
+    // 1 / rank, through the cumulative weights
+    std::vector<double> cumulative(vocab.size());
+    double total = 0;
+    for (uint64_t rank = 0; rank < vocab.size(); ++rank)
+    {
+        total += 1.0 / (rank + 1);
+        cumulative[rank] = total;
+    }
+
+    std::vector<corpus::document> docs;
+    docs.reserve(num_docs);
+    for (uint64_t id = 0; id < num_docs; ++id)
+    {
+        std::string content;
+        auto num_sentences = 3 + uniform(20);
+        for (uint64_t s = 0; s < num_sentences; ++s)
+        {
+            auto num_words = 4 + uniform(20);
+            for (uint64_t w = 0; w < num_words; ++w)
+            {
+                auto target = total * (rng() >> 11) / (1ull << 53);
+                auto rank = std::lower_bound(cumulative.begin(),
+                                             cumulative.end(), target)
+                            - cumulative.begin();
+                auto word = vocab[std::min<uint64_t>(rank, vocab.size() - 1)];
+                if (w == 0 && word[0] >= 'a' && word[0] <= 'z')
+                    word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                content += word;
+                if (w + 1 < num_words)
+                    content += uniform(10) == 0 ? ", " : " ";
+            }
+            content += ".?!"[uniform(3)];
+            content += uniform(5) == 0 ? "\n\n" : " ";
+        }
+
+        docs.emplace_back(doc_id{id});
+        docs.back().content(content);
+    }
+    return docs;
+}
+
+int print_usage(const std::string& prog)
+{
+    std::cerr << "Usage: " << prog << " config.toml [OPTION]" << std::endl;
+    std::cerr << "where [OPTION] is one or more of:" << std::endl;
+    std::cerr << "\t--docs N\tanalyze the first N documents of the "
+                 "configured corpus (default 1000)"
+              << std::endl;
+    std::cerr << "\t--generate N\tanalyze N generated documents instead of "
+                 "the corpus"
+              << std::endl;
+    std::cerr << "\t--repeat N\tanalyze the documents N times in each case, "
+                 "keeping the fastest (default 3)"
+              << std::endl;
+    std::cerr << "Results are written to stdout as one JSON object per line."
+              << std::endl;
+    return 1;
+}
+
+/**
+ * @param arg The value given for an option
+ * @param value Where to store the count it names
+ * @return whether arg is a count
+ */
+bool parse_count(const std::string& arg, uint64_t& value)
+{
+    if (arg.empty() || !std::all_of(arg.begin(), arg.end(), [](char c)
+                                    {
+                                        return c >= '0' && c <= '9';
+                                    }))
+        return false;
+
+    try
+    {
+        value = std::stoull(arg);
+    }
+    catch (const std::out_of_range&)
+    {
+        return false;
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+        return print_usage(argv[0]);
+
+    logging::set_cerr_logging();
+
+    // the tree and POS analyzers are benchmarked if they are configured
+    parser::register_analyzers();
+    sequence::register_analyzers();
+
+    auto config = cpptoml::parse_file(argv[1]);
+
+    uint64_t max_docs = 1000;
+    uint64_t generate = 0;
+    bench_corpus corp;
+    for (int i = 2; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for option: " << option << std::endl;
+            return print_usage(argv[0]);
+        }
+
+        uint64_t value;
+        if (!parse_count(argv[i + 1], value))
+        {
+            std::cerr << "Invalid value for option " << option << ": "
+                      << argv[i + 1] << std::endl;
+            return print_usage(argv[0]);
+        }
+
+        if (option == "--docs")
+            max_docs = value;
+        else if (option == "--generate")
+            generate = value;
+        else if (option == "--repeat")
+            corp.repeats = std::max<uint64_t>(value, 1);
+        else
+        {
+            std::cerr << "Unknown option: " << option << std::endl;
+            return print_usage(argv[0]);
+        }
+    }
+
+    if (generate > 0)
+        corp.docs = generate_documents(generate);
+    else
+        corp.docs = read_documents(*config, max_docs);
+    for (const auto& doc : corp.docs)
+        corp.bytes += analyzers::get_content(doc).size();
+
+    std::cout << "{\"corpus\": ";
+    write_string(std::cout, generate > 0 ? "generated" : "configured");
+    std::cout << ", \"docs\": " << corp.docs.size()
+              << ", \"bytes\": " << corp.bytes
+              << ", \"repeats\": " << corp.repeats << "}" << std::endl;
+
+    using namespace analyzers;
+
+    // the default chains, both fused and as the dynamic chains of
+    // filters they replace
+    for (const auto& unigram : {true, false})
+    {
+        std::string name = unigram ? "ngram-word-1/default-unigram-chain"
+                                   : "ngram-word-1/default-chain";
+        ngram_word_analyzer fused{1, unigram ? default_unigram_chain(*config)
+                                             : default_filter_chain(*config)};
+        run_case(name, "fused", fused, corp);
+
+        ngram_word_analyzer dynamic{
+            1, virtual_default_chain(*config, unigram, nullptr)};
+        std::deque<stage_stats> stats;
+        auto timed_chain = virtual_default_chain(*config, unigram, &stats);
+        run_case(name, "virtual", dynamic, corp, timed_chain.get(), &stats);
+    }
+
+    // the tokenizers, each followed by only a lowercase_filter
+    {
+        auto icu_chain = [](std::deque<stage_stats>* stats)
+        {
+            auto chain = make_stage<tokenizers::icu_tokenizer>(stats, true);
+            return make_stage<filters::lowercase_filter>(stats,
+                                                         std::move(chain));
+        };
+        ngram_word_analyzer ana{1, icu_chain(nullptr)};
+        std::deque<stage_stats> stats;
+        auto timed_chain = icu_chain(&stats);
+        run_case("ngram-word-1/icu-tokenizer", "virtual", ana, corp,
+                 timed_chain.get(), &stats);
+    }
+    {
+        auto whitespace_chain = [](std::deque<stage_stats>* stats)
+        {
+            auto chain = make_stage<tokenizers::whitespace_tokenizer>(stats);
+            return make_stage<filters::lowercase_filter>(stats,
+                                                         std::move(chain));
+        };
+        ngram_word_analyzer ana{1, whitespace_chain(nullptr)};
+        std::deque<stage_stats> stats;
+        auto timed_chain = whitespace_chain(&stats);
+        run_case("ngram-word-1/whitespace-tokenizer", "virtual", ana, corp,
+                 timed_chain.get(), &stats);
+    }
+
+    {
+        ngram_char_analyzer ana{{3}};
+        run_case("ngram-char-3", "", ana, corp);
+    }
+
+    // every analyzer in the configuration, with the stages of its filter
+    // chain timed if it lists them
+    auto groups = config->get_table_array("analyzers");
+    if (!groups)
+        return 0;
+
+    uint64_t idx = 0;
+    for (const auto& group : groups->get())
+    {
+        auto method = group->get_as<std::string>("method");
+        if (!method)
+            continue;
+
+        auto name = "config-" + std::to_string(idx++) + "/" + *method;
+        auto ana = analyzer_factory::get().create(*method, *config, *group);
+        if (auto filters = group->get_table_array("filter"))
+        {
+            std::deque<stage_stats> stats;
+            auto timed_chain = configured_chain(*filters, stats);
+            run_case(name, "virtual", *ana, corp, timed_chain.get(), &stats);
+        }
+        else
+        {
+            auto filter = group->get_as<std::string>("filter");
+            run_case(name, filter ? "fused" : "", *ana, corp);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file ascii.cpp
+ */
+
+#include "meta/utf/ascii.h"
+
+namespace meta
+{
+namespace utf
+{
+
+bool is_valid_utf8(util::string_view str)
+{
+    auto bytes = reinterpret_cast<const unsigned char*>(str.data());
+    uint64_t pos = 0;
+    while (pos < str.size())
+    {
+        // ASCII is skipped a word at a time
+        if (pos + 8 <= str.size()
+            && (detail::load(str.data() + pos) & detail::high_bits) == 0)
+        {
+            pos += 8;
+            continue;
+        }
+
+        auto lead = bytes[pos];
+        if (lead < 0x80)
+        {
+            ++pos;
+            continue;
+        }
+
+        // the number of continuation bytes, and the range of the first
+        // one, which is narrower after some lead bytes to rule out
+        // overlong encodings, surrogates, and codepoints past U+10FFFF
+        uint64_t length;
+        unsigned char lo = 0x80;
+        unsigned char hi = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            length = 1;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            length = 2;
+            if (lead == 0xE0)
+                lo = 0xA0;
+            else if (lead == 0xED)
+                hi = 0x9F;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            length = 3;
+            if (lead == 0xF0)
+                lo = 0x90;
+            else if (lead == 0xF4)
+                hi = 0x8F;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (str.size() - pos - 1 < length)
+            return false;
+        if (bytes[pos + 1] < lo || bytes[pos + 1] > hi)
+            return false;
+        for (uint64_t i = 2; i <= length; ++i)
+        {
+            if ((bytes[pos + i] & 0xC0) != 0x80)
+                return false;
+        }
+        pos += length + 1;
+    }
+    return true;
+}
+}
+}
@@ -14,6 +14,7 @@
 
 #include "detail.h"
 #include "meta/util/pimpl.tcc"
+#include "meta/utf/ascii.h"
 #include "meta/utf/utf.h"
 
 namespace meta
@@ -98,13 +99,37 @@ std::string toupper(const std::string& str)
                      });
 }
 
-std::string foldcase(const std::string& str)
+std::string foldcase(util::string_view str)
 {
-    return transform(str, [](uint32_t cp)
-                     {
-                         return u_foldCase(static_cast<UChar32>(cp),
-                                           U_FOLD_CASE_DEFAULT);
-                     });
+    std::string result;
+    result.reserve(str.size());
+    const char* s = str.data();
+    auto length = static_cast<int32_t>(str.size());
+    for (int32_t i = 0; i < length;)
+    {
+        // an ASCII byte is never part of a multi-byte codepoint, so the
+        // string can be split into ASCII and non-ASCII runs
+        auto ascii = ascii_prefix(str.substr(static_cast<std::size_t>(i)));
+        if (ascii > 0)
+        {
+            auto pos = result.size();
+            result.resize(pos + ascii);
+            ascii_tolower(str.substr(static_cast<std::size_t>(i), ascii),
+                          &result[pos]);
+            i += static_cast<int32_t>(ascii);
+        }
+
+        auto end = i;
+        while (end < length && static_cast<unsigned char>(s[end]) >= 0x80)
+            ++end;
+        while (i < end)
+        {
+            auto codepoint = detail::utf8_next_codepoint(s, i, end);
+            detail::utf8_append_codepoint(
+                result, u_foldCase(codepoint, U_FOLD_CASE_DEFAULT));
+        }
+    }
+    return result;
 }
 
 bool isalpha(uint32_t codepoint)
@@ -122,9 +147,13 @@ bool isspace(uint32_t codepoint)
     return u_isUWhiteSpace(static_cast<int32_t>(codepoint));
 }
 
-uint64_t length(const std::string& str)
+uint64_t length(util::string_view str)
 {
-    const char* s = str.c_str();
+    // an ASCII string has one codepoint per byte
+    if (is_ascii(str))
+        return str.size();
+
+    const char* s = str.data();
     auto length = static_cast<int32_t>(str.length());
     uint64_t count = 0;
     for (int32_t i = 0; i < length;)
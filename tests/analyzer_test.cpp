@@ -4,7 +4,9 @@
  */
 
 #include "meta/analyzers/all.h"
+#include "meta/analyzers/batch_analyzer.h"
 #include "meta/analyzers/token_stream.h"
+#include "meta/analyzers/tokenizers/character_tokenizer.h"
 #include "bandit/bandit.h"
 #include "meta/corpus/document.h"
 #include "create_config.h"
@@ -38,6 +40,28 @@ void check_analyzer_expected(Analyzer& ana, corpus::document doc,
     AssertThat(total, Equals(length));
     AssertThat(doc.id(), Equals(47ul));
 }
+
+template <class Analyzer>
+void check_analyzer_hashed(Analyzer& ana, const corpus::document& doc) {
+    auto counts = ana.template analyze<uint64_t>(doc);
+    analyzers::feature_dictionary dict;
+    auto hashed = ana.template analyze_hashed<uint64_t>(doc, &dict);
+
+    AssertThat(hashed.size(), Equals(counts.size()));
+    AssertThat(dict.size(), Equals(counts.size()));
+    AssertThat(dict.collisions().empty(), IsTrue());
+    for (const auto& count : hashed) {
+        const auto& feats = dict.features(count.key());
+        AssertThat(feats.size(), Equals(1ul));
+        AssertThat(count.value(), Equals(counts.at(feats.front())));
+    }
+
+    // naming the features must not change their ids
+    auto unnamed = ana.template analyze_hashed<uint64_t>(doc);
+    AssertThat(unnamed.size(), Equals(hashed.size()));
+    for (const auto& count : unnamed)
+        AssertThat(count.value(), Equals(hashed.at(count.key())));
+}
 }
 
 go_bandit([]() {
@@ -86,6 +110,191 @@ go_bandit([]() {
         });
     });
 
+    describe("[analyzers]: hashed features", [&]() {
+
+        doc.content(filesystem::file_text("../data/sample-document.txt"));
+
+        it("should hash the same unigrams as it counts", [&]() {
+            analyzers::ngram_word_analyzer ana{1, make_filter()};
+            check_analyzer_hashed(ana, doc);
+        });
+
+        it("should hash the same bigrams as it counts", [&]() {
+            analyzers::ngram_word_analyzer ana{2, make_filter()};
+            check_analyzer_hashed(ana, doc);
+        });
+
+        it("should hash the same trigrams as it counts", [&]() {
+            analyzers::ngram_word_analyzer ana{3, make_filter()};
+            check_analyzer_hashed(ana, doc);
+        });
+
+        it("should hash features of other analyzers", [&]() {
+            auto config = tests::create_config("line", true);
+            auto ana = analyzers::load(*config);
+            check_analyzer_hashed(*ana, doc);
+        });
+
+        it("should compute n-gram ids from token hashes", [&]() {
+            using namespace analyzers;
+            rolling_hash bigram{2};
+            bigram.push(hash_feature("two"));
+            AssertThat(bigram.full(), IsFalse());
+            bigram.push(hash_feature("three"));
+            AssertThat(bigram.full(), IsTrue());
+            auto id = bigram.value();
+
+            rolling_hash other{2};
+            for (const auto& tok : {"one", "two", "three"})
+                other.push(hash_feature(tok));
+            AssertThat(other.value(), Equals(id));
+
+            rolling_hash reversed{2};
+            reversed.push(hash_feature("three"));
+            reversed.push(hash_feature("two"));
+            AssertThat(reversed.value(), Is().Not().EqualTo(id));
+
+            rolling_hash trigram{3};
+            for (const auto& tok : {"one", "two", "three"})
+                trigram.push(hash_feature(tok));
+            AssertThat(trigram.value(), Is().Not().EqualTo(id));
+        });
+
+        it("should reject hashed ids on string feature maps", [&]() {
+            analyzers::feature_map<uint64_t> counts;
+            analyzers::featurizer feats{counts};
+            AssertThat(feats.hashed(), IsFalse());
+            AssertThrows(analyzers::featurizer_exception, feats(47ul, 1ul));
+        });
+
+        it("should record collisions in the dictionary", [&]() {
+            analyzers::feature_dictionary dict;
+            dict.insert(1, "one");
+            dict.insert(1, "one");
+            dict.insert(2, "two");
+            AssertThat(dict.collisions().empty(), IsTrue());
+            dict.insert(2, "deux");
+            AssertThat(dict.size(), Equals(2ul));
+            AssertThat(dict.features(1).size(), Equals(1ul));
+            AssertThat(dict.features(2).back(), Equals("deux"));
+            AssertThat(dict.features(3).empty(), IsTrue());
+            AssertThat(dict.collisions(), Equals(std::vector<uint64_t>{2}));
+        });
+    });
+
+    describe("[analyzers]: character ngrams", [&]() {
+
+        it("should count the ngrams of codepoints", [&]() {
+            corpus::document utf_doc;
+            utf_doc.content("h\xC3\xA9h\xC3\xA9!");
+            analyzers::ngram_char_analyzer ana{{2, 1, 2}};
+            AssertThat(ana.n_values(), Equals(std::vector<uint16_t>{1, 2}));
+
+            auto counts = ana.analyze<uint64_t>(utf_doc);
+            AssertThat(counts.size(), Equals(6ul));
+            AssertThat(counts.at("h"), Equals(2ul));
+            AssertThat(counts.at("\xC3\xA9"), Equals(2ul));
+            AssertThat(counts.at("h\xC3\xA9"), Equals(2ul));
+            AssertThat(counts.at("\xC3\xA9h"), Equals(1ul));
+            AssertThat(counts.at("\xC3\xA9!"), Equals(1ul));
+        });
+
+        it("should hash the same ngrams as it counts", [&]() {
+            doc.content(filesystem::file_text("../data/sample-document.txt"));
+            analyzers::ngram_char_analyzer ana{{1, 3, 5}};
+            check_analyzer_hashed(ana, doc);
+        });
+
+        it("should give ASCII the ids of word ngrams of characters", [&]() {
+            doc.content("the quick brown fox jumps over the lazy dog");
+            analyzers::ngram_char_analyzer ana{{3}};
+            analyzers::ngram_word_analyzer words{
+                3, make_unique<analyzers::tokenizers::character_tokenizer>()};
+
+            auto hashed = ana.analyze_hashed<uint64_t>(doc);
+            auto expected = words.analyze_hashed<uint64_t>(doc);
+            AssertThat(hashed.size(), Equals(expected.size()));
+            for (const auto& count : expected)
+                AssertThat(hashed.at(count.key()), Equals(count.value()));
+        });
+
+        it("should reject invalid values of n", [&]() {
+            using analyzers::ngram_char_analyzer;
+            AssertThrows(analyzers::analyzer_exception,
+                         ngram_char_analyzer{std::vector<uint16_t>{}});
+            AssertThrows(analyzers::analyzer_exception,
+                         ngram_char_analyzer({0, 2}));
+        });
+
+        it("should read an array of n from a config object", [&]() {
+            auto ngram = cpptoml::make_array();
+            ngram->push_back(cpptoml::make_value<int64_t>(1));
+            ngram->push_back(cpptoml::make_value<int64_t>(2));
+
+            auto ana_cfg = cpptoml::make_table();
+            ana_cfg->insert("method", "ngram-char");
+            ana_cfg->insert("ngram", ngram);
+            auto anas = cpptoml::make_table_array();
+            anas->push_back(ana_cfg);
+            auto config = cpptoml::make_table();
+            config->insert("analyzers", anas);
+            auto ana = analyzers::load(*config);
+
+            doc.content("abab");
+            auto counts = ana->analyze<uint64_t>(doc);
+            AssertThat(counts.size(), Equals(4ul));
+            AssertThat(counts.at("ab"), Equals(2ul));
+            AssertThat(counts.at("ba"), Equals(1ul));
+        });
+    });
+
+    describe("[analyzers]: batches", [&]() {
+        std::vector<corpus::document> docs;
+        auto text = filesystem::file_text("../data/sample-document.txt");
+        for (uint64_t i = 0; i < 50; ++i) {
+            docs.emplace_back(doc_id{i});
+            docs.back().content(text.substr(0, 40 * i));
+        }
+
+        auto check_batch = [](analyzers::analyzer& ana,
+                              const std::vector<corpus::document>& docs,
+                              const analyzers::feature_batch<uint64_t>& batch) {
+            AssertThat(batch.size(), Equals(docs.size()));
+            for (std::size_t i = 0; i < docs.size(); ++i) {
+                auto counts = ana.analyze<uint64_t>(docs[i]);
+                AssertThat(batch[i].size(), Equals(counts.size()));
+                for (const auto& feat : batch[i])
+                    AssertThat(feat.second,
+                               Equals(counts.at(feat.first.to_string())));
+            }
+        };
+
+        it("should analyze documents in parallel", [&]() {
+            analyzers::ngram_word_analyzer ana{2, make_filter()};
+            parallel::thread_pool pool{3};
+            analyzers::batch_analyzer<uint64_t> batcher{ana, pool};
+            auto batch = batcher.analyze_batch(docs);
+            check_batch(ana, docs, batch);
+        });
+
+        it("should reuse a batch", [&]() {
+            analyzers::ngram_word_analyzer ana{1, make_filter()};
+            parallel::thread_pool pool{2};
+            analyzers::batch_analyzer<uint64_t> batcher{ana, pool};
+            analyzers::feature_batch<uint64_t> batch;
+            batcher.analyze_batch(docs, batch);
+            check_batch(ana, docs, batch);
+
+            std::vector<corpus::document> fewer(docs.rbegin(),
+                                                docs.rbegin() + 5);
+            batcher.analyze_batch(fewer, batch);
+            check_batch(ana, fewer, batch);
+
+            batcher.analyze_batch(std::vector<corpus::document>{}, batch);
+            AssertThat(batch.size(), Equals(0ul));
+        });
+    });
+
     describe("[analyzers]: create from factory", [&]() {
         doc.content(filesystem::file_text("../data/sample-document.txt"));
 
@@ -0,0 +1,87 @@
+/**
+ * @file doc_filter_test.cpp
+ */
+
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "meta/index/doc_filter.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+std::vector<doc_id> accepted(const index::doc_filter& filter) {
+    std::vector<doc_id> docs;
+    filter.for_each([&](doc_id d_id) { docs.push_back(d_id); });
+    return docs;
+}
+}
+
+go_bandit([]() {
+
+    describe("[doc filter]", []() {
+
+        std::vector<uint64_t> evens;
+        for (uint64_t i = 0; i < 150; i += 2)
+            evens.push_back(i);
+        index::doc_filter even{150, evens.begin(), evens.end()};
+
+        it("should accept only the documents it was built with", [&]() {
+            AssertThat(even.size(), Equals(150ul));
+            AssertThat(even.count(), Equals(75ul));
+            for (doc_id d_id{0}; d_id < 150; ++d_id)
+                AssertThat(even(d_id), Equals(d_id % 2 == 0));
+            AssertThat(even(doc_id{150}), IsFalse());
+            AssertThat(even(doc_id{1000}), IsFalse());
+        });
+
+        it("should find the next accepted document", [&]() {
+            index::doc_filter sparse{200};
+            sparse.set(doc_id{3});
+            sparse.set(doc_id{130});
+            AssertThat(sparse.next(doc_id{0}), Equals(doc_id{3}));
+            AssertThat(sparse.next(doc_id{3}), Equals(doc_id{3}));
+            AssertThat(sparse.next(doc_id{4}), Equals(doc_id{130}));
+            AssertThat(sparse.next(doc_id{131}), Equals(doc_id{200}));
+
+            sparse.set(doc_id{130}, false);
+            AssertThat(sparse.next(doc_id{4}), Equals(doc_id{200}));
+
+            // setting a document twice, or clearing one that isn't set,
+            // doesn't change the count
+            sparse.set(doc_id{3});
+            sparse.set(doc_id{130}, false);
+            AssertThat(sparse.count(), Equals(1ul));
+        });
+
+        it("should be composable", [&]() {
+            auto small = index::doc_filter::from_predicate(
+                150, [](doc_id d_id) { return d_id < 10; });
+            AssertThat(small.count(), Equals(10ul));
+
+            auto both = even & small;
+            AssertThat(accepted(both),
+                       Equals(std::vector<doc_id>{doc_id{0}, doc_id{2},
+                                                  doc_id{4}, doc_id{6},
+                                                  doc_id{8}}));
+
+            auto either = even | small;
+            AssertThat(either.count(), Equals(80ul));
+
+            auto odd = ~even;
+            AssertThat(odd.count(), Equals(75ul));
+            AssertThat(odd(doc_id{1}), IsTrue());
+            AssertThat(odd(doc_id{2}), IsFalse());
+            AssertThat((odd & even).count(), Equals(0ul));
+            AssertThat((odd | even).count(), Equals(150ul));
+        });
+
+        it("should accept everything when built full", [&]() {
+            index::doc_filter all{70, true};
+            AssertThat(all.count(), Equals(70ul));
+            AssertThat((~all).count(), Equals(0ul));
+        });
+    });
+});
@@ -201,6 +201,12 @@ go_bandit([]() {
 
             auto oov = idx->get_term_id("somelongrandomword");
             AssertThat(fvector.at(oov), Equals(0));
+
+            // the counts of the last document are not carried over
+            doc.content("Smoking is bad.");
+            fvector = idx->tokenize(doc);
+            AssertThat(fvector.at(smoke), Equals(1));
+            AssertThat(fvector.at(think), Equals(0));
         });
     });
 
@@ -224,6 +230,79 @@ go_bandit([]() {
         });
     });
 
+    describe("[forward-index] with hashed features", []() {
+        auto hash_cfg = tests::create_config("line");
+        hash_cfg->insert("index", "ceeaus-hashed");
+        hash_cfg->insert("feature-hash-bits", int64_t{16});
+
+        it("should create the index", [&]() {
+            filesystem::remove_all("ceeaus-hashed");
+            auto idx = index::make_index<index::forward_index>(*hash_cfg);
+            AssertThat(idx->num_docs(), Equals(1008ul));
+            AssertThat(idx->unique_terms(), Equals(uint64_t{1} << 16));
+        });
+
+        it("should count the same features as an unhashed index", [&]() {
+            auto idx = index::make_index<index::forward_index>(*hash_cfg);
+            auto line_cfg = tests::create_config("line");
+            auto plain = index::make_index<index::forward_index>(*line_cfg);
+            for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id) {
+                AssertThat(idx->doc_size(d_id), Equals(plain->doc_size(d_id)));
+                auto pdata = idx->search_primary(d_id);
+                for (const auto& count : pdata->counts())
+                    AssertThat(count.first, IsLessThan(idx->unique_terms()));
+            }
+        });
+
+        it("should analyze a new document into hashed features", [&]() {
+            auto idx = index::make_index<index::forward_index>(*hash_cfg);
+            std::string text{"I think smoking smoking bad."};
+            corpus::document doc;
+            doc.content(text);
+            auto fvector = idx->tokenize(doc);
+
+            auto line_cfg = tests::create_config("line");
+            auto plain = index::make_index<index::forward_index>(*line_cfg);
+            auto expected = plain->tokenize(doc);
+
+            // <s>, think, smoke (twice), bad, </s>
+            double total = 0;
+            for (const auto& count : fvector) {
+                AssertThat(count.first, IsLessThan(idx->unique_terms()));
+                total += count.second;
+            }
+            AssertThat(fvector.size(), Equals(expected.size()));
+            AssertThat(total, EqualsWithDelta(6, 0.001));
+        });
+
+        it("should load hashed features without the hash bits", [&]() {
+            auto idx = index::make_index<index::forward_index>(*hash_cfg);
+            auto cfg = tests::create_config("line");
+            cfg->insert("index", "ceeaus-hashed");
+            auto loaded = index::make_index<index::forward_index>(*cfg);
+            AssertThat(loaded->unique_terms(), Equals(uint64_t{1} << 16));
+
+            corpus::document doc;
+            doc.content("I think smoking smoking bad.");
+            auto expected = idx->tokenize(doc);
+            auto fvector = loaded->tokenize(doc);
+            AssertThat(fvector.size(), Equals(expected.size()));
+            for (const auto& count : expected)
+                AssertThat(fvector.at(count.first), Equals(count.second));
+        });
+
+        it("should not uninvert", [&]() {
+            filesystem::remove_all("ceeaus-hashed");
+            auto cfg = tests::create_config("line");
+            cfg->insert("index", "ceeaus-hashed");
+            cfg->insert("feature-hash-bits", int64_t{16});
+            cfg->insert("uninvert", true);
+            AssertThrows(index::forward_index_exception,
+                         index::make_index<index::forward_index>(*cfg));
+            filesystem::remove_all("ceeaus-hashed");
+        });
+    });
+
     describe("[forward-index] with zlib", []() {
 
         filesystem::remove_all("ceeaus");
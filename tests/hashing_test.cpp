@@ -392,6 +392,28 @@ go_bandit([]() {
             map.resize_ratio(2.0);
             count(map, tokens);
         });
+
+        it("should keep its memory when reset (probe_set)", [&]() {
+            hashing::probe_set<std::string> set;
+            count_unique(set, tokens);
+            auto bytes = set.bytes_used();
+            set.reset();
+            AssertThat(set.empty(), IsTrue());
+            AssertThat(set.bytes_used(), Equals(bytes));
+            count_unique(set, tokens);
+            AssertThat(set.bytes_used(), Equals(bytes));
+        });
+
+        it("should keep its memory when reset (probe_map)", [&]() {
+            hashing::probe_map<std::string, uint64_t> map;
+            count(map, tokens);
+            auto bytes = map.bytes_used();
+            map.reset();
+            AssertThat(map.empty(), IsTrue());
+            AssertThat(map.bytes_used(), Equals(bytes));
+            count(map, tokens);
+            AssertThat(map.bytes_used(), Equals(bytes));
+        });
     });
 
     describe("[hashing] probing", []() {
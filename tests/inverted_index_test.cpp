@@ -3,6 +3,7 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include "bandit/bandit.h"
@@ -12,6 +13,7 @@
 #include "meta/index/inverted_index.h"
 #include "meta/index/postings_data.h"
 #include "meta/io/filesystem.h"
+#include "meta/util/disk_vector.h"
 
 using namespace bandit;
 using namespace meta;
@@ -23,6 +25,7 @@ void check_ceeaus_expected(Index& idx) {
     AssertThat(idx.num_docs(), Equals(1008ul));
     AssertThat(idx.avg_doc_length(), EqualsWithDelta(127.634, 0.001));
     AssertThat(idx.unique_terms(), Equals(4224ul));
+    AssertThat(idx.stats().num_docs, Equals(idx.num_docs()));
 
     std::ifstream in{"../data/ceeaus-metadata.txt"};
     uint64_t size;
@@ -47,11 +50,40 @@ void check_term_id(Index& idx) {
     double second;
     std::ifstream in{"../data/ceeaus-term-count.txt"};
     auto pdata = idx.search_primary(t_id);
+    uint64_t total = 0;
     for (auto& count : pdata->counts()) {
         in >> first;
         in >> second;
         AssertThat(first, Equals(count.first));
         AssertThat(second, EqualsWithDelta(count.second, 0.001));
+        total += count.second;
+    }
+
+    auto stats = idx.stats(t_id);
+    AssertThat(stats.doc_freq, Equals(pdata->counts().size()));
+    AssertThat(stats.corpus_count, Equals(total));
+}
+
+template <class Index>
+void check_seek(Index& idx) {
+    // "<s>" is in every document, so its list has skip points
+    for (const auto& term : {"<s>", "japanes", "think"}) {
+        auto t_id = idx.get_term_id(term);
+        auto stream = idx.stream_for(t_id);
+        AssertThat(static_cast<bool>(stream), IsTrue());
+
+        for (doc_id d_id{0}; d_id <= idx.num_docs(); d_id += 37) {
+            auto expected = stream->begin();
+            while (expected != stream->end() && expected->first < d_id)
+                ++expected;
+
+            auto it = idx.seek(*stream, t_id, d_id);
+            AssertThat(it == stream->end(), Equals(expected == stream->end()));
+            if (expected != stream->end()) {
+                AssertThat(it->first, Equals(expected->first));
+                AssertThat(it->second, Equals(expected->second));
+            }
+        }
     }
 }
 
@@ -87,6 +119,11 @@ go_bandit([]() {
             check_term_id(*idx);
         });
 
+        it("should seek within postings lists", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*file_cfg);
+            check_seek(*idx);
+        });
+
         filesystem::remove_all("ceeaus");
         it("should be able to store full text metadata", [&]() {
             auto docs = corpus::make_corpus(*file_cfg);
@@ -148,6 +185,114 @@ go_bandit([]() {
         });
     });
 
+    describe("[inverted-index] with load options", []() {
+
+        auto line_cfg = tests::create_config("line");
+        auto load = cpptoml::make_table();
+        load->insert("lazy", true);
+        load->insert("advice", "random");
+        load->insert("prefault", true);
+        load->insert<int64_t>("prefault-threads", 2);
+        line_cfg->insert("index-load", load);
+
+        it("should lazily load the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*line_cfg);
+            check_term_id(*idx);
+            check_ceeaus_expected(*idx);
+        });
+
+        it("should eagerly load the index", [&]() {
+            load->insert("lazy", false);
+            auto idx = index::make_index<index::inverted_index>(*line_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should reject bad load options", [&]() {
+            auto cfg = tests::create_config("line");
+            auto bad_load = cpptoml::make_table();
+            cfg->insert("index-load", bad_load);
+            for (const auto& threads : {int64_t{0}, int64_t{-3}}) {
+                bad_load->insert("prefault-threads", threads);
+                AssertThrows(
+                    index::disk_index_exception,
+                    index::make_index<index::inverted_index>(*cfg));
+            }
+
+            bad_load->insert<int64_t>("prefault-threads", 2);
+            bad_load->insert("advice", "eventually");
+            AssertThrows(index::disk_index_exception,
+                         index::make_index<index::inverted_index>(*cfg));
+        });
+    });
+
+    describe("[inverted-index] with document reordering", []() {
+
+        auto line_cfg = tests::create_config("line");
+        auto reorder = cpptoml::make_table();
+        line_cfg->insert("reorder", reorder);
+
+        auto check_reordered = [&]() {
+            auto idx = index::make_index<index::inverted_index>(*line_cfg);
+            AssertThat(idx->num_docs(), Equals(1008ul));
+            AssertThat(idx->avg_doc_length(), EqualsWithDelta(127.634, 0.001));
+            AssertThat(idx->unique_terms(), Equals(4224ul));
+
+            util::disk_vector<doc_id> order{"ceeaus/inv/docs.order"};
+            AssertThat(order.size(), Equals(idx->num_docs()));
+
+            // metadata must follow the documents to their new ids
+            std::vector<std::pair<uint64_t, uint64_t>> expected;
+            std::ifstream in{"../data/ceeaus-metadata.txt"};
+            uint64_t size;
+            uint64_t unique;
+            while (in >> size >> unique)
+                expected.emplace_back(size, unique);
+            for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id) {
+                AssertThat(idx->doc_size(d_id),
+                           Equals(expected[order[d_id]].first));
+                AssertThat(idx->unique_terms(d_id),
+                           Equals(expected[order[d_id]].second));
+            }
+
+            // postings must be sorted by new id and map back to the
+            // original postings
+            auto pdata = idx->search_primary(idx->get_term_id("japanes"));
+            std::vector<std::pair<doc_id, uint64_t>> original;
+            doc_id last{0};
+            for (const auto& count : pdata->counts()) {
+                AssertThat(count.first, Is().GreaterThanOrEqualTo(last));
+                last = count.first;
+                original.emplace_back(order[count.first], count.second);
+            }
+            std::sort(original.begin(), original.end());
+
+            std::ifstream counts_in{"../data/ceeaus-term-count.txt"};
+            doc_id first;
+            double second;
+            for (const auto& count : original) {
+                counts_in >> first >> second;
+                AssertThat(count.first, Equals(first));
+                AssertThat(count.second, EqualsWithDelta(second, 0.001));
+            }
+        };
+
+        it("should reorder by graph bisection", [&]() {
+            filesystem::remove_all("ceeaus");
+            reorder->insert("method", "graph-bisection");
+            check_reordered();
+        });
+
+        it("should reorder by metadata", [&]() {
+            filesystem::remove_all("ceeaus");
+            reorder->insert("method", "metadata");
+            reorder->insert("field", "unique-terms");
+            check_reordered();
+        });
+
+        filesystem::remove_all("ceeaus");
+    });
+
     describe("[inverted-index] with zlib", []() {
 
         filesystem::remove_all("ceeaus");
@@ -81,6 +81,15 @@ go_bandit([]() {
             AssertThat(eval.map(), Is().GreaterThanOrEqualTo(eval.gmap()));
         });
 
+        it("should look up relevance judgements", []() {
+            auto file_cfg = tests::create_config("file");
+            index::ir_eval eval{*file_cfg};
+            AssertThat(eval.relevance(query_id{0}, doc_id{30}), Equals(1ul));
+            AssertThat(eval.relevance(query_id{0}, doc_id{2}), Equals(0ul));
+            AssertThat(eval.relevance(query_id{1000}, doc_id{0}),
+                       Equals(0ul));
+        });
+
         it("should compute correct eval measures", []() {
 
             auto file_cfg = tests::create_config("file");
@@ -3,6 +3,8 @@
  * @author Sean Massung
  */
 
+#include <vector>
+
 #include "bandit/bandit.h"
 #include "meta/io/libsvm_parser.h"
 
@@ -67,5 +69,56 @@ go_bandit([]() {
             AssertThrows(exception, counts("label 9:9 9::9"));
             AssertThrows(exception, counts("label 5:"));
         });
+
+        it("should parse lines into a reusable buffer", []() {
+            auto same = {"a 12:2e-3 15:4.01 99:22 122:1",
+                         "a  12:2e-3 15:4.01   99:22 122:1  ",
+                         "a\t12:0.002 15:401e-2 99:2.2E1 122:1.\r"};
+            const double delta = 0.000001;
+            std::vector<std::pair<term_id, double>> counts;
+            for (auto& text : same) {
+                auto lbl = io::libsvm_parser::parse(text, counts);
+                AssertThat(lbl.to_string(), Equals("a"));
+                AssertThat(counts.size(), Equals(std::size_t{4}));
+                AssertThat(counts[0].first, Equals(11ul));
+                AssertThat(counts[0].second, EqualsWithDelta(2e-3, delta));
+                AssertThat(counts[1].first, Equals(14ul));
+                AssertThat(counts[1].second, EqualsWithDelta(4.01, delta));
+                AssertThat(counts[2].first, Equals(98ul));
+                AssertThat(counts[2].second, EqualsWithDelta(22.0, delta));
+                AssertThat(counts[3].first, Equals(121ul));
+                AssertThat(counts[3].second, EqualsWithDelta(1.0, delta));
+            }
+        });
+
+        it("should parse values outside of the fast path exactly", []() {
+            std::vector<std::pair<term_id, double>> counts;
+            io::libsvm_parser::parse(
+                "-1 1:0.1 2:-3.25 3:1e-30 4:12345678901234567890 5:0x10",
+                counts);
+            AssertThat(counts.size(), Equals(std::size_t{5}));
+            AssertThat(counts[0].second, Equals(0.1));
+            AssertThat(counts[1].second, Equals(-3.25));
+            AssertThat(counts[2].second, Equals(1e-30));
+            AssertThat(counts[3].second, Equals(12345678901234567890.0));
+            AssertThat(counts[4].second, Equals(16.0));
+        });
+
+        it("should throw an exception when parsing bad lines", []() {
+            using exception = io::libsvm_parser::libsvm_parser_exception;
+            using namespace io::libsvm_parser;
+            std::vector<std::pair<term_id, double>> counts;
+            AssertThrows(exception, parse("", counts));
+            AssertThrows(exception, parse(" missing", counts));
+            AssertThrows(exception, parse("label", counts));
+            AssertThrows(exception, parse("lis:uvfs agi uy:", counts));
+            AssertThrows(exception, parse("label :9 5:5", counts));
+            AssertThrows(exception, parse("label 9: 5:5", counts));
+            AssertThrows(exception, parse("label : :::", counts));
+            AssertThrows(exception, parse("label 9:9 9::9", counts));
+            AssertThrows(exception, parse("label 5:", counts));
+            AssertThrows(exception, parse("label 0:1", counts));
+            AssertThrows(exception, parse("label 1:1e", counts));
+        });
     });
 });
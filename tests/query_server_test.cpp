@@ -0,0 +1,216 @@
+/**
+ * @file query_server_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/index/ranker/ranker_factory.h"
+#include "meta/index/server/query_server.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+std::vector<std::string> split_lines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    std::string line;
+    while (std::getline(in, line))
+        lines.push_back(line);
+    return lines;
+}
+
+#ifndef _WIN32
+/**
+ * Connects to the server's socket, sends the requests, and reads until
+ * there is a response to each of them.
+ */
+std::vector<std::string> send_requests(const std::string& path,
+                                       const std::string& requests,
+                                       uint64_t num_requests) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), addr.sun_path);
+
+    // the server may not be listening yet
+    auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    for (int tries = 0;
+         ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0;
+         ++tries) {
+        AssertThat(tries, Is().LessThan(100));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    AssertThat(::write(fd, requests.data(), requests.size()),
+               Equals(static_cast<ssize_t>(requests.size())));
+
+    std::string text;
+    char chunk[4096];
+    while (static_cast<uint64_t>(std::count(text.begin(), text.end(), '\n'))
+           < num_requests) {
+        auto n = ::read(fd, chunk, sizeof(chunk));
+        AssertThat(n, Is().GreaterThan(0));
+        text.append(chunk, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return split_lines(text);
+}
+#endif
+}
+
+go_bandit([]() {
+
+    describe("[query server] requests", []() {
+
+        it("should parse requests", []() {
+            auto req = index::parse_request(
+                R"({"id": 7, "query": "a \"quoted\" \u00e9", "top_k": 3,)"
+                R"( "ranker": "bm25"})");
+            AssertThat(req.id, Equals("7"));
+            AssertThat(req.query, Equals("a \"quoted\" \xc3\xa9"));
+            AssertThat(req.top_k, Equals(3ul));
+            AssertThat(req.ranker, Equals("bm25"));
+
+            req = index::parse_request(R"({"id": "x", "command": "stats"})");
+            AssertThat(req.id, Equals("\"x\""));
+            AssertThat(req.command, Equals("stats"));
+        });
+
+        it("should reject invalid requests", []() {
+            AssertThrows(index::query_server_exception,
+                         index::parse_request("not json"));
+            AssertThrows(index::query_server_exception,
+                         index::parse_request(R"({"id": 1})"));
+            AssertThrows(index::query_server_exception,
+                         index::parse_request(R"({"query": "a")"));
+            for (const auto& top_k : {"-1", "0", "1.5", "10abc", "1e2",
+                                      "99999999999999999999"}) {
+                AssertThrows(index::query_server_exception,
+                             index::parse_request(
+                                 std::string{R"({"query": "a", "top_k": )"}
+                                 + top_k + "}"));
+            }
+            AssertThrows(
+                index::query_server_exception,
+                index::parse_request(R"({"id": abc, "query": "a"})"));
+            AssertThrows(
+                index::query_server_exception,
+                index::parse_request(R"({"id": 1x, "query": "a"})"));
+            AssertThat(
+                index::parse_request(R"({"id": -1.5e3, "query": "a"})").id,
+                Equals("-1.5e3"));
+        });
+    });
+
+    describe("[query server] serving", []() {
+
+        auto config = tests::create_config("file");
+        auto ranker_cfg = cpptoml::make_table();
+        ranker_cfg->insert("method", std::string{"bm25"});
+        config->insert("ranker", ranker_cfg);
+        auto server_cfg = cpptoml::make_table();
+        server_cfg->insert("threads", int64_t{4});
+        config->insert("server", server_cfg);
+
+        filesystem::remove_all("ceeaus");
+        auto idx = index::make_index<index::inverted_index>(*config);
+
+        it("should answer requests in order", [&]() {
+            index::query_server server{idx, *config};
+
+            std::stringstream in;
+            in << R"({"id": 1, "query": "smoking restaurants"})" << "\n"
+               << R"({"id": 2, "query": "smoking", "top_k": 3})" << "\n"
+               << "\n"
+               << R"({"id": 3, "query": "japan", "ranker": "dirichlet-prior"})"
+               << "\n"
+               << "garbage\n"
+               << R"({"id": 4, "query": "a", "ranker": "no-such-ranker"})"
+               << "\n"
+               << R"({"id": 5, "command": "stats"})" << "\n";
+            std::stringstream out;
+            server.serve(in, out);
+
+            auto lines = split_lines(out.str());
+            AssertThat(lines.size(), Equals(6ul));
+            AssertThat(lines[0], StartsWith(R"({"id": 1, "results": [)"));
+            AssertThat(lines[1], StartsWith(R"({"id": 2, "results": [)"));
+            AssertThat(lines[2], StartsWith(R"({"id": 3, "results": [)"));
+            AssertThat(lines[3], StartsWith(R"({"id": null, "error": )"));
+            AssertThat(lines[4], StartsWith(R"({"id": 4, "error": )"));
+            AssertThat(lines[5], StartsWith(R"({"id": 5, "stats": )"));
+
+            uint64_t results = 0;
+            for (auto pos = lines[1].find("\"doc_id\"");
+                 pos != std::string::npos;
+                 pos = lines[1].find("\"doc_id\"", pos + 1))
+                ++results;
+            AssertThat(results, Equals(3ul));
+
+            // the failed queries are timed too
+            AssertThat(server.latencies().count(), Equals(5ul));
+        });
+
+        it("should match the ranker's results", [&]() {
+            index::query_server server{idx, *config};
+            auto response = server.handle(
+                R"({"query": "smoking restaurants", "top_k": 1})");
+
+            corpus::document query;
+            query.content("smoking restaurants");
+            auto ranker = index::make_ranker(*config->get_table("ranker"));
+            auto ranking = ranker->score(*idx, query, 1);
+            AssertThat(ranking.size(), Equals(1ul));
+
+            auto expected
+                = "{\"doc_id\": " + std::to_string(ranking[0].d_id) + ",";
+            AssertThat(response, Contains(expected));
+        });
+
+#ifndef _WIN32
+        it("should answer requests on a socket", [&]() {
+            index::query_server server{idx, *config};
+            std::string path = "query-server-test.sock";
+            std::thread serving{[&]() { server.serve_socket(path); }};
+
+            auto lines = send_requests(
+                path, R"({"id": 1, "query": "smoking", "top_k": 2})"
+                      "\n",
+                1);
+            AssertThat(lines.size(), Equals(1ul));
+            AssertThat(lines[0], StartsWith(R"({"id": 1, "results": [)"));
+
+            // a second connection, after the first has closed
+            lines = send_requests(
+                path, R"({"id": 2, "query": "japan"})"
+                      "\n"
+                      R"({"id": 3, "command": "shutdown"})"
+                      "\n",
+                2);
+            AssertThat(lines.size(), Equals(2ul));
+            AssertThat(lines[0], StartsWith(R"({"id": 2, "results": [)"));
+            AssertThat(lines[1], StartsWith(R"({"id": 3, "status": )"));
+
+            serving.join();
+            AssertThat(filesystem::file_exists(path), IsFalse());
+            AssertThat(server.latencies().count(), Equals(2ul));
+        });
+#endif
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+});
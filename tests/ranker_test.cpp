@@ -3,10 +3,17 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
 #include "bandit/bandit.h"
+#include "cpptoml.h"
 #include "create_config.h"
 #include "meta/corpus/document.h"
 #include "meta/index/ranker/all.h"
+#include "meta/learn/loss/least_squares.h"
+#include "meta/parallel/thread_pool.h"
 
 using namespace bandit;
 using namespace meta;
@@ -87,7 +94,426 @@ go_bandit([]() {
             test_rank(r, *idx, encoding);
         });
 
+        it("should rank the same with a doc_filter as with a function", [&]() {
+            auto filter = index::doc_filter::from_predicate(
+                idx->num_docs(), [](doc_id d_id) { return d_id % 3 == 0; });
+
+            corpus::document query;
+            query.content("smoking restaurants");
+
+            index::okapi_bm25 r;
+            auto expected = r.score(*idx, query, 20, [](doc_id d_id) {
+                return d_id % 3 == 0;
+            });
+            auto ranking = r.score(*idx, query, 20, filter);
+            AssertThat(ranking.size(), Equals(expected.size()));
+            for (uint64_t i = 0; i < ranking.size(); ++i) {
+                AssertThat(ranking[i].d_id % 3, Equals(0ul));
+                AssertThat(ranking[i].score,
+                           EqualsWithDelta(expected[i].score, 0.0001));
+            }
+        });
+
+        it("should rank the same when a query is split across threads",
+           [&]() {
+               corpus::document query;
+               query.content("smoking restaurants japan");
+
+               index::okapi_bm25 r;
+               parallel::thread_pool pool{4};
+               for (uint64_t n : {1ul, 10ul, 50ul}) {
+                   auto expected = r.score(*idx, query, n);
+                   auto ranking = r.score_parallel(*idx, query, pool, n);
+                   AssertThat(ranking.size(), Equals(expected.size()));
+                   for (uint64_t i = 0; i < ranking.size(); ++i)
+                       AssertThat(ranking[i].score,
+                                  EqualsWithDelta(expected[i].score, 0.0001));
+               }
+
+               auto filter = index::doc_filter::from_predicate(
+                   idx->num_docs(), [](doc_id d_id) { return d_id % 2 == 1; });
+               auto expected = r.score(*idx, query, 20, filter);
+               auto ranking = r.score_parallel(*idx, query, pool, 20,
+                                               [](doc_id d_id) {
+                                                   return d_id % 2 == 1;
+                                               });
+               AssertThat(ranking.size(), Equals(expected.size()));
+               for (uint64_t i = 0; i < ranking.size(); ++i) {
+                   AssertThat(ranking[i].d_id % 2, Equals(1ul));
+                   AssertThat(ranking[i].score,
+                              EqualsWithDelta(expected[i].score, 0.0001));
+               }
+           });
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+
+    describe("[rankers] boolean queries", []() {
+
+        auto config = tests::create_config("file");
+        filesystem::remove_all("ceeaus");
+        auto idx = index::make_index<index::inverted_index>(*config);
+        index::okapi_bm25 r;
+
+        auto contains = [&](doc_id d_id, const std::string& term) {
+            auto stream = idx->stream_for(idx->get_term_id(term));
+            if (!stream)
+                return false;
+            for (const auto& count : *stream) {
+                if (count.first == d_id)
+                    return true;
+            }
+            return false;
+        };
+
+        it("should only rank documents with every required term", [&]() {
+            auto query
+                = index::make_boolean_query(*idx, "+smoking +restaurants");
+            AssertThat(query.must.size(), Equals(2ul));
+
+            auto ranking = r.score(*idx, query, 100);
+            AssertThat(ranking.size(), Is().GreaterThan(0ul));
+
+            // the scores are the same as the disjunctive ranking's for
+            // documents that contain every term
+            auto full = r.score(*idx, query.must.begin(), query.must.end(),
+                                idx->num_docs());
+            for (const auto& result : ranking) {
+                for (const auto& term : query.must)
+                    AssertThat(contains(result.d_id, term.first), IsTrue());
+
+                auto it = std::find_if(full.begin(), full.end(),
+                                       [&](const index::search_result& sr) {
+                                           return sr.d_id == result.d_id;
+                                       });
+                AssertThat(it != full.end(), IsTrue());
+                AssertThat(it->score, EqualsWithDelta(result.score, 0.0001));
+            }
+
+            corpus::document doc;
+            doc.content("smoking restaurants");
+            auto conj = r.score_conjunctive(*idx, doc, 100);
+            AssertThat(conj.size(), Equals(ranking.size()));
+        });
+
+        it("should not rank documents with an excluded term", [&]() {
+            auto query
+                = index::make_boolean_query(*idx, "+smoking -restaurants");
+            AssertThat(query.must_not.size(), Equals(1ul));
+
+            auto ranking = r.score(*idx, query, idx->num_docs());
+            AssertThat(ranking.size(), Is().GreaterThan(0ul));
+            for (const auto& result : ranking) {
+                AssertThat(contains(result.d_id, query.must[0].first),
+                           IsTrue());
+                AssertThat(contains(result.d_id, query.must_not[0]),
+                           IsFalse());
+            }
+        });
+
+        it("should match any optional term without required terms", [&]() {
+            auto query = index::make_boolean_query(*idx, "smoking restaurants");
+            AssertThat(query.should.size(), Equals(2ul));
+
+            auto ranking = r.score(*idx, query);
+            auto full = r.score(*idx, query.should.begin(), query.should.end());
+            AssertThat(ranking.size(), Equals(full.size()));
+            for (uint64_t i = 0; i < ranking.size(); ++i) {
+                AssertThat(ranking[i].score,
+                           EqualsWithDelta(full[i].score, 0.0001));
+            }
+        });
+
+        it("should leave sentence boundary tags out of the query", [&]() {
+            auto query = index::make_boolean_query(
+                *idx, "+smoking. Restaurants? -cheap!");
+            AssertThat(query.must.size(), Equals(1ul));
+            AssertThat(query.should.size(), Equals(1ul));
+            AssertThat(query.must_not.size(), Equals(1ul));
+        });
+
+        it("should intersect a rare and a frequent term", [&]() {
+            // the list of the most common word has skip points to gallop
+            // over
+            auto is_word = [&](term_id t_id) {
+                return idx->term_text(t_id).find('<') == std::string::npos;
+            };
+            term_id frequent{0};
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id) {
+                if (is_word(t_id)
+                    && idx->doc_freq(t_id) > idx->doc_freq(frequent))
+                    frequent = t_id;
+            }
+            AssertThat(idx->doc_freq(frequent),
+                       Is().GreaterThan(index::skip_index::interval));
+
+            std::vector<bool> in_frequent(idx->num_docs(), false);
+            for (const auto& count : *idx->stream_for(frequent))
+                in_frequent[count.first] = true;
+
+            // the rarest word that shares a document with it
+            term_id rare{0};
+            std::vector<doc_id> expected;
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id) {
+                auto df = idx->doc_freq(t_id);
+                if (!is_word(t_id) || df < 2
+                    || (!expected.empty() && df >= idx->doc_freq(rare)))
+                    continue;
+
+                std::vector<doc_id> both;
+                for (const auto& count : *idx->stream_for(t_id)) {
+                    if (in_frequent[count.first])
+                        both.push_back(count.first);
+                }
+                if (!both.empty()) {
+                    rare = t_id;
+                    expected = both;
+                }
+            }
+            AssertThat(expected.empty(), IsFalse());
+
+            index::boolean_query query;
+            query.must.emplace_back(idx->term_text(rare), 1.0f);
+            query.must.emplace_back(idx->term_text(frequent), 1.0f);
+            auto ranking = r.score(*idx, query, idx->num_docs());
+
+            std::vector<doc_id> found;
+            for (const auto& result : ranking)
+                found.push_back(result.d_id);
+            std::sort(found.begin(), found.end());
+            AssertThat(found, Equals(expected));
+        });
+
+        it("should return nothing if a required term is missing", [&]() {
+            auto query = index::make_boolean_query(*idx, "+smoking +zzyzx");
+            AssertThat(r.score(*idx, query).size(), Equals(0ul));
+        });
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+
+    describe("[rankers] pseudo-relevance feedback", []() {
+
+        auto config = tests::create_config("file");
+        filesystem::remove_all("ceeaus");
+        auto idx = index::make_index<index::inverted_index>(*config);
+        auto fwd = index::make_index<index::forward_index>(*config);
+        index::okapi_bm25 base;
+
+        auto check_feedback = [&](const index::feedback_options& options) {
+            index::feedback_ranker r{*idx, *fwd, base, options};
+
+            corpus::document query;
+            query.content("smoking restaurants");
+
+            auto ranking = r.score(query);
+            AssertThat(ranking.size(), Equals(10ul));
+            for (uint64_t i = 1; i < ranking.size(); ++i) {
+                AssertThat(ranking[i - 1].score,
+                           Is().GreaterThanOrEqualTo(ranking[i].score));
+            }
+
+            // the original terms are kept, and at most feedback_terms
+            // terms are added
+            auto counts = idx->tokenize(query);
+            const auto& expanded = r.expanded_query();
+            AssertThat(expanded.size(), Is().GreaterThan(counts.size()));
+            AssertThat(expanded.size(),
+                       Is().LessThanOrEqualTo(options.feedback_terms
+                                              + counts.size()));
+            float query_length = 0;
+            for (const auto& term : counts) {
+                query_length += term.value();
+                auto t_id = idx->get_term_id(term.key());
+                auto it = std::find_if(
+                    expanded.begin(), expanded.end(),
+                    [&](const std::pair<term_id, float>& pr) {
+                        return pr.first == t_id;
+                    });
+                AssertThat(it != expanded.end(), IsTrue());
+            }
+
+            // the expanded query is on the scale of the original query
+            float total = 0;
+            for (const auto& term : expanded)
+                total += term.second;
+            AssertThat(total,
+                       EqualsWithDelta(query_length
+                                           * (options.alpha + options.beta),
+                                       0.001));
+        };
+
+        it("should expand queries with Rocchio feedback", [&]() {
+            index::feedback_options options;
+            check_feedback(options);
+        });
+
+        it("should expand queries with RM3 feedback", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", "rm3");
+            cfg->insert<int64_t>("terms", 10);
+            auto options = index::make_feedback_options(*cfg);
+            AssertThat(options.feedback_terms, Equals(10ul));
+            check_feedback(options);
+        });
+
         idx = nullptr;
+        fwd = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+
+    describe("[rankers] cascade ranking", []() {
+
+        auto config = tests::create_config("file");
+        filesystem::remove_all("ceeaus");
+        auto idx = index::make_index<index::inverted_index>(*config);
+        auto fwd = index::make_index<index::forward_index>(*config);
+        index::okapi_bm25 first_stage;
+
+        std::vector<std::unique_ptr<index::ranker>> rankers;
+        rankers.push_back(make_unique<index::okapi_bm25>());
+        rankers.push_back(make_unique<index::dirichlet_prior>());
+        index::ranking_features features{*idx, *fwd, std::move(rankers)};
+
+        corpus::document query;
+        query.content("smoking restaurants");
+        auto counts = idx->tokenize(query);
+        auto candidates = first_stage.score(*idx, query, 50);
+
+        it("should compute the feature rankers' scores", [&]() {
+            AssertThat(features.size(), Equals(7ul));
+            AssertThat(features.names().size(), Equals(features.size()));
+
+            auto feats = features.compute(query, candidates);
+            AssertThat(feats.size(), Equals(candidates.size()));
+
+            index::dirichlet_prior dirichlet;
+            for (uint64_t i = 0; i < candidates.size(); ++i) {
+                auto d_id = candidates[i].d_id;
+                auto only = [&](doc_id other) { return other == d_id; };
+                auto bm25 = first_stage.score(*idx, counts.begin(),
+                                              counts.end(), 1, only);
+                auto dp = dirichlet.score(*idx, counts.begin(), counts.end(),
+                                          1, only);
+
+                const auto& feat = feats[i];
+                AssertThat(feat.size(), Equals(features.size()));
+                AssertThat(feat.at(learn::feature_id{0}),
+                           Equals(candidates[i].score));
+                AssertThat(feat.at(learn::feature_id{1}),
+                           EqualsWithDelta(bm25.at(0).score, 0.001));
+                AssertThat(feat.at(learn::feature_id{2}),
+                           EqualsWithDelta(dp.at(0).score, 0.001));
+
+                // coverage and cosine
+                AssertThat(feat.at(learn::feature_id{5}),
+                           Is().GreaterThan(0.0));
+                AssertThat(feat.at(learn::feature_id{6}),
+                           Is().GreaterThan(0.0).And().LessThanOrEqualTo(1.0));
+            }
+        });
+
+        it("should re-rank the candidates with a linear model", [&]() {
+            auto feats = features.compute(query, candidates);
+            learn::sgd_model model{features.size()};
+            learn::loss::least_squares loss;
+            for (uint64_t i = 0; i < feats.size(); ++i)
+                model.train_one(feats[i], i % 3 == 0 ? 1.0 : 0.0, loss);
+
+            auto expected = candidates;
+            for (uint64_t i = 0; i < expected.size(); ++i)
+                expected[i].score
+                    = static_cast<float>(model.predict(feats[i]));
+            std::stable_sort(expected.begin(), expected.end(),
+                             [](const index::search_result& a,
+                                const index::search_result& b) {
+                                 return a.score > b.score;
+                             });
+
+            index::cascade_ranker r{*idx, first_stage, features, model, 50};
+            auto ranking = r.score(query);
+            AssertThat(ranking.size(), Equals(10ul));
+            for (uint64_t i = 0; i < ranking.size(); ++i) {
+                AssertThat(ranking[i].d_id, Equals(expected[i].d_id));
+                AssertThat(ranking[i].score, Equals(expected[i].score));
+            }
+        });
+
+        it("should reject unknown priors", [&]() {
+            AssertThrows(index::ranker_exception,
+                         index::ranking_features(
+                             *idx, *fwd, {}, {"no-such-field"}));
+        });
+
+        idx = nullptr;
+        fwd = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+
+    describe("[rankers] score-at-a-time", []() {
+
+        auto config = tests::create_config("file");
+        auto impact_cfg = cpptoml::make_table();
+        config->insert("impact-index", impact_cfg);
+
+        auto check_ranking = [&](index::ranker& exhaustive) {
+            filesystem::remove_all("ceeaus");
+            auto idx = index::make_index<index::inverted_index>(*config);
+            index::impact_index impacts{*idx};
+            index::saat_ranker r{*idx, impacts};
+
+            corpus::document query;
+            query.content("character");
+
+            auto ranking = r.score(query);
+            AssertThat(ranking.size(), Equals(10ul));
+            AssertThat(r.terminated_early(), IsFalse());
+            AssertThat(r.postings_processed(), Is().GreaterThan(5ul));
+            for (uint64_t i = 1; i < ranking.size(); ++i) {
+                AssertThat(ranking[i - 1].score,
+                           Is().GreaterThanOrEqualTo(ranking[i].score));
+            }
+
+            // without a budget, every document is scored as the exhaustive
+            // ranker scores it, up to the rounding of each term's impact
+            auto num_terms = idx->tokenize(query).size();
+            auto all = r.score(query, idx->num_docs());
+            auto expected = exhaustive.score(*idx, query, idx->num_docs());
+            AssertThat(all.size(), Equals(expected.size()));
+            std::unordered_map<doc_id, float> scores;
+            for (const auto& result : expected)
+                scores[result.d_id] = result.score;
+            for (const auto& result : all) {
+                AssertThat(scores.count(result.d_id), Equals(1ul));
+                auto score = scores[result.d_id];
+                auto delta = num_terms * impacts.quantum()
+                             + 0.01 * (1 + std::abs(score));
+                AssertThat(result.score, EqualsWithDelta(score, delta));
+            }
+
+            index::saat_budget budget;
+            budget.postings = 5;
+            auto partial = r.score(query, 10, budget);
+            AssertThat(r.terminated_early(), IsTrue());
+            AssertThat(r.postings_processed(), Equals(5ul));
+            AssertThat(partial.size(), Is().LessThanOrEqualTo(5ul));
+            AssertThat(partial.size(), Is().GreaterThan(0ul));
+        };
+
+        it("should rank with quantized BM25 impacts", [&]() {
+            impact_cfg->insert("method", "bm25");
+            index::okapi_bm25 exhaustive;
+            check_ranking(exhaustive);
+        });
+
+        it("should rank with quantized Dirichlet prior impacts", [&]() {
+            impact_cfg->insert("method", "dirichlet-prior");
+            index::dirichlet_prior exhaustive;
+            check_ranking(exhaustive);
+        });
+
         filesystem::remove_all("ceeaus");
     });
 });
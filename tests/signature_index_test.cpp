@@ -0,0 +1,242 @@
+/**
+ * @file signature_index_test.cpp
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/index/ranker/ranker.h"
+#include "meta/index/signature_index.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+analyzers::feature_map<uint64_t> make_counts(uint64_t begin, uint64_t end) {
+    analyzers::feature_map<uint64_t> counts;
+    for (uint64_t i = begin; i < end; ++i)
+        counts["word" + std::to_string(i)] = 1 + i % 3;
+    return counts;
+}
+
+/**
+ * @return a word of letters that no other value of i gives
+ */
+std::string make_word(uint64_t i) {
+    std::string word = "zq";
+    do {
+        word += static_cast<char>('a' + i % 26);
+        i /= 26;
+    } while (i > 0);
+    return word;
+}
+
+/**
+ * Writes a line corpus of 20 unrelated documents followed by a
+ * near-duplicate of document 3, an exact duplicate of document 7, and two
+ * empty documents.
+ */
+void make_duplicates_corpus(const std::string& dir) {
+    filesystem::remove_all(dir);
+    filesystem::make_directories(dir);
+    {
+        std::ofstream corpus_config{dir + "/line.toml"};
+        corpus_config << "type = \"line-corpus\"\n";
+    }
+
+    auto document = [](uint64_t d) {
+        std::string text;
+        for (uint64_t i = 0; i < 80; ++i)
+            text += make_word(d * 100 + i) + " ";
+        return text;
+    };
+
+    std::ofstream lines{dir + "/" + dir + ".dat"};
+    for (uint64_t d = 0; d < 20; ++d)
+        lines << document(d) << "\n";
+    lines << document(3) << make_word(9999) << "\n";
+    lines << document(7) << "\n";
+    lines << "\n\n";
+}
+
+double agreement(const std::vector<uint64_t>& a,
+                 const std::vector<uint64_t>& b) {
+    uint64_t agree = 0;
+    for (uint64_t i = 0; i < a.size(); ++i)
+        agree += a[i] == b[i];
+    return static_cast<double>(agree) / a.size();
+}
+}
+
+go_bandit([]() {
+
+    describe("[signature index] signatures", []() {
+
+        it("should estimate Jaccard similarity with minhash", []() {
+            index::signature_options options;
+            options.bands = 32;
+            options.rows = 8;
+
+            std::vector<uint64_t> a(options.width());
+            std::vector<uint64_t> b(options.width());
+            std::vector<uint64_t> c(options.width());
+            index::compute_signature(options, make_counts(0, 100), a.data());
+            index::compute_signature(options, make_counts(0, 100), b.data());
+            AssertThat(a, Equals(b));
+
+            // 50 shared words out of 150
+            index::compute_signature(options, make_counts(50, 150), c.data());
+            AssertThat(agreement(a, c), Is().GreaterThan(0.2));
+            AssertThat(agreement(a, c), Is().LessThan(0.5));
+        });
+
+        it("should give similar documents close simhash fingerprints", []() {
+            index::signature_options options;
+            options.method = index::signature_options::method_type::simhash;
+            AssertThat(options.width(), Equals(1ul));
+
+            uint64_t a, b, c;
+            index::compute_signature(options, make_counts(0, 200), &a);
+            index::compute_signature(options, make_counts(0, 198), &b);
+            index::compute_signature(options, make_counts(200, 400), &c);
+
+            auto distance = [](uint64_t x, uint64_t y) {
+                uint64_t bits = 0;
+                for (auto v = x ^ y; v != 0; v &= v - 1)
+                    ++bits;
+                return bits;
+            };
+            AssertThat(distance(a, b), Is().LessThan(distance(a, c)));
+        });
+
+        it("should reject invalid options", []() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", std::string{"nohash"});
+            AssertThrows(index::signature_index_exception,
+                         index::make_signature_options(*cfg));
+
+            cfg = cpptoml::make_table();
+            cfg->insert("bands", int64_t{0});
+            AssertThrows(index::signature_index_exception,
+                         index::make_signature_options(*cfg));
+        });
+    });
+
+    describe("[signature index] near-duplicates", []() {
+
+        auto config = tests::create_config("file");
+        auto sig_cfg = cpptoml::make_table();
+        sig_cfg->insert("bands", int64_t{8});
+        sig_cfg->insert("rows", int64_t{2});
+        config->insert("signatures", sig_cfg);
+
+        filesystem::remove_all("ceeaus");
+        auto idx = index::make_index<index::inverted_index>(*config);
+
+        AssertThat(index::signature_index::exists(*idx), IsTrue());
+        index::signature_index sigs{*idx};
+
+        it("should store a signature for every document", [&]() {
+            AssertThat(sigs.num_docs(), Equals(idx->num_docs()));
+            AssertThat(sigs.signature(doc_id{0}).size(), Equals(16ul));
+            for (doc_id d_id{0}; d_id < idx->num_docs(); ++d_id)
+                AssertThat(sigs.similarity(d_id, d_id), Equals(1.0));
+        });
+
+        it("should find candidates that share a band", [&]() {
+            for (doc_id d_id{0}; d_id < idx->num_docs(); d_id += 50) {
+                auto candidates = sigs.candidates(d_id);
+                AssertThat(std::is_sorted(candidates.begin(),
+                                          candidates.end()),
+                           IsTrue());
+                AssertThat(std::find(candidates.begin(), candidates.end(),
+                                     d_id),
+                           Equals(candidates.end()));
+
+                for (const auto& other : candidates)
+                    AssertThat(sigs.similarity(d_id, other),
+                               Is().GreaterThan(0.0));
+            }
+        });
+
+        it("should cluster the documents in parallel", [&]() {
+            auto clusters = sigs.clusters(0.5, 4);
+            std::vector<bool> seen(idx->num_docs(), false);
+            for (const auto& cluster : clusters) {
+                AssertThat(cluster.size(), Is().GreaterThan(1ul));
+                AssertThat(std::is_sorted(cluster.begin(), cluster.end()),
+                           IsTrue());
+                for (const auto& d_id : cluster) {
+                    AssertThat(seen[d_id], IsFalse());
+                    seen[d_id] = true;
+                }
+            }
+            AssertThat(sigs.clusters(0.5, 1), Equals(clusters));
+        });
+
+        it("should collapse duplicate results", [&]() {
+            std::vector<index::search_result> results;
+            results.emplace_back(doc_id{3}, 3.0f);
+            results.emplace_back(doc_id{3}, 2.0f);
+            results.emplace_back(doc_id{7}, 1.0f);
+            results.emplace_back(doc_id{9}, 0.5f);
+
+            auto collapsed = index::collapse_duplicates(sigs, results, 1.0, 2);
+            AssertThat(collapsed.size(), Equals(2ul));
+            AssertThat(collapsed[0].d_id, Equals(doc_id{3}));
+            AssertThat(collapsed[1].d_id, Equals(doc_id{7}));
+        });
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+
+    describe("[signature index] planted duplicates", []() {
+
+        make_duplicates_corpus("sig-dups");
+        auto config = tests::create_config("line");
+        config->insert("prefix", ".");
+        config->insert("dataset", "sig-dups");
+        config->insert("encoding", "utf-8");
+        config->insert("index", "sig-dups-index");
+        auto sig_cfg = cpptoml::make_table();
+        sig_cfg->insert("bands", int64_t{8});
+        sig_cfg->insert("rows", int64_t{2});
+        config->insert("signatures", sig_cfg);
+
+        filesystem::remove_all("sig-dups-index");
+        auto idx = index::make_index<index::inverted_index>(*config);
+        index::signature_index sigs{*idx};
+
+        it("should cluster the planted duplicates", [&]() {
+            AssertThat(idx->num_docs(), Equals(24ul));
+            auto clusters = sigs.clusters(0.5, 4);
+            std::vector<std::vector<doc_id>> expected{{doc_id{3}, doc_id{20}},
+                                                      {doc_id{7}, doc_id{21}}};
+            AssertThat(clusters, Equals(expected));
+            AssertThat(sigs.clusters(0.5, 1), Equals(clusters));
+        });
+
+        it("should not treat empty documents as duplicates", [&]() {
+            AssertThat(idx->doc_size(doc_id{22}), Equals(0ul));
+            AssertThat(sigs.candidates(doc_id{22}).empty(), IsTrue());
+            AssertThat(sigs.similarity(doc_id{22}, doc_id{23}), Equals(0.0));
+            AssertThat(sigs.similarity(doc_id{22}, doc_id{22}), Equals(1.0));
+
+            std::vector<index::search_result> results;
+            results.emplace_back(doc_id{22}, 2.0f);
+            results.emplace_back(doc_id{23}, 1.0f);
+            auto collapsed = index::collapse_duplicates(sigs, results, 0.5, 2);
+            AssertThat(collapsed.size(), Equals(2ul));
+        });
+
+        idx = nullptr;
+        filesystem::remove_all("sig-dups-index");
+        filesystem::remove_all("sig-dups");
+    });
+});
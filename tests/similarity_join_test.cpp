@@ -0,0 +1,152 @@
+/**
+ * @file similarity_join_test.cpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/index/forward_index.h"
+#include "meta/index/similarity_join.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+/**
+ * Computes the unit-length tf-idf vector of every document directly.
+ */
+std::vector<std::unordered_map<uint64_t, double>>
+tf_idf_vectors(const index::forward_index& fwd) {
+    std::vector<uint64_t> doc_freqs(fwd.unique_terms(), 0);
+    for (doc_id d_id{0}; d_id < fwd.num_docs(); ++d_id) {
+        auto stream = fwd.stream_for(d_id);
+        for (const auto& count : *stream)
+            ++doc_freqs[count.first];
+    }
+
+    std::vector<std::unordered_map<uint64_t, double>> vectors(
+        fwd.num_docs());
+    for (doc_id d_id{0}; d_id < fwd.num_docs(); ++d_id) {
+        auto stream = fwd.stream_for(d_id);
+        double norm = 0;
+        for (const auto& count : *stream) {
+            auto weight
+                = (1.0 + std::log(count.second))
+                  * std::log(static_cast<double>(fwd.num_docs())
+                             / doc_freqs[count.first]);
+            if (weight <= 0)
+                continue;
+            vectors[d_id][count.first] = weight;
+            norm += weight * weight;
+        }
+        for (auto& weight : vectors[d_id])
+            weight.second /= std::sqrt(norm);
+    }
+    return vectors;
+}
+}
+
+go_bandit([]() {
+
+    describe("[similarity join]", []() {
+
+        auto config = tests::create_config("file");
+        filesystem::remove_all("ceeaus");
+        auto fwd = index::make_index<index::forward_index>(*config);
+
+        index::similarity_join_options options;
+        options.threshold = 0.2;
+        options.num_threads = 4;
+        auto lists = index::all_pairs_similarity(*fwd, options);
+
+        it("should find exactly the pairs over the threshold", [&]() {
+            AssertThat(lists.size(), Equals(fwd->num_docs()));
+
+            auto vectors = tf_idf_vectors(*fwd);
+            for (doc_id a{0}; a < fwd->num_docs(); a += 100) {
+                std::vector<std::pair<doc_id, double>> expected;
+                for (doc_id b{0}; b < fwd->num_docs(); ++b) {
+                    if (a == b)
+                        continue;
+                    double sim = 0;
+                    for (const auto& weight : vectors[a]) {
+                        auto it = vectors[b].find(weight.first);
+                        if (it != vectors[b].end())
+                            sim += weight.second * it->second;
+                    }
+                    if (sim >= options.threshold)
+                        expected.emplace_back(b, sim);
+                }
+
+                AssertThat(lists[a].size(), Equals(expected.size()));
+                for (const auto& pair : expected) {
+                    auto it = std::find_if(
+                        lists[a].begin(), lists[a].end(),
+                        [&](const std::pair<doc_id, double>& found) {
+                            return found.first == pair.first;
+                        });
+                    AssertThat(it, Is().Not().EqualTo(lists[a].end()));
+                    AssertThat(it->second, EqualsWithDelta(pair.second, 1e-9));
+                }
+            }
+        });
+
+        it("should produce symmetric, sorted lists", [&]() {
+            for (doc_id a{0}; a < lists.size(); ++a) {
+                for (uint64_t i = 0; i < lists[a].size(); ++i) {
+                    const auto& pair = lists[a][i];
+                    if (i > 0)
+                        AssertThat(pair.second,
+                                   Is().LessThanOrEqualTo(
+                                       lists[a][i - 1].second));
+
+                    const auto& other = lists[pair.first];
+                    auto it = std::find_if(
+                        other.begin(), other.end(),
+                        [&](const std::pair<doc_id, double>& found) {
+                            return found.first == a;
+                        });
+                    AssertThat(it, Is().Not().EqualTo(other.end()));
+                }
+            }
+        });
+
+        it("should not depend on the number of threads", [&]() {
+            auto serial = options;
+            serial.num_threads = 1;
+            AssertThat(index::all_pairs_similarity(*fwd, serial),
+                       Equals(lists));
+        });
+
+        it("should keep the nearest neighbors with a top-k", [&]() {
+            auto top = options;
+            top.top_k = 3;
+            auto nearest = index::all_pairs_similarity(*fwd, top);
+            AssertThat(nearest.size(), Equals(lists.size()));
+            for (doc_id d_id{0}; d_id < lists.size(); ++d_id) {
+                auto size = std::min<uint64_t>(3, lists[d_id].size());
+                AssertThat(nearest[d_id].size(), Equals(size));
+                for (uint64_t i = 0; i < size; ++i)
+                    AssertThat(nearest[d_id][i].second,
+                               EqualsWithDelta(lists[d_id][i].second, 1e-9));
+            }
+
+            auto graph = index::make_similarity_graph(*fwd, nearest);
+            AssertThat(graph.size(), Equals(fwd->num_docs()));
+        });
+
+        it("should reject invalid thresholds", [&]() {
+            auto bad = options;
+            bad.threshold = 0;
+            AssertThrows(index::similarity_join_exception,
+                         index::all_pairs_similarity(*fwd, bad));
+        });
+
+        fwd = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+});
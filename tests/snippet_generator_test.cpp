@@ -0,0 +1,71 @@
+/**
+ * @file snippet_generator_test.cpp
+ */
+
+#include "bandit/bandit.h"
+#include "create_config.h"
+#include "meta/corpus/corpus_factory.h"
+#include "meta/corpus/document.h"
+#include "meta/index/ranker/okapi_bm25.h"
+#include "meta/index/snippet_generator.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+
+    describe("[snippet generator]", []() {
+
+        auto config = tests::create_config("file");
+        filesystem::remove_all("ceeaus");
+        auto docs = corpus::make_corpus(*config);
+        docs->set_store_full_text(true);
+        auto idx = index::make_index<index::inverted_index>(*config, *docs);
+
+        corpus::document query;
+        query.content("smoking restaurants");
+
+        index::okapi_bm25 r;
+        auto ranking = r.score(*idx, query);
+
+        it("should highlight the query terms in each result", [&]() {
+            index::snippet_options options;
+            options.window = 10;
+            index::snippet_generator gen{*idx, options, 4};
+
+            auto snippets
+                = gen.generate(query, ranking.begin(), ranking.end());
+            AssertThat(snippets.size(), Equals(ranking.size()));
+            for (uint64_t i = 0; i < snippets.size(); ++i) {
+                AssertThat(snippets[i].d_id, Equals(ranking[i].d_id));
+                AssertThat(snippets[i].fragments.size(),
+                           Is().GreaterThan(0ul));
+                AssertThat(snippets[i].fragments.size(),
+                           Is().LessThanOrEqualTo(options.max_fragments));
+
+                // every result matches the query, so its best fragment
+                // has a highlighted word
+                bool highlighted = false;
+                for (const auto& fragment : snippets[i].fragments)
+                    highlighted |= fragment.find("<b>") != std::string::npos;
+                AssertThat(highlighted, IsTrue());
+            }
+        });
+
+        it("should use the beginning of a document without matches", [&]() {
+            index::snippet_options options;
+            options.window = 3;
+            index::snippet_generator gen{*idx, options, 2};
+
+            corpus::document none;
+            none.content("zzyzx");
+            auto snippets = gen.generate(none, {doc_id{0}});
+            AssertThat(snippets.size(), Equals(1ul));
+            AssertThat(snippets[0].fragments.size(), Equals(1ul));
+            AssertThat(snippets[0].fragments[0], StartsWith("In my opinion"));
+        });
+
+        idx = nullptr;
+        filesystem::remove_all("ceeaus");
+    });
+});
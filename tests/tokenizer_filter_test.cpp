@@ -4,15 +4,21 @@
  * @author Chase Geigle
  */
 
+#include <cctype>
+#include <sstream>
 #include <vector>
 
 #include "meta/analyzers/tokenizers/whitespace_tokenizer.h"
 #include "meta/analyzers/tokenizers/icu_tokenizer.h"
 #include "meta/analyzers/tokenizers/character_tokenizer.h"
+#include "meta/analyzers/analyzer.h"
 #include "meta/analyzers/filters/all.h"
 #include "bandit/bandit.h"
 #include "meta/corpus/document.h"
 #include "create_config.h"
+#include "meta/io/filesystem.h"
+#include "meta/utf/ascii.h"
+#include "meta/utf/utf.h"
 #include "meta/util/shim.h"
 
 using namespace bandit;
@@ -27,6 +33,44 @@ void check_expected(analyzers::token_stream& filter,
         AssertThat(filter.next(), Equals(s));
     AssertThat(static_cast<bool>(filter), IsFalse());
 }
+
+std::vector<std::string> read_views(analyzers::token_stream& stream,
+                                    analyzers::token_arena& arena,
+                                    const std::string& content) {
+    arena.clear();
+    stream.set_view_content(std::string{content}, arena);
+    std::vector<std::string> tokens;
+    while (stream)
+        tokens.push_back(stream.next_view(arena).to_string());
+    return tokens;
+}
+
+std::vector<std::string> read_tokens(analyzers::token_stream& stream,
+                                     const std::string& content) {
+    stream.set_content(std::string{content});
+    std::vector<std::string> tokens;
+    while (stream)
+        tokens.push_back(stream.next());
+    return tokens;
+}
+
+std::unique_ptr<analyzers::token_stream>
+    make_dynamic_chain(const cpptoml::table& config, bool unigram) {
+    using namespace analyzers;
+    auto stopwords_file = *config.get_as<std::string>("stop-words");
+    std::unique_ptr<token_stream> stream;
+    stream = make_unique<tokenizers::icu_tokenizer>(unigram);
+    stream = make_unique<filters::lowercase_filter>(std::move(stream));
+    stream = make_unique<filters::alpha_filter>(std::move(stream));
+    stream = make_unique<filters::length_filter>(std::move(stream), 2, 35);
+    stream = make_unique<filters::list_filter>(std::move(stream),
+                                               stopwords_file);
+    stream = make_unique<filters::porter2_filter>(std::move(stream));
+    if (!unigram)
+        stream
+            = make_unique<filters::empty_sentence_filter>(std::move(stream));
+    return stream;
+}
 }
 
 go_bandit([]() {
@@ -50,6 +94,12 @@ go_bandit([]() {
             std::vector<std::string> expected = {"aa", "b", "c", "d"};
             check_expected(*norm, expected);
         });
+
+        it("should drop bytes of invalid utf8", [&]() {
+            norm->set_content("\xc3\x89t\xc3\xa9 \xc3tat\xc3\xa9 \xff\xc3");
+            std::vector<std::string> expected = {"\xc3\x89t\xc3\xa9", "tat"};
+            check_expected(*norm, expected);
+        });
     });
 
     describe("[tokenizer-filter] english_normalizer", [&]() {
@@ -76,6 +126,13 @@ go_bandit([]() {
                    " ",    "do",  " ",     "something", "."};
             check_expected(*norm, expected);
         });
+
+        it("should keep words that start with non-ASCII letters", [&]() {
+            norm->set_content("ÉCOLE, étés \"Über\"");
+            std::vector<std::string> expected
+                = {"ÉCOLE", ",", " ", "étés", " ", "``", "Über", "''"};
+            check_expected(*norm, expected);
+        });
     });
 
     describe("[tokenizer-filter] icu_filter", [&]() {
@@ -152,6 +209,19 @@ go_bandit([]() {
                    " ",          " ", " ", "big", " ", "house"};
             check_expected(*norm, expected);
         });
+
+        it("should read its list like std::getline", [&]() {
+            std::istringstream in{"a\nthe\n\nof\nthe\nlast"};
+            filters::word_set words{in};
+            AssertThat(words.size(), Equals(5ul));
+            for (const auto& word : {"a", "the", "", "of", "last"})
+                AssertThat(words.contains(word), IsTrue());
+            for (const auto& word : {"th", "them", "\n", "lastly"})
+                AssertThat(words.contains(word), IsFalse());
+
+            std::istringstream empty{""};
+            AssertThat(filters::word_set{empty}.contains(""), IsFalse());
+        });
     });
 
     describe("[tokenizer-filter] lowercase_filter", [&]() {
@@ -165,6 +235,15 @@ go_bandit([]() {
                    "case", " ",  "is",    " ", "here!"};
             check_expected(*norm, expected);
         });
+
+        it("should only lowercase ASCII in invalid utf8", [&]() {
+            auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+            auto norm = make_unique<filters::lowercase_filter>(std::move(tok));
+            norm->set_content("\xc3" "COLE CAF\xc3\x89 A\xff\xc3");
+            std::vector<std::string> expected
+                = {"\xc3" "cole", " ", "caf\xc3\xa9", " ", "a\xff\xc3"};
+            check_expected(*norm, expected);
+        });
     });
 
     describe("[tokenizer-filter] porter2_filter", [&]() {
@@ -182,6 +261,29 @@ go_bandit([]() {
                 "inform", " ", "retrieval,", " ", "stem"};
             check_expected(*norm, expected);
         });
+
+        it("should produce the same stems with any size of cache", [&]() {
+            auto content
+                = filesystem::file_text("../data/sample-document.txt");
+            auto make_filter = [](uint64_t cache_size) {
+                auto tok = make_unique<tokenizers::icu_tokenizer>();
+                return make_unique<filters::porter2_filter>(std::move(tok),
+                                                            cache_size);
+            };
+            auto uncached = make_filter(0);
+            auto expected = read_tokens(*uncached, content);
+
+            // a tiny cache is emptied many times within the document
+            token_arena arena;
+            for (uint64_t cache_size : {3ul, 65536ul}) {
+                auto cached = make_filter(cache_size);
+                AssertThat(read_tokens(*cached, content), Equals(expected));
+                AssertThat(read_views(*cached, arena, content),
+                           Equals(expected));
+                auto copy = cached->clone();
+                AssertThat(read_tokens(*copy, content), Equals(expected));
+            }
+        });
     });
 
     describe("[tokenizer-filter] ptb_normalizer", [&]() {
@@ -271,6 +373,51 @@ go_bandit([]() {
                    "said", ".",   "(", "What", "?", ")"};
             check_expected(*tok, expected);
         });
+
+        it("should segment ASCII and Latin-1 text the same way as ICU",
+           [&]() {
+               // the default tokenizer segments this text without ICU,
+               // while one with a language always uses ICU
+               tokenizers::icu_tokenizer fast;
+               tokenizers::icu_tokenizer slow{utf::segmenter{"en"}};
+               std::vector<std::string> docs = {
+                   "Mr. Smith paid $3.50 (or 3,000.5 cents) for U.S. "
+                   "goods. ok? \"Yes!\" she said... then left.\n\n"
+                   "Don't split can't, or foo_bar42; a:b a.b a..b 1.a.",
+                   "Étés naïve CAFÉ. über-cool résumé; Zoë's ×2 ÷3.\t",
+                   "etc. 5 dogs. e.g. this (is it?) [really].  ",
+                   "", "   ", "?!?", "a"};
+               for (const auto& doc : docs)
+               {
+                   fast.set_content(std::string{doc});
+                   slow.set_content(std::string{doc});
+                   while (fast && slow)
+                       AssertThat(fast.next(), Equals(slow.next()));
+                   AssertThat(static_cast<bool>(fast), IsFalse());
+                   AssertThat(static_cast<bool>(slow), IsFalse());
+               }
+           });
+
+        it("should tokenize text outside of Latin-1", [&]() {
+            auto tok = make_unique<tokenizers::icu_tokenizer>();
+            tok->set_content("Γειά σου κόσμε. Hi\nthere.");
+            std::vector<std::string> expected
+                = {"<s>",  "Γειά", "σου", "κόσμε", ".",   "</s>",
+                   "<s>", "Hi",   "there", ".",   "</s>"};
+            check_expected(*tok, expected);
+        });
+
+        it("should copy its position when cloned", [&]() {
+            auto tok = make_unique<tokenizers::icu_tokenizer>();
+            tok->set_content("One two. Three four.");
+            tok->next();
+            tok->next();
+            auto copy = tok->clone();
+            tok->set_content("Something else.");
+            std::vector<std::string> expected
+                = {"two", ".", "</s>", "<s>", "Three", "four", ".", "</s>"};
+            check_expected(*copy, expected);
+        });
     });
 
     describe("[tokenizer-filter] character_tokenizer", [&]() {
@@ -285,4 +432,223 @@ go_bandit([]() {
             check_expected(*tok, expected);
         });
     });
+
+    describe("[tokenizer-filter] token views", [&]() {
+        std::string content = "\"The QUICK brown fox's jumps---over 42 "
+                              "lazy dogs.\" Isn't it naïve? ÉCOLE, étés.";
+        token_arena arena;
+
+        it("should produce the expected tokens", [&]() {
+            std::vector<std::string> expected
+                = {"<s>", "quick", "brown", "fox", "jump", "lazi",
+                   "dog", "</s>", "<s>", "isn't", "naïv", "</s>",
+                   "<s>", "école", "étés", "</s>"};
+            auto stream = default_filter_chain(*config);
+            AssertThat(read_tokens(*stream, content), Equals(expected));
+            AssertThat(read_views(*stream, arena, content), Equals(expected));
+
+            auto dynamic = make_dynamic_chain(*config, false);
+            AssertThat(read_tokens(*dynamic, content), Equals(expected));
+            AssertThat(read_views(*dynamic, arena, content), Equals(expected));
+        });
+
+        it("should work with filters that copy their tokens", [&]() {
+            auto stopwords_file = *config->get_as<std::string>("stop-words");
+            std::unique_ptr<token_stream> stream;
+            stream = make_unique<tokenizers::whitespace_tokenizer>();
+            stream
+                = make_unique<filters::english_normalizer>(std::move(stream));
+            stream = make_unique<filters::sentence_boundary>(std::move(stream));
+            stream = make_unique<filters::lowercase_filter>(std::move(stream));
+            stream = make_unique<filters::alpha_filter>(std::move(stream));
+            stream = make_unique<filters::list_filter>(
+                std::move(stream), stopwords_file,
+                filters::list_filter::type::REJECT);
+            stream = make_unique<filters::porter2_filter>(std::move(stream));
+
+            std::vector<std::string> expected
+                = {"<s>",  "quick", "brown", "fox",  "'s",  "jump",
+                   "lazi", "dog",   "isn",   "'t",   "naïv", "</s>",
+                   "<s>",  "école", "étés",  "</s>"};
+            AssertThat(read_tokens(*stream, content), Equals(expected));
+            AssertThat(read_views(*stream, arena, content), Equals(expected));
+        });
+
+        it("should reuse the arena across documents", [&]() {
+            auto stream = default_filter_chain(*config);
+            read_views(*stream, arena, content);
+            auto capacity = arena.capacity();
+            for (int i = 0; i < 10; ++i)
+                read_views(*stream, arena, content);
+            AssertThat(arena.capacity(), Equals(capacity));
+        });
+
+        it("should copy buffered tokens when cloned", [&]() {
+            auto stream = default_filter_chain(*config);
+            auto expected = read_tokens(*stream, content);
+
+            std::unique_ptr<token_stream> copy;
+            {
+                token_arena doc_arena;
+                stream->set_view_content(std::string{content}, doc_arena);
+                copy = stream->clone();
+            }
+            std::vector<std::string> tokens;
+            while (*copy)
+                tokens.push_back(copy->next());
+            AssertThat(tokens, Equals(expected));
+        });
+    });
+
+    describe("[tokenizer-filter] fused_chain", [&]() {
+        std::vector<std::string> contents
+            = {"\"The QUICK brown fox's jumps---over 42 lazy dogs.\" Isn't "
+               "it naïve? ÉCOLE, étés.",
+               "Hi. . . There! A. I. The end.", ". . .", "",
+               filesystem::file_text("../data/sample-document.txt")};
+        token_arena arena;
+
+        it("should produce the same tokens as the dynamic chain", [&]() {
+            auto fused = default_filter_chain(*config);
+            auto dynamic = make_dynamic_chain(*config, false);
+            for (const auto& content : contents) {
+                auto expected = read_tokens(*dynamic, content);
+                AssertThat(read_tokens(*fused, content), Equals(expected));
+                AssertThat(read_views(*fused, arena, content),
+                           Equals(expected));
+            }
+        });
+
+        it("should produce the same unigrams as the dynamic chain", [&]() {
+            auto fused = default_unigram_chain(*config);
+            auto dynamic = make_dynamic_chain(*config, true);
+            for (const auto& content : contents) {
+                auto expected = read_tokens(*dynamic, content);
+                AssertThat(read_tokens(*fused, content), Equals(expected));
+                AssertThat(read_views(*fused, arena, content),
+                           Equals(expected));
+            }
+        });
+
+        it("should copy its position when cloned", [&]() {
+            auto fused = default_filter_chain(*config);
+            auto expected = read_tokens(*fused, contents.back());
+
+            fused->set_content(std::string{contents.back()});
+            for (int i = 0; i < 10; ++i)
+                fused->next();
+            auto copy = fused->clone();
+            std::vector<std::string> tokens;
+            while (*copy)
+                tokens.push_back(copy->next());
+            AssertThat(tokens, Equals(std::vector<std::string>(
+                                   expected.begin() + 10, expected.end())));
+        });
+    });
+
+    describe("[tokenizer-filter] utf ascii functions", []() {
+        // every byte value, so that each one is seen at every position of
+        // a word
+        std::string bytes;
+        for (int i = 0; i < 256; ++i)
+            bytes.push_back(static_cast<char>(i));
+
+        it("should classify bytes like <cctype>", [&]() {
+            for (const auto& c : bytes) {
+                auto uc = static_cast<unsigned char>(c);
+                for (uint64_t len = 1; len <= 17; ++len) {
+                    std::string str(len, c);
+                    bool ascii = uc < 0x80;
+                    AssertThat(utf::is_ascii(str), Equals(ascii));
+                    AssertThat(utf::is_ascii_alpha(str),
+                               Equals(ascii && std::isalpha(uc)));
+                    AssertThat(utf::is_ascii_alnum(str),
+                               Equals(ascii && std::isalnum(uc)));
+                    AssertThat(utf::is_ascii_space(str),
+                               Equals(ascii && std::isspace(uc)));
+                    AssertThat(utf::is_ascii_punct(str),
+                               Equals(ascii && std::ispunct(uc)));
+                    AssertThat(utf::has_ascii_upper(str),
+                               Equals(ascii && std::isupper(uc)));
+
+                    // one odd byte anywhere in a word makes it fail
+                    std::string mixed(len, 'a');
+                    mixed[len - 1] = c;
+                    AssertThat(utf::is_ascii_alpha(mixed),
+                               Equals(ascii && std::isalpha(uc)));
+                }
+            }
+            AssertThat(utf::is_ascii(""), IsTrue());
+            AssertThat(utf::has_ascii_upper(""), IsFalse());
+        });
+
+        it("should lowercase only ASCII letters", [&]() {
+            std::string expected = bytes;
+            for (auto& c : expected) {
+                if (c >= 'A' && c <= 'Z')
+                    c = static_cast<char>(c - 'A' + 'a');
+            }
+            std::string lower(bytes.size(), '\0');
+            utf::ascii_tolower(bytes, &lower[0]);
+            AssertThat(lower, Equals(expected));
+
+            for (uint64_t len = 0; len < 20; ++len) {
+                auto str = bytes.substr(60, len);
+                utf::ascii_tolower(str, &str[0]);
+                AssertThat(str, Equals(expected.substr(60, len)));
+            }
+        });
+
+        it("should find the ASCII prefix of a string", [&]() {
+            AssertThat(utf::ascii_prefix(""), Equals(0ul));
+            AssertThat(utf::ascii_prefix("abc"), Equals(3ul));
+            AssertThat(utf::ascii_prefix("na\xc3\xafve"), Equals(2ul));
+            AssertThat(utf::ascii_prefix(bytes), Equals(128ul));
+        });
+
+        it("should find the first ASCII punctuation of a string", [&]() {
+            AssertThat(utf::ascii_punct_offset(""), Equals(0ul));
+            AssertThat(utf::ascii_punct_offset("caf\xc3\xa9"), Equals(5ul));
+            for (uint64_t len = 1; len <= 20; ++len) {
+                for (uint64_t pos = 0; pos < len; ++pos) {
+                    std::string str(len, 'a');
+                    str[pos] = '-';
+                    AssertThat(utf::ascii_punct_offset(str), Equals(pos));
+                }
+            }
+            // the first punctuation of the bytes is "!" (0x21)
+            AssertThat(utf::ascii_punct_offset(bytes), Equals(33ul));
+            AssertThat(utf::ascii_punct_offset(bytes.substr(34)),
+                       Equals(0ul));
+        });
+
+        it("should validate utf8", [&]() {
+            AssertThat(utf::is_valid_utf8(""), IsTrue());
+            AssertThat(utf::is_valid_utf8(bytes.substr(0, 128)), IsTrue());
+            AssertThat(utf::is_valid_utf8(bytes), IsFalse());
+            AssertThat(utf::is_valid_utf8("caf\xc3\xa9 \xe2\x82\xac "
+                                          "\xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf"),
+                       IsTrue());
+            // overlong encodings
+            AssertThat(utf::is_valid_utf8("\xc0\xaf"), IsFalse());
+            AssertThat(utf::is_valid_utf8("\xe0\x80\xaf"), IsFalse());
+            AssertThat(utf::is_valid_utf8("\xf0\x80\x80\xaf"), IsFalse());
+            // a surrogate, and past U+10FFFF
+            AssertThat(utf::is_valid_utf8("\xed\xa0\x80"), IsFalse());
+            AssertThat(utf::is_valid_utf8("\xf4\x90\x80\x80"), IsFalse());
+            // truncated, and a stray continuation byte
+            AssertThat(utf::is_valid_utf8("abcdefgh\xe2\x82"), IsFalse());
+            AssertThat(utf::is_valid_utf8("abc\x82"), IsFalse());
+        });
+
+        it("should fold case in mixed strings", [&]() {
+            AssertThat(utf::foldcase("The CAF\xc3\x89S, Na\xc3\xafve"),
+                       Equals("the caf\xc3\xa9s, na\xc3\xafve"));
+            AssertThat(utf::foldcase("\xce\xa3\xce\x91\xce\xa3 ABC"),
+                       Equals("\xcf\x83\xce\xb1\xcf\x83 abc"));
+            AssertThat(utf::foldcase(""), Equals(""));
+            AssertThat(utf::length("caf\xc3\xa9s"), Equals(5ul));
+            AssertThat(utf::length("cafes"), Equals(5ul));
+        });
+    });
 });